@@ -91,6 +91,7 @@ void vds::vds_cmd_app::register_services(vds::service_registrator& registrator)
   base_class::register_services(registrator);
 
   registrator.add(this->mt_service_);
+  registrator.add(this->async_file_service_);
   registrator.add(this->task_manager_);
   registrator.add(this->network_service_);
   registrator.add(this->crypto_service_);
@@ -43,6 +43,7 @@ vds::expected<void> vds::vds_embedded::do_server_root(const std::string & /*logi
   service_registrator registrator;
 
   mt_service mt_service;
+  async_file_service async_file_service;
   network_service network_service;
 
   std::unordered_set<std::string> modules;
@@ -58,6 +59,7 @@ vds::expected<void> vds::vds_embedded::do_server_root(const std::string & /*logi
   CHECK_EXPECTED(folder.create());
 
   registrator.add(mt_service);
+  registrator.add(async_file_service);
   registrator.add(logger);
   registrator.add(task_manager);
   registrator.add(crypto_service);
@@ -103,6 +105,7 @@ vds::expected<void> vds::vds_embedded::do_start(int port, bool dev_network) {
   }
 
   this->registrator_.add(this->mt_service_);
+  this->registrator_.add(this->async_file_service_);
   this->registrator_.add(this->logger_);
   this->registrator_.add(this->task_manager_);
   this->registrator_.add(this->crypto_service_);
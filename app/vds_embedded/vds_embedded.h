@@ -8,6 +8,7 @@ All rights reserved
 
 #include <task_manager.h>
 #include <mt_service.h>
+#include <async_file.h>
 #include "user_manager.h"
 #include "vds_api.h"
 
@@ -68,6 +69,7 @@ namespace vds {
     service_registrator registrator_;
     task_manager task_manager_;
     mt_service mt_service_;
+    async_file_service async_file_service_;
     file_logger logger_;
     network_service network_service_;
     crypto_service crypto_service_;
@@ -9,6 +9,7 @@ TrayIcon::TrayIcon()
 : logger_(vds::log_level::ll_trace, std::unordered_set<std::string>{"*"})
 {
   this->registrator_.add(this->mt_service_);
+  this->registrator_.add(this->async_file_service_);
   this->registrator_.add(this->logger_);
   this->registrator_.add(this->task_manager_);
   this->registrator_.add(this->network_service_);
@@ -19,6 +19,7 @@ private:
   vds::file_logger logger_;
   vds::task_manager task_manager_;
   vds::mt_service mt_service_;
+  vds::async_file_service async_file_service_;
   vds::network_service network_service_;
   vds::crypto_service crypto_service_;
   vds::server server_;
@@ -31,6 +31,7 @@ namespace std {
 
 #include "task_manager.h"
 #include "mt_service.h"
+#include "async_file.h"
 #include "network_service.h"
 #include "crypto_service.h"
 #include "server.h"
@@ -372,6 +372,7 @@ void vds::app::register_command_line(command_line& cmd_line) {
 void vds::app::register_common_parameters(command_line& cmd_line) {
   cmd_line.register_common_parameter(this->log_level_);
   cmd_line.register_common_parameter(this->log_modules_);
+  cmd_line.register_common_parameter(this->log_binary_);
   cmd_line.register_common_parameter(this->root_folder_);
 }
 
@@ -403,6 +404,10 @@ void vds::app::process_common_parameters() {
       p = s + 1;
     }
   }
+
+  if (this->log_binary_.value()) {
+    this->logger_.enable_binary_log();
+  }
 }
 
 bool vds::app::need_demonize() {
@@ -413,6 +418,7 @@ bool vds::app::need_demonize() {
 vds::app::app(): logger_(log_level::ll_info, std::unordered_set<std::string>()),
                  log_level_("ll", "log_level", "Log Level", "Set log level"),
                  log_modules_("lm", "log_modules", "Log modules", "Set log modules"),
+                 log_binary_("lb", "log_binary", "Binary log", "Write binary log to vds.vlog, decode it with log_parser"),
                  root_folder_("", "root-folder", "Root folder", "Root folder to store files"),
                  current_command_set_(nullptr),
                  help_cmd_set_("Show help", "Show application help", "help"),
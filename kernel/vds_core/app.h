@@ -57,6 +57,7 @@ namespace vds{
       file_logger logger_;
       command_line_value log_level_;
       command_line_value log_modules_;
+      command_line_switch log_binary_;
       command_line_value root_folder_;
       const command_line_set *current_command_set_;
       filename current_process_;
@@ -0,0 +1,187 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include "async_file.h"
+#include "private/async_file_p.h"
+#include "file.h"
+#include "foldername.h"
+#include "mt_service.h"
+#include <thread>
+
+vds::async_file_service::async_file_service(size_t thread_count)
+: thread_count_(thread_count) {
+}
+
+vds::async_file_service::~async_file_service() {
+}
+
+vds::expected<void> vds::async_file_service::register_services(service_registrator & registrator) {
+  registrator.add_service<async_file_service>(this);
+  return expected<void>();
+}
+
+vds::expected<void> vds::async_file_service::start(const service_provider *) {
+  this->impl_.reset(new _async_file_service());
+  this->impl_->start(this->thread_count_);
+  return expected<void>();
+}
+
+vds::expected<void> vds::async_file_service::stop() {
+  if (this->impl_) {
+    this->impl_->stop();
+  }
+
+  return expected<void>();
+}
+
+vds::_async_file_service::_async_file_service()
+: is_stopping_(false) {
+}
+
+void vds::_async_file_service::start(size_t thread_count) {
+  for (size_t i = 0; i < thread_count; ++i) {
+    this->threads_.emplace_back([this]() { this->work_thread(); });
+  }
+}
+
+void vds::_async_file_service::stop() {
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  this->is_stopping_ = true;
+  this->cond_.notify_all();
+  lock.unlock();
+
+  //The workers leave only when the queue is empty
+  for (auto & t : this->threads_) {
+    t.join();
+  }
+  this->threads_.clear();
+}
+
+vds::expected<void> vds::_async_file_service::schedule(lambda_holder_t<void> handler) {
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  if (this->is_stopping_) {
+    return vds::make_unexpected<std::runtime_error>("Disk I/O service is stopped");
+  }
+
+  this->queue_.push_back(std::move(handler));
+  this->cond_.notify_one();
+  return expected<void>();
+}
+
+void vds::_async_file_service::work_thread() {
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  for (;;) {
+    if (!this->queue_.empty()) {
+      auto handler = std::move(this->queue_.front());
+      this->queue_.pop_front();
+
+      lock.unlock();
+      handler();
+      lock.lock();
+    }
+    else if (this->is_stopping_) {
+      return;
+    }
+    else {
+      this->cond_.wait(lock);
+    }
+  }
+}
+
+static vds::expected<void> create_folder(const vds::filename & fn) {
+  const auto folder = fn.contains_folder();
+  if (folder.empty()) {
+    return vds::expected<void>();
+  }
+
+  return folder.create();
+}
+
+template <typename result_type>
+vds::async_task<vds::expected<result_type>> vds::async_file::execute(
+  const service_provider * sp,
+  lambda_holder_t<expected<result_type>> handler) {
+
+  async_result<expected<result_type>> result;
+  auto future = result.get_future();
+
+  auto service = sp->get<async_file_service>();
+  if (!service->impl_) {
+    result.set_value(vds::make_unexpected<std::runtime_error>("Disk I/O service is not started"));
+    return future;
+  }
+
+  auto error = service->impl_->schedule([sp, handler = std::move(handler), result]() mutable {
+    auto value = handler();
+
+    imt_service::async(sp, [result = std::move(result), value = std::move(value)]() mutable {
+      result.set_value(std::move(value));
+    });
+  });
+
+  if (error.has_error()) {
+    result.set_value(vds::unexpected(std::move(error.error())));
+  }
+
+  return future;
+}
+
+vds::async_task<vds::expected<vds::const_data_buffer>> vds::async_file::read_all(
+  const service_provider * sp,
+  const filename & fn) {
+  //A single read into the result buffer, the data is not copied afterwards
+  return execute<const_data_buffer>(sp, [fn]() -> expected<const_data_buffer> {
+    return file::read_all(fn);
+  });
+}
+
+vds::async_task<vds::expected<void>> vds::async_file::write_all(
+  const service_provider * sp,
+  const filename & fn,
+  const_data_buffer data) {
+  return execute<void>(sp, [fn, data = std::move(data)]() -> expected<void> {
+    if (file::exists(fn)) {
+      return expected<void>();
+    }
+
+    CHECK_EXPECTED(create_folder(fn));
+
+    //A thread writes one file at a time, so the thread id keeps concurrent writers apart
+    const filename tmp(fn.full_name() + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp");
+    auto error = file::write_all(tmp, data);
+    if (!error.has_error()) {
+      error = file::move(tmp, fn);
+      if (error.has_error() && file::exists(fn)) {
+        //The same content was stored by another writer meanwhile
+        error = expected<void>();
+      }
+    }
+
+    if (file::exists(tmp)) {
+      (void)file::delete_file(tmp);
+    }
+
+    return error;
+  });
+}
+
+vds::async_task<vds::expected<void>> vds::async_file::move(
+  const service_provider * sp,
+  const filename & source,
+  const filename & target) {
+  return execute<void>(sp, [source, target]() -> expected<void> {
+    CHECK_EXPECTED(create_folder(target));
+    return file::move(source, target);
+  });
+}
+
+vds::async_task<vds::expected<void>> vds::async_file::delete_file(
+  const service_provider * sp,
+  const filename & fn) {
+  return execute<void>(sp, [fn]() -> expected<void> {
+    return file::delete_file(fn);
+  });
+}
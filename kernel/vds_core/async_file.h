@@ -0,0 +1,74 @@
+#ifndef __VDS_CORE_ASYNC_FILE_H_
+#define __VDS_CORE_ASYNC_FILE_H_
+
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "service_provider.h"
+#include "async_task.h"
+#include "const_data_buffer.h"
+#include "filename.h"
+#include "expected.h"
+
+namespace vds {
+  class _async_file_service;
+
+  //Disk I/O threads behind async_file.
+  //Queued operations are completed before stop() returns.
+  class async_file_service : public iservice_factory
+  {
+  public:
+    static constexpr size_t default_thread_count = 4;
+
+    async_file_service(size_t thread_count = default_thread_count);
+    ~async_file_service();
+
+    expected<void> register_services(service_registrator &) override;
+    expected<void> start(const service_provider *) override;
+    expected<void> stop() override;
+
+  private:
+    friend class async_file;
+
+    size_t thread_count_;
+    std::unique_ptr<_async_file_service> impl_;
+  };
+
+  //Whole-file operations executed on the async_file_service threads.
+  //The caller is resumed on the mt_service pool, so a slow disk never blocks
+  //the database apartment or the worker threads.
+  class async_file {
+  public:
+    static async_task<expected<const_data_buffer>> read_all(
+      const service_provider * sp,
+      const filename & fn);
+
+    //The data is written under a temporary name and renamed into place,
+    //so readers never see a partial file. Missing folders are created.
+    //File names are content addressed: an existing file is kept as it is.
+    static async_task<expected<void>> write_all(
+      const service_provider * sp,
+      const filename & fn,
+      const_data_buffer data);
+
+    //Missing folders of the target are created
+    static async_task<expected<void>> move(
+      const service_provider * sp,
+      const filename & source,
+      const filename & target);
+
+    static async_task<expected<void>> delete_file(
+      const service_provider * sp,
+      const filename & fn);
+
+  private:
+    template <typename result_type>
+    static async_task<expected<result_type>> execute(
+      const service_provider * sp,
+      lambda_holder_t<expected<result_type>> handler);
+  };
+}
+
+#endif // __VDS_CORE_ASYNC_FILE_H_
@@ -0,0 +1,180 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include "async_frame_pool.h"
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <new>
+
+namespace vds {
+  class _async_frame_cache;
+
+  static size_t frame_size_class(size_t size) {
+    size_t index = 0;
+    while ((async_frame_pool::min_class_size << index) < size) {
+      ++index;
+    }
+    return index;
+  }
+
+  class _async_frame_registry {
+  public:
+    std::mutex mutex_;
+    std::list<_async_frame_cache *> caches_;
+    async_frame_pool::statistic retired_;
+
+    static _async_frame_registry & instance() {
+      static _async_frame_registry registry;
+      return registry;
+    }
+
+  private:
+    _async_frame_registry()
+    : retired_{ 0, 0, 0, 0 } {
+    }
+  };
+
+  class _async_frame_cache {
+  public:
+    _async_frame_cache()
+    : allocations_(0), allocated_bytes_(0), pool_hits_(0), cached_bytes_(0) {
+      for (size_t i = 0; i < async_frame_pool::size_class_count; ++i) {
+        this->free_[i] = nullptr;
+        this->free_count_[i] = 0;
+      }
+
+      auto & registry = _async_frame_registry::instance();
+      std::unique_lock<std::mutex> lock(registry.mutex_);
+      registry.caches_.push_back(this);
+    }
+
+    ~_async_frame_cache() {
+      for (size_t i = 0; i < async_frame_pool::size_class_count; ++i) {
+        while (nullptr != this->free_[i]) {
+          auto block = this->free_[i];
+          this->free_[i] = block->next_;
+          ::operator delete(block);
+        }
+      }
+
+      auto & registry = _async_frame_registry::instance();
+      std::unique_lock<std::mutex> lock(registry.mutex_);
+      registry.caches_.remove(this);
+      registry.retired_.allocations += this->allocations_;
+      registry.retired_.allocated_bytes += this->allocated_bytes_;
+      registry.retired_.pool_hits += this->pool_hits_;
+    }
+
+    void * allocate(size_t size) {
+      //Only the owner thread writes the counters, so plain load/store is enough
+      this->allocations_.store(this->allocations_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      this->allocated_bytes_.store(this->allocated_bytes_.load(std::memory_order_relaxed) + size, std::memory_order_relaxed);
+
+      if (async_frame_pool::max_pooled_size < size) {
+        return ::operator new(size);
+      }
+
+      const auto index = frame_size_class(size);
+      auto block = this->free_[index];
+      if (nullptr == block) {
+        return ::operator new(async_frame_pool::min_class_size << index);
+      }
+
+      this->free_[index] = block->next_;
+      --this->free_count_[index];
+      this->pool_hits_.store(this->pool_hits_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      this->cached_bytes_.store(
+        this->cached_bytes_.load(std::memory_order_relaxed) - (async_frame_pool::min_class_size << index),
+        std::memory_order_relaxed);
+      return block;
+    }
+
+    void deallocate(void * p, size_t size) {
+      if (async_frame_pool::max_pooled_size < size) {
+        ::operator delete(p);
+        return;
+      }
+
+      const auto index = frame_size_class(size);
+      if (async_frame_pool::max_cached_blocks <= this->free_count_[index]) {
+        ::operator delete(p);
+        return;
+      }
+
+      auto block = static_cast<free_block *>(p);
+      block->next_ = this->free_[index];
+      this->free_[index] = block;
+      ++this->free_count_[index];
+      this->cached_bytes_.store(
+        this->cached_bytes_.load(std::memory_order_relaxed) + (async_frame_pool::min_class_size << index),
+        std::memory_order_relaxed);
+    }
+
+    void add_statistic(async_frame_pool::statistic & result) const {
+      result.allocations += this->allocations_.load(std::memory_order_relaxed);
+      result.allocated_bytes += this->allocated_bytes_.load(std::memory_order_relaxed);
+      result.pool_hits += this->pool_hits_.load(std::memory_order_relaxed);
+      result.cached_bytes += this->cached_bytes_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    struct free_block {
+      free_block * next_;
+    };
+
+    free_block * free_[async_frame_pool::size_class_count];
+    size_t free_count_[async_frame_pool::size_class_count];
+
+    std::atomic<uint64_t> allocations_;
+    std::atomic<uint64_t> allocated_bytes_;
+    std::atomic<uint64_t> pool_hits_;
+    std::atomic<uint64_t> cached_bytes_;
+  };
+}
+
+//Frames may be released by other thread_local destructors after the cache is gone
+static thread_local bool g_frame_cache_destroyed = false;
+
+class _async_frame_cache_holder {
+public:
+  ~_async_frame_cache_holder() {
+    g_frame_cache_destroyed = true;
+  }
+
+  vds::_async_frame_cache cache_;
+};
+
+static thread_local _async_frame_cache_holder g_frame_cache;
+
+void * vds::async_frame_pool::allocate(size_t size) {
+  if (g_frame_cache_destroyed) {
+    return ::operator new(size);
+  }
+
+  return g_frame_cache.cache_.allocate(size);
+}
+
+void vds::async_frame_pool::deallocate(void * p, size_t size) noexcept {
+  if (g_frame_cache_destroyed) {
+    ::operator delete(p);
+    return;
+  }
+
+  g_frame_cache.cache_.deallocate(p, size);
+}
+
+vds::async_frame_pool::statistic vds::async_frame_pool::get_statistic() {
+  auto & registry = _async_frame_registry::instance();
+  std::unique_lock<std::mutex> lock(registry.mutex_);
+
+  auto result = registry.retired_;
+  for (auto cache : registry.caches_) {
+    cache->add_statistic(result);
+  }
+
+  return result;
+}
@@ -0,0 +1,42 @@
+#ifndef __VDS_CORE_ASYNC_FRAME_POOL_H_
+#define __VDS_CORE_ASYNC_FRAME_POOL_H_
+
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vds {
+
+  //Coroutine frame allocator.
+  //Frames up to max_pooled_size come from per-thread size-class freelists,
+  //bigger ones go to the global operator new.
+  class async_frame_pool {
+  public:
+    static constexpr size_t min_class_size = 64;
+    static constexpr size_t size_class_count = 7;
+    static constexpr size_t max_pooled_size = min_class_size << (size_class_count - 1);
+    static constexpr size_t max_cached_blocks = 256;
+
+    struct statistic {
+      uint64_t allocations;
+      uint64_t allocated_bytes;
+      uint64_t pool_hits;
+      uint64_t cached_bytes;
+
+      double hit_rate() const {
+        return (0 == this->allocations) ? 0.0 : double(this->pool_hits) / this->allocations;
+      }
+    };
+
+    static void * allocate(size_t size);
+    static void deallocate(void * p, size_t size) noexcept;
+
+    static statistic get_statistic();
+  };
+}
+
+#endif // __VDS_CORE_ASYNC_FRAME_POOL_H_
@@ -0,0 +1,49 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include "async_semaphore.h"
+
+vds::async_semaphore::async_semaphore(size_t count)
+: count_(count) {
+}
+
+bool vds::async_semaphore::try_acquire() {
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  if (0 < this->count_ && this->waiters_.empty()) {
+    --this->count_;
+    return true;
+  }
+
+  return false;
+}
+
+bool vds::async_semaphore::enqueue(acquire_awaiter* waiter) {
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  if (0 < this->count_ && this->waiters_.empty()) {
+    --this->count_;
+    return false;
+  }
+
+  this->waiters_.push_back(waiter);
+  return true;
+}
+
+void vds::async_semaphore::release() {
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  auto waiter = this->waiters_.pop_front();
+  if (nullptr == waiter) {
+    ++this->count_;
+    return;
+  }
+  lock.unlock();
+
+  waiter->resume();
+}
+
+size_t vds::async_semaphore::available() const {
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  return this->count_;
+}
@@ -0,0 +1,116 @@
+#ifndef __VDS_CORE_ASYNC_SEMAPHORE_H_
+#define __VDS_CORE_ASYNC_SEMAPHORE_H_
+
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include <mutex>
+#include "async_wait_queue.h"
+
+namespace vds {
+
+  //Counting semaphore for coroutines.
+  //Waiters are resumed in FIFO order and a released permit is handed straight to the next waiter.
+  class async_semaphore {
+  public:
+    //Returns the permit when destroyed
+    class guard {
+    public:
+      guard()
+      : owner_(nullptr) {
+      }
+
+      explicit guard(async_semaphore * owner)
+      : owner_(owner) {
+      }
+
+      guard(guard && origin) noexcept
+      : owner_(origin.owner_) {
+        origin.owner_ = nullptr;
+      }
+
+      guard(const guard &) = delete;
+      guard & operator = (const guard &) = delete;
+
+      ~guard() {
+        this->release();
+      }
+
+      void release() {
+        if (nullptr != this->owner_) {
+          auto owner = this->owner_;
+          this->owner_ = nullptr;
+          owner->release();
+        }
+      }
+
+    private:
+      async_semaphore * owner_;
+    };
+
+    class acquire_awaiter : public _async_waiter {
+    public:
+      explicit acquire_awaiter(async_semaphore * owner)
+      : owner_(owner) {
+      }
+
+      bool await_ready() {
+        return this->owner_->try_acquire();
+      }
+
+      bool await_suspend(std::experimental::coroutine_handle<> h) {
+        this->handle_ = h;
+        return this->owner_->enqueue(this);
+      }
+
+      void await_resume() {
+      }
+
+    protected:
+      async_semaphore * owner_;
+    };
+
+    class scoped_acquire_awaiter : public acquire_awaiter {
+    public:
+      explicit scoped_acquire_awaiter(async_semaphore * owner)
+      : acquire_awaiter(owner) {
+      }
+
+      guard await_resume() {
+        return guard(this->owner_);
+      }
+    };
+
+    explicit async_semaphore(size_t count);
+
+    async_semaphore(const async_semaphore &) = delete;
+    async_semaphore & operator = (const async_semaphore &) = delete;
+
+    //co_await sem.acquire(); ... sem.release();
+    acquire_awaiter acquire() {
+      return acquire_awaiter(this);
+    }
+
+    //auto guard = co_await sem.scoped_acquire();
+    scoped_acquire_awaiter scoped_acquire() {
+      return scoped_acquire_awaiter(this);
+    }
+
+    bool try_acquire();
+    void release();
+
+    size_t available() const;
+
+  private:
+    mutable std::mutex mutex_;
+    size_t count_;
+    _async_wait_queue<acquire_awaiter> waiters_;
+
+    //Returns false if a permit became available and the coroutine should not suspend
+    bool enqueue(acquire_awaiter * waiter);
+  };
+}
+
+#endif // __VDS_CORE_ASYNC_SEMAPHORE_H_
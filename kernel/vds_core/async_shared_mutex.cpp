@@ -0,0 +1,90 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include "async_shared_mutex.h"
+
+vds::async_shared_mutex::async_shared_mutex()
+: readers_(0), is_writer_(false) {
+}
+
+bool vds::async_shared_mutex::try_lock() {
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  if (this->can_lock()) {
+    this->is_writer_ = true;
+    return true;
+  }
+
+  return false;
+}
+
+bool vds::async_shared_mutex::try_lock_shared() {
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  if (this->can_lock_shared()) {
+    ++this->readers_;
+    return true;
+  }
+
+  return false;
+}
+
+bool vds::async_shared_mutex::enqueue(lock_awaiter* waiter) {
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  if (waiter->is_exclusive_) {
+    if (this->can_lock()) {
+      this->is_writer_ = true;
+      return false;
+    }
+  }
+  else if (this->can_lock_shared()) {
+    ++this->readers_;
+    return false;
+  }
+
+  this->waiters_.push_back(waiter);
+  return true;
+}
+
+void vds::async_shared_mutex::unlock() {
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  vds_assert(this->is_writer_);
+  this->is_writer_ = false;
+  this->wake_waiters(lock);
+}
+
+void vds::async_shared_mutex::unlock_shared() {
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  vds_assert(0 < this->readers_);
+  if (0 == --this->readers_) {
+    this->wake_waiters(lock);
+  }
+}
+
+void vds::async_shared_mutex::wake_waiters(std::unique_lock<std::mutex> & lock) {
+  //Either the next writer or every reader queued before it
+  _async_wait_queue<lock_awaiter> ready;
+  auto front = this->waiters_.front();
+  if (nullptr != front && front->is_exclusive_) {
+    if (0 == this->readers_) {
+      this->is_writer_ = true;
+      ready.push_back(this->waiters_.pop_front());
+    }
+  }
+  else {
+    while (nullptr != (front = this->waiters_.front()) && !front->is_exclusive_) {
+      ++this->readers_;
+      ready.push_back(this->waiters_.pop_front());
+    }
+  }
+  lock.unlock();
+
+  for (;;) {
+    auto waiter = ready.pop_front();
+    if (nullptr == waiter) {
+      break;
+    }
+    waiter->resume();
+  }
+}
@@ -0,0 +1,84 @@
+#ifndef __VDS_CORE_ASYNC_SHARED_MUTEX_H_
+#define __VDS_CORE_ASYNC_SHARED_MUTEX_H_
+
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include <mutex>
+#include "async_wait_queue.h"
+
+namespace vds {
+
+  //Reader/writer lock for coroutines.
+  //Waiters are served in FIFO order; a queued writer blocks later readers, so writers are not starved.
+  class async_shared_mutex {
+  public:
+    class lock_awaiter : public _async_waiter {
+    public:
+      lock_awaiter(async_shared_mutex * owner, bool is_exclusive)
+      : owner_(owner), is_exclusive_(is_exclusive) {
+      }
+
+      bool await_ready() {
+        return this->is_exclusive_ ? this->owner_->try_lock() : this->owner_->try_lock_shared();
+      }
+
+      bool await_suspend(std::experimental::coroutine_handle<> h) {
+        this->handle_ = h;
+        return this->owner_->enqueue(this);
+      }
+
+      void await_resume() {
+      }
+
+    private:
+      friend class async_shared_mutex;
+
+      async_shared_mutex * owner_;
+      const bool is_exclusive_;
+    };
+
+    async_shared_mutex();
+
+    async_shared_mutex(const async_shared_mutex &) = delete;
+    async_shared_mutex & operator = (const async_shared_mutex &) = delete;
+
+    //co_await m.lock(); ... m.unlock();
+    lock_awaiter lock() {
+      return lock_awaiter(this, true);
+    }
+
+    //co_await m.lock_shared(); ... m.unlock_shared();
+    lock_awaiter lock_shared() {
+      return lock_awaiter(this, false);
+    }
+
+    bool try_lock();
+    bool try_lock_shared();
+
+    void unlock();
+    void unlock_shared();
+
+  private:
+    std::mutex mutex_;
+    size_t readers_;
+    bool is_writer_;
+    _async_wait_queue<lock_awaiter> waiters_;
+
+    bool can_lock() const {
+      return !this->is_writer_ && 0 == this->readers_ && this->waiters_.empty();
+    }
+
+    bool can_lock_shared() const {
+      return !this->is_writer_ && this->waiters_.empty();
+    }
+
+    //Returns false if the lock was taken and the coroutine should not suspend
+    bool enqueue(lock_awaiter * waiter);
+    void wake_waiters(std::unique_lock<std::mutex> & lock);
+  };
+}
+
+#endif // __VDS_CORE_ASYNC_SHARED_MUTEX_H_
@@ -7,11 +7,15 @@ All rights reserved
 */
 
 #include <experimental/coroutine>
+#include <atomic>
 #include <future>
 #include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include "vds_debug.h"
 #include "expected.h"
 #include "func_utils.h"
+#include "async_frame_pool.h"
 
 namespace vds {
   template <typename result_type>
@@ -31,234 +35,262 @@ namespace vds {
 	  void do_async(lambda_holder_t<void> handler);
   };
   
-  template <typename result_type>
-  class _async_task_value {
-  public:
-    virtual ~_async_task_value(){}
-    virtual result_type && get() = 0;
-  };
-
-  template <>
-  class _async_task_value<void> {
+  //Blocking get()/wait_for() support, created only when somebody waits on the thread
+  class _async_task_waiter {
   public:
-    virtual ~_async_task_value() {}
-    virtual void get() = 0;
+    std::mutex mutex_;
+    std::condition_variable cond_;
   };
 
-  template <typename result_type>
-  class _async_task_return_value : public _async_task_value<result_type>{
+  //Single-shot state shared by async_result and async_task.
+  //The value is stored inline and the ready/continuation handoff is one atomic state word.
+  class _async_task_state_base {
   public:
-
-    template<typename init_type>
-    _async_task_return_value(init_type && v)
-    : value_(std::forward<init_type>(v)) {
-    }
-
-    result_type && get() override {
-      return std::move(this->value_);
+    _async_task_state_base()
+    : ref_count_(1), state_(0), waiter_(nullptr) {
     }
 
-  private:
-    result_type value_;
-  };
-
-  template <>
-  class _async_task_return_value<void> : public _async_task_value<void> {
-  public:
+    _async_task_state_base(const _async_task_state_base &) = delete;
+    _async_task_state_base & operator = (const _async_task_state_base &) = delete;
 
-    void get() override {
+    virtual ~_async_task_state_base() {
+      delete this->waiter_.load(std::memory_order_acquire);
     }
-  };
 
-  template <typename result_type>
-  class _async_task_throw_exception : public _async_task_value<result_type> {
-  public:
-    _async_task_throw_exception(std::exception_ptr ex)
-      : ex_(ex) {
+    void add_ref() noexcept {
+      this->ref_count_.fetch_add(1, std::memory_order_relaxed);
     }
 
-    result_type && get() override {
-      std::rethrow_exception(this->ex_);
+    void release() noexcept {
+      if (1 == this->ref_count_.fetch_sub(1, std::memory_order_acq_rel)) {
+        delete this;
+      }
     }
 
-  private:
-    std::exception_ptr ex_;
-  };
-
-  template <>
-  class _async_task_throw_exception<void> : public _async_task_value<void> {
-  public:
-    _async_task_throw_exception(std::exception_ptr ex)
-      : ex_(ex) {
+    bool is_ready() const noexcept {
+      return 0 != (this->state_.load(std::memory_order_acquire) & state_ready);
     }
 
-    void get() override {
-      std::rethrow_exception(this->ex_);
+    template<class _Rep, class _Period>
+    std::future_status wait_for(std::chrono::duration<_Rep, _Period> timeout) {
+      if (this->is_ready()) {
+        return std::future_status::ready;
+      }
+
+      auto waiter = this->get_waiter();
+      std::unique_lock<std::mutex> lock(waiter->mutex_);
+      waiter->cond_.wait_for(lock, timeout, [this]() { return this->is_ready(); });
+      return this->is_ready() ? std::future_status::ready : std::future_status::timeout;
     }
 
-  private:
-    std::exception_ptr ex_;
-  };
+    void wait() {
+      if (this->is_ready()) {
+        return;
+      }
 
-  template <typename result_type>
-  class _async_task_state {
-  public:
-    _async_task_state() {
+      auto waiter = this->get_waiter();
+      std::unique_lock<std::mutex> lock(waiter->mutex_);
+      waiter->cond_.wait(lock, [this]() { return this->is_ready(); });
     }
 
-    template<class _Rep, class _Period>
-    std::future_status wait_for(std::chrono::duration<_Rep, _Period> timeout) {
-      std::unique_lock<std::mutex> lock(this->value_mutex_);
-      if (this->value_) {
-        return std::future_status::ready;
+    void then(lambda_holder_t<void> f) {
+      this->then_function_ = std::move(f);
+      if (!this->set_continuation()) {
+        auto f_ = std::move(this->then_function_);
+        f_();
       }
-
-      this->value_cond_.wait_for(lock, timeout);
-      return (!this->value_) ? std::future_status::timeout : std::future_status::ready;
     }
 
-    bool is_ready() {
-      std::unique_lock<std::mutex> lock(this->value_mutex_);
-      return (!this->value_) ? false : true;
+    //Returns false if the value is already set and the coroutine should not be suspended
+    bool then(std::experimental::coroutine_handle<> h) {
+      this->resume_handle_ = h;
+      return this->set_continuation();
     }
 
+  protected:
+    std::exception_ptr exception_;
 
-    result_type && get() {
-      std::unique_lock<std::mutex> lock(this->value_mutex_);
-      while (!this->value_) {
-        this->value_cond_.wait(lock);
+    void set_ready() {
+      const auto old_state = this->state_.exchange(state_ready, std::memory_order_seq_cst);
+      vds_assert(0 == (old_state & state_ready));
+
+      auto waiter = this->waiter_.load(std::memory_order_seq_cst);
+      if (nullptr != waiter) {
+        std::unique_lock<std::mutex> lock(waiter->mutex_);
+        waiter->cond_.notify_all();
+      }
+
+      if (0 != (old_state & state_continuation)) {
+        this->resume();
       }
-      return std::move(this->value_->get());
     }
 
-    void then(lambda_holder_t<void> f) {
-      std::unique_lock<std::mutex> lock(this->value_mutex_);
-      if (!this->value_) {
-        this->then_function_ = std::move(f);
+  private:
+    static constexpr uint32_t state_continuation = 1;
+    static constexpr uint32_t state_ready = 2;
+
+    std::atomic<uint32_t> ref_count_;
+    std::atomic<uint32_t> state_;
+    std::atomic<_async_task_waiter *> waiter_;
+    std::experimental::coroutine_handle<> resume_handle_;
+    lambda_holder_t<void> then_function_;
+
+    bool set_continuation() {
+      uint32_t expected_state = 0;
+      return this->state_.compare_exchange_strong(
+        expected_state,
+        state_continuation,
+        std::memory_order_acq_rel,
+        std::memory_order_acquire);
+    }
+
+    void resume() {
+      auto mt = imt_service::get_current();
+      if (this->resume_handle_) {
+        auto h = this->resume_handle_;
+        if (nullptr != mt) {
+          mt->do_async([h]() mutable {
+            h.resume();
+          });
+        }
+        else {
+          h.resume();
+        }
       }
       else {
-        lock.unlock();
-
-        f();
+        auto f = std::move(this->then_function_);
+        if (nullptr != mt) {
+          mt->do_async(std::move(f));
+        }
+        else {
+          f();
+        }
       }
     }
 
-    void set_value(_async_task_value<result_type> * v) {
-      std::unique_lock<std::mutex> lock(this->value_mutex_);
-      vds_assert(!this->value_);
-      this->value_.reset(v);
-      this->value_cond_.notify_all();
-	  if (this->then_function_) {
-		  lock.unlock();
-
-		  auto mt = imt_service::get_current();
-		  if (nullptr != mt) {
-			  mt->do_async([f = std::move(this->then_function_)]() {
-						f();
-			  });
-		  }
-		  else {
-			  this->then_function_();
-		  }
+    _async_task_waiter * get_waiter() {
+      auto waiter = this->waiter_.load(std::memory_order_seq_cst);
+      if (nullptr == waiter) {
+        auto new_waiter = new _async_task_waiter();
+        if (this->waiter_.compare_exchange_strong(waiter, new_waiter, std::memory_order_seq_cst)) {
+          waiter = new_waiter;
+        }
+        else {
+          delete new_waiter;
+        }
       }
+
+      return waiter;
     }
-  private:
-    std::mutex value_mutex_;
-    std::condition_variable value_cond_;
-    std::unique_ptr<_async_task_value<result_type>> value_;
-    lambda_holder_t<void> then_function_;
   };
 
-  template <>
-  class _async_task_state<void> {
+  template <typename result_type>
+  class _async_task_state : public _async_task_state_base {
   public:
-    template<class _Rep, class _Period>
-    std::future_status wait_for(std::chrono::duration<_Rep, _Period> timeout) {
-      std::unique_lock<std::mutex> lock(this->value_mutex_);
-      if (this->value_) {
-        return std::future_status::ready;
-      }
+    _async_task_state()
+    : has_value_(false) {
+    }
 
-      this->value_cond_.wait_for(lock, timeout);
-      return (!this->value_) ? std::future_status::timeout : std::future_status::ready;
+    ~_async_task_state() {
+      if (this->has_value_) {
+        this->value_.~result_type();
+      }
     }
 
-    bool is_ready() {
-      std::unique_lock<std::mutex> lock(this->value_mutex_);
-      return (!this->value_) ? false : true;
+    result_type && get() {
+      this->wait();
+      if (this->exception_) {
+        std::rethrow_exception(this->exception_);
+      }
+      return std::move(this->value_);
     }
 
+    template<typename init_type>
+    void set_value(init_type && v) {
+      new(&this->value_) result_type(std::forward<init_type>(v));
+      this->has_value_ = true;
+      this->set_ready();
+    }
 
-    void get() {
-      std::unique_lock<std::mutex> lock(this->value_mutex_);
-      while (!this->value_) {
-        this->value_cond_.wait(lock);
-      }
-      this->value_->get();
+    void set_exception(std::exception_ptr ex) {
+      this->exception_ = ex;
+      this->set_ready();
     }
 
-    void then(lambda_holder_t<void> f) {
-      std::unique_lock<std::mutex> lock(this->value_mutex_);
-      if (!this->value_) {
-        this->then_function_ = std::move(f);
-      }
-      else {
-        lock.unlock();
+  private:
+    bool has_value_;
+    union {
+      result_type value_;
+    };
+  };
 
-        f();
+  template <>
+  class _async_task_state<void> : public _async_task_state_base {
+  public:
+    void get() {
+      this->wait();
+      if (this->exception_) {
+        std::rethrow_exception(this->exception_);
       }
     }
 
-    void set_value(_async_task_value<void> * v) {
-      std::unique_lock<std::mutex> lock(this->value_mutex_);
-      vds_assert(!this->value_);
-      this->value_.reset(v);
-      this->value_cond_.notify_all();
-      if (this->then_function_) {
-        lock.unlock();
-
-		auto mt = imt_service::get_current();
-		if (nullptr != mt) {
-			mt->do_async(std::move(this->then_function_));
-		}
-		else {
-			this->then_function_();
-		}
-	  }
+    void set_value() {
+      this->set_ready();
     }
 
-  private:
-    std::mutex value_mutex_;
-    std::condition_variable value_cond_;
-    std::unique_ptr<_async_task_value<void>> value_;
-    lambda_holder_t<void> then_function_;
+    void set_exception(std::exception_ptr ex) {
+      this->exception_ = ex;
+      this->set_ready();
+    }
   };
 
   template <typename result_type>
   class [[nodiscard]] async_task {
   public:
-    async_task() = default;
+    async_task()
+    : state_(nullptr) {
+    }
+
     async_task(const async_task &) = delete;
-    async_task(async_task &&) = default;
+    async_task(async_task && origin) noexcept
+    : state_(origin.state_) {
+      origin.state_ = nullptr;
+    }
 
     async_task(result_type && result)
-      : state_(std::make_shared<_async_task_state<result_type>>()) {
-      this->state_->set_value(new _async_task_return_value<result_type>(std::move(result)));
+      : state_(new _async_task_state<result_type>()) {
+      this->state_->set_value(std::move(result));
     }
     async_task(unexpected && error)
-    : state_(std::make_shared<_async_task_state<result_type>>()){
-      this->state_->set_value(new _async_task_return_value<result_type>(std::move(error)));
+    : state_(new _async_task_state<result_type>()){
+      this->state_->set_value(std::move(error));
     }
 
-    async_task & operator = (const async_task &) = delete;
-    async_task & operator = (async_task &&) = default;
+    //Takes ownership of the state reference
+    explicit async_task(_async_task_state<result_type> * state)
+    : state_(state) {
+    }
 
-    async_task(const std::shared_ptr<_async_task_state<result_type>> & state)
-    : state_(state) {      
+    ~async_task() {
+      if (nullptr != this->state_) {
+        this->state_->release();
+      }
+    }
+
+    async_task & operator = (const async_task &) = delete;
+    async_task & operator = (async_task && origin) noexcept {
+      if (this != &origin) {
+        if (nullptr != this->state_) {
+          this->state_->release();
+        }
+        this->state_ = origin.state_;
+        origin.state_ = nullptr;
+      }
+      return *this;
     }
 
 	bool has_state() const {
-		return (nullptr != this->state_.get());
+		return (nullptr != this->state_);
 	}
 
     template<class _Rep, class _Period>
@@ -280,37 +312,32 @@ namespace vds {
       return std::move(this->state_->get());
     }
 
-    void await_suspend(std::experimental::coroutine_handle<> _ResumeCb)
+    bool await_suspend(std::experimental::coroutine_handle<> _ResumeCb)
     {
-      this->then([_ResumeCb]() mutable {
-        _ResumeCb();
-      });
+      return this->state_->then(_ResumeCb);
     }
 
     void then(lambda_holder_t<void> && f) {
-      this->state_->then([f_ = std::move(f), s = this->state_]() {
+      //The continuation keeps its own reference, the task may be destroyed before it runs
+      auto s = this->state_;
+      s->add_ref();
+      s->then([f_ = std::move(f), s]() {
         f_();
+        s->release();
       });
     }
     
     void then(lambda_holder_t<void, result_type> && f) {
-      this->state_->then([f_ = std::move(f), s = std::move(this->state_)]() {
+      auto s = this->state_;
+      this->state_ = nullptr;
+      s->then([f_ = std::move(f), s]() {
         f_(std::move(s->get()));
+        s->release();
       });
     }
 
-    //void detach() {
-    //  auto s = std::move(this->state_);
-    //  s->then([s]() {
-    //    try {
-    //      s->get();
-    //    }
-    //    catch(...) {          
-    //    }
-    //  });
-    //}
   private:
-    std::shared_ptr<_async_task_state<result_type>> state_;
+    _async_task_state<result_type> * state_;
   };  
 
   template <>
@@ -318,15 +345,33 @@ namespace vds {
   public:
     async_task() = delete;
     async_task(const async_task &) = delete;
-    async_task(async_task &&) = default;
-
-    async_task & operator = (const async_task &) = delete;
-    async_task & operator = (async_task &&) = default;
+    async_task(async_task && origin) noexcept
+    : state_(origin.state_) {
+      origin.state_ = nullptr;
+    }
 
-    async_task(const std::shared_ptr<_async_task_state<void>> & state)
+    //Takes ownership of the state reference
+    explicit async_task(_async_task_state<void> * state)
       : state_(state) {
     }
 
+    ~async_task() {
+      if (nullptr != this->state_) {
+        this->state_->release();
+      }
+    }
+
+    async_task & operator = (const async_task &) = delete;
+    async_task & operator = (async_task && origin) noexcept {
+      if (this != &origin) {
+        if (nullptr != this->state_) {
+          this->state_->release();
+        }
+        this->state_ = origin.state_;
+        origin.state_ = nullptr;
+      }
+      return *this;
+    }
 
     template<class _Rep, class _Period>
     std::future_status wait_for(std::chrono::duration<_Rep, _Period> timeout) const {
@@ -345,19 +390,23 @@ namespace vds {
       this->state_->get();
     }
 
-    void await_suspend(std::experimental::coroutine_handle<> _ResumeCb)
+    bool await_suspend(std::experimental::coroutine_handle<> _ResumeCb)
     {
-      this->then([_ResumeCb]() mutable {
-        _ResumeCb();
-      });
+      return this->state_->then(_ResumeCb);
     }
 
     void then(lambda_holder_t<void> f) {
-      this->state_->then(std::move(f));
+      //The continuation keeps its own reference, the task may be destroyed before it runs
+      auto s = this->state_;
+      s->add_ref();
+      s->then([f_ = std::move(f), s]() {
+        f_();
+        s->release();
+      });
     }
 
   private:
-    std::shared_ptr<_async_task_state<void>> state_;
+    _async_task_state<void> * state_;
   };
 
   template <typename result_type>
@@ -367,17 +416,54 @@ namespace vds {
       : state_(new _async_task_state<result_type>()) {
     }
 
+    async_result(const async_result & origin)
+    : state_(origin.state_) {
+      this->state_->add_ref();
+    }
+
+    async_result(async_result && origin) noexcept
+    : state_(origin.state_) {
+      origin.state_ = nullptr;
+    }
+
+    ~async_result() {
+      if (nullptr != this->state_) {
+        this->state_->release();
+      }
+    }
+
+    async_result & operator = (const async_result & origin) {
+      origin.state_->add_ref();
+      if (nullptr != this->state_) {
+        this->state_->release();
+      }
+      this->state_ = origin.state_;
+      return *this;
+    }
+
+    async_result & operator = (async_result && origin) noexcept {
+      if (this != &origin) {
+        if (nullptr != this->state_) {
+          this->state_->release();
+        }
+        this->state_ = origin.state_;
+        origin.state_ = nullptr;
+      }
+      return *this;
+    }
+
     async_task<result_type> get_future() {
+      this->state_->add_ref();
       return async_task<result_type>(this->state_);
     }
 
     template<typename init_type>
     void set_value(init_type && v) {
-      this->state_->set_value(new _async_task_return_value<result_type>(std::forward<init_type>(v)));
+      this->state_->set_value(std::forward<init_type>(v));
     }
 
     void set_exception(std::exception_ptr ex) {
-      this->state_->set_value(new _async_task_throw_exception<result_type>(ex));
+      this->state_->set_exception(ex);
     }
 
     void unhandled_exception() {
@@ -385,7 +471,7 @@ namespace vds {
     }
 
   private:
-    std::shared_ptr<_async_task_state<result_type>> state_;
+    _async_task_state<result_type> * state_;
   };
 
   template <>
@@ -395,20 +481,57 @@ namespace vds {
     : state_(new _async_task_state<void>()){
     }
 
+    async_result(const async_result & origin)
+    : state_(origin.state_) {
+      this->state_->add_ref();
+    }
+
+    async_result(async_result && origin) noexcept
+    : state_(origin.state_) {
+      origin.state_ = nullptr;
+    }
+
+    ~async_result() {
+      if (nullptr != this->state_) {
+        this->state_->release();
+      }
+    }
+
+    async_result & operator = (const async_result & origin) {
+      origin.state_->add_ref();
+      if (nullptr != this->state_) {
+        this->state_->release();
+      }
+      this->state_ = origin.state_;
+      return *this;
+    }
+
+    async_result & operator = (async_result && origin) noexcept {
+      if (this != &origin) {
+        if (nullptr != this->state_) {
+          this->state_->release();
+        }
+        this->state_ = origin.state_;
+        origin.state_ = nullptr;
+      }
+      return *this;
+    }
+
     async_task<void> get_future() {
+      this->state_->add_ref();
       return async_task<void>(this->state_);
     }
 
     void set_value() {
-      this->state_->set_value(new _async_task_return_value<void>());
+      this->state_->set_value();
     }
 
     void set_exception(std::exception_ptr ex) {
-      this->state_->set_value(new _async_task_throw_exception<void>(ex));
+      this->state_->set_exception(ex);
     }
 
   private:
-    std::shared_ptr<_async_task_state<void>> state_;
+    _async_task_state<void> * state_;
   };
 
 
@@ -421,14 +544,12 @@ namespace vds {
     }
 
     bool await_ready() const noexcept {
-      return _future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+      return _future.await_ready();
     }
 
     template<typename U>
-    void await_suspend(std::experimental::coroutine_handle<U> hndl) noexcept {
-      this->_future.then([hndl]() mutable {
-        hndl();
-      });
+    bool await_suspend(std::experimental::coroutine_handle<U> hndl) noexcept {
+      return this->_future.await_suspend(hndl);
     }
 
     T && await_resume() {
@@ -448,10 +569,8 @@ namespace vds {
     }
 
     template<typename U>
-    void await_suspend(std::experimental::coroutine_handle<U> hndl) noexcept {
-      this->_future.then([hndl]() mutable {
-        hndl();
-      });
+    bool await_suspend(std::experimental::coroutine_handle<U> hndl) noexcept {
+      return this->_future.await_suspend(hndl);
     }
 
     void await_resume() { _future.get(); }
@@ -476,6 +595,14 @@ namespace std {
       struct promise_type {
         vds::async_result<R> p;
 
+        void * operator new(size_t size) {
+          return vds::async_frame_pool::allocate(size);
+        }
+
+        void operator delete(void * ptr, size_t size) noexcept {
+          vds::async_frame_pool::deallocate(ptr, size);
+        }
+
         auto get_return_object() {
           return p.get_future();
         }
@@ -508,6 +635,14 @@ namespace std {
       struct promise_type {
         vds::async_result<void> p;
 
+        void * operator new(size_t size) {
+          return vds::async_frame_pool::allocate(size);
+        }
+
+        void operator delete(void * ptr, size_t size) noexcept {
+          vds::async_frame_pool::deallocate(ptr, size);
+        }
+
         auto get_return_object() {
           return p.get_future();
         }
@@ -0,0 +1,91 @@
+#ifndef __VDS_CORE_ASYNC_WAIT_QUEUE_H_
+#define __VDS_CORE_ASYNC_WAIT_QUEUE_H_
+
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "async_task.h"
+
+namespace vds {
+
+  //Suspended coroutine waiting on an async primitive.
+  //Awaiters derive from it and live in the coroutine frame, so queueing does not allocate.
+  class _async_waiter {
+  public:
+    _async_waiter()
+    : next_(nullptr) {
+    }
+
+    _async_waiter(const _async_waiter &) = delete;
+    _async_waiter & operator = (const _async_waiter &) = delete;
+
+    //Posted to the mt_service when called on a worker, so the releaser's stack does not grow
+    void resume() {
+      auto h = this->handle_;
+      auto mt = imt_service::get_current();
+      if (nullptr != mt) {
+        mt->do_async([h]() mutable {
+          h.resume();
+        });
+      }
+      else {
+        h.resume();
+      }
+    }
+
+  protected:
+    template <typename waiter_type>
+    friend class _async_wait_queue;
+
+    _async_waiter * next_;
+    std::experimental::coroutine_handle<> handle_;
+  };
+
+  //Intrusive FIFO of waiters, guarded by the owner's mutex
+  template <typename waiter_type>
+  class _async_wait_queue {
+  public:
+    _async_wait_queue()
+    : head_(nullptr), tail_(nullptr) {
+    }
+
+    bool empty() const {
+      return nullptr == this->head_;
+    }
+
+    waiter_type * front() const {
+      return static_cast<waiter_type *>(this->head_);
+    }
+
+    void push_back(waiter_type * waiter) {
+      waiter->next_ = nullptr;
+      if (nullptr == this->tail_) {
+        this->head_ = waiter;
+      }
+      else {
+        this->tail_->next_ = waiter;
+      }
+      this->tail_ = waiter;
+    }
+
+    waiter_type * pop_front() {
+      auto result = this->head_;
+      if (nullptr != result) {
+        this->head_ = result->next_;
+        if (nullptr == this->head_) {
+          this->tail_ = nullptr;
+        }
+        result->next_ = nullptr;
+      }
+      return static_cast<waiter_type *>(result);
+    }
+
+  private:
+    _async_waiter * head_;
+    _async_waiter * tail_;
+  };
+}
+
+#endif // __VDS_CORE_ASYNC_WAIT_QUEUE_H_
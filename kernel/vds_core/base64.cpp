@@ -0,0 +1,459 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+#include "stdafx.h"
+#include "encoding.h"
+#include "cpu_features.h"
+
+#ifdef VDS_X86_SIMD
+#define VDS_BASE64_SIMD
+#include <immintrin.h>
+#endif
+
+namespace {
+  static constexpr char pad_character = '=';
+  static constexpr uint8_t invalid_character = 0xFF;
+
+  struct base64_alphabet {
+    char encode[64];
+    uint8_t decode[256];
+
+    base64_alphabet(char ch62, char ch63) {
+      static const char letters[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+      memcpy(this->encode, letters, 62);
+      this->encode[62] = ch62;
+      this->encode[63] = ch63;
+
+      memset(this->decode, invalid_character, sizeof(this->decode));
+      for (uint8_t i = 0; i < 64; ++i) {
+        this->decode[static_cast<uint8_t>(this->encode[i])] = i;
+      }
+    }
+  };
+
+  //Function-local, so other static initializers can already use base64
+  static const base64_alphabet & standard_alphabet() {
+    static const base64_alphabet alphabet('+', '/');
+    return alphabet;
+  }
+
+  static const base64_alphabet & url_alphabet() {
+    static const base64_alphabet alphabet('-', '_');
+    return alphabet;
+  }
+
+#ifdef VDS_BASE64_SIMD
+  enum class simd_level {
+    scalar,
+    sse41,
+    avx2
+  };
+
+  static simd_level detect_simd_level() {
+    if (vds::cpu_features::has_avx2()) {
+      return simd_level::avx2;
+    }
+    if (vds::cpu_features::has_sse41()) {
+      return simd_level::sse41;
+    }
+    return simd_level::scalar;
+  }
+
+  static simd_level get_simd_level() {
+    static const simd_level level = detect_simd_level();
+    return level;
+  }
+
+  //Per-alphabet constants of the vector codecs.
+  //Encoding maps 6-bit indexes to ASCII by adding a shift picked by pshufb;
+  //decoding validates every character by its nibbles and adds a "roll" offset
+  //(see W. Mula, D. Lemire, "Faster Base64 Encoding and Decoding Using AVX2 Instructions").
+  struct simd_alphabet {
+    int8_t encode_shift[16];
+    int8_t decode_lo[16];
+    int8_t decode_hi[16];
+    int8_t decode_roll[16];
+    uint8_t roll_char;
+    uint8_t roll_index;
+  };
+
+  static const simd_alphabet standard_simd = {
+    { 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+      '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0 },
+    { 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A },
+    { 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10 },
+    { 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0 },
+    '/', 0xFF
+  };
+
+  //'_' shares the high nibble with 'P'..'Z', so it gets its own roll slot,
+  //and 0x7X gets its own class bit to reject DEL while accepting '_'
+  static const simd_alphabet url_simd = {
+    { 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+      '0' - 52, '0' - 52, '0' - 52, '-' - 62, '_' - 63, 'A', 0, 0 },
+    { 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x3B, 0x3B, 0x3A, 0x3B, 0x33 },
+    { 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x20, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10 },
+    { 0, 0, 62 - '-', 4, -65, -65, -71, -71, 63 - '_', 0, 0, 0, 0, 0, 0, 0 },
+    '_', 3
+  };
+
+  VDS_TARGET("sse4.1,ssse3")
+  static inline __m128i load_table(const int8_t (&table)[16]) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(table));
+  }
+
+  VDS_TARGET("sse4.1,ssse3")
+  static inline __m128i encode_block_sse(__m128i in, __m128i shift_lut) {
+    //Spread 12 bytes into 16 lanes of 6 bits
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    const __m128i indices = _mm_or_si128(t1, t3);
+
+    __m128i result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    const __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+    return _mm_add_epi8(_mm_shuffle_epi8(shift_lut, result), indices);
+  }
+
+  VDS_TARGET("sse4.1,ssse3")
+  static size_t encode_sse41(const uint8_t * data, size_t len, char * out, const simd_alphabet & alphabet) {
+    const __m128i shift_lut = load_table(alphabet.encode_shift);
+
+    size_t processed = 0;
+    while (processed + 16 <= len) {
+      const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + processed));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out), encode_block_sse(in, shift_lut));
+      processed += 12;
+      out += 16;
+    }
+
+    return processed;
+  }
+
+  VDS_TARGET("sse4.1,ssse3")
+  static size_t decode_sse41(const char * data, size_t len, uint8_t * out, const simd_alphabet & alphabet) {
+    const __m128i lut_lo = load_table(alphabet.decode_lo);
+    const __m128i lut_hi = load_table(alphabet.decode_hi);
+    const __m128i lut_roll = load_table(alphabet.decode_roll);
+    const __m128i roll_char = _mm_set1_epi8(static_cast<char>(alphabet.roll_char));
+    const __m128i roll_index = _mm_set1_epi8(static_cast<char>(alphabet.roll_index));
+    const __m128i mask_0f = _mm_set1_epi8(0x0F);
+
+    size_t processed = 0;
+    while (processed + 16 <= len) {
+      __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + processed));
+
+      const __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(in, 4), mask_0f);
+      const __m128i lo_nibbles = _mm_and_si128(in, mask_0f);
+      const __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+      const __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+      if (!_mm_testz_si128(lo, hi)) {
+        break;
+      }
+
+      const __m128i roll_shift = _mm_and_si128(_mm_cmpeq_epi8(in, roll_char), roll_index);
+      const __m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(roll_shift, hi_nibbles));
+      in = _mm_add_epi8(in, roll);
+
+      //Pack 16 lanes of 6 bits into 12 bytes
+      const __m128i merge_ab_and_bc = _mm_maddubs_epi16(in, _mm_set1_epi32(0x01400140));
+      __m128i result = _mm_madd_epi16(merge_ab_and_bc, _mm_set1_epi32(0x00011000));
+      result = _mm_shuffle_epi8(result, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+      uint8_t buffer[16];
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(buffer), result);
+      memcpy(out, buffer, 12);
+
+      processed += 16;
+      out += 12;
+    }
+
+    return processed;
+  }
+
+  VDS_TARGET("avx2")
+  static size_t encode_avx2(const uint8_t * data, size_t len, char * out, const simd_alphabet & alphabet) {
+    const __m128i shift_lut128 = load_table(alphabet.encode_shift);
+    const __m256i shift_lut = _mm256_broadcastsi128_si256(shift_lut128);
+
+    size_t processed = 0;
+    while (processed + 28 <= len) {
+      __m256i in = _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + processed)));
+      in = _mm256_inserti128_si256(in, _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + processed + 12)), 1);
+
+      in = _mm256_shuffle_epi8(in, _mm256_setr_epi8(
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+      const __m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+      const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+      const __m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+      const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+      const __m256i indices = _mm256_or_si256(t1, t3);
+
+      __m256i result = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+      const __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+      result = _mm256_or_si256(result, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+      result = _mm256_add_epi8(_mm256_shuffle_epi8(shift_lut, result), indices);
+
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), result);
+      processed += 24;
+      out += 32;
+    }
+
+    //Avoid the AVX-SSE transition penalty in the code that follows
+    _mm256_zeroupper();
+    return processed;
+  }
+
+  VDS_TARGET("avx2")
+  static size_t decode_avx2(const char * data, size_t len, uint8_t * out, const simd_alphabet & alphabet) {
+    const __m256i lut_lo = _mm256_broadcastsi128_si256(load_table(alphabet.decode_lo));
+    const __m256i lut_hi = _mm256_broadcastsi128_si256(load_table(alphabet.decode_hi));
+    const __m256i lut_roll = _mm256_broadcastsi128_si256(load_table(alphabet.decode_roll));
+    const __m256i roll_char = _mm256_set1_epi8(static_cast<char>(alphabet.roll_char));
+    const __m256i roll_index = _mm256_set1_epi8(static_cast<char>(alphabet.roll_index));
+    const __m256i mask_0f = _mm256_set1_epi8(0x0F);
+
+    size_t processed = 0;
+    while (processed + 32 <= len) {
+      __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + processed));
+
+      const __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(in, 4), mask_0f);
+      const __m256i lo_nibbles = _mm256_and_si256(in, mask_0f);
+      const __m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+      const __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+      if (!_mm256_testz_si256(lo, hi)) {
+        break;
+      }
+
+      const __m256i roll_shift = _mm256_and_si256(_mm256_cmpeq_epi8(in, roll_char), roll_index);
+      const __m256i roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(roll_shift, hi_nibbles));
+      in = _mm256_add_epi8(in, roll);
+
+      const __m256i merge_ab_and_bc = _mm256_maddubs_epi16(in, _mm256_set1_epi32(0x01400140));
+      __m256i result = _mm256_madd_epi16(merge_ab_and_bc, _mm256_set1_epi32(0x00011000));
+      result = _mm256_shuffle_epi8(result, _mm256_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+      result = _mm256_permutevar8x32_epi32(result, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+
+      uint8_t buffer[32];
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(buffer), result);
+      memcpy(out, buffer, 24);
+
+      processed += 32;
+      out += 24;
+    }
+
+    //Avoid the AVX-SSE transition penalty in the code that follows
+    _mm256_zeroupper();
+    return processed;
+  }
+
+  //Returns the number of bytes encoded; the remainder is left to the scalar code
+  static size_t encode_simd(const uint8_t * data, size_t len, char * out, const simd_alphabet & alphabet) {
+    size_t processed = 0;
+    switch (get_simd_level()) {
+    case simd_level::avx2:
+      processed = encode_avx2(data, len, out, alphabet);
+      //fallthrough
+    case simd_level::sse41:
+      processed += encode_sse41(data + processed, len - processed, out + 4 * (processed / 3), alphabet);
+      break;
+    default:
+      break;
+    }
+    return processed;
+  }
+
+  //Returns the number of characters decoded; the remainder is left to the scalar code
+  static size_t decode_simd(const char * data, size_t len, uint8_t * out, const simd_alphabet & alphabet) {
+    size_t processed = 0;
+    switch (get_simd_level()) {
+    case simd_level::avx2:
+      processed = decode_avx2(data, len, out, alphabet);
+      //fallthrough
+    case simd_level::sse41:
+      processed += decode_sse41(data + processed, len - processed, out + 3 * (processed / 4), alphabet);
+      break;
+    default:
+      break;
+    }
+    return processed;
+  }
+#endif//VDS_BASE64_SIMD
+
+  static std::string encode(
+    const uint8_t * data,
+    size_t len,
+    const base64_alphabet & alphabet,
+#ifdef VDS_BASE64_SIMD
+    const simd_alphabet & simd,
+#endif
+    bool with_padding) {
+
+    const size_t tail = len % 3;
+    std::string result;
+    result.resize(4 * (len / 3) + (tail ? (with_padding ? 4 : tail + 1) : 0));
+    char * out = &result[0];
+
+#ifdef VDS_BASE64_SIMD
+    const auto processed = encode_simd(data, len, out, simd);
+    data += processed;
+    len -= processed;
+    out += 4 * (processed / 3);
+#endif
+
+    for (; 2 < len; len -= 3) {
+      const uint32_t value = (uint32_t(data[0]) << 16) | (uint32_t(data[1]) << 8) | data[2];
+      out[0] = alphabet.encode[(value >> 18) & 0x3F];
+      out[1] = alphabet.encode[(value >> 12) & 0x3F];
+      out[2] = alphabet.encode[(value >> 6) & 0x3F];
+      out[3] = alphabet.encode[value & 0x3F];
+      data += 3;
+      out += 4;
+    }
+
+    switch (len) {
+    case 1: {
+      const uint32_t value = uint32_t(data[0]) << 16;
+      out[0] = alphabet.encode[(value >> 18) & 0x3F];
+      out[1] = alphabet.encode[(value >> 12) & 0x3F];
+      if (with_padding) {
+        out[2] = pad_character;
+        out[3] = pad_character;
+      }
+      break;
+    }
+    case 2: {
+      const uint32_t value = (uint32_t(data[0]) << 16) | (uint32_t(data[1]) << 8);
+      out[0] = alphabet.encode[(value >> 18) & 0x3F];
+      out[1] = alphabet.encode[(value >> 12) & 0x3F];
+      out[2] = alphabet.encode[(value >> 6) & 0x3F];
+      if (with_padding) {
+        out[3] = pad_character;
+      }
+      break;
+    }
+    }
+
+    return result;
+  }
+
+  static vds::expected<vds::const_data_buffer> decode(
+    const char * data,
+    size_t len,
+    const base64_alphabet & alphabet,
+#ifdef VDS_BASE64_SIMD
+    const simd_alphabet & simd,
+#endif
+    bool padding_required) {
+
+    size_t padding = 0;
+    if (0 < len && pad_character == data[len - 1]) {
+      ++padding;
+      if (1 < len && pad_character == data[len - 2]) {
+        ++padding;
+      }
+    }
+
+    if (padding_required || 0 < padding) {
+      if (0 != len % 4) {
+        return vds::make_unexpected<std::runtime_error>("Non-Valid base64!");
+      }
+      len -= padding;
+    }
+    else if (1 == len % 4) {
+      return vds::make_unexpected<std::runtime_error>("Non-Valid base64!");
+    }
+
+    //Unpadded tail of 2 or 3 characters gives 1 or 2 bytes
+    const size_t tail = len % 4;
+    vds::const_data_buffer result;
+    result.resize(3 * (len / 4) + (tail ? tail - 1 : 0));
+    uint8_t * out = result.data();
+
+#ifdef VDS_BASE64_SIMD
+    //The vector loop stops at the first block with an invalid character,
+    //the scalar loop below reports the error
+    const auto processed = decode_simd(data, len, out, simd);
+    data += processed;
+    len -= processed;
+    out += 3 * (processed / 4);
+#endif
+
+    for (; 3 < len; len -= 4) {
+      const uint8_t a = alphabet.decode[static_cast<uint8_t>(data[0])];
+      const uint8_t b = alphabet.decode[static_cast<uint8_t>(data[1])];
+      const uint8_t c = alphabet.decode[static_cast<uint8_t>(data[2])];
+      const uint8_t d = alphabet.decode[static_cast<uint8_t>(data[3])];
+      if (0 != ((a | b | c | d) & 0x80)) {
+        return vds::make_unexpected<std::runtime_error>("Non-Valid Character in Base 64!");
+      }
+
+      const uint32_t value = (uint32_t(a) << 18) | (uint32_t(b) << 12) | (uint32_t(c) << 6) | d;
+      out[0] = static_cast<uint8_t>(value >> 16);
+      out[1] = static_cast<uint8_t>(value >> 8);
+      out[2] = static_cast<uint8_t>(value);
+      data += 4;
+      out += 3;
+    }
+
+    if (1 < len) {
+      const uint8_t a = alphabet.decode[static_cast<uint8_t>(data[0])];
+      const uint8_t b = alphabet.decode[static_cast<uint8_t>(data[1])];
+      const uint8_t c = (2 < len) ? alphabet.decode[static_cast<uint8_t>(data[2])] : 0;
+      if (0 != ((a | b | c) & 0x80)) {
+        return vds::make_unexpected<std::runtime_error>("Non-Valid Character in Base 64!");
+      }
+
+      const uint32_t value = (uint32_t(a) << 18) | (uint32_t(b) << 12) | (uint32_t(c) << 6);
+      out[0] = static_cast<uint8_t>(value >> 16);
+      if (2 < len) {
+        out[1] = static_cast<uint8_t>(value >> 8);
+      }
+    }
+
+    return result;
+  }
+}
+
+#ifdef VDS_BASE64_SIMD
+#define VDS_SIMD_ALPHABET(name) , name
+#else
+#define VDS_SIMD_ALPHABET(name)
+#endif
+
+std::string vds::base64::from_bytes(const void * data, size_t len)
+{
+  return encode(static_cast<const uint8_t *>(data), len, standard_alphabet() VDS_SIMD_ALPHABET(standard_simd), true);
+}
+
+std::string vds::base64::from_bytes(const const_data_buffer & data)
+{
+  return from_bytes(data.data(), data.size());
+}
+
+vds::expected<vds::const_data_buffer> vds::base64::to_bytes(const std::string& data)
+{
+  return decode(data.c_str(), data.length(), standard_alphabet() VDS_SIMD_ALPHABET(standard_simd), true);
+}
+
+std::string vds::base64::url_from_bytes(const void * data, size_t len)
+{
+  return encode(static_cast<const uint8_t *>(data), len, url_alphabet() VDS_SIMD_ALPHABET(url_simd), false);
+}
+
+std::string vds::base64::url_from_bytes(const const_data_buffer & data)
+{
+  return url_from_bytes(data.data(), data.size());
+}
+
+vds::expected<vds::const_data_buffer> vds::base64::url_to_bytes(const std::string& data)
+{
+  return decode(data.c_str(), data.length(), url_alphabet() VDS_SIMD_ALPHABET(url_simd), false);
+}
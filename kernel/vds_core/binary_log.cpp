@@ -0,0 +1,281 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include "binary_log.h"
+#include "private/binary_log_p.h"
+#include "logger.h"
+#include "file.h"
+
+namespace {
+  struct thread_ring {
+    thread_ring()
+    : serial(0) {
+    }
+
+    ~thread_ring() {
+      if (this->ring) {
+        this->ring->abandon();
+      }
+    }
+
+    uint64_t serial;
+    std::shared_ptr<vds::_binary_log_ring> ring;
+  };
+
+  thread_local thread_ring current_thread_ring;
+
+  uint64_t next_serial() {
+    static std::atomic<uint64_t> last_serial(0);
+    return ++last_serial;
+  }
+
+  uint32_t current_thread_id() {
+#ifndef _WIN32
+    return static_cast<uint32_t>(syscall(SYS_gettid));
+#else
+    return static_cast<uint32_t>(GetCurrentThreadId());
+#endif
+  }
+
+  uint64_t current_time() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count());
+  }
+
+  template <typename value_type>
+  uint8_t * put_le(uint8_t * p, value_type value) {
+    for (size_t i = 0; i < sizeof(value_type); ++i) {
+      *p++ = static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i));
+    }
+    return p;
+  }
+
+  template <typename value_type>
+  void append_le(std::vector<uint8_t> & result, value_type value) {
+    uint8_t buffer[sizeof(value_type)];
+    put_le(buffer, value);
+    result.insert(result.end(), buffer, buffer + sizeof(buffer));
+  }
+
+  void append_string(std::vector<uint8_t> & result, const char * value, size_t len) {
+    if (0xFFFF < len) {
+      len = 0xFFFF;
+    }
+    append_le(result, static_cast<uint16_t>(len));
+    result.insert(result.end(), value, value + len);
+  }
+}
+
+static_assert(vds::binary_log::max_modules == vds::log_module::max_count, "Invalid module count");
+static_assert(vds::binary_log::max_levels == static_cast<size_t>(vds::log_level::ll_error) + 1, "Invalid level count");
+
+vds::binary_log::binary_log()
+: serial_(next_serial()), last_format_id_(0), is_stopping_(false) {
+  for (auto & module_formats : this->message_formats_) {
+    for (auto & format_id : module_formats) {
+      format_id.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+vds::binary_log::~binary_log() {
+  this->stop();
+}
+
+vds::expected<void> vds::binary_log::start(const filename & fn) {
+  file f;
+  CHECK_EXPECTED(f.open(fn, file::file_mode::append));
+
+  GET_EXPECTED(length, f.length());
+  if (0 == length) {
+    std::vector<uint8_t> header{ 'V', 'L', 'O', 'G' };
+    append_le(header, version);
+    CHECK_EXPECTED(f.write(header.data(), header.size()));
+  }
+
+  this->f_.reset(new file(std::move(f)));
+  this->flush_thread_ = std::thread([this]() { this->flush_thread(); });
+
+  return expected<void>();
+}
+
+void vds::binary_log::stop() {
+  if (!this->flush_thread_.joinable()) {
+    return;
+  }
+
+  this->stop_mutex_.lock();
+  this->is_stopping_ = true;
+  this->stop_cond_.notify_all();
+  this->stop_mutex_.unlock();
+
+  this->flush_thread_.join();
+  this->flush();
+
+  (void)this->f_->close();
+  this->f_.reset();
+}
+
+void vds::binary_log::write(
+  log_site & site,
+  uint32_t module_id,
+  log_level level,
+  const char * format,
+  const _binary_log_args & args) {
+
+  const auto tag = (this->serial_ & 0xFFFFFFFF) << 32;
+  auto format_key = site.format_key.load(std::memory_order_acquire);
+  if (tag != (format_key & 0xFFFFFFFF00000000ULL)) {
+    format_key = tag | this->register_format(module_id, level, format);
+    site.format_key.store(format_key, std::memory_order_release);
+  }
+
+  const auto format_id = static_cast<uint32_t>(format_key);
+  this->push(format_id, args.data(), args.size());
+}
+
+void vds::binary_log::write(const log_record & record) {
+  auto format_id = this->message_formats_[record.module_id][static_cast<size_t>(record.level)].load(std::memory_order_acquire);
+  if (0 == format_id) {
+    format_id = this->register_message_format(record.module_id, record.level);
+  }
+
+  _binary_log_args args;
+  args.add(record.message);
+  this->push(format_id, args.data(), args.size());
+}
+
+uint32_t vds::binary_log::register_format(uint32_t module_id, log_level level, const char * format) {
+  std::unique_lock<std::mutex> lock(this->formats_mutex_);
+  return this->add_format(module_id, level, format);
+}
+
+uint32_t vds::binary_log::register_message_format(uint32_t module_id, log_level level) {
+  std::unique_lock<std::mutex> lock(this->formats_mutex_);
+
+  //Another thread may have registered it while this one waited for the lock
+  auto & slot = this->message_formats_[module_id][static_cast<size_t>(level)];
+  auto format_id = slot.load(std::memory_order_relaxed);
+  if (0 == format_id) {
+    format_id = this->add_format(module_id, level, "%s");
+    slot.store(format_id, std::memory_order_release);
+  }
+
+  return format_id;
+}
+
+//Called under formats_mutex_
+uint32_t vds::binary_log::add_format(uint32_t module_id, log_level level, const char * format) {
+  const auto format_id = ++this->last_format_id_;
+
+  const auto & module = log_module::name(module_id);
+  this->pending_formats_.push_back(format_block);
+  append_le(this->pending_formats_, format_id);
+  this->pending_formats_.push_back(static_cast<uint8_t>(level));
+  append_string(this->pending_formats_, module.c_str(), module.length());
+  append_string(this->pending_formats_, format, strlen(format));
+
+  return format_id;
+}
+
+void vds::binary_log::push(uint32_t format_id, const uint8_t * args, size_t args_size) {
+  auto ring = this->current_ring();
+
+  uint8_t record[1 + 4 + 8 + 4 + 2 + _binary_log_args::max_size];
+  auto p = record;
+  *p++ = record_block;
+  p = put_le(p, ring->thread_id());
+  p = put_le(p, current_time());
+  p = put_le(p, format_id);
+  p = put_le(p, static_cast<uint16_t>(args_size));
+  memcpy(p, args, args_size);
+  p += args_size;
+
+  ring->push(record, p - record);
+}
+
+vds::_binary_log_ring * vds::binary_log::current_ring() {
+  auto & current = current_thread_ring;
+  if (current.serial != this->serial_) {
+    if (current.ring) {
+      current.ring->abandon();
+    }
+
+    current.ring = std::make_shared<_binary_log_ring>(current_thread_id());
+    current.serial = this->serial_;
+
+    std::unique_lock<std::mutex> lock(this->rings_mutex_);
+    this->rings_.push_back(current.ring);
+  }
+
+  return current.ring.get();
+}
+
+void vds::binary_log::flush() {
+  std::unique_lock<std::mutex> flush_lock(this->flush_mutex_);
+  if (!this->f_) {
+    return;
+  }
+
+  //Rings are drained before the pending formats are taken,
+  //so every drained record has its format written ahead of it
+  std::vector<uint8_t> records;
+  {
+    std::unique_lock<std::mutex> lock(this->rings_mutex_);
+    for (auto p = this->rings_.begin(); this->rings_.end() != p;) {
+      auto & ring = *p;
+      const auto is_abandoned = ring->is_abandoned();
+      ring->pop(records);
+
+      const auto dropped = ring->take_dropped();
+      if (0 < dropped) {
+        records.push_back(dropped_block);
+        append_le(records, ring->thread_id());
+        append_le(records, current_time());
+        append_le(records, dropped);
+      }
+
+      if (is_abandoned) {
+        p = this->rings_.erase(p);
+      }
+      else {
+        ++p;
+      }
+    }
+  }
+
+  this->buffer_.clear();
+  {
+    std::unique_lock<std::mutex> lock(this->formats_mutex_);
+    this->buffer_.swap(this->pending_formats_);
+  }
+
+  if (this->buffer_.empty() && records.empty()) {
+    return;
+  }
+
+  this->buffer_.insert(this->buffer_.end(), records.begin(), records.end());
+  (void)this->f_->write(this->buffer_.data(), this->buffer_.size());
+  (void)this->f_->flush();
+}
+
+void vds::binary_log::flush_thread() {
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(this->stop_mutex_);
+      if (this->is_stopping_) {
+        return;
+      }
+
+      this->stop_cond_.wait_for(lock, std::chrono::milliseconds(100));
+      if (this->is_stopping_) {
+        return;
+      }
+    }
+
+    this->flush();
+  }
+}
@@ -0,0 +1,207 @@
+#ifndef __VDS_CORE_BINARY_LOG_H_
+#define __VDS_CORE_BINARY_LOG_H_
+
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "filename.h"
+
+namespace vds {
+  enum class log_level;
+  struct log_record;
+  class file;
+  class _binary_log_ring;
+
+  //VDS_LOG call site. The format id is assigned on the first binary write
+  //and is tagged with the log instance in the high 32 bits.
+  struct log_site {
+    constexpr log_site()
+    : format_key(0) {
+    }
+
+    std::atomic<uint64_t> format_key;
+  };
+
+  //Raw log arguments: a type tag followed by the little-endian value.
+  //'i' - int64, 'u' - uint64, 'd' - double, 'p' - pointer as uint64, 's' - uint16 length and bytes
+  class _binary_log_args {
+  public:
+    static constexpr size_t max_size = 2048;
+
+    _binary_log_args()
+    : size_(0) {
+    }
+
+    template <typename value_type>
+    typename std::enable_if<std::is_integral<value_type>::value && std::is_signed<value_type>::value>::type
+    add(value_type value) {
+      this->put_value('i', static_cast<uint64_t>(static_cast<int64_t>(value)));
+    }
+
+    template <typename value_type>
+    typename std::enable_if<std::is_integral<value_type>::value && !std::is_signed<value_type>::value>::type
+    add(value_type value) {
+      this->put_value('u', static_cast<uint64_t>(value));
+    }
+
+    template <typename value_type>
+    typename std::enable_if<std::is_enum<value_type>::value>::type
+    add(value_type value) {
+      this->put_value('i', static_cast<uint64_t>(static_cast<int64_t>(value)));
+    }
+
+    template <typename value_type>
+    typename std::enable_if<std::is_floating_point<value_type>::value>::type
+    add(value_type value) {
+      const double v = value;
+      uint64_t bits;
+      memcpy(&bits, &v, sizeof(bits));
+      this->put_value('d', bits);
+    }
+
+    template <typename value_type>
+    void add(const value_type * value) {
+      this->put_value('p', static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)));
+    }
+
+    void add(const char * value) {
+      this->put_string(value, (nullptr == value) ? 0 : strlen(value));
+    }
+
+    void add(char * value) {
+      this->add(static_cast<const char *>(value));
+    }
+
+    void add(const std::string & value) {
+      this->put_string(value.c_str(), value.length());
+    }
+
+    const uint8_t * data() const {
+      return this->data_;
+    }
+
+    size_t size() const {
+      return this->size_;
+    }
+
+  private:
+    uint8_t data_[max_size];
+    size_t size_;
+
+    void put_value(uint8_t tag, uint64_t value) {
+      if (max_size < this->size_ + 9) {
+        return;
+      }
+
+      this->data_[this->size_++] = tag;
+      for (int i = 0; i < 8; ++i) {
+        this->data_[this->size_++] = static_cast<uint8_t>(value >> (8 * i));
+      }
+    }
+
+    //Long strings are truncated to the space left
+    void put_string(const char * value, size_t len) {
+      if (max_size < this->size_ + 3) {
+        return;
+      }
+
+      if (max_size - this->size_ - 3 < len) {
+        len = max_size - this->size_ - 3;
+      }
+
+      this->data_[this->size_++] = 's';
+      this->data_[this->size_++] = static_cast<uint8_t>(len);
+      this->data_[this->size_++] = static_cast<uint8_t>(len >> 8);
+      if (0 < len) {
+        memcpy(this->data_ + this->size_, value, len);
+        this->size_ += len;
+      }
+    }
+  };
+
+  //Binary log: call sites write a format id and raw arguments into per-thread ring buffers,
+  //the background thread flushes them to the .vlog file. Text is rendered offline by log_parser.
+  //
+  //File layout: "VLOG", uint32 version, then blocks. All integers are little-endian.
+  //  format:  uint8 1, uint32 id, uint8 level, uint16 module length, module, uint16 format length, format
+  //  record:  uint8 2, uint32 thread id, uint64 time (ns since epoch), uint32 format id, uint16 args size, args
+  //  dropped: uint8 3, uint32 thread id, uint64 time, uint64 count of records lost on a full ring
+  class binary_log {
+  public:
+    static constexpr uint32_t version = 1;
+
+    //log_module::max_count and the number of log levels
+    static constexpr size_t max_modules = 256;
+    static constexpr size_t max_levels = 5;
+
+    static constexpr uint8_t format_block = 1;
+    static constexpr uint8_t record_block = 2;
+    static constexpr uint8_t dropped_block = 3;
+
+    binary_log();
+    ~binary_log();
+
+    //Records written before start are kept in the ring buffers
+    expected<void> start(const filename & fn);
+    void stop();
+
+    //Write all buffered records to the file
+    void flush();
+
+    void write(
+      log_site & site,
+      uint32_t module_id,
+      log_level level,
+      const char * format,
+      const _binary_log_args & args);
+
+    //Already formatted message
+    void write(const log_record & record);
+
+  private:
+    //Distinguishes instances in the per-thread ring cache
+    const uint64_t serial_;
+
+    std::mutex formats_mutex_;
+    uint32_t last_format_id_;
+    std::vector<uint8_t> pending_formats_;
+
+    //"%s" format id of the preformatted messages, 0 until registered
+    std::atomic<uint32_t> message_formats_[max_modules][max_levels];
+
+    std::mutex rings_mutex_;
+    std::list<std::shared_ptr<_binary_log_ring>> rings_;
+
+    std::mutex flush_mutex_;
+    std::unique_ptr<file> f_;
+    std::vector<uint8_t> buffer_;
+
+    std::mutex stop_mutex_;
+    std::condition_variable stop_cond_;
+    bool is_stopping_;
+    std::thread flush_thread_;
+
+    uint32_t register_format(uint32_t module_id, log_level level, const char * format);
+    uint32_t register_message_format(uint32_t module_id, log_level level);
+    uint32_t add_format(uint32_t module_id, log_level level, const char * format);
+    void push(uint32_t format_id, const uint8_t * args, size_t args_size);
+    _binary_log_ring * current_ring();
+
+    void flush_thread();
+  };
+}
+
+#endif // __VDS_CORE_BINARY_LOG_H_
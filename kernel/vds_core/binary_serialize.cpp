@@ -17,28 +17,17 @@ vds::expected<void> vds::binary_serializer::put(uint8_t value)
 
 vds::expected<void> vds::binary_serializer::put(uint16_t value)
 {
-  CHECK_EXPECTED(this->data_.add((value >> 8) & 0xFF));
-  return this->data_.add(value & 0xFF);
+  return this->put_array(&value, 1);
 }
 
 vds::expected<void> vds::binary_serializer::put(uint32_t value)
 {
-  CHECK_EXPECTED(this->data_.add((value >> 24) & 0xFF));
-  CHECK_EXPECTED(this->data_.add((value >> 16) & 0xFF));
-  CHECK_EXPECTED(this->data_.add((value >> 8) & 0xFF));
-  return this->data_.add(value & 0xFF);
+  return this->put_array(&value, 1);
 }
 
 vds::expected<void> vds::binary_serializer::put(uint64_t value)
 {
-  CHECK_EXPECTED(this->data_.add((value >> 56) & 0xFF));
-  CHECK_EXPECTED(this->data_.add((value >> 48) & 0xFF));
-  CHECK_EXPECTED(this->data_.add((value >> 40) & 0xFF));
-  CHECK_EXPECTED(this->data_.add((value >> 32) & 0xFF));
-  CHECK_EXPECTED(this->data_.add((value >> 24) & 0xFF));
-  CHECK_EXPECTED(this->data_.add((value >> 16) & 0xFF));
-  CHECK_EXPECTED(this->data_.add((value >> 8) & 0xFF));
-  return this->data_.add(value & 0xFF);
+  return this->put_array(&value, 1);
 }
 
 vds::expected<void> vds::binary_serializer::write_number(uint64_t value)
@@ -50,19 +39,15 @@ vds::expected<void> vds::binary_serializer::write_number(uint64_t value)
   
   value -= 128;
   
-  uint8_t data[8];
-  int index = 0;
+  uint8_t data[9];
+  int index = 9;
   do {
-    data[index++] = (value & 0xFF);
+    data[--index] = (value & 0xFF);
     value >>= 8;
   } while (0 != value);
   
-  CHECK_EXPECTED(this->data_.add((uint8_t)(0x80 | index)));
-  while(index > 0){
-      CHECK_EXPECTED(this->data_.add(data[--index]));
-  }
-  
-  return expected<void>();
+  data[index - 1] = (uint8_t)(0x80 | (9 - index));
+  return this->data_.add(data + index - 1, 10 - index);
 }
 
 vds::expected<void> vds::binary_serializer::put(const std::string & value)
@@ -214,6 +199,20 @@ vds::expected<void> vds::binary_deserializer::get(vds::const_data_buffer & data)
   return expected<void>();
 }
 
+vds::expected<void> vds::binary_deserializer::get(vds::const_data_view & data)
+{
+  GET_EXPECTED(len, this->read_number());
+  if (len > this->len_) {
+    return vds::make_unexpected<std::runtime_error>("Invalid data");
+  }
+
+  data = const_data_view(this->data_, safe_cast<size_t>(len));
+  this->data_ += safe_cast<size_t>(len);
+  this->len_ -= safe_cast<size_t>(len);
+
+  return expected<void>();
+}
+
 vds::expected<void> vds::binary_deserializer::pop_data(void* data, size_t& size, bool serialize_size)
 {
   if(serialize_size){
@@ -8,8 +8,10 @@ All rights reserved
 #include <list>
 #include <set>
 #include <map>
+#include <type_traits>
 #include "types.h"
 #include "const_data_buffer.h"
+#include "const_data_view.h"
 #include "resizable_data_buffer.h"
 #include "expected.h"
 
@@ -41,6 +43,20 @@ namespace vds {
     
     expected<void> put(const const_data_buffer & data);
 
+    //Integers stored in the same format as put() for each item, with one size check
+    template <typename value_type>
+    expected<void> put_array(const value_type * values, size_t count);
+
+    //Preallocate the exact size computed by binary_sizer
+    expected<void> reserve(size_t size) {
+      return this->data_.reserve(size);
+    }
+
+    //Drop the data but keep the memory for the next message
+    void clear() {
+      this->data_.clear();
+    }
+
     const uint8_t * get_buffer() const {
       return this->data_.data();
     }
@@ -55,6 +71,30 @@ namespace vds {
     resizable_data_buffer data_;
   };
 
+  template <typename value_type>
+  inline expected<void> binary_serializer::put_array(const value_type * values, size_t count) {
+    static_assert(std::is_integral<value_type>::value && !std::is_same<value_type, bool>::value, "Integer array is expected");
+
+    const auto size = count * sizeof(value_type);
+    CHECK_EXPECTED(this->data_.resize_data(this->data_.size() + size));
+
+    auto p = this->data_.data() + this->data_.size();
+    if (1 == sizeof(value_type)) {
+      memcpy(p, values, size);
+    }
+    else {
+      for (size_t i = 0; i < count; ++i) {
+        const auto value = static_cast<uint64_t>(values[i]);
+        for (size_t shift = 8 * sizeof(value_type); shift > 0; shift -= 8) {
+          *p++ = static_cast<uint8_t>(value >> (shift - 8));
+        }
+      }
+    }
+
+    this->data_.apply_size(size);
+    return expected<void>();
+  }
+
   inline expected<void> operator <<(binary_serializer & s, bool value) {
     return s.put(value);
   }
@@ -93,6 +133,11 @@ namespace vds {
     return s.put(data);
   }
 
+  //Same format as const_data_buffer
+  inline expected<void> operator <<(binary_serializer & s, const const_data_view & data) {
+    return s.push_data(data.data(), data.size(), true);
+  }
+
   template <typename T>
   inline expected<void> operator <<(binary_serializer & s, const std::list<T> & value)
   {
@@ -147,6 +192,126 @@ namespace vds {
     return (s << value.value());
   }
 
+  //Sizing pass: counts the bytes binary_serializer would write for the same values
+  class binary_sizer
+  {
+  public:
+    binary_sizer()
+    : size_(0) {
+    }
+
+    void add(size_t size) {
+      this->size_ += size;
+    }
+
+    void add_number(uint64_t value) {
+      this->size_ += number_size(value);
+    }
+
+    size_t size() const {
+      return this->size_;
+    }
+
+    //The first error of a field measured by serializing it
+    void set_error(std::unique_ptr<std::exception> && error) {
+      if (!this->error_) {
+        this->error_ = std::move(error);
+      }
+    }
+
+    std::unique_ptr<std::exception> & error() {
+      return this->error_;
+    }
+
+    //Size of binary_serializer::write_number
+    static size_t number_size(uint64_t value) {
+      if (128 > value) {
+        return 1;
+      }
+
+      value -= 128;
+      size_t result = 1;
+      do {
+        ++result;
+        value >>= 8;
+      } while (0 != value);
+
+      return result;
+    }
+
+  private:
+    size_t size_;
+    std::unique_ptr<std::exception> error_;
+  };
+
+  inline void operator <<(binary_sizer & s, bool) {
+    s.add(1);
+  }
+
+  inline void operator <<(binary_sizer & s, uint8_t) {
+    s.add(1);
+  }
+
+  inline void operator <<(binary_sizer & s, uint16_t) {
+    s.add(2);
+  }
+
+  inline void operator <<(binary_sizer & s, uint32_t) {
+    s.add(4);
+  }
+
+  inline void operator <<(binary_sizer & s, uint64_t) {
+    s.add(8);
+  }
+
+  inline void operator <<(binary_sizer & s, const std::string & value) {
+    s.add_number(value.length());
+    s.add(value.length());
+  }
+
+  inline void operator <<(binary_sizer & s, const const_data_buffer & data) {
+    s.add_number(data.size());
+    s.add(data.size());
+  }
+
+  inline void operator <<(binary_sizer & s, const const_data_view & data) {
+    s.add_number(data.size());
+    s.add(data.size());
+  }
+
+  template <typename T>
+  inline void operator <<(binary_sizer & s, const std::list<T> & value) {
+    s.add_number(value.size());
+    for (auto & p : value) {
+      s << p;
+    }
+  }
+
+  template <typename T>
+  inline void operator <<(binary_sizer & s, const std::vector<T> & value) {
+    s.add_number(value.size());
+    for (auto & p : value) {
+      s << p;
+    }
+  }
+
+  template <typename T>
+  inline void operator <<(binary_sizer & s, const std::set<T> & value) {
+    s.add_number(value.size());
+    for (auto & p : value) {
+      s << p;
+    }
+  }
+
+  template <typename TKey, typename TValue>
+  inline void operator <<(binary_sizer & s, const std::map<TKey, TValue> & value) {
+    s.add_number(value.size());
+    for (const auto & p : value) {
+      s << p.first;
+      s << p.second;
+    }
+  }
+
   class binary_deserializer
   {
   public:
@@ -172,6 +337,9 @@ namespace vds {
     expected<void> get(std::string & value);
    
     expected<void> get(const_data_buffer & data);
+
+    //Zero-copy: the view points into the source buffer
+    expected<void> get(const_data_view & data);
     
     expected<uint64_t> read_number();
 
@@ -219,6 +387,10 @@ namespace vds {
     return s.get(data);
   }
 
+  inline expected<void> operator >>(binary_deserializer & s, const_data_view & data) {
+    return s.get(data);
+  }
+
   template <typename T>
   inline expected<void> operator >>(binary_deserializer & s, std::list<T> & value)
   {
@@ -378,6 +550,54 @@ namespace vds {
     }
   };
 
+  class _size_visitor {
+  public:
+    _size_visitor(vds::binary_sizer & s)
+      : s_(s) {
+    }
+
+    template <typename... field_types>
+    _size_visitor & operator ()(field_types & ... fields) {
+      (void)std::initializer_list<int>{ ((this->s_ << fields), 0)... };
+      return *this;
+    }
+
+    _size_visitor & operator ()(void) {
+      return *this;
+    }
+
+  private:
+    vds::binary_sizer & s_;
+  };
+
+  template <typename T, typename = void>
+  struct _is_message : std::false_type {
+  };
+
+  template <typename T>
+  struct _is_message<T, decltype((void)std::declval<T &>().visit(std::declval<_size_visitor &>()))> : std::true_type {
+  };
+
+  //Nested messages are measured field by field
+  template <typename T>
+  inline typename std::enable_if<_is_message<T>::value>::type operator <<(binary_sizer & s, const T & value) {
+    _size_visitor v(s);
+    const_cast<T *>(&value)->visit(v);
+  }
+
+  //Leaf types with only a binary_serializer operator, like certificates, are measured by serializing them
+  template <typename T>
+  inline typename std::enable_if<!_is_message<T>::value>::type operator <<(binary_sizer & s, const T & value) {
+    binary_serializer b;
+    auto result = (b << value);
+    if (result.has_error()) {
+      s.set_error(std::move(result.error()));
+      return;
+    }
+
+    s.add(b.size());
+  }
+
   class _deserialize_visitor {
   public:
     _deserialize_visitor(vds::binary_deserializer & b)
@@ -435,10 +655,27 @@ namespace vds {
     return message;
   }
 
+  template<typename message_type>
+  inline expected<size_t> message_size(const message_type & message)
+  {
+    vds::binary_sizer s;
+    _size_visitor v(s);
+    const_cast<typename std::remove_const<message_type>::type *>(&message)->visit(v);
+    if (s.error()) {
+      return vds::unexpected(std::move(s.error()));
+    }
+
+    return s.size();
+  }
+
   template<typename message_type>
   inline expected<const_data_buffer> message_serialize(const message_type & message)
   {
+    GET_EXPECTED(size, message_size(message));
+
     vds::binary_serializer b;
+    CHECK_EXPECTED(b.reserve(size));
+
     _serialize_visitor bs(b);
     const_cast<typename std::remove_const<message_type>::type *>(&message)->visit(bs);
     if(bs.error()) {
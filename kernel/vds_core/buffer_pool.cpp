@@ -0,0 +1,106 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include "buffer_pool.h"
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace vds {
+  class _buffer_pool {
+  public:
+    static _buffer_pool & instance() {
+      static _buffer_pool pool;
+      return pool;
+    }
+
+    static size_t size_class(size_t size) {
+      size_t index = 0;
+      while ((buffer_pool::min_class_size << index) < size) {
+        ++index;
+      }
+      return index;
+    }
+
+    uint8_t * allocate(size_t class_index) {
+      std::unique_lock<std::mutex> lock(this->mutex_);
+      ++this->statistic_.allocations;
+
+      auto & free_list = this->free_[class_index];
+      if (!free_list.empty()) {
+        auto result = free_list.back();
+        free_list.pop_back();
+        ++this->statistic_.pool_hits;
+        this->statistic_.cached_bytes -= (buffer_pool::min_class_size << class_index);
+        return result;
+      }
+
+      lock.unlock();
+      return static_cast<uint8_t *>(::operator new(buffer_pool::min_class_size << class_index));
+    }
+
+    void deallocate(uint8_t * data, size_t class_index) noexcept {
+      std::unique_lock<std::mutex> lock(this->mutex_);
+      auto & free_list = this->free_[class_index];
+      if (free_list.size() < buffer_pool::max_cached_buffers) {
+        free_list.push_back(data);
+        this->statistic_.cached_bytes += (buffer_pool::min_class_size << class_index);
+        return;
+      }
+
+      lock.unlock();
+      ::operator delete(data);
+    }
+
+    buffer_pool::statistic get_statistic() {
+      std::unique_lock<std::mutex> lock(this->mutex_);
+      return this->statistic_;
+    }
+
+  private:
+    std::mutex mutex_;
+    std::vector<uint8_t *> free_[buffer_pool::size_class_count];
+    buffer_pool::statistic statistic_;
+
+    _buffer_pool()
+    : statistic_{ 0, 0, 0 } {
+      for (auto & free_list : this->free_) {
+        free_list.reserve(buffer_pool::max_cached_buffers);
+      }
+    }
+
+    ~_buffer_pool() {
+      for (auto & free_list : this->free_) {
+        for (auto p : free_list) {
+          ::operator delete(p);
+        }
+      }
+    }
+  };
+}
+
+vds::buffer_pool::buffer vds::buffer_pool::allocate(size_t size) {
+  if (max_pooled_size < size) {
+    return buffer(static_cast<uint8_t *>(::operator new(size)), size);
+  }
+
+  const auto index = _buffer_pool::size_class(size);
+  return buffer(_buffer_pool::instance().allocate(index), min_class_size << index);
+}
+
+void vds::buffer_pool::deallocate(uint8_t * data, size_t size) noexcept {
+  if (max_pooled_size < size) {
+    ::operator delete(data);
+    return;
+  }
+
+  _buffer_pool::instance().deallocate(data, _buffer_pool::size_class(size));
+}
+
+vds::buffer_pool::statistic vds::buffer_pool::get_statistic() {
+  return _buffer_pool::instance().get_statistic();
+}
@@ -0,0 +1,96 @@
+#ifndef __VDS_CORE_BUFFER_POOL_H_
+#define __VDS_CORE_BUFFER_POOL_H_
+
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vds {
+
+  //Large I/O buffers for the stream pipeline.
+  //Requests are rounded up to a power-of-two size class from 64 KiB to 1 MiB
+  //and released buffers are kept in global freelists for reuse.
+  class buffer_pool {
+  public:
+    static constexpr size_t min_class_size = 64 * 1024;
+    static constexpr size_t size_class_count = 5;
+    static constexpr size_t max_pooled_size = min_class_size << (size_class_count - 1);
+    static constexpr size_t max_cached_buffers = 16;
+
+    //Default size of the stream pipeline buffers
+    static constexpr size_t default_size = min_class_size;
+
+    struct statistic {
+      uint64_t allocations;
+      uint64_t pool_hits;
+      uint64_t cached_bytes;
+    };
+
+    class buffer {
+    public:
+      buffer()
+      : data_(nullptr), size_(0) {
+      }
+
+      buffer(const buffer &) = delete;
+      buffer(buffer && other) noexcept
+      : data_(other.data_), size_(other.size_) {
+        other.data_ = nullptr;
+        other.size_ = 0;
+      }
+
+      ~buffer() {
+        if (nullptr != this->data_) {
+          buffer_pool::deallocate(this->data_, this->size_);
+        }
+      }
+
+      buffer & operator = (const buffer &) = delete;
+      buffer & operator = (buffer && other) noexcept {
+        if (this != &other) {
+          if (nullptr != this->data_) {
+            buffer_pool::deallocate(this->data_, this->size_);
+          }
+          this->data_ = other.data_;
+          this->size_ = other.size_;
+          other.data_ = nullptr;
+          other.size_ = 0;
+        }
+        return *this;
+      }
+
+      uint8_t * data() const { return this->data_; }
+
+      //Capacity of the size class, may be bigger than requested
+      size_t size() const { return this->size_; }
+
+      explicit operator bool() const {
+        return nullptr != this->data_;
+      }
+
+    private:
+      friend class buffer_pool;
+
+      buffer(uint8_t * data, size_t size)
+      : data_(data), size_(size) {
+      }
+
+      uint8_t * data_;
+      size_t size_;
+    };
+
+    //Buffers bigger than max_pooled_size are allocated and released directly
+    static buffer allocate(size_t size = default_size);
+
+    static statistic get_statistic();
+
+  private:
+    static void deallocate(uint8_t * data, size_t size) noexcept;
+  };
+}
+
+#endif // __VDS_CORE_BUFFER_POOL_H_
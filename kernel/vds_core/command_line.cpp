@@ -198,7 +198,7 @@ vds::command_line_switch::command_line_switch(
   const std::string& name,
   const std::string& description)
 : command_line_item(name, description),
-sort_switch_(sort_switch), long_switch_(long_switch)
+sort_switch_(sort_switch), long_switch_(long_switch), value_(false)
 {
 }
 
@@ -7,15 +7,49 @@ All rights reserved
 #include "binary_serialize.h"
 
 vds::const_data_buffer::const_data_buffer(resizable_data_buffer&& other)
-  : data_(other.data_), size_(other.size_), allocated_size_(other.allocated_size_)
+  : data_(other.data_), size_(other.size_), allocated_size_(other.allocated_size_), shared_(nullptr)
 {
   other.data_ = nullptr;
   other.size_ = 0;
   other.allocated_size_ = 0;
 }
 
+vds::const_data_buffer & vds::const_data_buffer::share() {
+  if (nullptr == this->shared_ && nullptr != this->data_) {
+    this->shared_ = new shared_block{ { 1 }, this->data_ };
+    this->allocated_size_ = 0;
+  }
+
+  return *this;
+}
+
+vds::const_data_buffer vds::const_data_buffer::slice(size_t offset, size_t len) const {
+  vds_assert(offset + len <= this->size_);
+
+  if (nullptr == this->shared_ || 0 == len) {
+    return const_data_buffer(this->data_ + offset, len);
+  }
+
+  const_data_buffer result(*this);
+  result.data_ += offset;
+  result.size_ = len;
+  return result;
+}
+
+void vds::const_data_buffer::detach() {
+  auto data = static_cast<uint8_t *>(this->size_ ? std::malloc(this->size_) : nullptr);
+  memcpy(data, this->data_, this->size_);
+
+  this->release();
+  this->data_ = data;
+  this->allocated_size_ = this->size_;
+}
+
 void vds::const_data_buffer::remove(size_t start, size_t size) {
   vds_assert(this->size_ > start + size);
+  if (this->shared_) {
+    this->detach();
+  }
   this->size_ -= size;
   memmove(this->data_ + start, this->data_ + start + size, this->size_ - start);
 }
@@ -6,6 +6,7 @@ Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
 All rights reserved
 */
 #include "targetver.h"
+#include <atomic>
 #include <vector>
 #include <list>
 #include "types.h"
@@ -16,48 +17,73 @@ namespace vds{
   class binary_serializer;
   class resizable_data_buffer;
 
+  //By default every copy owns its data. After share() the data is immutable and reference-counted:
+  //copies and slices are O(1), non-const access detaches a private copy first.
   class const_data_buffer
   {
   public:
     const_data_buffer()
-      : data_(nullptr), size_(0), allocated_size_(0)
+      : data_(nullptr), size_(0), allocated_size_(0), shared_(nullptr)
     {
     }
 
     const_data_buffer(const void * data, size_t len)
-      : data_(static_cast<uint8_t *>(len ? std::malloc(len) : nullptr)), size_(len), allocated_size_(len)
+      : data_(static_cast<uint8_t *>(len ? std::malloc(len) : nullptr)), size_(len), allocated_size_(len), shared_(nullptr)
     {
       memcpy(this->data_, data, len);
     }
       
     const_data_buffer(const const_data_buffer & other)
-      : data_(static_cast<uint8_t *>(other.size_ ? std::malloc(other.size_) : nullptr)), size_(other.size_), allocated_size_(other.size_)
+      : data_(other.data_), size_(other.size_), allocated_size_(0), shared_(other.shared_)
     {
-      memcpy(this->data_, other.data_, other.size_);
+      if (this->shared_) {
+        this->shared_->ref_count.fetch_add(1, std::memory_order_relaxed);
+      }
+      else {
+        this->data_ = static_cast<uint8_t *>(other.size_ ? std::malloc(other.size_) : nullptr);
+        this->allocated_size_ = other.size_;
+        memcpy(this->data_, other.data_, other.size_);
+      }
     }
 
     const_data_buffer(resizable_data_buffer && other);
       
     const_data_buffer(const_data_buffer&& other) noexcept
-      : data_(other.data_), size_(other.size_), allocated_size_(other.allocated_size_)
+      : data_(other.data_), size_(other.size_), allocated_size_(other.allocated_size_), shared_(other.shared_)
     {
       other.data_ = nullptr;
       other.size_ = 0;
       other.allocated_size_ = 0;
+      other.shared_ = nullptr;
     }
      
 
     ~const_data_buffer() {
-      if (this->data_) {
-        std::free(this->data_);
-      }
+      this->release();
     }
           
     const uint8_t * data() const { return this->data_; }
-    uint8_t * data() { return this->data_; }
+    uint8_t * data() {
+      if (this->shared_) {
+        this->detach();
+      }
+      return this->data_;
+    }
     size_t size() const { return this->size_; }
     
+    //Switch to the shared mode without copying the data
+    const_data_buffer & share();
+
+    bool is_shared() const { return nullptr != this->shared_; }
+
+    //Zero-copy in the shared mode, a copy of the range otherwise
+    const_data_buffer slice(size_t offset, size_t len) const;
+
     void resize(size_t len) {
+      if (this->shared_) {
+        this->detach();
+      }
+
       if (this->allocated_size_ < len) {
         if (this->data_) {
           std::free(this->data_);
@@ -71,24 +97,44 @@ namespace vds{
 
     const_data_buffer & operator = (const const_data_buffer & other)
     {
-      this->resize(other.size_);
-      memcpy(this->data_, other.data_, other.size_);
+      if (other.shared_) {
+        other.shared_->ref_count.fetch_add(1, std::memory_order_relaxed);
+        this->release();
+        this->data_ = other.data_;
+        this->size_ = other.size_;
+        this->allocated_size_ = 0;
+        this->shared_ = other.shared_;
+
+        return *this;
+      }
+
+      if (this != &other) {
+        if (this->shared_) {
+          this->release();
+          this->data_ = nullptr;
+        }
+
+        this->resize(other.size_);
+        memcpy(this->data_, other.data_, other.size_);
+      }
 
       return *this;
     }
     
     const_data_buffer & operator = (const_data_buffer && other) noexcept
     {
-      if (this->data_) {
-        std::free(this->data_);
+      if (this != &other) {
+        this->release();
+        this->data_ = other.data_;
+        this->size_ = other.size_;
+        this->allocated_size_ = other.allocated_size_;
+        this->shared_ = other.shared_;
+
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.allocated_size_ = 0;
+        other.shared_ = nullptr;
       }
-      this->data_ = other.data_;
-      this->size_ = other.size_;
-      this->allocated_size_ = other.allocated_size_;
-
-      other.data_ = nullptr;
-      other.size_ = 0;
-      other.allocated_size_ = 0;
 
       return *this;
     }
@@ -124,7 +170,7 @@ namespace vds{
 
     uint8_t & operator[](size_t index)
     {
-      return this->data_[index];
+      return this->data()[index];
     }
 
     bool operator !() const
@@ -144,9 +190,30 @@ namespace vds{
     void remove(size_t start, size_t size);
 
   private:
+    struct shared_block {
+      std::atomic<size_t> ref_count;
+      uint8_t * data;
+    };
+
     uint8_t * data_;
     size_t size_;
     size_t allocated_size_;
+    shared_block * shared_;
+
+    void release() {
+      if (this->shared_) {
+        if (1 == this->shared_->ref_count.fetch_sub(1, std::memory_order_acq_rel)) {
+          std::free(this->shared_->data);
+          delete this->shared_;
+        }
+        this->shared_ = nullptr;
+      }
+      else if (this->data_) {
+        std::free(this->data_);
+      }
+    }
+
+    void detach();
   };
 }
 
@@ -0,0 +1,80 @@
+#ifndef __VDS_CORE_CONST_DATA_VIEW_H_
+#define __VDS_CORE_CONST_DATA_VIEW_H_
+
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+#include <cstring>
+#include "const_data_buffer.h"
+
+namespace vds {
+
+  //Non-owning range of bytes. Valid only while the source buffer is alive and unchanged;
+  //use to_buffer() to keep the data longer.
+  class const_data_view
+  {
+  public:
+    const_data_view()
+      : data_(nullptr), size_(0)
+    {
+    }
+
+    const_data_view(const void * data, size_t len)
+      : data_(static_cast<const uint8_t *>(data)), size_(len)
+    {
+    }
+
+    const_data_view(const const_data_buffer & data)
+      : data_(data.data()), size_(data.size())
+    {
+    }
+
+    const uint8_t * data() const { return this->data_; }
+    size_t size() const { return this->size_; }
+
+    const_data_buffer to_buffer() const {
+      return const_data_buffer(this->data_, this->size_);
+    }
+
+    uint8_t operator[](size_t index) const
+    {
+      return this->data_[index];
+    }
+
+    bool operator == (const const_data_view & other) const
+    {
+      return this->size_ == other.size_
+        && (0 == this->size_ || 0 == memcmp(this->data_, other.data_, this->size_));
+    }
+
+    bool operator != (const const_data_view & other) const
+    {
+      return !(*this == other);
+    }
+
+    bool operator !() const
+    {
+      return this->size_ == 0;
+    }
+
+    explicit operator bool() const
+    {
+      return this->size_ != 0;
+    }
+
+  private:
+    const uint8_t * data_;
+    size_t size_;
+  };
+
+  inline bool operator == (const const_data_buffer & left, const const_data_view & right) {
+    return right == const_data_view(left);
+  }
+
+  inline bool operator != (const const_data_buffer & left, const const_data_view & right) {
+    return right != const_data_view(left);
+  }
+}
+
+#endif // __VDS_CORE_CONST_DATA_VIEW_H_
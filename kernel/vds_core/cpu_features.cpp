@@ -0,0 +1,41 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+#include "stdafx.h"
+#include "cpu_features.h"
+
+#if defined(VDS_X86_SIMD) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+vds::cpu_features::cpu_features()
+: ssse3_(false),
+  sse41_(false),
+  avx2_(false) {
+#ifdef VDS_X86_SIMD
+#ifdef _MSC_VER
+  int info[4];
+  __cpuid(info, 0);
+  const auto max_id = info[0];
+  if (max_id < 1) {
+    return;
+  }
+
+  __cpuid(info, 1);
+  this->ssse3_ = (0 != (info[2] & (1 << 9)));
+  this->sse41_ = (0 != (info[2] & (1 << 19)));
+  const bool has_osxsave = (0 != (info[2] & (1 << 27)));
+  if (max_id >= 7 && has_osxsave && 6 == (_xgetbv(0) & 6)) {
+    __cpuidex(info, 7, 0);
+    this->avx2_ = (0 != (info[1] & (1 << 5)));
+  }
+#else
+  __builtin_cpu_init();
+  this->ssse3_ = __builtin_cpu_supports("ssse3");
+  this->sse41_ = __builtin_cpu_supports("sse4.1");
+  this->avx2_ = __builtin_cpu_supports("avx2");
+#endif
+#endif//VDS_X86_SIMD
+}
@@ -0,0 +1,50 @@
+#ifndef __VDS_CORE_CPU_FEATURES_H_
+#define __VDS_CORE_CPU_FEATURES_H_
+
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define VDS_X86_SIMD
+#ifdef _MSC_VER
+#define VDS_TARGET(name)
+#else
+#define VDS_TARGET(name) __attribute__((target(name)))
+#endif
+#endif
+
+namespace vds {
+
+  //Instruction set extensions of the current CPU, detected once.
+  //Vector kernels are compiled with VDS_TARGET and picked at run time.
+  class cpu_features {
+  public:
+    static bool has_ssse3() {
+      return get().ssse3_;
+    }
+
+    static bool has_sse41() {
+      return get().sse41_;
+    }
+
+    static bool has_avx2() {
+      return get().avx2_;
+    }
+
+  private:
+    bool ssse3_;
+    bool sse41_;
+    bool avx2_;
+
+    cpu_features();
+
+    static const cpu_features & get() {
+      static const cpu_features features;
+      return features;
+    }
+  };
+}
+
+#endif // __VDS_CORE_CPU_FEATURES_H_
@@ -33,6 +33,12 @@ namespace vds {
     static std::string from_bytes(const void * data, size_t len);
     static std::string from_bytes(const const_data_buffer & data);
     static expected<const_data_buffer> to_bytes(const std::string & data);
+
+    //RFC 4648 URL and file name safe alphabet ('-' and '_') without padding.
+    //The decoder accepts padded input as well.
+    static std::string url_from_bytes(const void * data, size_t len);
+    static std::string url_from_bytes(const const_data_buffer & data);
+    static expected<const_data_buffer> url_to_bytes(const std::string & data);
   };
 
   class hex
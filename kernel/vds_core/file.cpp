@@ -3,6 +3,7 @@
 #include <sys/stat.h>
 #include "file.h"
 #include "persistence.h"
+#include "buffer_pool.h"
 
 vds::file::file()
 : handle_(0)
@@ -236,14 +237,14 @@ vds::expected<void> vds::file::copy(const filename& source, const filename& targ
   CHECK_EXPECTED(fin.open(source, file_mode::open_read));
   CHECK_EXPECTED(fout.open(target, override_exist ? file_mode::open_or_create : file_mode::create_new));
 
-  uint8_t buffer[1024];
+  auto buffer = buffer_pool::allocate(buffer_pool::default_size);
   for(;;) {
-    GET_EXPECTED(readed, fin.read(buffer, sizeof(buffer)));
+    GET_EXPECTED(readed, fin.read(buffer.data(), buffer.size()));
     if(0 == readed) {
       break;
     }
 
-    CHECK_EXPECTED(fout.write(buffer, readed));
+    CHECK_EXPECTED(fout.write(buffer.data(), readed));
   }
 
   CHECK_EXPECTED(fin.close());
@@ -390,17 +391,29 @@ vds::expected<vds::const_data_buffer> vds::file::read_all(const vds::filename& f
   CHECK_EXPECTED(f.open(fn, file::file_mode::open_read));
 
   GET_EXPECTED(len, f.length());
-  std::vector<uint8_t> buffer(len);
-  
-  CHECK_EXPECTED(f.read(buffer.data(), buffer.size()));
-  
-  return const_data_buffer(buffer.data(), buffer.size());
+  const_data_buffer result;
+  result.resize(len);
+
+  size_t offset = 0;
+  while (offset < result.size()) {
+    GET_EXPECTED(readed, f.read(result.data() + offset, result.size() - offset));
+    if (0 == readed) {
+      return vds::make_unexpected<std::runtime_error>("Unexpected end of file " + fn.full_name());
+    }
+    offset += readed;
+  }
+
+  return result;
 }
 
 vds::expected<void> vds::file::write_all(const vds::filename &fn, const vds::const_data_buffer &data) {
+  return write_all(fn, data.data(), data.size());
+}
+
+vds::expected<void> vds::file::write_all(const vds::filename &fn, const void * data, size_t size) {
   file f;
   CHECK_EXPECTED(f.open(fn, file::file_mode::truncate));
-  CHECK_EXPECTED(f.write(data.data(), data.size()));
+  CHECK_EXPECTED(f.write(data, size));
   CHECK_EXPECTED(f.close());
 
   return expected<void>();
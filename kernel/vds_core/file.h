@@ -91,6 +91,7 @@ namespace vds {
     static expected<std::string> read_all_text(const filename & fn);
     static expected<const_data_buffer> read_all(const filename & fn);
     static expected<void> write_all(const filename & fn, const const_data_buffer & data);
+    static expected<void> write_all(const filename & fn, const void * data, size_t size);
 
   private:
     filename filename_;
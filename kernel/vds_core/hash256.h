@@ -0,0 +1,197 @@
+#ifndef __VDS_CORE_HASH256_H_
+#define __VDS_CORE_HASH256_H_
+
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include <cstring>
+#include <functional>
+#include "const_data_buffer.h"
+#include "binary_serialize.h"
+#include "expected.h"
+#include "vds_debug.h"
+
+namespace vds {
+
+  //32-byte SHA-256 value (node id, object id, block id) stored inline.
+  //The zero value stands for the empty id and is serialized as an empty const_data_buffer,
+  //so messages keep the wire format of const_data_buffer fields.
+  class hash256 {
+  public:
+    static constexpr size_t hash_size = 32;
+
+    hash256()
+    : data_{} {
+    }
+
+    explicit hash256(const uint8_t * data) {
+      memcpy(this->data_, data, hash_size);
+    }
+
+    //For buffers of a known size, such as a fresh SHA-256 signature.
+    //Buffers from the network or the database go through create(), other sizes only hit the debug assert here.
+    explicit hash256(const const_data_buffer & data)
+    : data_{} {
+      vds_assert(0 == data.size() || hash_size == data.size());
+      memcpy(this->data_, data.data(), (hash_size < data.size()) ? hash_size : data.size());
+    }
+
+    static expected<hash256> create(const const_data_buffer & data) {
+      if (0 != data.size() && hash_size != data.size()) {
+        return vds::make_unexpected<std::runtime_error>("Invalid hash size");
+      }
+
+      return hash256(data);
+    }
+
+    operator const_data_buffer() const {
+      return (*this) ? const_data_buffer(this->data_, hash_size) : const_data_buffer();
+    }
+
+    const uint8_t * data() const {
+      return this->data_;
+    }
+
+    uint8_t * data() {
+      return this->data_;
+    }
+
+    static constexpr size_t size() {
+      return hash_size;
+    }
+
+    uint8_t operator[](size_t index) const {
+      return this->data_[index];
+    }
+
+    uint8_t & operator[](size_t index) {
+      return this->data_[index];
+    }
+
+    explicit operator bool() const {
+      for (size_t i = 0; i < hash_size; ++i) {
+        if (0 != this->data_[i]) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    bool operator !() const {
+      return !static_cast<bool>(*this);
+    }
+
+    bool operator == (const hash256 & other) const {
+      return 0 == memcmp(this->data_, other.data_, hash_size);
+    }
+
+    bool operator != (const hash256 & other) const {
+      return 0 != memcmp(this->data_, other.data_, hash_size);
+    }
+
+    bool operator < (const hash256 & other) const {
+      return 0 > memcmp(this->data_, other.data_, hash_size);
+    }
+
+    bool operator > (const hash256 & other) const {
+      return 0 < memcmp(this->data_, other.data_, hash_size);
+    }
+
+    bool operator == (const const_data_buffer & other) const {
+      return (0 == other.size()) ? !(*this) : (hash_size == other.size() && 0 == memcmp(this->data_, other.data(), hash_size));
+    }
+
+    bool operator != (const const_data_buffer & other) const {
+      return !(*this == other);
+    }
+
+    //XOR distance
+    hash256 operator ^ (const hash256 & other) const {
+      hash256 result;
+      for (size_t i = 0; i < hash_size; ++i) {
+        result.data_[i] = this->data_[i] ^ other.data_[i];
+      }
+      return result;
+    }
+
+    //Index of the first different bit; 0 for equal values
+    size_t distance_exp(const hash256 & other) const {
+      for (size_t i = 0; i < hash_size; ++i) {
+        auto b = static_cast<uint8_t>(this->data_[i] ^ other.data_[i]);
+        if (0 == b) {
+          continue;
+        }
+
+        auto result = (i << 3);
+        while (0 == (b & 0x80)) {
+          ++result;
+          b <<= 1;
+        }
+        return result;
+      }
+
+      return 0;
+    }
+
+    //The value is already uniformly distributed
+    size_t hash() const {
+      size_t result;
+      memcpy(&result, this->data_, sizeof(result));
+      return result;
+    }
+
+  private:
+    uint8_t data_[hash_size];
+  };
+
+  inline bool operator == (const const_data_buffer & left, const hash256 & right) {
+    return right == left;
+  }
+
+  inline bool operator != (const const_data_buffer & left, const hash256 & right) {
+    return right != left;
+  }
+
+  inline expected<void> operator <<(binary_serializer & s, const hash256 & value) {
+    if (!value) {
+      return s.write_number(0);
+    }
+
+    return s.push_data(value.data(), hash256::hash_size, true);
+  }
+
+  inline void operator <<(binary_sizer & s, const hash256 & value) {
+    s.add(value ? 1 + hash256::hash_size : 1);
+  }
+
+  inline expected<void> operator >>(binary_deserializer & s, hash256 & value) {
+    size_t size = hash256::hash_size;
+    uint8_t data[hash256::hash_size];
+    CHECK_EXPECTED(s.pop_data(data, size, true));
+
+    if (0 == size) {
+      value = hash256();
+    }
+    else if (hash256::hash_size == size) {
+      value = hash256(data);
+    }
+    else {
+      return vds::make_unexpected<std::runtime_error>("Invalid hash size");
+    }
+
+    return expected<void>();
+  }
+}
+
+namespace std {
+  template <>
+  struct hash<vds::hash256> {
+    size_t operator()(const vds::hash256 & value) const {
+      return value.hash();
+    }
+  };
+}
+
+#endif // __VDS_CORE_HASH256_H_
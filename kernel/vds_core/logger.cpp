@@ -9,13 +9,85 @@ All rights reserved
 #include "persistence.h"
 #include "string_format.h"
 #include "mt_service.h"
+#include <unordered_map>
+
+static std::string * log_module_names() {
+  static std::string names[vds::log_module::max_count];
+  return names;
+}
+
+uint32_t vds::log_module::get_id(const std::string & name) {
+  static std::mutex modules_mutex;
+  static std::unordered_map<std::string, uint32_t> modules;
+
+  std::unique_lock<std::mutex> lock(modules_mutex);
+  auto p = modules.find(name);
+  if (modules.end() != p) {
+    return p->second;
+  }
+
+  auto id = static_cast<uint32_t>(modules.size());
+  if (overflow_id <= id) {
+    return overflow_id;
+  }
+
+  //The name is stored before the id is published, so name() needs no lock
+  log_module_names()[id] = name;
+  modules[name] = id;
+  return id;
+}
+
+const std::string & vds::log_module::name(uint32_t id) {
+  if (overflow_id == id) {
+    static const std::string other("other");
+    return other;
+  }
+
+  return log_module_names()[id];
+}
+
+void vds::logger::set_log_module(const std::string & module) {
+  std::unique_lock<std::mutex> lock(this->modules_mutex_);
+  if ("*" == module) {
+    this->all_modules_ = true;
+  }
+  else {
+    this->modules_.emplace(module);
+  }
+
+  for (auto & state : this->module_states_) {
+    state.store(module_state_unknown, std::memory_order_relaxed);
+  }
+}
+
+bool vds::logger::resolve_module(uint32_t module_id) const {
+  std::unique_lock<std::mutex> lock(this->modules_mutex_);
+  const auto & module = log_module::name(module_id);
+
+  bool result;
+  if (log_module::overflow_id == module_id) {
+    result = this->all_modules_;
+  }
+  else if (this->modules_.end() != this->modules_.find(module)) {
+    result = true;
+  }
+  else if (this->modules_.end() != this->modules_.find("-" + module)) {
+    result = false;
+  }
+  else {
+    result = this->all_modules_;
+  }
+
+  this->module_states_[module_id].store(result ? module_state_enabled : module_state_disabled, std::memory_order_relaxed);
+  return result;
+}
 
 void vds::logger::operator()(
   const std::string & module,
   log_level level,
   const std::string & message) const
 {
-  log_record record{ level, module, message };
+  log_record record{ level, module, message, log_module::get_id(module) };
 
   this->log_writer_.write(record);
 }
@@ -86,6 +158,14 @@ vds::file_logger::file_logger(log_level level, const std::unordered_set<std::str
 {
 }
 
+void vds::file_logger::enable_binary_log()
+{
+  if (!this->vlog_) {
+    this->vlog_.reset(new binary_log());
+    this->binary_log_ = this->vlog_.get();
+  }
+}
+
 vds::expected<void> vds::file_logger::register_services(service_registrator & registrator)
 {
   registrator.add_service<logger>(this);
@@ -99,6 +179,10 @@ vds::expected<void> vds::file_logger::start(const service_provider * sp)
   GET_EXPECTED(folder, persistence::current_user(sp));
   CHECK_EXPECTED(folder.create());
 
+  if (this->vlog_) {
+    return this->vlog_->start(filename(folder, "vds.vlog"));
+  }
+
   file f;
   CHECK_EXPECTED(f.open(filename(folder, "vds.log"), file::file_mode::append));
 
@@ -110,6 +194,11 @@ vds::expected<void> vds::file_logger::start(const service_provider * sp)
 
 vds::expected<void> vds::file_logger::stop()
 {
+  if (this->vlog_) {
+    this->vlog_->stop();
+    return expected<void>();
+  }
+
   this->log_mutex_.lock();
   this->is_stopping_ = true;
   this->log_cond_.notify_all();
@@ -125,6 +214,11 @@ vds::expected<void> vds::file_logger::stop()
 
 void vds::file_logger::write(  const log_record & record)
 {
+  if (this->vlog_) {
+    this->vlog_->write(record);
+    return;
+  }
+
   std::string level_str;
   switch (record.level) {
   case log_level::ll_trace:
@@ -168,6 +262,11 @@ void vds::file_logger::write(  const log_record & record)
 }
 
 void vds::file_logger::flush() {
+  if (this->vlog_) {
+    this->vlog_->flush();
+    return;
+  }
+
   std::unique_lock<std::mutex> lock(this->log_mutex_);
   if (!this->log_.empty()) {
     auto log = this->log_;
@@ -6,6 +6,7 @@ Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
 All rights reserved
 */
 
+#include <atomic>
 #include <sstream>
 #include <mutex>
 #include <memory>
@@ -13,9 +14,15 @@ All rights reserved
 #include <thread>
 
 #include "service_provider.h"
+#include "binary_log.h"
 #include "string_format.h"
 #include "string_utils.h"
 
+//Minimal level that is compiled in: 0 - trace, 1 - debug, 2 - info, 3 - warning, 4 - error
+#ifndef VDS_LOG_MIN_LEVEL
+#define VDS_LOG_MIN_LEVEL 0
+#endif
+
 namespace vds {
     enum class log_level {
         ll_trace,
@@ -30,6 +37,20 @@ namespace vds {
       log_level level;
       std::string module;
       std::string message;
+      uint32_t module_id;
+    };
+
+    //Process wide table of log module names, so filters are checked by index instead of by string
+    class log_module {
+    public:
+      static constexpr uint32_t max_count = 256;
+
+      //Modules past max_count share this id, named "other", and follow the "*" filter
+      static constexpr uint32_t overflow_id = max_count - 1;
+
+      //Takes a lock, so callers cache the result
+      static uint32_t get_id(const std::string & name);
+      static const std::string & name(uint32_t id);
     };
 
     class log_writer
@@ -54,11 +75,14 @@ namespace vds {
         log_writer & log_writer,
         log_level min_log_level,
         const std::unordered_set<std::string> & modules)
-        : sp_(nullptr),
+        : sp_(nullptr), binary_log_(nullptr),
           log_writer_(log_writer), min_log_level_(min_log_level),
           all_modules_(modules.end() != modules.find("*")),
           modules_(modules)
       {
+        for (auto & state : this->module_states_) {
+          state.store(module_state_unknown, std::memory_order_relaxed);
+        }
       }
 
       template <typename... arg_types>
@@ -72,7 +96,7 @@ namespace vds {
       template <typename... arg_types>
       void trace(const std::string & module,  const std::string & format, arg_types... args) const
       {
-        if(this->check(module, log_level::ll_trace)) {
+        if(VDS_LOG_MIN_LEVEL <= 0 && this->check(module, log_level::ll_trace)) {
           (*this)(module, log_level::ll_trace, string_format(format, args...));
         }
       }
@@ -80,7 +104,7 @@ namespace vds {
       template <typename... arg_types>
       void debug(const std::string & module,  const std::string & format, arg_types... args) const
       {
-        if (this->check(module, log_level::ll_debug)) {
+        if (VDS_LOG_MIN_LEVEL <= 1 && this->check(module, log_level::ll_debug)) {
           (*this)(module, log_level::ll_debug, string_format(format, args...));
         }
       }
@@ -88,7 +112,7 @@ namespace vds {
       template <typename... arg_types>
       void info(const std::string & module,  const std::string & format, arg_types... args) const
       {
-        if (this->check(module, log_level::ll_info)) {
+        if (VDS_LOG_MIN_LEVEL <= 2 && this->check(module, log_level::ll_info)) {
           (*this)(module, log_level::ll_info, string_format(format, args...));
         }
       }
@@ -96,7 +120,7 @@ namespace vds {
       template <typename... arg_types>
       void warning(const std::string & module,  const std::string & format, arg_types... args) const
       {
-        if (this->check(module, log_level::ll_warning)) {
+        if (VDS_LOG_MIN_LEVEL <= 3 && this->check(module, log_level::ll_warning)) {
           (*this)(module, log_level::ll_warning, string_format(format, args...));
         }
       }
@@ -131,16 +155,10 @@ namespace vds {
         this->min_log_level_ = new_level;
       }
       
-      void set_log_module(const std::string & module)
-      {
-        if("*" == module){
-          this->all_modules_ = true;
-        }
-        else {
-          this->modules_.emplace(module);
-        }
-      }
+      //Modules are configured before logging starts
+      void set_log_module(const std::string & module);
       
+      //Used by the calls that pass the module by name, so it does not touch the module id table
       bool check(const std::string & module, log_level level) const
       {
         if(log_level::ll_error <= level) {
@@ -159,35 +177,76 @@ namespace vds {
           return false;
         }
         
-//         this->processed_modules_mutex_.lock();
-//         if(this->processed_modules_.end() == this->processed_modules_.find(module)){
-//           this->processed_modules_.emplace(module);
-//           this->processed_modules_mutex_.unlock();
-//           
-//           (*this)(module, sp, ll_warning, "Log messages of this module will be filtered");
-//         }
-//         else {
-//           this->processed_modules_mutex_.unlock();
-//         }
-        
         return this->all_modules_;
       }
 
+      bool check(uint32_t module_id, log_level level) const
+      {
+        if(log_level::ll_error <= level) {
+          return true;
+        }
+
+        if (this->min_log_level() > level) {
+          return false;
+        }
+
+        return this->is_module_enabled(module_id);
+      }
+
+      void write(uint32_t module_id, log_level level, const std::string & message) const
+      {
+        log_record record{ level, log_module::name(module_id), message, module_id };
+        this->log_writer_.write(record);
+      }
+
+      //In the binary mode the arguments are stored raw and formatted offline
+      template <typename... arg_types>
+      void write_format(log_site & site, uint32_t module_id, log_level level, const char * format, arg_types... args) const
+      {
+        if (nullptr != this->binary_log_) {
+          _binary_log_args binary_args;
+          int unused[] = { 0, (binary_args.add(args), 0)... };
+          (void)unused;
+          this->binary_log_->write(site, module_id, level, format, binary_args);
+        }
+        else {
+          this->write(module_id, level, string_format(format, args...));
+        }
+      }
+
       void flush() {
         this->log_writer_.flush();
       }
 
     protected:
       const service_provider * sp_;
+      binary_log * binary_log_;
     private:
       log_writer & log_writer_;
       log_level min_log_level_;
+
+      static constexpr uint8_t module_state_unknown = 0;
+      static constexpr uint8_t module_state_enabled = 1;
+      static constexpr uint8_t module_state_disabled = 2;
+
+      //Filter result per module id, resolved from modules_ on first use
+      mutable std::atomic<uint8_t> module_states_[log_module::max_count];
+
+      mutable std::mutex modules_mutex_;
       bool all_modules_;
       std::unordered_set<std::string> modules_;
-      
-//       mutable std::mutex processed_modules_mutex_;
-//       mutable std::unordered_set<std::string> processed_modules_;
 
+      bool is_module_enabled(uint32_t module_id) const
+      {
+        const auto state = this->module_states_[module_id].load(std::memory_order_relaxed);
+        if (module_state_unknown != state) {
+          return (module_state_enabled == state);
+        }
+
+        return this->resolve_module(module_id);
+      }
+
+      bool resolve_module(uint32_t module_id) const;
       
       void operator () (
         const std::string & module,
@@ -217,6 +276,9 @@ namespace vds {
     public:
       file_logger(log_level level, const std::unordered_set<std::string> & modules);
 
+      //Write vds.vlog instead of vds.log; must be called before start
+      void enable_binary_log();
+
       //iservice_factory
       expected<void> register_services(service_registrator &) override;
       expected<void> start(const service_provider * sp) override;
@@ -229,6 +291,7 @@ namespace vds {
     private:
       std::unique_ptr<file> f_;
       std::thread logger_thread_;
+      std::unique_ptr<binary_log> vlog_;
 
       std::mutex log_mutex_;
       std::condition_variable log_cond_;
@@ -239,4 +302,44 @@ namespace vds {
 
 }
 
+//Arguments are evaluated only if the module and the level are enabled.
+//The module id is cached per call site, so module must be the same on every call.
+#define VDS_LOG(sp, module, level, ...) \
+  do { \
+    static const uint32_t vds_log_module_id_ = vds::log_module::get_id(module); \
+    auto vds_log_ = vds::logger::get(sp); \
+    if (vds_log_->check(vds_log_module_id_, (level))) { \
+      static vds::log_site vds_log_site_; \
+      vds_log_->write_format(vds_log_site_, vds_log_module_id_, (level), __VA_ARGS__); \
+    } \
+  } while (false)
+
+#define VDS_LOG_DISABLED() do { } while (false)
+
+#if VDS_LOG_MIN_LEVEL <= 0
+#define VDS_LOG_TRACE(sp, module, ...) VDS_LOG(sp, module, vds::log_level::ll_trace, __VA_ARGS__)
+#else
+#define VDS_LOG_TRACE(sp, module, ...) VDS_LOG_DISABLED()
+#endif
+
+#if VDS_LOG_MIN_LEVEL <= 1
+#define VDS_LOG_DEBUG(sp, module, ...) VDS_LOG(sp, module, vds::log_level::ll_debug, __VA_ARGS__)
+#else
+#define VDS_LOG_DEBUG(sp, module, ...) VDS_LOG_DISABLED()
+#endif
+
+#if VDS_LOG_MIN_LEVEL <= 2
+#define VDS_LOG_INFO(sp, module, ...) VDS_LOG(sp, module, vds::log_level::ll_info, __VA_ARGS__)
+#else
+#define VDS_LOG_INFO(sp, module, ...) VDS_LOG_DISABLED()
+#endif
+
+#if VDS_LOG_MIN_LEVEL <= 3
+#define VDS_LOG_WARNING(sp, module, ...) VDS_LOG(sp, module, vds::log_level::ll_warning, __VA_ARGS__)
+#else
+#define VDS_LOG_WARNING(sp, module, ...) VDS_LOG_DISABLED()
+#endif
+
+#define VDS_LOG_ERROR(sp, module, ...) VDS_LOG(sp, module, vds::log_level::ll_error, __VA_ARGS__)
+
 #endif//__VDS_CORE_LOGGER_H_
@@ -0,0 +1,252 @@
+#ifndef __VDS_CORE_LRU_CACHE_H_
+#define __VDS_CORE_LRU_CACHE_H_
+
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "const_data_buffer.h"
+
+namespace vds {
+
+  //Default cost of a cache item in bytes
+  struct lru_cache_item_size {
+    template <typename key_type, typename value_type>
+    size_t operator()(const key_type &, const value_type &) const {
+      return sizeof(key_type) + sizeof(value_type);
+    }
+
+    template <typename key_type>
+    size_t operator()(const key_type &, const const_data_buffer & value) const {
+      return sizeof(key_type) + sizeof(const_data_buffer) + value.size();
+    }
+  };
+
+  //Thread-safe LRU cache with a byte budget.
+  //Keys are split between shards by hash; each shard has its own lock,
+  //a hash index and an intrusive recently used list, so every operation is O(1).
+  template <
+    typename key_type,
+    typename value_type,
+    typename hash_type = std::hash<key_type>,
+    typename size_type = lru_cache_item_size>
+  class lru_cache {
+  public:
+    struct statistics {
+      uint64_t hits;
+      uint64_t misses;
+      uint64_t evictions;
+      uint64_t expirations;
+      size_t count;
+      size_t bytes;
+    };
+
+    //ttl == 0 means the items never expire
+    lru_cache(
+      size_t max_bytes,
+      size_t shard_count = 16,
+      std::chrono::steady_clock::duration ttl = std::chrono::steady_clock::duration::zero())
+    : shards_(shard_count ? shard_count : 1),
+      ttl_(ttl) {
+      for (auto & shard : this->shards_) {
+        shard.max_bytes_ = max_bytes / this->shards_.size();
+      }
+    }
+
+    lru_cache(const lru_cache &) = delete;
+    lru_cache & operator = (const lru_cache &) = delete;
+
+    //Copies the value out because other threads may evict the item right after the lock is released
+    bool find(const key_type & key, value_type & value) {
+      auto & shard = this->get_shard(key);
+      std::unique_lock<std::mutex> lock(shard.mutex_);
+
+      auto p = shard.items_.find(key);
+      if (shard.items_.end() == p) {
+        ++shard.misses_;
+        return false;
+      }
+
+      if (this->is_expired(p->second)) {
+        ++shard.misses_;
+        ++shard.expirations_;
+        shard.erase(p);
+        return false;
+      }
+
+      ++shard.hits_;
+      shard.move_to_front(&p->second);
+      value = p->second.value_;
+      return true;
+    }
+
+    bool contains(const key_type & key) {
+      auto & shard = this->get_shard(key);
+      std::unique_lock<std::mutex> lock(shard.mutex_);
+
+      auto p = shard.items_.find(key);
+      return shard.items_.end() != p && !this->is_expired(p->second);
+    }
+
+    void set(const key_type & key, const value_type & value) {
+      this->set_value(key, value_type(value));
+    }
+
+    void set(const key_type & key, value_type && value) {
+      this->set_value(key, std::move(value));
+    }
+
+    void remove(const key_type & key) {
+      auto & shard = this->get_shard(key);
+      std::unique_lock<std::mutex> lock(shard.mutex_);
+
+      auto p = shard.items_.find(key);
+      if (shard.items_.end() != p) {
+        shard.erase(p);
+      }
+    }
+
+    void clear() {
+      for (auto & shard : this->shards_) {
+        std::unique_lock<std::mutex> lock(shard.mutex_);
+        shard.items_.clear();
+        shard.head_ = nullptr;
+        shard.tail_ = nullptr;
+        shard.bytes_ = 0;
+      }
+    }
+
+    statistics get_statistics() const {
+      statistics result{};
+      for (auto & shard : this->shards_) {
+        std::unique_lock<std::mutex> lock(shard.mutex_);
+        result.hits += shard.hits_;
+        result.misses += shard.misses_;
+        result.evictions += shard.evictions_;
+        result.expirations += shard.expirations_;
+        result.count += shard.items_.size();
+        result.bytes += shard.bytes_;
+      }
+      return result;
+    }
+
+  private:
+    struct item {
+      value_type value_;
+      size_t size_;
+      std::chrono::steady_clock::time_point expires_;
+      const key_type * key_;
+      item * prev_;
+      item * next_;
+    };
+
+    //References to unordered_map elements survive rehashing, so the list links point right into the index
+    struct shard {
+      mutable std::mutex mutex_;
+      std::unordered_map<key_type, item, hash_type> items_;
+      item * head_ = nullptr;
+      item * tail_ = nullptr;
+      size_t bytes_ = 0;
+      size_t max_bytes_ = 0;
+
+      uint64_t hits_ = 0;
+      uint64_t misses_ = 0;
+      uint64_t evictions_ = 0;
+      uint64_t expirations_ = 0;
+
+      void unlink(item * p) {
+        if (p->prev_) {
+          p->prev_->next_ = p->next_;
+        }
+        else {
+          this->head_ = p->next_;
+        }
+
+        if (p->next_) {
+          p->next_->prev_ = p->prev_;
+        }
+        else {
+          this->tail_ = p->prev_;
+        }
+      }
+
+      void push_front(item * p) {
+        p->prev_ = nullptr;
+        p->next_ = this->head_;
+        if (this->head_) {
+          this->head_->prev_ = p;
+        }
+        else {
+          this->tail_ = p;
+        }
+        this->head_ = p;
+      }
+
+      void move_to_front(item * p) {
+        if (this->head_ != p) {
+          this->unlink(p);
+          this->push_front(p);
+        }
+      }
+
+      void erase(typename std::unordered_map<key_type, item, hash_type>::iterator p) {
+        this->unlink(&p->second);
+        this->bytes_ -= p->second.size_;
+        this->items_.erase(p);
+      }
+
+      void evict(size_t required_bytes) {
+        while (this->tail_ && this->bytes_ + required_bytes > this->max_bytes_) {
+          ++this->evictions_;
+          this->erase(this->items_.find(*this->tail_->key_));
+        }
+      }
+    };
+
+    std::vector<shard> shards_;
+    std::chrono::steady_clock::duration ttl_;
+
+    shard & get_shard(const key_type & key) {
+      const size_t h = hash_type()(key);
+      return this->shards_[(h ^ (h >> 16)) % this->shards_.size()];
+    }
+
+    bool is_expired(const item & value) const {
+      return this->ttl_ != std::chrono::steady_clock::duration::zero()
+        && value.expires_ <= std::chrono::steady_clock::now();
+    }
+
+    void set_value(const key_type & key, value_type && value) {
+      const auto size = size_type()(key, value);
+      const auto expires = std::chrono::steady_clock::now() + this->ttl_;
+
+      auto & shard = this->get_shard(key);
+      std::unique_lock<std::mutex> lock(shard.mutex_);
+
+      auto p = shard.items_.find(key);
+      if (shard.items_.end() != p) {
+        shard.erase(p);
+      }
+
+      if (size > shard.max_bytes_) {
+        return;
+      }
+
+      shard.evict(size);
+
+      auto result = shard.items_.emplace(key, item{ std::move(value), size, expires, nullptr, nullptr, nullptr });
+      auto & new_item = result.first->second;
+      new_item.key_ = &result.first->first;
+      shard.push_front(&new_item);
+      shard.bytes_ += size;
+    }
+  };
+}
+
+#endif//__VDS_CORE_LRU_CACHE_H_
@@ -0,0 +1,143 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include "metrics.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+vds::metric_histogram::metric_histogram() {
+  for (auto & shard : this->shards_) {
+    for (auto & bucket : shard.buckets_) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+    shard.sum_.store(0, std::memory_order_relaxed);
+    shard.max_.store(0, std::memory_order_relaxed);
+  }
+}
+
+size_t vds::metric_histogram::count_leading_zeros(uint64_t value) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanReverse64(&index, value);
+  return 63 - index;
+#else
+  return __builtin_clzll(value);
+#endif
+}
+
+vds::metric_histogram::snapshot vds::metric_histogram::get_snapshot() const {
+  snapshot result{};
+
+  std::vector<uint64_t> buckets(bucket_count);
+  for (const auto & shard : this->shards_) {
+    for (size_t i = 0; i < bucket_count; ++i) {
+      const auto count = shard.buckets_[i].load(std::memory_order_relaxed);
+      buckets[i] += count;
+      result.count += count;
+    }
+    result.sum += shard.sum_.load(std::memory_order_relaxed);
+
+    const auto max = shard.max_.load(std::memory_order_relaxed);
+    if (result.max < max) {
+      result.max = max;
+    }
+  }
+
+  if (0 == result.count) {
+    return result;
+  }
+
+  //Percentiles are reported as the middle of their bucket
+  const auto percentile = [&buckets, &result](uint64_t numerator, uint64_t denominator) -> uint64_t {
+    const auto rank = (result.count * numerator + denominator - 1) / denominator;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < bucket_count; ++i) {
+      seen += buckets[i];
+      if (seen >= rank) {
+        const auto lower = bucket_lower_bound(i);
+        const auto upper = (i + 1 < bucket_count) ? bucket_lower_bound(i + 1) : result.max + 1;
+        const auto value = lower + (upper - lower - 1) / 2;
+        return (value < result.max) ? value : result.max;
+      }
+    }
+    return result.max;
+  };
+
+  for (size_t i = 0; i < bucket_count; ++i) {
+    if (0 != buckets[i]) {
+      result.min = bucket_lower_bound(i);
+      break;
+    }
+  }
+
+  result.p50 = percentile(50, 100);
+  result.p90 = percentile(90, 100);
+  result.p99 = percentile(99, 100);
+  result.p999 = percentile(999, 1000);
+  return result;
+}
+
+namespace vds {
+  class _metrics_registry {
+  public:
+    static _metrics_registry & instance() {
+      static _metrics_registry registry;
+      return registry;
+    }
+
+    template <typename metric_type>
+    metric_type & get(std::map<std::string, std::unique_ptr<metric_type>> & items, const std::string & name) {
+      std::unique_lock<std::mutex> lock(this->mutex_);
+      auto & result = items[name];
+      if (!result) {
+        result.reset(new metric_type());
+      }
+      return *result;
+    }
+
+    std::mutex mutex_;
+    std::map<std::string, std::unique_ptr<metric_counter>> counters_;
+    std::map<std::string, std::unique_ptr<metric_gauge>> gauges_;
+    std::map<std::string, std::unique_ptr<metric_histogram>> histograms_;
+  };
+}
+
+vds::metric_counter & vds::metrics::counter(const std::string & name) {
+  auto & registry = _metrics_registry::instance();
+  return registry.get(registry.counters_, name);
+}
+
+vds::metric_gauge & vds::metrics::gauge(const std::string & name) {
+  auto & registry = _metrics_registry::instance();
+  return registry.get(registry.gauges_, name);
+}
+
+vds::metric_histogram & vds::metrics::histogram(const std::string & name) {
+  auto & registry = _metrics_registry::instance();
+  return registry.get(registry.histograms_, name);
+}
+
+vds::metrics_statistic vds::metrics::get_statistic() {
+  auto & registry = _metrics_registry::instance();
+
+  metrics_statistic result;
+  std::unique_lock<std::mutex> lock(registry.mutex_);
+  for (const auto & p : registry.counters_) {
+    result.counters_[p.first] = p.second->value();
+  }
+  for (const auto & p : registry.gauges_) {
+    result.gauges_[p.first] = p.second->value();
+  }
+  for (const auto & p : registry.histograms_) {
+    result.histograms_[p.first] = p.second->get_snapshot();
+  }
+  return result;
+}
@@ -0,0 +1,171 @@
+#ifndef __VDS_CORE_METRICS_H_
+#define __VDS_CORE_METRICS_H_
+
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <map>
+#include <string>
+
+namespace vds {
+
+  //Shards are picked per thread, so concurrent updates from different threads
+  //do not fight for the same cache line
+  class metric_shard {
+  public:
+    static constexpr size_t shard_count = 16;
+
+    static size_t current() {
+      static std::atomic<size_t> next_index(0);
+      thread_local size_t index = next_index.fetch_add(1, std::memory_order_relaxed) % shard_count;
+      return index;
+    }
+  };
+
+  //Monotonic event counter
+  class metric_counter {
+  public:
+    metric_counter()
+    : shards_{} {
+    }
+
+    void add(uint64_t value = 1) {
+      this->shards_[metric_shard::current()].value_.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const {
+      uint64_t result = 0;
+      for (const auto & shard : this->shards_) {
+        result += shard.value_.load(std::memory_order_relaxed);
+      }
+      return result;
+    }
+
+  private:
+    struct alignas(64) shard_t {
+      std::atomic<uint64_t> value_;
+    };
+
+    shard_t shards_[metric_shard::shard_count];
+  };
+
+  //Current value of a level, e.g. a queue length
+  class metric_gauge {
+  public:
+    metric_gauge()
+    : value_(0) {
+    }
+
+    void set(int64_t value) {
+      this->value_.store(value, std::memory_order_relaxed);
+    }
+
+    void add(int64_t value) {
+      this->value_.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    int64_t value() const {
+      return this->value_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::atomic<int64_t> value_;
+  };
+
+  //HDR-style histogram: every power of two is split into sub_bucket_count linear buckets,
+  //so the relative error stays below 1/sub_bucket_count over the whole uint64_t range.
+  class metric_histogram {
+  public:
+    static constexpr size_t sub_bucket_bits = 4;
+    static constexpr size_t sub_bucket_count = size_t(1) << sub_bucket_bits;
+    static constexpr size_t bucket_count = (64 - sub_bucket_bits + 1) * sub_bucket_count;
+    static constexpr size_t shard_count = 4;
+
+    struct snapshot {
+      uint64_t count;
+      uint64_t sum;
+      uint64_t min;
+      uint64_t max;
+      uint64_t p50;
+      uint64_t p90;
+      uint64_t p99;
+      uint64_t p999;
+    };
+
+    metric_histogram();
+
+    void record(uint64_t value) {
+      auto & shard = this->shards_[metric_shard::current() % shard_count];
+      shard.buckets_[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+      shard.sum_.fetch_add(value, std::memory_order_relaxed);
+
+      auto max = shard.max_.load(std::memory_order_relaxed);
+      while (max < value && !shard.max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+      }
+    }
+
+    //Durations are kept in microseconds
+    void record(std::chrono::steady_clock::duration value) {
+      const auto us = std::chrono::duration_cast<std::chrono::microseconds>(value).count();
+      this->record(static_cast<uint64_t>(us < 0 ? 0 : us));
+    }
+
+    snapshot get_snapshot() const;
+
+    static size_t bucket_index(uint64_t value) {
+      if (value < sub_bucket_count) {
+        return static_cast<size_t>(value);
+      }
+
+      const size_t exponent = 63 - count_leading_zeros(value);
+      const size_t sub_bucket = static_cast<size_t>(value >> (exponent - sub_bucket_bits)) & (sub_bucket_count - 1);
+      return (exponent - sub_bucket_bits + 1) * sub_bucket_count + sub_bucket;
+    }
+
+    static uint64_t bucket_lower_bound(size_t index) {
+      if (index < sub_bucket_count) {
+        return index;
+      }
+
+      const size_t exponent = index / sub_bucket_count + sub_bucket_bits - 1;
+      const uint64_t sub_bucket = index % sub_bucket_count;
+      return (sub_bucket_count + sub_bucket) << (exponent - sub_bucket_bits);
+    }
+
+  private:
+    struct alignas(64) shard_t {
+      std::atomic<uint64_t> buckets_[bucket_count];
+      std::atomic<uint64_t> sum_;
+      std::atomic<uint64_t> max_;
+    };
+
+    shard_t shards_[shard_count];
+
+    static size_t count_leading_zeros(uint64_t value);
+  };
+
+  struct metrics_statistic {
+    std::map<std::string, uint64_t> counters_;
+    std::map<std::string, int64_t> gauges_;
+    std::map<std::string, metric_histogram::snapshot> histograms_;
+  };
+
+  //Process-wide registry. Metrics are created on the first request and live until the process exits,
+  //so the hot paths keep a reference in a static variable:
+  //  static auto & sent = metrics::counter("dht.datagram.sent");
+  class metrics {
+  public:
+    static metric_counter & counter(const std::string & name);
+    static metric_gauge & gauge(const std::string & name);
+    static metric_histogram & histogram(const std::string & name);
+
+    static metrics_statistic get_statistic();
+  };
+}
+
+#endif // __VDS_CORE_METRICS_H_
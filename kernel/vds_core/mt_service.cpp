@@ -11,6 +11,7 @@ All rights reserved
 
 #include <thread>
 #include "logger.h"
+#include "metrics.h"
 
 #ifndef _WIN32
 #include <sys/syscall.h>
@@ -75,31 +76,47 @@ void vds::imt_service::do_async(lambda_holder_t<void> handler)
 }
 
 vds::_mt_service::_mt_service(const service_provider * sp)
-: sp_(sp), is_shuting_down_(false), free_threads_(0)
+: sp_(sp), is_shuting_down_(false), pending_(0), sleeping_(0)
 {
 }
 
+static thread_local vds::_mt_service * current_owner = nullptr;
+static thread_local void * current_worker = nullptr;
+
 void vds::_mt_service::start()
 {
-  //unsigned int count = std::thread::hardware_concurrency();
-  //if(count < 1){
-  //  count = 1;
-  //}
-  //else if(count > 1024 * 1024) {
-  //  count = 1024 * 1024;
-  //}
-  //
-  //for(unsigned int i = 0; i < count; ++i){
-  //  this->work_threads_.push_back(std::thread(std::bind(&_mt_service::work_thread, this)));
-  //}
+  //Continuations still may block on async_task::get, so keep a reserve over the core count
+  unsigned int count = 2 * std::thread::hardware_concurrency();
+  if(count < 4){
+    count = 4;
+  }
+
+  for(unsigned int i = 0; i < count; ++i){
+    auto worker = std::make_unique<worker_t>();
+    worker->owner_ = this;
+    this->workers_.push_back(std::move(worker));
+  }
+
+  for (size_t i = 0; i < this->workers_.size(); ++i) {
+    auto worker = this->workers_[i].get();
+    worker->thread_ = std::thread([this, worker, i]() {
+      this->work_thread(worker, i);
+    });
+  }
 }
 
 void vds::_mt_service::stop()
 {
-  this->is_shuting_down_ = true;
-  for(auto & t : this->work_threads_){
-    this->cond_.notify_all();
-    t.join();
+  {
+    std::unique_lock<std::mutex> lock(this->idle_mutex_);
+    this->is_shuting_down_ = true;
+    this->idle_cond_.notify_all();
+  }
+
+  for(auto & w : this->workers_){
+    if (w->thread_.joinable()) {
+      w->thread_.join();
+    }
   }
 }
 
@@ -109,20 +126,118 @@ vds::async_task<vds::expected<void>> vds::_mt_service::prepare_to_stop() {
 
 void vds::_mt_service::do_async(lambda_holder_t<void> handler)
 {
-  std::unique_lock<std::mutex> lock(this->mutex_);
-  this->queue_.push(std::move(handler));
-  if(0 == this->free_threads_) {
-    auto count = std::thread::hardware_concurrency();
-    if(count < 1){
-      count = 1;
+  if (this == current_owner) {
+    this->push_local(static_cast<worker_t *>(current_worker), std::move(handler));
+  }
+  else {
+    this->push_injected(std::move(handler));
+  }
+}
+
+void vds::_mt_service::push_local(worker_t * worker, lambda_holder_t<void> && handler)
+{
+  std::unique_lock<std::mutex> lock(worker->mutex_);
+  ++this->pending_;
+  if (!worker->lifo_slot_) {
+    worker->lifo_slot_ = std::move(handler);
+  }
+  else {
+    //The previous continuation moves to the deque
+    worker->lifo_slot_.swap(handler);
+    worker->queue_.push_back(queued_task_t{ std::move(handler), std::chrono::steady_clock::now() });
+  }
+  lock.unlock();
+
+  //The owner may block before it gets back to the LIFO slot, so an idle worker has to see it
+  this->wake_one();
+}
+
+void vds::_mt_service::push_injected(lambda_holder_t<void> && handler)
+{
+  std::unique_lock<std::mutex> lock(this->inject_mutex_);
+  ++this->pending_;
+  this->inject_queue_.push(queued_task_t{ std::move(handler), std::chrono::steady_clock::now() });
+  lock.unlock();
+
+  this->wake_one();
+}
+
+void vds::_mt_service::wake_one()
+{
+  if (0 < this->sleeping_) {
+    std::unique_lock<std::mutex> lock(this->idle_mutex_);
+    this->idle_cond_.notify_one();
+  }
+}
+
+bool vds::_mt_service::pop_local(worker_t * worker, lambda_holder_t<void> & handler)
+{
+  std::unique_lock<std::mutex> lock(worker->mutex_);
+  if (worker->lifo_slot_) {
+    handler = std::move(worker->lifo_slot_);
+    --this->pending_;
+    return true;
+  }
+
+  if (worker->queue_.empty()) {
+    return false;
+  }
+
+  take(worker->queue_.back(), handler);
+  worker->queue_.pop_back();
+  --this->pending_;
+  return true;
+}
+
+bool vds::_mt_service::pop_injected(lambda_holder_t<void> & handler)
+{
+  std::unique_lock<std::mutex> lock(this->inject_mutex_);
+  if (this->inject_queue_.empty()) {
+    return false;
+  }
+
+  take(this->inject_queue_.front(), handler);
+  this->inject_queue_.pop();
+  --this->pending_;
+  return true;
+}
+
+bool vds::_mt_service::steal(size_t index, std::minstd_rand & rnd, lambda_holder_t<void> & handler)
+{
+  const auto count = this->workers_.size();
+  const auto start = rnd() % count;
+  for (size_t i = 0; i < count; ++i) {
+    const auto victim_index = (start + i) % count;
+    if (victim_index == index) {
+      continue;
     }
-    if (this->work_threads_.size() < 16 * count) {
-      this->work_threads_.emplace_back(std::bind(&_mt_service::work_thread, this));
-      return;
+
+    auto victim = this->workers_[victim_index].get();
+    std::unique_lock<std::mutex> lock(victim->mutex_);
+    if (!victim->queue_.empty()) {
+      take(victim->queue_.front(), handler);
+      victim->queue_.pop_front();
+      --this->pending_;
+      return true;
+    }
+
+    //The owner may be blocked while its continuation waits in the LIFO slot
+    if (victim->lifo_slot_) {
+      handler = std::move(victim->lifo_slot_);
+      --this->pending_;
+      return true;
     }
   }
 
-  this->cond_.notify_one();
+  return false;
+}
+
+//Continuations in the LIFO slot run right away and are not measured
+void vds::_mt_service::take(queued_task_t & task, lambda_holder_t<void> & handler)
+{
+  static auto & queue_wait = metrics::histogram("mt_service.queue_wait_us");
+  queue_wait.record(std::chrono::steady_clock::now() - task.queued_);
+  handler = std::move(task.handler_);
 }
 
 void vds::_mt_service::set_instance(const service_provider * sp)
@@ -130,33 +245,38 @@ void vds::_mt_service::set_instance(const service_provider * sp)
 	current_instance = sp->get<imt_service>();
 }
 
-void vds::_mt_service::work_thread()
+void vds::_mt_service::work_thread(worker_t * worker, size_t index)
 {
   set_instance(this->sp_);
+  current_owner = this;
+  current_worker = worker;
+
+  std::minstd_rand rnd(static_cast<std::minstd_rand::result_type>(index + 1));
   for(;;){
-    std::unique_lock<std::mutex> lock(this->mutex_);
-    if (this->queue_.empty()) {
-      if(8 < ++this->free_threads_ || this->is_shuting_down_) {
-        --this->free_threads_;
+    lambda_holder_t<void> handler;
+    if (this->pop_local(worker, handler)
+      || this->pop_injected(handler)
+      || this->steal(index, rnd, handler)) {
+      handler();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(this->idle_mutex_);
+    if (0 == this->pending_) {
+      //Queued continuations are still resumed during shutdown
+      if (this->is_shuting_down_) {
         break;
       }
-      do {
-        this->cond_.wait(lock);
-      } while (this->queue_.empty() && !this->is_shuting_down_);
-      --this->free_threads_;
 
-      if (this->is_shuting_down_) {
-        continue;
+      ++this->sleeping_;
+      if (0 == this->pending_) {
+        this->idle_cond_.wait(lock);
       }
+      --this->sleeping_;
     }
-    
-    auto handler = std::move(this->queue_.front());
-    this->queue_.pop();
-
-    lock.unlock();
-    
-    handler();
   }
+
+  current_worker = nullptr;
+  current_owner = nullptr;
   current_instance = nullptr;
 }
-
@@ -1,37 +1,312 @@
-//#ifndef __VDS_CORE_PARALLEL_TASKS_H_
-//#define __VDS_CORE_PARALLEL_TASKS_H_
-//
-///*
-//Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
-//All rights reserved
-//*/
-//
-//
-//
-//namespace vds {
-//
-//  class parallel_tasks
-//  {
-//  public:
-//
-//    template <typename task_type>
-//    void add(task_type && task)
-//    {
-//      this->tasks_.push_back(std::forward<task_type>(task));
-//    }
-//
-//    vds::async_task<vds::expected<void>> run()
-//    {
-//      return [this](const vds::async_result<> & result) {
-//          auto runner = new _async_series(result, this->tasks_.size());
-//          runner->run(std::move(this->tasks_));
-//        };
-//    }
-//
-//  private:
-//    std::list<vds::async_task<vds::expected<void>>> tasks_;
-//  };
-//}
-//
-//#endif // __VDS_CORE_PARALLEL_TASKS_H_
-// 
+#ifndef __VDS_CORE_PARALLEL_TASKS_H_
+#define __VDS_CORE_PARALLEL_TASKS_H_
+
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "async_task.h"
+#include "expected.h"
+
+namespace vds {
+
+  //Completes when every task has completed.
+  //The result is the first error to arrive, otherwise the values in the order of the tasks.
+  template <typename value_type>
+  class _when_all_state : public std::enable_shared_from_this<_when_all_state<value_type>> {
+  public:
+    _when_all_state(size_t count)
+    : remaining_(count), values_(count) {
+    }
+
+    async_task<expected<std::vector<value_type>>> run(std::vector<async_task<expected<value_type>>> && tasks) {
+      auto result = this->result_.get_future();
+      if (tasks.empty()) {
+        this->result_.set_value(expected<std::vector<value_type>>());
+        return result;
+      }
+
+      for (size_t index = 0; index < tasks.size(); ++index) {
+        tasks[index].then([pthis = this->shared_from_this(), index](expected<value_type> task_result) {
+          pthis->on_complete(index, std::move(task_result));
+        });
+      }
+
+      return result;
+    }
+
+  private:
+    std::mutex mutex_;
+    size_t remaining_;
+    std::unique_ptr<std::exception> error_;
+    std::vector<value_type> values_;
+    async_result<expected<std::vector<value_type>>> result_;
+
+    void on_complete(size_t index, expected<value_type> && task_result) {
+      std::unique_lock<std::mutex> lock(this->mutex_);
+      if (task_result.has_error()) {
+        if (!this->error_) {
+          this->error_ = std::move(task_result.error());
+        }
+      }
+      else {
+        this->values_[index] = std::move(task_result.value());
+      }
+
+      if (0 != --this->remaining_) {
+        return;
+      }
+      lock.unlock();
+
+      if (this->error_) {
+        this->result_.set_value(unexpected(std::move(this->error_)));
+      }
+      else {
+        this->result_.set_value(std::move(this->values_));
+      }
+    }
+  };
+
+  template <>
+  class _when_all_state<void> : public std::enable_shared_from_this<_when_all_state<void>> {
+  public:
+    _when_all_state(size_t count)
+    : remaining_(count) {
+    }
+
+    async_task<expected<void>> run(std::vector<async_task<expected<void>>> && tasks) {
+      auto result = this->result_.get_future();
+      if (tasks.empty()) {
+        this->result_.set_value(expected<void>());
+        return result;
+      }
+
+      for (auto & task : tasks) {
+        task.then([pthis = this->shared_from_this()](expected<void> task_result) {
+          pthis->on_complete(std::move(task_result));
+        });
+      }
+
+      return result;
+    }
+
+  private:
+    std::mutex mutex_;
+    size_t remaining_;
+    std::unique_ptr<std::exception> error_;
+    async_result<expected<void>> result_;
+
+    void on_complete(expected<void> && task_result) {
+      std::unique_lock<std::mutex> lock(this->mutex_);
+      if (task_result.has_error() && !this->error_) {
+        this->error_ = std::move(task_result.error());
+      }
+
+      if (0 != --this->remaining_) {
+        return;
+      }
+      lock.unlock();
+
+      if (this->error_) {
+        this->result_.set_value(unexpected(std::move(this->error_)));
+      }
+      else {
+        this->result_.set_value(expected<void>());
+      }
+    }
+  };
+
+  //Completes with the index and result of the first task to complete.
+  //The other tasks keep running; their results are dropped.
+  template <typename value_type>
+  class _when_any_state : public std::enable_shared_from_this<_when_any_state<value_type>> {
+  public:
+    _when_any_state()
+    : is_completed_(false) {
+    }
+
+    async_task<expected<std::pair<size_t, value_type>>> run(std::vector<async_task<expected<value_type>>> && tasks) {
+      vds_assert(!tasks.empty());
+
+      auto result = this->result_.get_future();
+      for (size_t index = 0; index < tasks.size(); ++index) {
+        tasks[index].then([pthis = this->shared_from_this(), index](expected<value_type> task_result) {
+          if (!pthis->is_completed_.exchange(true)) {
+            if (task_result.has_error()) {
+              pthis->result_.set_value(unexpected(std::move(task_result.error())));
+            }
+            else {
+              pthis->result_.set_value(std::make_pair(index, std::move(task_result.value())));
+            }
+          }
+        });
+      }
+
+      return result;
+    }
+
+  private:
+    std::atomic<bool> is_completed_;
+    async_result<expected<std::pair<size_t, value_type>>> result_;
+  };
+
+  template <>
+  class _when_any_state<void> : public std::enable_shared_from_this<_when_any_state<void>> {
+  public:
+    _when_any_state()
+    : is_completed_(false) {
+    }
+
+    async_task<expected<size_t>> run(std::vector<async_task<expected<void>>> && tasks) {
+      vds_assert(!tasks.empty());
+
+      auto result = this->result_.get_future();
+      for (size_t index = 0; index < tasks.size(); ++index) {
+        tasks[index].then([pthis = this->shared_from_this(), index](expected<void> task_result) {
+          if (!pthis->is_completed_.exchange(true)) {
+            if (task_result.has_error()) {
+              pthis->result_.set_value(unexpected(std::move(task_result.error())));
+            }
+            else {
+              pthis->result_.set_value(index);
+            }
+          }
+        });
+      }
+
+      return result;
+    }
+
+  private:
+    std::atomic<bool> is_completed_;
+    async_result<expected<size_t>> result_;
+  };
+
+  //Calls fn for every element of the range, keeping at most max_in_flight calls running.
+  //After the first error no new calls are started; the error is reported once the running ones finish.
+  template <typename range_type, typename fn_type>
+  class _parallel_for_each_state : public std::enable_shared_from_this<_parallel_for_each_state<range_type, fn_type>> {
+  public:
+    _parallel_for_each_state(range_type && range, size_t max_in_flight, fn_type && fn)
+    : range_(std::move(range)),
+      max_in_flight_((0 == max_in_flight) ? 1 : max_in_flight),
+      fn_(std::move(fn)),
+      next_(std::begin(this->range_)),
+      in_flight_(0),
+      is_pumping_(false),
+      is_completed_(false) {
+    }
+
+    async_task<expected<void>> run() {
+      auto result = this->result_.get_future();
+
+      std::unique_lock<std::mutex> lock(this->mutex_);
+      this->pump(lock);
+
+      return result;
+    }
+
+  private:
+    range_type range_;
+    const size_t max_in_flight_;
+    fn_type fn_;
+    decltype(std::begin(std::declval<range_type &>())) next_;
+
+    std::mutex mutex_;
+    size_t in_flight_;
+    bool is_pumping_;
+    bool is_completed_;
+    std::unique_ptr<std::exception> error_;
+    async_result<expected<void>> result_;
+
+    void on_complete(expected<void> && task_result) {
+      std::unique_lock<std::mutex> lock(this->mutex_);
+      --this->in_flight_;
+      if (task_result.has_error() && !this->error_) {
+        this->error_ = std::move(task_result.error());
+      }
+
+      //Tasks completed inline are picked up by the loop already running
+      if (!this->is_pumping_) {
+        this->pump(lock);
+      }
+    }
+
+    void pump(std::unique_lock<std::mutex> & lock) {
+      this->is_pumping_ = true;
+      while (!this->error_ && std::end(this->range_) != this->next_ && this->in_flight_ < this->max_in_flight_) {
+        auto & item = *this->next_;
+        ++this->next_;
+        ++this->in_flight_;
+        lock.unlock();
+
+        auto task = this->fn_(item);
+        task.then([pthis = this->shared_from_this()](expected<void> task_result) {
+          pthis->on_complete(std::move(task_result));
+        });
+
+        lock.lock();
+      }
+      this->is_pumping_ = false;
+
+      if (0 != this->in_flight_ || this->is_completed_) {
+        return;
+      }
+      if (!this->error_ && std::end(this->range_) != this->next_) {
+        return;
+      }
+
+      this->is_completed_ = true;
+      auto error = std::move(this->error_);
+      lock.unlock();
+
+      if (error) {
+        this->result_.set_value(unexpected(std::move(error)));
+      }
+      else {
+        this->result_.set_value(expected<void>());
+      }
+    }
+  };
+
+  template <typename value_type>
+  inline async_task<expected<std::vector<value_type>>> when_all(std::vector<async_task<expected<value_type>>> tasks) {
+    auto state = std::make_shared<_when_all_state<value_type>>(tasks.size());
+    return state->run(std::move(tasks));
+  }
+
+  inline async_task<expected<void>> when_all(std::vector<async_task<expected<void>>> tasks) {
+    auto state = std::make_shared<_when_all_state<void>>(tasks.size());
+    return state->run(std::move(tasks));
+  }
+
+  template <typename value_type>
+  inline async_task<expected<std::pair<size_t, value_type>>> when_any(std::vector<async_task<expected<value_type>>> tasks) {
+    auto state = std::make_shared<_when_any_state<value_type>>();
+    return state->run(std::move(tasks));
+  }
+
+  inline async_task<expected<size_t>> when_any(std::vector<async_task<expected<void>>> tasks) {
+    auto state = std::make_shared<_when_any_state<void>>();
+    return state->run(std::move(tasks));
+  }
+
+  //The range is moved into the returned task and stays alive until every call has completed
+  template <typename range_type, typename fn_type>
+  inline async_task<expected<void>> parallel_for_each(range_type range, size_t max_in_flight, fn_type fn) {
+    auto state = std::make_shared<_parallel_for_each_state<range_type, fn_type>>(
+      std::move(range),
+      max_in_flight,
+      std::move(fn));
+    return state->run();
+  }
+}
+
+#endif // __VDS_CORE_PARALLEL_TASKS_H_
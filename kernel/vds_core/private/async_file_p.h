@@ -0,0 +1,39 @@
+#ifndef __VDS_CORE_ASYNC_FILE_P_H_
+#define __VDS_CORE_ASYNC_FILE_P_H_
+
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+
+#include "func_utils.h"
+#include "expected.h"
+
+namespace vds {
+  class _async_file_service
+  {
+  public:
+    _async_file_service();
+
+    void start(size_t thread_count);
+    void stop();
+
+    expected<void> schedule(lambda_holder_t<void> handler);
+
+  private:
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::list<lambda_holder_t<void>> queue_;
+    std::list<std::thread> threads_;
+    bool is_stopping_;
+
+    void work_thread();
+  };
+}
+
+#endif // __VDS_CORE_ASYNC_FILE_P_H_
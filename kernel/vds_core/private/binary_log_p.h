@@ -0,0 +1,86 @@
+#ifndef __VDS_CORE_BINARY_LOG_P_H_
+#define __VDS_CORE_BINARY_LOG_P_H_
+
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include <atomic>
+#include <vector>
+
+namespace vds {
+
+  //Single producer/single consumer byte ring owned by one writing thread.
+  //Positions grow monotonically; the producer never blocks and drops records when the ring is full.
+  class _binary_log_ring {
+  public:
+    static constexpr size_t capacity = 256 * 1024;
+
+    explicit _binary_log_ring(uint32_t thread_id)
+    : thread_id_(thread_id), head_(0), tail_(0), dropped_(0), is_abandoned_(false) {
+    }
+
+    uint32_t thread_id() const {
+      return this->thread_id_;
+    }
+
+    //Producer side
+    bool push(const uint8_t * data, size_t size) {
+      const auto head = this->head_.load(std::memory_order_relaxed);
+      const auto tail = this->tail_.load(std::memory_order_acquire);
+      if (capacity - (head - tail) < size) {
+        this->dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+
+      const auto offset = static_cast<size_t>(head % capacity);
+      const auto first = (capacity - offset < size) ? (capacity - offset) : size;
+      memcpy(this->data_ + offset, data, first);
+      memcpy(this->data_, data + first, size - first);
+
+      this->head_.store(head + size, std::memory_order_release);
+      return true;
+    }
+
+    //Consumer side: appends everything written so far
+    void pop(std::vector<uint8_t> & result) {
+      const auto head = this->head_.load(std::memory_order_acquire);
+      const auto tail = this->tail_.load(std::memory_order_relaxed);
+      if (head == tail) {
+        return;
+      }
+
+      const auto size = static_cast<size_t>(head - tail);
+      const auto offset = static_cast<size_t>(tail % capacity);
+      const auto first = (capacity - offset < size) ? (capacity - offset) : size;
+      result.insert(result.end(), this->data_ + offset, this->data_ + offset + first);
+      result.insert(result.end(), this->data_, this->data_ + (size - first));
+
+      this->tail_.store(head, std::memory_order_release);
+    }
+
+    uint64_t take_dropped() {
+      return this->dropped_.exchange(0, std::memory_order_relaxed);
+    }
+
+    //The owning thread has exited; the ring is released once drained
+    void abandon() {
+      this->is_abandoned_.store(true, std::memory_order_release);
+    }
+
+    bool is_abandoned() const {
+      return this->is_abandoned_.load(std::memory_order_acquire);
+    }
+
+  private:
+    const uint32_t thread_id_;
+    std::atomic<uint64_t> head_;
+    std::atomic<uint64_t> tail_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<bool> is_abandoned_;
+    uint8_t data_[capacity];
+  };
+}
+
+#endif // __VDS_CORE_BINARY_LOG_P_H_
@@ -6,17 +6,27 @@ Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
 All rights reserved
 */
 
-#include <list>
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <mutex>
 #include <queue>
+#include <random>
 #include <thread>
+#include <vector>
 #include <condition_variable>
 
 #include "service_provider.h"
 
 namespace vds {
   class mt_service;
-  
+
+  //Fixed-size work-stealing pool.
+  //Each worker owns a deque and a LIFO slot for the continuation it scheduled last.
+  //Tasks from foreign threads go to the shared injection queue.
+  //Idle workers steal the oldest task from random victims, or the LIFO slot
+  //of a victim whose deque is empty.
+  //Workers leave only after every queue is drained.
   class _mt_service
   {
   public:
@@ -30,17 +40,49 @@ namespace vds {
 
 	static void set_instance(const service_provider * sp);
 
+    size_t worker_count() const {
+      return this->workers_.size();
+    }
+
   private:
+    //The enqueue time feeds the queue wait histogram
+    struct queued_task_t {
+      lambda_holder_t<void> handler_;
+      std::chrono::steady_clock::time_point queued_;
+    };
+
+    struct worker_t {
+      _mt_service * owner_;
+      std::mutex mutex_;
+      std::deque<queued_task_t> queue_;
+      lambda_holder_t<void> lifo_slot_;
+      std::thread thread_;
+    };
+
     const service_provider * sp_;
-    std::list<std::thread> work_threads_;
-    unsigned int free_threads_;
-    bool is_shuting_down_;
-    
-    std::mutex mutex_;
-    std::condition_variable cond_;
-    std::queue<lambda_holder_t<void>> queue_;
-    
-    void work_thread();
+    std::vector<std::unique_ptr<worker_t>> workers_;
+    std::atomic<bool> is_shuting_down_;
+
+    std::mutex inject_mutex_;
+    std::queue<queued_task_t> inject_queue_;
+
+    //Tasks in deques, LIFO slots and the injection queue
+    std::atomic<size_t> pending_;
+    std::atomic<size_t> sleeping_;
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cond_;
+
+    void work_thread(worker_t * worker, size_t index);
+
+    void push_local(worker_t * worker, lambda_holder_t<void> && handler);
+    void push_injected(lambda_holder_t<void> && handler);
+    void wake_one();
+
+    bool pop_local(worker_t * worker, lambda_holder_t<void> & handler);
+    bool pop_injected(lambda_holder_t<void> & handler);
+    bool steal(size_t index, std::minstd_rand & rnd, lambda_holder_t<void> & handler);
+
+    static void take(queued_task_t & task, lambda_holder_t<void> & handler);
   };
 }
 
@@ -103,6 +103,20 @@ namespace vds {
       return expected<void>();
     }
 
+    //Allocate exactly size bytes when the final size is known
+    [[nodiscard]]
+    expected<void> reserve(size_t size) {
+      if (this->allocated_size_ < size) {
+        auto p = std::realloc(this->data_, size);
+        if (nullptr == p) {
+            return make_unexpected<std::bad_alloc>();
+        }
+        this->allocated_size_ = size;
+        this->data_ = static_cast<uint8_t *>(p);
+      }
+      return expected<void>();
+    }
+
     void remove(size_t offset, size_t len) {
       vds_assert(offset + len <= this->size_);
       if (0 < len) {
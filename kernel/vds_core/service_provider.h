@@ -20,6 +20,36 @@ namespace vds {
   class shutdown_event;
   class service_registrator;
   class foldername;
+  class logger;
+  class imt_service;
+
+  //Services used on hot paths are stored in a flat array at fixed indices;
+  //the rest are looked up by type id in the hash map.
+  //Libraries above the core take a reserved index by specializing service_slot<>
+  //next to the service class, so every caller that can use the service sees it.
+  enum class service_slot_t : size_t {
+    logger,
+    imt_service,
+    reserved_0,
+    reserved_1,
+
+    dynamic
+  };
+
+  template <typename service_type>
+  struct service_slot {
+    static constexpr service_slot_t value = service_slot_t::dynamic;
+  };
+
+  template <>
+  struct service_slot<logger> {
+    static constexpr service_slot_t value = service_slot_t::logger;
+  };
+
+  template <>
+  struct service_slot<imt_service> {
+    static constexpr service_slot_t value = service_slot_t::imt_service;
+  };
 
   class iservice_factory
   {
@@ -41,7 +71,16 @@ namespace vds {
     template <typename service_type>
     service_type * get() const
     {
-      auto result = (service_type *)this->get(types::get_type_id<service_type>());
+      //The slot is declared next to the class, so it is only known when the class is
+      static_assert(0 < sizeof(service_type), "Include the header of the service");
+
+      service_type * result;
+      if constexpr (service_slot_t::dynamic != service_slot<service_type>::value) {
+        result = static_cast<service_type *>(this->get(service_slot<service_type>::value));
+      }
+      else {
+        result = static_cast<service_type *>(this->get(types::get_type_id<service_type>()));
+      }
       vds_assert(nullptr != result);
       return result;
     }
@@ -59,6 +98,7 @@ namespace vds {
     private:
 
     void* get(size_t type_id) const;
+    void* get(service_slot_t slot) const;
   };
 
   class service_registrator : private service_provider
@@ -67,7 +107,14 @@ namespace vds {
     template <typename service_type>
     void add_service(service_type * service)
     {
-      this->add_service(types::get_type_id<service_type>(), service);
+      static_assert(0 < sizeof(service_type), "Include the header of the service");
+
+      if constexpr (service_slot_t::dynamic != service_slot<service_type>::value) {
+        this->add_service(service_slot<service_type>::value, service);
+      }
+      else {
+        this->add_service(types::get_type_id<service_type>(), service);
+      }
     }
 
     void add(iservice_factory & factory)
@@ -120,6 +167,7 @@ namespace vds {
     friend class service_provider;
 
     shutdown_event shutdown_event_;
+    void * slots_[static_cast<size_t>(service_slot_t::dynamic)] = {};
     std::unordered_map<size_t, void *> services_;
     std::list<iservice_factory *> factories_;
     foldername current_user_;
@@ -130,6 +178,12 @@ namespace vds {
 
       this->services_[type_id] = service;
     }
+
+    void add_service(service_slot_t slot, void* service) {
+      vds_assert(nullptr == this->slots_[static_cast<size_t>(slot)]);
+
+      this->slots_[static_cast<size_t>(slot)] = service;
+    }
   };
 
   inline const vds::shutdown_event& vds::service_provider::get_shutdown_event() const {
@@ -154,6 +208,10 @@ namespace vds {
     }
   }
 
+  inline void * service_provider::get(service_slot_t slot) const {
+    return static_cast<const service_registrator *>(this)->slots_[static_cast<size_t>(slot)];
+  }
+
 }
 
 
@@ -8,6 +8,7 @@ All rights reserved
 
 #include "async_task.h"
 #include "resizable_data_buffer.h"
+#include "buffer_pool.h"
 #include "file.h"
 
 namespace vds {
@@ -64,26 +65,32 @@ namespace vds {
       item_type * buffer,
       size_t len) = 0;
 
+    //Reads straight into the result, doubling the free space up to buffer_pool::max_pooled_size
     vds::async_task<vds::expected<const_data_buffer>> read_all() {
       auto result = std::make_shared<resizable_data_buffer>();
+      size_t block_size = buffer_pool::default_size;
       for(;;) {
-        CHECK_EXPECTED_ASYNC(result->resize_data(result->size() + 1024));
+        CHECK_EXPECTED_ASYNC(result->reserve(result->size() + block_size));
 
-        GET_EXPECTED_ASYNC(readed, co_await this->read_async(const_cast<uint8_t *>(result->data() + result->size()), 1024));
+        GET_EXPECTED_ASYNC(readed, co_await this->read_async(const_cast<uint8_t *>(result->data() + result->size()), block_size));
         if(readed == 0) {
           co_return result->move_data();
         }
 
         result->apply_size(readed);
+        if (readed == block_size && block_size < buffer_pool::max_pooled_size) {
+          block_size <<= 1;
+        }
       }
     }
 
     async_task<expected<void>> copy_to(std::shared_ptr<stream_output_async<item_type>> target)
     {
-      item_type buffer[1024];
+      auto buffer = buffer_pool::allocate(buffer_pool::default_size);
+      auto data = reinterpret_cast<item_type *>(buffer.data());
       for (;;) {
-        GET_EXPECTED_ASYNC(readed, co_await this->read_async(buffer, sizeof(buffer) / sizeof(buffer[0])));
-        CHECK_EXPECTED_ASYNC(co_await target->write_async(buffer, readed));
+        GET_EXPECTED_ASYNC(readed, co_await this->read_async(data, buffer.size() / sizeof(item_type)));
+        CHECK_EXPECTED_ASYNC(co_await target->write_async(data, readed));
         if (0 == readed) {
           co_return expected<void>();
         }
@@ -146,15 +153,28 @@ namespace vds {
             len = this->readed_ - this->processed_;
           }
 
-          memcpy(buffer, this->buffer_ + this->processed_, len);
+          memcpy(buffer, this->buffer_.data() + this->processed_, len);
           this->processed_ += len;
           co_return len;
         }
         if (this->eof_) {
           co_return 0;
         }
+
+        //Large reads bypass the buffer
+        if (len >= buffer_pool::default_size) {
+          GET_EXPECTED_ASYNC(readed, this->f_.read(buffer, len));
+          if (0 == readed) {
+            this->eof_ = true;
+          }
+          co_return readed;
+        }
+
+        if (!this->buffer_) {
+          this->buffer_ = buffer_pool::allocate(buffer_pool::default_size);
+        }
         this->processed_ = 0;
-        GET_EXPECTED_VALUE_ASYNC(this->readed_, this->f_.read(this->buffer_, sizeof(this->buffer_)));
+        GET_EXPECTED_VALUE_ASYNC(this->readed_, this->f_.read(this->buffer_.data(), this->buffer_.size()));
         if (0 == this->readed_) {
           this->eof_ = true;
           co_return 0;
@@ -165,7 +185,7 @@ namespace vds {
   private:
     file f_;
 
-    uint8_t buffer_[1024];
+    buffer_pool::buffer buffer_;
     size_t processed_;
     size_t readed_;
     bool eof_;
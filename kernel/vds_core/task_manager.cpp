@@ -11,9 +11,36 @@ All rights reserved
 #include "barrier.h"
 #include "logger.h"
 #include "async_task.h"
+#include "vds_exceptions.h"
+
+class barrier_locker
+{
+public:
+  barrier_locker(vds::barrier * b)
+  : b_(b) {
+    ++*this->b_;
+  }
+
+  barrier_locker(barrier_locker && original)
+    : b_(original.b_) {
+    original.b_ = nullptr;
+  }
+
+  barrier_locker(const barrier_locker &) = delete;
+  barrier_locker& operator = (const barrier_locker &) = delete;
+
+  ~barrier_locker() {
+    if (nullptr != this->b_) {
+      --*this->b_;
+    }
+  }
+private:
+  vds::barrier * b_;
+};
 
 vds::timer::timer(const char * name)
 : name_(name),
+  wheel_entry_(this),
   current_state_(std::make_shared<state_machine<state_t>>(state_t::bof)),
   is_shuting_down_(false)
 {
@@ -27,7 +54,11 @@ vds::timer::~timer() {
 
 
 vds::task_manager::task_manager()
-: is_shuting_down_(false), is_disabled_(false)
+: start_time_(std::chrono::steady_clock::now()),
+  wakeup_tick_(UINT64_MAX),
+  executing_(0),
+  is_shuting_down_(false),
+  is_disabled_(false)
 {
 }
 
@@ -59,22 +90,16 @@ vds::expected<void> vds::timer::stop()
 {
 	auto manager = static_cast<task_manager *>(this->sp_->get<task_manager>());
 
-	std::lock_guard<std::mutex> lock(manager->scheduled_mutex_);
-	manager->scheduled_.remove(this);
+	std::unique_lock<std::mutex> lock(manager->scheduled_mutex_);
+	manager->scheduled_.cancel(&this->wheel_entry_);
   this->is_shuting_down_ = true;
+  lock.unlock();
+
   CHECK_EXPECTED(this->current_state_->wait(state_t::eof).get());
 
   return expected<void>();
 }
 
-void vds::timer::execute()
-{
-    auto r = this->execute_async().get();
-    if(r.has_error()) {
-      this->sp_->get<logger>()->warning("tm", "Timer execute error %s", r.error()->what());
-    }
-}
-
 void vds::timer::schedule()
 {
   if(this->sp_->get_shutdown_event().is_shuting_down()){
@@ -87,17 +112,23 @@ void vds::timer::schedule()
     return;
   }
   
-  this->start_time_ = std::chrono::steady_clock::now() + this->period_;
-
-  std::lock_guard<std::mutex> lock(manager->scheduled_mutex_);
-  manager->scheduled_.push_back(this);
-  this->sp_->get<logger>()->trace("tm", "Add Task %s", this->name_.c_str());
+  if (manager->schedule(&this->wheel_entry_, std::chrono::steady_clock::now() + this->period_)) {
+    this->sp_->get<logger>()->trace("tm", "Add Task %s", this->name_.c_str());
+  }
+}
 
-  if (!manager->work_thread_.joinable()) {
-    manager->work_thread_ = std::thread([manager]() {
-      manager->work_thread();
+void vds::timer::wheel_entry::on_expired()
+{
+  auto manager = static_cast<task_manager *>(this->owner_->sp_->get<task_manager>());
+  imt_service::async(this->owner_->sp_, [task = this->owner_, l = barrier_locker(&manager->executing_)]() mutable {
+    //Do not park the worker thread until the handler is done.
+    //The task manager waits for the barrier at shutdown, so it is released by the continuation.
+    task->execute_async().then([sp = task->sp_, l = std::move(l)](expected<void> r) {
+      if(r.has_error()) {
+        sp->get<logger>()->warning("tm", "Timer execute error %s", r.error()->what());
+      }
     });
-  }
+  });
 }
 
 vds::async_task<vds::expected<void>> vds::timer::execute_async() {
@@ -148,66 +179,109 @@ vds::expected<void> vds::task_manager::stop()
 }
 
 vds::async_task<vds::expected<void>> vds::task_manager::prepare_to_stop() {
+  std::unique_lock<std::mutex> lock(this->scheduled_mutex_);
   this->is_shuting_down_ = true;
   this->scheduled_changed_.notify_all();
   co_return expected<void>();
 }
 
-class barrier_locker
+uint64_t vds::task_manager::to_tick(std::chrono::steady_clock::time_point time) const
 {
-public:
-  barrier_locker(vds::barrier * b)
-  : b_(b) {
-    ++*this->b_;
+  if (time <= this->start_time_) {
+    return 0;
   }
 
-  barrier_locker(barrier_locker && original)
-    : b_(original.b_) {
-    original.b_ = nullptr;
+  //Round up, so an entry never fires before its deadline
+  return static_cast<uint64_t>((time - this->start_time_ + tick_duration - std::chrono::steady_clock::duration(1)) / tick_duration);
+}
+
+bool vds::task_manager::schedule(timer_wheel::entry * entry, std::chrono::steady_clock::time_point time)
+{
+  std::unique_lock<std::mutex> lock(this->scheduled_mutex_);
+  if (this->is_shuting_down_) {
+    return false;
   }
 
-  barrier_locker(const barrier_locker &) = delete;
-  barrier_locker& operator = (const barrier_locker &) = delete;
+  this->scheduled_.schedule(entry, this->to_tick(time));
 
-  ~barrier_locker() {
-    if (nullptr != this->b_) {
-      --*this->b_;
-    }
+  if (!this->work_thread_.joinable()) {
+    this->work_thread_ = std::thread([this]() {
+      this->work_thread();
+    });
+  }
+  else if (entry->expire_tick() < this->wakeup_tick_) {
+    this->scheduled_changed_.notify_one();
   }
-private:
-  vds::barrier * b_;
-};
+
+  return true;
+}
 
 void vds::task_manager::work_thread()
 {
-  barrier b(0);
-  
+  std::unique_lock<std::mutex> lock(this->scheduled_mutex_);
   while(!this->is_shuting_down_){
-  
-    std::unique_lock<std::mutex> lock(this->scheduled_mutex_);
-    
-    std::chrono::steady_clock::duration timeout = std::chrono::seconds(5);
-    auto now = std::chrono::steady_clock::now();
-    for(auto task : this->scheduled_){
-      if(task->start_time_ <= now){
-        this->scheduled_.remove(task);
-        
-        imt_service::async(this->sp_, [task, l = barrier_locker(&b)](){
-          task->execute();
-        });
-        break;
-      }
-      else {
-        auto delta = task->start_time_ - now;
-        if (timeout > delta) {
-          timeout = delta;
-        }
-      }
+    const auto now = std::chrono::steady_clock::now();
+    this->scheduled_.advance(static_cast<uint64_t>((now - this->start_time_) / tick_duration));
+
+    this->wakeup_tick_ = this->scheduled_.next_tick();
+    if (UINT64_MAX == this->wakeup_tick_) {
+      this->scheduled_changed_.wait(lock);
+    }
+    else {
+      this->scheduled_changed_.wait_until(lock, this->start_time_ + this->wakeup_tick_ * tick_duration);
     }
-    
-    this->scheduled_changed_.wait_for(lock, timeout);
   }
-  
-  b.wait();
-  
+
+  this->wakeup_tick_ = UINT64_MAX;
+  this->scheduled_.clear();
+  lock.unlock();
+
+  this->executing_.wait();
+}
+
+namespace {
+  class _sleep_entry : public vds::timer_wheel::entry {
+  public:
+    _sleep_entry(const vds::service_provider * sp)
+    : sp_(sp) {
+    }
+
+    vds::async_task<vds::expected<void>> get_future() {
+      return this->result_.get_future();
+    }
+
+    void on_expired() override {
+      //Called under the task manager lock, so resume the waiter on the pool
+      vds::imt_service::async(this->sp_, [result = std::move(this->result_)]() mutable {
+        result.set_value(vds::expected<void>());
+      });
+      delete this;
+    }
+
+    void on_shutdown() override {
+      //timer_wheel::clear() runs under the task manager lock too
+      vds::imt_service::async(this->sp_, [result = std::move(this->result_)]() mutable {
+        result.set_value(vds::make_unexpected<vds::vds_exceptions::shooting_down_exception>());
+      });
+      delete this;
+    }
+
+  private:
+    const vds::service_provider * sp_;
+    vds::async_result<vds::expected<void>> result_;
+  };
+}
+
+vds::async_task<vds::expected<void>> vds::sleep_for(
+  const service_provider * sp,
+  std::chrono::steady_clock::duration period)
+{
+  auto entry = new _sleep_entry(sp);
+  auto result = entry->get_future();
+
+  if (!sp->get<task_manager>()->schedule(entry, std::chrono::steady_clock::now() + period)) {
+    entry->on_shutdown();
+  }
+
+  return result;
 }
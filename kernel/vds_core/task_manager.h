@@ -9,9 +9,12 @@
 #include "service_provider.h"
 #include "state_machine.h"
 #include "async_task.h"
+#include "barrier.h"
+#include "timer_wheel.h"
 
 namespace vds {
-  
+  class task_manager;
+
   class timer
   {
   public:
@@ -32,8 +35,21 @@ namespace vds {
     std::string name_;
 
     friend class task_manager;
+
+    class wheel_entry : public timer_wheel::entry {
+    public:
+      wheel_entry(timer * owner)
+      : owner_(owner) {
+      }
+
+      void on_expired() override;
+
+    private:
+      timer * owner_;
+    };
+
     std::chrono::steady_clock::duration period_;
-    std::chrono::time_point<std::chrono::steady_clock> start_time_;
+    wheel_entry wheel_entry_;
     std::function<async_task<expected<bool>>(void)> handler_;
 
 	  enum state_t {
@@ -44,7 +60,6 @@ namespace vds {
 	  };
     std::shared_ptr<state_machine<state_t>> current_state_;
 		bool is_shuting_down_;
-    void execute();
     void schedule();
 
     async_task<expected<void>> execute_async();
@@ -53,6 +68,8 @@ namespace vds {
   class task_manager : public iservice_factory
   {
   public:
+    static constexpr std::chrono::milliseconds tick_duration = std::chrono::milliseconds(10);
+
     task_manager();
     ~task_manager();
 
@@ -67,15 +84,30 @@ namespace vds {
 
   private:
     friend class timer;
+    friend async_task<expected<void>> sleep_for(
+      const service_provider * sp,
+      std::chrono::steady_clock::duration period);
+
     const service_provider * sp_;
-    std::list<timer *> scheduled_;
+    std::chrono::steady_clock::time_point start_time_;
+    timer_wheel scheduled_;
+    uint64_t wakeup_tick_;
     std::condition_variable scheduled_changed_;
     std::mutex scheduled_mutex_;
     std::thread work_thread_;
+    barrier executing_;
     bool is_shuting_down_;
     bool is_disabled_;
+
+    uint64_t to_tick(std::chrono::steady_clock::time_point time) const;
+    bool schedule(timer_wheel::entry * entry, std::chrono::steady_clock::time_point time);
     void work_thread();
   };
+
+  //Completes after the period without holding a thread; fails if the task manager is stopping
+  async_task<expected<void>> sleep_for(
+    const service_provider * sp,
+    std::chrono::steady_clock::duration period);
 }
 
 #endif // __VDS_CORE_TASK_MANAGER_H_
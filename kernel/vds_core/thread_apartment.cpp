@@ -5,4 +5,195 @@ All rights reserved
 
 #include "stdafx.h"
 #include "thread_apartment.h"
+#include <thread>
 
+vds::thread_apartment::thread_apartment(const service_provider * sp, const char * metrics_name)
+: sp_(sp),
+  is_stopping_(false),
+  head_(nullptr),
+  first_scheduled_(0),
+  size_(0),
+  max_queue_size_(0),
+  processed_(0),
+  batches_(0),
+  total_wait_(0),
+  max_wait_(0),
+  total_execute_(0),
+  max_execute_(0),
+  wait_histogram_(nullptr),
+  execute_histogram_(nullptr) {
+  if (nullptr != metrics_name) {
+    this->wait_histogram_ = &metrics::histogram(std::string(metrics_name) + ".queue_wait_us");
+    this->execute_histogram_ = &metrics::histogram(std::string(metrics_name) + ".execute_us");
+  }
+}
+
+vds::thread_apartment::~thread_apartment() {
+  auto node = this->head_.exchange(nullptr);
+  while (nullptr != node) {
+    auto next = node->next_;
+    delete node;
+    node = next;
+  }
+}
+
+void vds::thread_apartment::push(task_node * node) {
+  vds_assert(!this->is_stopping_);
+
+  //Count first, so the drainer never sees the queue empty while the node is being pushed
+  const auto need_start = (0 == this->size_.fetch_add(1, std::memory_order_acq_rel));
+
+  //Only the node which starts a new stack reads the clock; the others take its time,
+  //so their wait is counted from the oldest node of the same batch
+  auto head = this->head_.load(std::memory_order_acquire);
+  do {
+    node->next_ = head;
+    if (nullptr == head) {
+      node->scheduled_ = std::chrono::steady_clock::now();
+      this->first_scheduled_.store(node->scheduled_.time_since_epoch().count(), std::memory_order_relaxed);
+    }
+    else {
+      node->scheduled_ = std::chrono::steady_clock::time_point(
+        std::chrono::steady_clock::duration(this->first_scheduled_.load(std::memory_order_relaxed)));
+    }
+  } while (!this->head_.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_acquire));
+
+  if (need_start) {
+    mt_service::async(this->sp_, [pthis = this->shared_from_this()]() {
+      pthis->drain();
+    });
+  }
+}
+
+void vds::thread_apartment::drain() {
+  for (;;) {
+    auto batch = this->head_.exchange(nullptr, std::memory_order_acquire);
+    if (nullptr == batch) {
+      //A producer has counted its node but not pushed it yet
+      std::this_thread::yield();
+      continue;
+    }
+
+    //Only the drainer lowers size_, so this is the deepest the queue has been since the last batch
+    const auto depth = this->size_.load(std::memory_order_relaxed);
+    if (this->max_queue_size_.load(std::memory_order_relaxed) < depth) {
+      this->max_queue_size_.store(depth, std::memory_order_relaxed);
+    }
+
+    //The stack holds the newest node first
+    task_node * ordered = nullptr;
+    size_t count = 0;
+    while (nullptr != batch) {
+      auto next = batch->next_;
+      batch->next_ = ordered;
+      ordered = batch;
+      batch = next;
+      ++count;
+    }
+
+    this->execute_batch(ordered, count);
+
+    if (count == this->size_.fetch_sub(count, std::memory_order_acq_rel)) {
+      break;
+    }
+  }
+
+  std::unique_lock<std::mutex> lock(this->stop_mutex_);
+  if (this->empty_query_) {
+    auto r = std::move(this->empty_query_);
+    lock.unlock();
+    r->set_value(expected<void>());
+  }
+}
+
+void vds::thread_apartment::execute_batch(task_node * node, size_t count) {
+  //Small batches are timed per item, the end of one item is the start of the next.
+  //A long batch of short items is timed as a whole, and every item gets the average.
+  const auto per_item = (count <= per_item_timing_limit);
+  const auto batch_start = std::chrono::steady_clock::now();
+  auto start = batch_start;
+  int64_t total_wait = 0;
+  int64_t max_wait = 0;
+  uint64_t processed = 0;
+
+  while (nullptr != node) {
+    const auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(start - node->scheduled_).count();
+    total_wait += wait;
+    if (nullptr != this->wait_histogram_) {
+      this->wait_histogram_->record(start - node->scheduled_);
+    }
+    if (max_wait < wait) {
+      max_wait = wait;
+    }
+
+    auto callback_result = node->execute();
+    if (callback_result.has_error()) {
+      this->sp_->get<logger>()->warning("Core", "%s at process callback", callback_result.error()->what());
+    }
+
+    auto next = node->next_;
+    delete node;
+    node = next;
+    ++processed;
+
+    if (per_item) {
+      const auto finish = std::chrono::steady_clock::now();
+      this->record_execute(finish - start, 1);
+      start = finish;
+    }
+  }
+
+  if (!per_item) {
+    this->record_execute((std::chrono::steady_clock::now() - batch_start) / processed, processed);
+  }
+
+  //Only the drainer updates these, so plain load/store is enough for the maximums
+  this->processed_.fetch_add(processed, std::memory_order_relaxed);
+  this->batches_.fetch_add(1, std::memory_order_relaxed);
+  this->total_wait_.fetch_add(total_wait, std::memory_order_relaxed);
+  if (this->max_wait_.load(std::memory_order_relaxed) < max_wait) {
+    this->max_wait_.store(max_wait, std::memory_order_relaxed);
+  }
+}
+
+void vds::thread_apartment::record_execute(std::chrono::steady_clock::duration time, uint64_t count) {
+  const auto execute = std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+  this->total_execute_.fetch_add(execute * count, std::memory_order_relaxed);
+  if (nullptr != this->execute_histogram_) {
+    for (uint64_t i = 0; i < count; ++i) {
+      this->execute_histogram_->record(time);
+    }
+  }
+  if (this->max_execute_.load(std::memory_order_relaxed) < execute) {
+    this->max_execute_.store(execute, std::memory_order_relaxed);
+  }
+}
+
+vds::async_task<vds::expected<void>> vds::thread_apartment::prepare_to_stop() {
+  std::unique_lock<std::mutex> lock(this->stop_mutex_);
+  vds_assert(!this->is_stopping_);
+  this->is_stopping_ = true;
+
+  this->empty_query_ = std::make_unique<vds::async_result<vds::expected<void>>>();
+  auto result = this->empty_query_->get_future();
+  if (0 == this->size_.load(std::memory_order_acquire)) {
+    auto r = std::move(this->empty_query_);
+    lock.unlock();
+    r->set_value(expected<void>());
+  }
+
+  return result;
+}
+
+vds::thread_apartment::statistic vds::thread_apartment::get_statistic() const {
+  statistic result;
+  result.queue_size = this->size_.load(std::memory_order_relaxed);
+  result.max_queue_size = this->max_queue_size_.load(std::memory_order_relaxed);
+  result.processed = this->processed_.load(std::memory_order_relaxed);
+  result.batches = this->batches_.load(std::memory_order_relaxed);
+  result.total_wait = std::chrono::nanoseconds(this->total_wait_.load(std::memory_order_relaxed));
+  result.max_wait = std::chrono::nanoseconds(this->max_wait_.load(std::memory_order_relaxed));
+  result.total_execute = std::chrono::nanoseconds(this->total_execute_.load(std::memory_order_relaxed));
+  result.max_execute = std::chrono::nanoseconds(this->max_execute_.load(std::memory_order_relaxed));
+  return result;
+}
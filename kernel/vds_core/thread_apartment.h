@@ -5,89 +5,109 @@
 Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
 All rights reserved
 */
-#include <queue>
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <mutex>
+#include <type_traits>
 #include "mt_service.h"
 #include "vds_debug.h"
 #include "logger.h"
+#include "metrics.h"
 
 namespace vds {
 
+  //Executes callbacks one at a time in the order they were scheduled.
+  //Producers push onto a lock-free intrusive stack; the single drainer takes the whole
+  //stack at once and runs it as one batch.
+  //The link lives in the same allocation as the callback, so scheduling allocates once.
   class thread_apartment : public std::enable_shared_from_this<thread_apartment> {
   public:
-    thread_apartment(const service_provider * sp)
-      : sp_(sp), is_stopping_(false){
-    }
-
-    ~thread_apartment() {
-      //vds_assert(this->task_queue_.empty());
-    }
+    //Batches up to this size have every item timed separately.
+    //Items queued behind others take the time of the oldest one, so waits are upper bounds.
+    static constexpr size_t per_item_timing_limit = 16;
 
-    void schedule(lambda_holder_t<expected<void>> callback) {
-      std::unique_lock<std::mutex> lock(this->task_queue_mutex_);
-      vds_assert(!this->is_stopping_);
-
-      const auto need_start = this->task_queue_.empty();
-      this->task_queue_.push(std::move(callback));
-      lock.unlock();
-
-      if(need_start) {
-        mt_service::async(this->sp_, [pthis = this->shared_from_this()]() {
-          for (;;) {
-            std::unique_lock<std::mutex> lock(pthis->task_queue_mutex_);
-            auto & f = pthis->task_queue_.front();
-            lock.unlock();
-
-            auto callback_result = f();
-            if(callback_result.has_error()) {
-              pthis->sp_->get<logger>()->warning("Core", "%s at process callback", callback_result.error()->what());
-            }
-
-            lock.lock();
-            pthis->task_queue_.pop();
-            if (pthis->task_queue_.empty()) {
-              if(pthis->empty_query_) {
-                auto r = std::move(pthis->empty_query_);
-                r->set_value(expected<void>());
-              }
-              break;
-            }
-            lock.unlock();
-          }
-        });
-      }
-    }
+    struct statistic {
+      size_t queue_size;
+      size_t max_queue_size;
+      uint64_t processed;
+      uint64_t batches;
+      std::chrono::nanoseconds total_wait;
+      std::chrono::nanoseconds max_wait;
+      std::chrono::nanoseconds total_execute;
+      std::chrono::nanoseconds max_execute;
+    };
 
-    vds::async_task<vds::expected<void>> prepare_to_stop() {
-      std::unique_lock<std::mutex> lock(this->task_queue_mutex_);
-      vds_assert(!this->is_stopping_);
-      this->is_stopping_ = true;
-      if(task_queue_.empty()) {
-        auto r = vds::async_result<vds::expected<void>>();
-        r.set_value(expected<void>());
-        return r.get_future();
-      }
+    //With a metrics name the queue wait and execution time also go to
+    //the "<name>.queue_wait_us" and "<name>.execute_us" histograms
+    thread_apartment(const service_provider * sp, const char * metrics_name = nullptr);
+    ~thread_apartment();
 
-      this->empty_query_ = std::make_unique<vds::async_result<vds::expected<void>>>();
-      return this->empty_query_->get_future();
+    template <typename callback_type, class = typename std::enable_if<std::is_invocable_r_v<expected<void>, std::decay_t<callback_type> &>>::type>
+    void schedule(callback_type && callback) {
+      this->push(new task_node_t<std::decay_t<callback_type>>(std::forward<callback_type>(callback)));
     }
 
+    vds::async_task<vds::expected<void>> prepare_to_stop();
+
     bool is_ready_to_stop() const {
-      std::unique_lock<std::mutex> lock(this->task_queue_mutex_);
-      return task_queue_.empty();
+      return 0 == this->size_.load(std::memory_order_acquire);
     }
 
     size_t size() const {
-      return this->task_queue_.size();
+      return this->size_.load(std::memory_order_relaxed);
     }
 
+    statistic get_statistic() const;
+
   private:
+    struct task_node {
+      task_node * next_;
+      std::chrono::steady_clock::time_point scheduled_;
+
+      virtual ~task_node() {}
+      virtual expected<void> execute() = 0;
+    };
+
+    template <typename callback_type>
+    struct task_node_t : public task_node {
+      callback_type callback_;
+
+      template <typename init_type>
+      task_node_t(init_type && callback)
+      : callback_(std::forward<init_type>(callback)) {
+      }
+
+      expected<void> execute() override {
+        return this->callback_();
+      }
+    };
+
     const service_provider * sp_;
-    bool is_stopping_;
-    mutable std::mutex task_queue_mutex_;
-    std::queue<lambda_holder_t<expected<void>>> task_queue_;
+    std::atomic<bool> is_stopping_;
+
+    std::atomic<task_node *> head_;
+    std::atomic<std::chrono::steady_clock::rep> first_scheduled_;
+    std::atomic<size_t> size_;
+
+    std::mutex stop_mutex_;
     std::unique_ptr<async_result<expected<void>>> empty_query_;
+
+    std::atomic<size_t> max_queue_size_;
+    std::atomic<uint64_t> processed_;
+    std::atomic<uint64_t> batches_;
+    std::atomic<int64_t> total_wait_;
+    std::atomic<int64_t> max_wait_;
+    std::atomic<int64_t> total_execute_;
+    std::atomic<int64_t> max_execute_;
+
+    metric_histogram * wait_histogram_;
+    metric_histogram * execute_histogram_;
+
+    void push(task_node * node);
+    void drain();
+    void execute_batch(task_node * node, size_t count);
+    void record_execute(std::chrono::steady_clock::duration time, uint64_t count);
   };
 }
 
@@ -0,0 +1,167 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include "timer_wheel.h"
+#include <stdexcept>
+#include "vds_debug.h"
+
+vds::timer_wheel::timer_wheel()
+: current_tick_(0), count_(0) {
+  for (uint32_t level = 0; level < level_count; ++level) {
+    for (uint32_t index = 0; index < slot_count; ++index) {
+      auto & head = this->slots_[level][index];
+      head.prev_ = &head;
+      head.next_ = &head;
+    }
+  }
+}
+
+vds::timer_wheel::~timer_wheel() {
+}
+
+void vds::timer_wheel::schedule(entry * e, uint64_t expire_tick) {
+  vds_assert(!e->is_scheduled());
+
+  //The current tick has already been processed
+  e->expire_tick_ = (expire_tick <= this->current_tick_) ? this->current_tick_ + 1 : expire_tick;
+  this->place(e);
+  ++this->count_;
+}
+
+void vds::timer_wheel::cancel(entry * e) {
+  if (e->is_scheduled()) {
+    unlink(e);
+    --this->count_;
+  }
+}
+
+void vds::timer_wheel::advance(uint64_t now_tick) {
+  while (this->current_tick_ < now_tick) {
+    if (0 == this->count_) {
+      this->current_tick_ = now_tick;
+      break;
+    }
+
+    ++this->current_tick_;
+
+    for (uint32_t level = 1; level < level_count; ++level) {
+      if (0 != (this->current_tick_ & ((uint64_t(1) << (level_bits * level)) - 1))) {
+        break;
+      }
+      this->cascade(level);
+    }
+
+    auto & head = this->slots_[0][this->current_tick_ & (slot_count - 1)];
+    while (head.next_ != &head) {
+      auto e = head.next_;
+      unlink(e);
+
+      if (e->expire_tick_ <= this->current_tick_) {
+        --this->count_;
+        e->on_expired();
+      }
+      else {
+        //Deadline was beyond the wheel span
+        this->place(e);
+      }
+    }
+  }
+}
+
+void vds::timer_wheel::clear() {
+  for (uint32_t level = 0; level < level_count; ++level) {
+    for (uint32_t index = 0; index < slot_count; ++index) {
+      auto & head = this->slots_[level][index];
+      while (head.next_ != &head) {
+        auto e = head.next_;
+        unlink(e);
+        --this->count_;
+        e->on_shutdown();
+      }
+    }
+  }
+}
+
+uint64_t vds::timer_wheel::next_tick() const {
+  uint64_t result = UINT64_MAX;
+  if (0 == this->count_) {
+    return result;
+  }
+
+  for (uint32_t level = 0; level < level_count; ++level) {
+    const auto shift = level_bits * level;
+    const auto base = this->current_tick_ >> shift;
+    for (uint64_t i = 1; i <= slot_count; ++i) {
+      const auto & head = this->slots_[level][(base + i) & (slot_count - 1)];
+      if (head.next_ != &head) {
+        //Higher levels report the tick at which the slot cascades down
+        const auto tick = (base + i) << shift;
+        if (result > tick) {
+          result = tick;
+        }
+        break;
+      }
+    }
+  }
+
+  return result;
+}
+
+void vds::timer_wheel::place(entry * e) {
+  static constexpr uint64_t max_delta = (uint64_t(1) << (level_bits * level_count)) - 1;
+
+  auto expire = e->expire_tick_;
+  if (expire < this->current_tick_) {
+    expire = this->current_tick_;
+  }
+  else if (expire - this->current_tick_ > max_delta) {
+    expire = this->current_tick_ + max_delta;
+  }
+
+  const auto delta = expire - this->current_tick_;
+  uint32_t level = 0;
+  while (level + 1 < level_count && delta >= (uint64_t(1) << (level_bits * (level + 1)))) {
+    ++level;
+  }
+
+  link(this->slots_[level][(expire >> (level_bits * level)) & (slot_count - 1)], e);
+}
+
+void vds::timer_wheel::cascade(uint32_t level) {
+  auto & head = this->slots_[level][(this->current_tick_ >> (level_bits * level)) & (slot_count - 1)];
+
+  //Detach the whole slot first, entries may land back on this level
+  entry * first = head.next_;
+  entry * last = head.prev_;
+  if (first == &head) {
+    return;
+  }
+  head.next_ = &head;
+  head.prev_ = &head;
+  last->next_ = nullptr;
+
+  while (nullptr != first) {
+    auto e = first;
+    first = first->next_;
+    e->prev_ = nullptr;
+    e->next_ = nullptr;
+    this->place(e);
+  }
+}
+
+void vds::timer_wheel::link(slot_head & head, entry * e) {
+  e->prev_ = head.prev_;
+  e->next_ = &head;
+  head.prev_->next_ = e;
+  head.prev_ = e;
+}
+
+void vds::timer_wheel::unlink(entry * e) {
+  e->prev_->next_ = e->next_;
+  e->next_->prev_ = e->prev_;
+  e->prev_ = nullptr;
+  e->next_ = nullptr;
+}
@@ -0,0 +1,107 @@
+#ifndef __VDS_CORE_TIMER_WHEEL_H_
+#define __VDS_CORE_TIMER_WHEEL_H_
+
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include <cstdint>
+#include <cstddef>
+
+namespace vds {
+
+  //Hashed hierarchical timer wheel.
+  //Entries are intrusive, so schedule and cancel are O(1) and do not allocate.
+  //The wheel is not thread safe; the owner serializes access.
+  class timer_wheel {
+  public:
+    static constexpr uint32_t level_bits = 6;
+    static constexpr uint32_t slot_count = 1 << level_bits;
+    static constexpr uint32_t level_count = 4;
+
+    class entry {
+    public:
+      entry()
+      : prev_(nullptr), next_(nullptr), expire_tick_(0) {
+      }
+
+      virtual ~entry() {
+      }
+
+      entry(const entry &) = delete;
+      entry & operator = (const entry &) = delete;
+
+      bool is_scheduled() const {
+        return nullptr != this->next_;
+      }
+
+      uint64_t expire_tick() const {
+        return this->expire_tick_;
+      }
+
+      //Called by the wheel owner when the entry expires; the entry is already unlinked
+      virtual void on_expired() = 0;
+
+      //Called for entries still scheduled when the owner shuts down
+      virtual void on_shutdown() {
+      }
+
+    private:
+      friend class timer_wheel;
+
+      entry * prev_;
+      entry * next_;
+      uint64_t expire_tick_;
+    };
+
+    timer_wheel();
+    ~timer_wheel();
+
+    timer_wheel(const timer_wheel &) = delete;
+    timer_wheel & operator = (const timer_wheel &) = delete;
+
+    void schedule(entry * e, uint64_t expire_tick);
+    void cancel(entry * e);
+
+    //Moves the wheel to now_tick and calls on_expired for every due entry
+    void advance(uint64_t now_tick);
+
+    //Unlinks every entry and calls on_shutdown
+    void clear();
+
+    //Earliest tick at which advance() has work to do, UINT64_MAX if the wheel is empty
+    uint64_t next_tick() const;
+
+    uint64_t current_tick() const {
+      return this->current_tick_;
+    }
+
+    size_t size() const {
+      return this->count_;
+    }
+
+    bool empty() const {
+      return 0 == this->count_;
+    }
+
+  private:
+    class slot_head : public entry {
+    public:
+      void on_expired() override {
+      }
+    };
+
+    uint64_t current_tick_;
+    size_t count_;
+    slot_head slots_[level_count][slot_count];
+
+    void place(entry * e);
+    void cascade(uint32_t level);
+
+    static void link(slot_head & head, entry * e);
+    static void unlink(entry * e);
+  };
+}
+
+#endif // __VDS_CORE_TIMER_WHEEL_H_
@@ -23,7 +23,8 @@ All rights reserved
 #include "file.h"
 #include "task_manager.h"
 #include "mt_service.h"
-#include "simple_cache.h"
+#include "async_file.h"
+#include "lru_cache.h"
 #include "binary_serialize.h"
 #include "const_data_buffer.h"
 
@@ -0,0 +1,252 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include <algorithm>
+#include "cauchy_codec.h"
+#include "metrics.h"
+
+namespace {
+  typedef vds::gf_math<uint8_t>::region_table region_table;
+
+  //Bytes of every segment processed per pass: the k source windows stay in L2
+  static constexpr size_t window_size = 4096;
+
+  //Bytes of the segment that are inside the data; the rest is zero padding
+  static size_t segment_bytes(size_t size, size_t segment_size, size_t column, size_t offset, size_t count) {
+    const size_t start = column * segment_size + offset;
+    if (start >= size) {
+      return 0;
+    }
+    return std::min(count, size - start);
+  }
+}
+
+vds::cauchy_encoder::cauchy_encoder(uint16_t k, const std::vector<uint16_t> & replicas)
+: k_(k), replicas_(replicas), tables_(k * replicas.size())
+{
+  for (size_t r = 0; r < replicas.size(); ++r) {
+    vds_assert(replicas[r] < 0x100);
+    if (replicas[r] >= k) {
+      for (uint16_t j = 0; j < k; ++j) {
+        math().prepare_region_table(coefficient(replicas[r], j), this->tables_[r * k + j]);
+      }
+    }
+  }
+}
+
+const vds::gf_math<uint8_t> & vds::cauchy_encoder::math()
+{
+  static const gf_math<uint8_t> result;
+  return result;
+}
+
+uint8_t vds::cauchy_encoder::coefficient(uint16_t replica, uint16_t column)
+{
+  return math().div(1, static_cast<uint8_t>(replica ^ column));
+}
+
+vds::expected<std::vector<vds::const_data_buffer>> vds::cauchy_encoder::write(const void * data, size_t size) const
+{
+  static auto & encoded_bytes = metrics::counter("erasure.encode.bytes");
+  static auto & encode_time = metrics::histogram("erasure.encode_us");
+  const auto start_time = std::chrono::steady_clock::now();
+
+  const size_t k = this->k_;
+  const size_t segment_size = (size + k - 1) / k;
+  const auto padding = safe_cast<uint16_t>(segment_size * k - size);
+  const auto input = static_cast<const uint8_t *>(data);
+
+  std::vector<const_data_buffer> result(this->replicas_.size());
+  for (auto & chunk : result) {
+    chunk.resize(segment_size + sizeof(uint16_t));
+  }
+
+  //Window by window, so every replica is computed from the same cached part of the input
+  for (size_t offset = 0; offset < segment_size; offset += window_size) {
+    const size_t count = std::min(window_size, segment_size - offset);
+
+    for (size_t r = 0; r < this->replicas_.size(); ++r) {
+      uint8_t * out = result[r].data() + offset;
+      const auto replica = this->replicas_[r];
+
+      if (replica < k) {
+        const auto bytes = segment_bytes(size, segment_size, replica, offset, count);
+        if (0 != bytes) {
+          memcpy(out, input + replica * segment_size + offset, bytes);
+        }
+        memset(out + bytes, 0, count - bytes);
+        continue;
+      }
+
+      memset(out, 0, count);
+      for (size_t j = 0; j < k; ++j) {
+        const auto bytes = segment_bytes(size, segment_size, j, offset, count);
+        if (0 != bytes) {
+          math().mul_add_region(out, input + j * segment_size + offset, this->tables_[r * k + j], bytes);
+        }
+      }
+    }
+  }
+
+  for (auto & chunk : result) {
+    chunk[segment_size] = static_cast<uint8_t>(padding >> 8);
+    chunk[segment_size + 1] = static_cast<uint8_t>(padding);
+  }
+
+  encoded_bytes.add(size * result.size());
+  encode_time.record(std::chrono::steady_clock::now() - start_time);
+  return result;
+}
+
+vds::cauchy_decoder::cauchy_decoder(
+  uint16_t k,
+  size_t max_bytes)
+: k_(k), decoders_(max_bytes, 4)
+{
+}
+
+vds::expected<vds::const_data_buffer> vds::cauchy_decoder::restore(
+  const std::vector<uint16_t> & replicas,
+  const std::vector<const_data_buffer> & chunks)
+{
+  static auto & decoded_bytes = metrics::counter("erasure.decode.bytes");
+  static auto & decode_time = metrics::histogram("erasure.decode_us");
+  const auto start_time = std::chrono::steady_clock::now();
+
+  const size_t k = this->k_;
+  if (replicas.size() < k || chunks.size() < k) {
+    return vds::make_unexpected<std::runtime_error>("Not enough replicas to restore data");
+  }
+
+  const auto size = chunks[0].size();
+  if (size < sizeof(uint16_t)) {
+    return vds::make_unexpected<std::runtime_error>("Invalid replica size");
+  }
+
+  //The matrix is inverted for the sorted set, so the chunks are reordered the same way
+  std::vector<size_t> order(k);
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&replicas](size_t left, size_t right) {
+    return replicas[left] < replicas[right];
+  });
+
+  std::vector<uint16_t> key(k);
+  std::vector<const uint8_t *> sources(k);
+  for (size_t i = 0; i < k; ++i) {
+    const auto & chunk = chunks[order[i]];
+    if (size != chunk.size()) {
+      return vds::make_unexpected<std::runtime_error>("Invalid replica size");
+    }
+    key[i] = replicas[order[i]];
+    sources[i] = chunk.data();
+  }
+
+  GET_EXPECTED(tables, this->get(key));
+
+  const size_t segment_size = size - sizeof(uint16_t);
+  const size_t padding = (uint16_t(chunks[0][segment_size]) << 8) | chunks[0][segment_size + 1];
+  if (padding >= k || padding > segment_size * k) {
+    return vds::make_unexpected<std::runtime_error>("Invalid replica padding");
+  }
+
+  const_data_buffer result;
+  result.resize(segment_size * k);
+
+  for (size_t offset = 0; offset < segment_size; offset += window_size) {
+    const size_t count = std::min(window_size, segment_size - offset);
+    for (size_t i = 0; i < k; ++i) {
+      uint8_t * out = result.data() + i * segment_size + offset;
+      memset(out, 0, count);
+      for (size_t j = 0; j < k; ++j) {
+        cauchy_encoder::math().mul_add_region(out, sources[j] + offset, (*tables)[i * k + j], count);
+      }
+    }
+  }
+
+  result.resize(segment_size * k - padding);
+
+  decoded_bytes.add(result.size());
+  decode_time.record(std::chrono::steady_clock::now() - start_time);
+  return result;
+}
+
+vds::expected<std::shared_ptr<const vds::cauchy_decoder::tables_t>> vds::cauchy_decoder::get(const std::vector<uint16_t> & replicas)
+{
+  static auto & hits = metrics::counter("erasure.decoder_cache.hits");
+  static auto & misses = metrics::counter("erasure.decoder_cache.misses");
+
+  std::shared_ptr<const tables_t> result;
+  if (this->decoders_.find(replicas, result)) {
+    hits.add();
+    return result;
+  }
+  misses.add();
+
+  const size_t k = this->k_;
+  const auto & math = cauchy_encoder::math();
+
+  //Gauss-Jordan elimination of [rows | E]
+  std::vector<uint8_t> left(k * k);
+  std::vector<uint8_t> right(k * k);
+  for (size_t i = 0; i < k; ++i) {
+    if (replicas[i] >= 0x100 || (0 < i && replicas[i] == replicas[i - 1])) {
+      return vds::make_unexpected<std::runtime_error>("Invalid replica index");
+    }
+    for (size_t j = 0; j < k; ++j) {
+      if (replicas[i] < k) {
+        left[i * k + j] = (replicas[i] == j) ? 1 : 0;
+      }
+      else {
+        left[i * k + j] = cauchy_encoder::coefficient(replicas[i], static_cast<uint16_t>(j));
+      }
+      right[i * k + j] = (i == j) ? 1 : 0;
+    }
+  }
+
+  for (size_t c = 0; c < k; ++c) {
+    size_t pivot = c;
+    while (pivot < k && 0 == left[pivot * k + c]) {
+      ++pivot;
+    }
+    if (pivot == k) {
+      return vds::make_unexpected<std::runtime_error>("Singular decode matrix");
+    }
+    if (pivot != c) {
+      for (size_t j = 0; j < k; ++j) {
+        std::swap(left[pivot * k + j], left[c * k + j]);
+        std::swap(right[pivot * k + j], right[c * k + j]);
+      }
+    }
+
+    const auto factor = math.div(1, left[c * k + c]);
+    for (size_t j = 0; j < k; ++j) {
+      left[c * k + j] = math.mul(left[c * k + j], factor);
+      right[c * k + j] = math.mul(right[c * k + j], factor);
+    }
+
+    for (size_t i = 0; i < k; ++i) {
+      const auto m = left[i * k + c];
+      if (i == c || 0 == m) {
+        continue;
+      }
+      for (size_t j = 0; j < k; ++j) {
+        left[i * k + j] ^= math.mul(m, left[c * k + j]);
+        right[i * k + j] ^= math.mul(m, right[c * k + j]);
+      }
+    }
+  }
+
+  auto tables = std::make_shared<tables_t>(k * k);
+  for (size_t i = 0; i < k * k; ++i) {
+    math.prepare_region_table(right[i], (*tables)[i]);
+  }
+
+  result = tables;
+  this->decoders_.set(replicas, result);
+  return result;
+}
@@ -0,0 +1,88 @@
+#ifndef __VDS_DATA_CAUCHY_CODEC_H_
+#define __VDS_DATA_CAUCHY_CODEC_H_
+
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include <memory>
+#include <vector>
+
+#include "erasure_codec.h"
+#include "gf.h"
+#include "lru_cache.h"
+
+namespace vds {
+
+  //Systematic Reed-Solomon code over GF(2^8).
+  //The data is split into k segments of equal length; replica r < k is segment r,
+  //replica r >= k is the sum of segment j multiplied by 1 / (r ^ j).
+  //Every k rows of the matrix are independent because each square part of a Cauchy matrix is.
+  //Replica chunk: segment length bytes and the number of zero bytes added to the data (uint16_t).
+  class cauchy_encoder : public erasure_encoder
+  {
+  public:
+    //Replicas must be less than 256
+    cauchy_encoder(uint16_t k, const std::vector<uint16_t> & replicas);
+
+    erasure_codec_id codec() const override {
+      return erasure_codec_id::gf8_cauchy;
+    }
+
+    uint16_t k() const {
+      return this->k_;
+    }
+
+    const std::vector<uint16_t> & replicas() const {
+      return this->replicas_;
+    }
+
+    expected<std::vector<const_data_buffer>> write(const void * data, size_t size) const override;
+
+    static const gf_math<uint8_t> & math();
+
+    //The coefficient of the segment column in the replica row
+    static uint8_t coefficient(uint16_t replica, uint16_t column);
+
+  private:
+    uint16_t k_;
+    std::vector<uint16_t> replicas_;
+
+    //k tables per replica, empty for the data replicas
+    std::vector<gf_math<uint8_t>::region_table> tables_;
+  };
+
+  class cauchy_decoder : public erasure_decoder
+  {
+  public:
+    cauchy_decoder(
+      uint16_t k,
+      size_t max_bytes = 4 * 1024 * 1024);
+
+    erasure_codec_id codec() const override {
+      return erasure_codec_id::gf8_cauchy;
+    }
+
+    expected<const_data_buffer> restore(
+      const std::vector<uint16_t> & replicas,
+      const std::vector<const_data_buffer> & chunks) override;
+
+  private:
+    typedef std::vector<gf_math<uint8_t>::region_table> tables_t;
+
+    struct tables_size {
+      size_t operator()(const std::vector<uint16_t> & key, const std::shared_ptr<const tables_t> & value) const {
+        return key.size() * sizeof(uint16_t) + value->size() * sizeof(gf_math<uint8_t>::region_table);
+      }
+    };
+
+    uint16_t k_;
+    lru_cache<std::vector<uint16_t>, std::shared_ptr<const tables_t>, replica_set_hash, tables_size> decoders_;
+
+    //replicas must be sorted
+    expected<std::shared_ptr<const tables_t>> get(const std::vector<uint16_t> & replicas);
+  };
+}
+
+#endif//__VDS_DATA_CAUCHY_CODEC_H_
@@ -6,3 +6,310 @@ All rights reserved
 #include "stdafx.h"
 #include "chunk.h"
 
+namespace {
+  typedef vds::gf_math<uint16_t>::region_table region_table;
+
+  //Cells processed per pass: enough for the vector kernels, small enough
+  //to keep the transposed columns in L2
+  static size_t region_batch_size(size_t k) {
+    return std::max<size_t>(256, 32768 / k);
+  }
+
+  static uint16_t read_cell(const uint8_t * p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+  }
+
+  //Transposes count stripes starting from the stripe first into k columns of batch cells
+  static void load_columns(
+    uint16_t * columns,
+    size_t batch,
+    const uint8_t * input,
+    size_t size,
+    size_t first,
+    size_t count,
+    size_t k) {
+    const size_t stripe_size = sizeof(uint16_t) * k;
+    const uint8_t * p = input + first * stripe_size;
+
+    if (size - first * stripe_size >= count * stripe_size) {
+      //Column by column: the writes are sequential and the strided reads hit L1
+      for (size_t j = 0; j < k; ++j) {
+        const uint8_t * cell = p + sizeof(uint16_t) * j;
+        uint16_t * column = columns + j * batch;
+        for (size_t i = 0; i < count; ++i) {
+          column[i] = read_cell(cell);
+          cell += stripe_size;
+        }
+      }
+    }
+    else {
+      //The last stripe is padded with zeros
+      for (size_t i = 0; i < count; ++i) {
+        for (size_t j = 0; j < k; ++j) {
+          const size_t offset = (first + i) * stripe_size + sizeof(uint16_t) * j;
+          const uint8_t b0 = (offset < size) ? input[offset] : 0;
+          const uint8_t b1 = (offset + 1 < size) ? input[offset + 1] : 0;
+          columns[j * batch + i] = static_cast<uint16_t>((b0 << 8) | b1);
+        }
+      }
+    }
+  }
+
+  //Decodes the chunks with the inverted matrix given as k * k region tables
+  static vds::expected<vds::const_data_buffer> restore_chunks(
+    size_t k,
+    const region_table * tables,
+    const std::vector<const vds::const_data_buffer *> & chunks) {
+    static auto & decoded_bytes = vds::metrics::counter("erasure.decode.bytes");
+    static auto & decode_time = vds::metrics::histogram("erasure.decode_us");
+    const auto start_time = std::chrono::steady_clock::now();
+
+    if (chunks.size() < k) {
+      return vds::make_unexpected<std::runtime_error>("Fatal error at chunk_restore::restore");
+    }
+
+    const auto size = chunks[0]->size();
+    if (size < sizeof(uint16_t) || 0 != size % sizeof(uint16_t)) {
+      return vds::make_unexpected<std::runtime_error>("Fatal error at chunk_restore::restore");
+    }
+
+    auto padding = uint16_t(chunks[0]->data()[size - 2] << 8) | chunks[0]->data()[size - 1];
+
+    for (size_t j = 1; j < k; ++j) {
+      vds_assert(size == chunks[j]->size());
+      vds_assert(padding == (uint16_t(chunks[j]->data()[size - 2] << 8) | chunks[j]->data()[size - 1]));
+    }
+
+    //The last cell of every chunk is the padding
+    const size_t cell_count = (size - sizeof(uint16_t)) / sizeof(uint16_t);
+    size_t expected_size = cell_count * k * sizeof(uint16_t);
+    if (0 != padding) {
+      if (0 == cell_count) {
+        return vds::make_unexpected<std::runtime_error>("Fatal error at chunk_restore::restore");
+      }
+      expected_size -= k * sizeof(uint16_t);
+      expected_size += padding;
+    }
+
+    const auto & math = vds::chunk<uint16_t>::math();
+    const size_t batch = region_batch_size(k);
+    std::vector<uint16_t> columns(k * batch);
+    std::vector<uint16_t> rows(k * batch);
+
+    //Whole stripes are written and the tail is cut off afterwards
+    vds::const_data_buffer result;
+    result.resize(cell_count * k * sizeof(uint16_t));
+    uint8_t * out = result.data();
+
+    for (size_t first = 0; first < cell_count; first += batch) {
+      const size_t count = std::min(batch, cell_count - first);
+
+      for (size_t j = 0; j < k; ++j) {
+        const uint8_t * p = chunks[j]->data() + first * sizeof(uint16_t);
+        for (size_t index = 0; index < count; ++index) {
+          columns[j * batch + index] = read_cell(p);
+          p += sizeof(uint16_t);
+        }
+      }
+
+      std::fill(rows.begin(), rows.end(), uint16_t(0));
+      for (size_t i = 0; i < k; ++i) {
+        for (size_t j = 0; j < k; ++j) {
+          math.mul_add_region(rows.data() + i * batch, columns.data() + j * batch, tables[i * k + j], count);
+        }
+      }
+
+      for (size_t index = 0; index < count; ++index) {
+        for (size_t i = 0; i < k; ++i) {
+          const auto value = rows[i * batch + index];
+          *out++ = static_cast<uint8_t>(value >> 8);
+          *out++ = static_cast<uint8_t>(value);
+        }
+      }
+    }
+
+    result.resize(expected_size);
+
+    decoded_bytes.add(expected_size);
+    decode_time.record(std::chrono::steady_clock::now() - start_time);
+    return result;
+  }
+}
+
+template<>
+vds::expected<void> vds::chunk_generator<uint16_t>::write(binary_serializer & s, const void * data, size_t size, bool write_padding) const
+{
+  static auto & encoded_bytes = metrics::counter("erasure.encode.bytes");
+  static auto & encode_time = metrics::histogram("erasure.encode_us");
+  const auto start_time = std::chrono::steady_clock::now();
+
+  const size_t k = this->k_;
+  const size_t stripe_size = sizeof(uint16_t) * k;
+  const size_t stripe_count = (size + stripe_size - 1) / stripe_size;
+  CHECK_EXPECTED(s.reserve(s.size() + sizeof(uint16_t) * stripe_count + (write_padding ? sizeof(uint16_t) : 0)));
+
+  const auto & math = chunk<uint16_t>::math_;
+  std::vector<region_table> tables(k);
+  for (size_t j = 0; j < k; ++j) {
+    math.prepare_region_table(this->multipliers_[j], tables[j]);
+  }
+
+  //The input is transposed into k columns, one per multiplier,
+  //and every output cell is the sum of the column products
+  const size_t batch = region_batch_size(k);
+  std::vector<uint16_t> columns(k * batch);
+  std::vector<uint16_t> values(batch);
+
+  const auto input = static_cast<const uint8_t *>(data);
+  for (size_t first = 0; first < stripe_count; first += batch) {
+    const size_t count = std::min(batch, stripe_count - first);
+    load_columns(columns.data(), batch, input, size, first, count, k);
+
+    std::fill(values.begin(), values.begin() + count, uint16_t(0));
+    for (size_t j = 0; j < k; ++j) {
+      math.mul_add_region(values.data(), columns.data() + j * batch, tables[j], count);
+    }
+    CHECK_EXPECTED(s.put_array(values.data(), count));
+  }
+
+  if (write_padding) {
+    CHECK_EXPECTED(s << safe_cast<uint16_t>(size % stripe_size));//Padding
+  }
+  else {
+    vds_assert(0 == size % stripe_size);
+  }
+
+  encoded_bytes.add(size);
+  encode_time.record(std::chrono::steady_clock::now() - start_time);
+  return vds::expected<void>();
+}
+
+template<>
+void vds::chunk_restore<uint16_t>::restore(
+  std::vector<uint16_t> & result,
+  const chunk<uint16_t> ** chunks)
+{
+  const size_t k = this->k_;
+  const size_t cell_count = chunks[0]->data_.size();
+
+  const auto & math = chunk<uint16_t>::math_;
+  std::vector<region_table> tables(k * k);
+  for (size_t i = 0; i < k * k; ++i) {
+    math.prepare_region_table(this->multipliers_[i], tables[i]);
+  }
+
+  const size_t batch = region_batch_size(k);
+  std::vector<uint16_t> rows(k * batch);
+
+  result.reserve(result.size() + cell_count * k);
+  for (size_t first = 0; first < cell_count; first += batch) {
+    const size_t count = std::min(batch, cell_count - first);
+
+    std::fill(rows.begin(), rows.end(), uint16_t(0));
+    for (size_t i = 0; i < k; ++i) {
+      for (size_t j = 0; j < k; ++j) {
+        math.mul_add_region(rows.data() + i * batch, chunks[j]->data_.data() + first, tables[i * k + j], count);
+      }
+    }
+
+    for (size_t index = 0; index < count; ++index) {
+      for (size_t i = 0; i < k; ++i) {
+        result.push_back(rows[i * batch + index]);
+      }
+    }
+  }
+}
+
+template<>
+vds::expected<vds::const_data_buffer> vds::chunk_restore<uint16_t>::restore(
+  const std::vector<const_data_buffer> & chunks)
+{
+  const size_t k = this->k_;
+  std::vector<region_table> tables(k * k);
+  for (size_t i = 0; i < k * k; ++i) {
+    chunk<uint16_t>::math_.prepare_region_table(this->multipliers_[i], tables[i]);
+  }
+
+  std::vector<const const_data_buffer *> sources(chunks.size());
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    sources[i] = &chunks[i];
+  }
+
+  return restore_chunks(k, tables.data(), sources);
+}
+
+vds::chunk_decoder::chunk_decoder(uint16_t k, const uint16_t * replicas)
+: k_(k), tables_(k * k)
+{
+  chunk_restore<uint16_t> restore(k, replicas);
+  for (size_t i = 0; i < this->tables_.size(); ++i) {
+    chunk<uint16_t>::math_.prepare_region_table(restore.multipliers()[i], this->tables_[i]);
+  }
+}
+
+vds::expected<vds::const_data_buffer> vds::chunk_decoder::restore(
+  const std::vector<const const_data_buffer *> & chunks) const
+{
+  return restore_chunks(this->k_, this->tables_.data(), chunks);
+}
+
+vds::chunk_replica_generator::chunk_replica_generator(uint16_t k, const std::vector<uint16_t> & replicas)
+: k_(k), replicas_(replicas), tables_(k * replicas.size())
+{
+  std::vector<uint16_t> multipliers(k);
+  for (size_t r = 0; r < replicas.size(); ++r) {
+    chunk<uint16_t>::generate_multipliers(multipliers.data(), k, replicas[r]);
+    for (size_t j = 0; j < k; ++j) {
+      chunk<uint16_t>::math_.prepare_region_table(multipliers[j], this->tables_[r * k + j]);
+    }
+  }
+}
+
+vds::expected<std::vector<vds::const_data_buffer>> vds::chunk_replica_generator::write(const void * data, size_t size) const
+{
+  static auto & encoded_bytes = metrics::counter("erasure.encode.bytes");
+  static auto & encode_time = metrics::histogram("erasure.encode_us");
+  const auto start_time = std::chrono::steady_clock::now();
+
+  const size_t k = this->k_;
+  const size_t stripe_size = sizeof(uint16_t) * k;
+  const size_t stripe_count = (size + stripe_size - 1) / stripe_size;
+
+  std::vector<binary_serializer> outputs(this->replicas_.size());
+  for (auto & s : outputs) {
+    CHECK_EXPECTED(s.reserve(sizeof(uint16_t) * (stripe_count + 1)));
+  }
+
+  //Every batch of the input is transposed once and stays in L2
+  //while all replicas are computed from it
+  const auto & math = chunk<uint16_t>::math_;
+  const size_t batch = region_batch_size(k);
+  std::vector<uint16_t> columns(k * batch);
+  std::vector<uint16_t> values(batch);
+
+  const auto input = static_cast<const uint8_t *>(data);
+  for (size_t first = 0; first < stripe_count; first += batch) {
+    const size_t count = std::min(batch, stripe_count - first);
+    load_columns(columns.data(), batch, input, size, first, count, k);
+
+    for (size_t r = 0; r < outputs.size(); ++r) {
+      const auto tables = this->tables_.data() + r * k;
+      std::fill(values.begin(), values.begin() + count, uint16_t(0));
+      for (size_t j = 0; j < k; ++j) {
+        math.mul_add_region(values.data(), columns.data() + j * batch, tables[j], count);
+      }
+      CHECK_EXPECTED(outputs[r].put_array(values.data(), count));
+    }
+  }
+
+  std::vector<const_data_buffer> result;
+  result.reserve(outputs.size());
+  for (auto & s : outputs) {
+    CHECK_EXPECTED(s << safe_cast<uint16_t>(size % stripe_size));//Padding
+    result.push_back(s.move_data());
+  }
+
+  encoded_bytes.add(size * outputs.size());
+  encode_time.record(std::chrono::steady_clock::now() - start_time);
+  return result;
+}
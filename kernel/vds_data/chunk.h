@@ -7,12 +7,16 @@ All rights reserved
 */
 
 #include <assert.h>
+#include <algorithm>
+#include <deque>
 #include <vector>
 
 #include "gf.h"
 #include "binary_serialize.h"
 #include "vds_debug.h"
 #include "stream.h"
+#include "metrics.h"
+#include "erasure_codec.h"
 
 namespace vds {
     template<typename cell_type>
@@ -54,6 +58,8 @@ namespace vds {
 
         friend class chunk_generator<cell_type>; 
         friend class chunk_restore<cell_type>;
+        friend class chunk_replica_generator;
+        friend class chunk_decoder;
     };
 
     template<typename cell_type>
@@ -76,8 +82,8 @@ namespace vds {
           return this->multipliers_;
         }
 
-        expected<void> write(binary_serializer & s, const void * data, size_t size, bool write_padding = true);
-        expected<void> write_padding(binary_serializer & s, uint64_t size);
+        expected<void> write(binary_serializer & s, const void * data, size_t size, bool write_padding = true) const;
+        expected<void> write_padding(binary_serializer & s, uint64_t size) const;
 
     private:        
         cell_type k_;
@@ -113,17 +119,92 @@ namespace vds {
         cell_type * multipliers_;
     };
 
+    //GF(2^16) is encoded and decoded by the region kernels of gf_math<uint16_t>
+    template<>
+    expected<void> chunk_generator<uint16_t>::write(binary_serializer & s, const void * data, size_t size, bool write_padding) const;
+
+    template<>
+    void chunk_restore<uint16_t>::restore(std::vector<uint16_t> & result, const chunk<uint16_t> ** chunks);
+
+    template<>
+    expected<const_data_buffer> chunk_restore<uint16_t>::restore(const std::vector<const_data_buffer> & chunks);
+
+    //Encodes the replicas of the same data in one pass over the input.
+    //The result of every replica is the same as chunk_generator<uint16_t>::write returns.
+    class chunk_replica_generator : public erasure_encoder
+    {
+    public:
+        chunk_replica_generator(uint16_t k, const std::vector<uint16_t> & replicas);
+
+        erasure_codec_id codec() const override {
+          return erasure_codec_id::gf16_vandermonde;
+        }
+
+        uint16_t k() const {
+          return this->k_;
+        }
+
+        const std::vector<uint16_t> & replicas() const {
+          return this->replicas_;
+        }
+
+        //Returns the chunks in the order of replicas()
+        expected<std::vector<const_data_buffer>> write(const void * data, size_t size) const override;
+
+    private:
+        uint16_t k_;
+        std::vector<uint16_t> replicas_;
+
+        //k tables per replica
+        std::vector<gf_math<uint16_t>::region_table> tables_;
+    };
+
+    //The inverted matrix of one replica set with the multiplication tables of every cell.
+    //Immutable after construction, so it can be shared between threads.
+    class chunk_decoder
+    {
+    public:
+        chunk_decoder(uint16_t k, const uint16_t * replicas);
+
+        uint16_t k() const {
+          return this->k_;
+        }
+
+        //The chunks are in the order of the replicas given to the constructor
+        expected<const_data_buffer> restore(const std::vector<const const_data_buffer *> & chunks) const;
+
+        size_t memory_size() const {
+          return this->tables_.size() * sizeof(gf_math<uint16_t>::region_table);
+        }
+
+    private:
+        uint16_t k_;
+        std::vector<gf_math<uint16_t>::region_table> tables_;
+    };
+
+    //Splits the stream into stripes of whole 1024 * k cell blocks and encodes them in parallel on the mt_service threads.
+    //The encoded stripes are written to the target in order, so the output is the same as one generator.write call.
+    //Stripes waiting for the encoder take at most max_in_flight_bytes of input: write_async waits for the oldest one
+    //when the budget is used up. The encoder jobs share the generator, so the stream can be dropped at any time.
     template<typename cell_type>
     class chunk_output_async : public stream_output_async<uint8_t> {
     public:
+    static constexpr size_t default_in_flight_bytes = 8 * 1024 * 1024;
+
     chunk_output_async(
-      chunk_generator<cell_type> & generator,
-      const std::shared_ptr<stream_output_async<uint8_t>> & target)
-    : generator_(generator),
+      const service_provider * sp,
+      const std::shared_ptr<const chunk_generator<cell_type>> & generator,
+      const std::shared_ptr<stream_output_async<uint8_t>> & target,
+      size_t max_in_flight_bytes = default_in_flight_bytes)
+    : sp_(sp),
+      generator_(generator),
       target_(target),
       size_(0),
-      buffer_(new uint8_t[1024 * generator.k() * sizeof(cell_type)]),
+      stripe_size_(stripe_size(generator->k())),
+      max_in_flight_(std::max<size_t>(1, max_in_flight_bytes / stripe_size_)),
+      buffer_(buffer_pool::allocate(stripe_size_)),
       buffer_position_(0) {
+      vds_assert(!!this->generator_);
       vds_assert(!!this->target_);
     }
 
@@ -135,30 +216,33 @@ namespace vds {
         this->size_ += len;
         while (len > 0) {
           auto l = len;
-          if(l > 1024 * this->generator_.k() * sizeof(cell_type) - this->buffer_position_) {
-            l = 1024 * this->generator_.k() * sizeof(cell_type) - this->buffer_position_;
+          if(l > this->stripe_size_ - this->buffer_position_) {
+            l = this->stripe_size_ - this->buffer_position_;
           }
 
-          memcpy(this->buffer_.get() + this->buffer_position_, data, l);
+          memcpy(this->buffer_.data() + this->buffer_position_, data, l);
           data += l;
           len -= l;
           this->buffer_position_ += l;
 
-          if (1024 * this->generator_.k() * sizeof(cell_type) == this->buffer_position_) {
-            binary_serializer s;
-            CHECK_EXPECTED_ASYNC(this->generator_.write(s, this->buffer_.get(), this->buffer_position_, false));
-            CHECK_EXPECTED_ASYNC(co_await this->target_->write_async(s.get_buffer(), s.size()));
+          if (this->stripe_size_ == this->buffer_position_) {
+            //Backpressure: the producer waits until there is room for one more stripe
+            CHECK_EXPECTED_ASYNC(co_await this->flush_async(this->max_in_flight_ - 1));
+            this->pending_.push_back(this->encode_async(std::move(this->buffer_)));
+            this->buffer_ = buffer_pool::allocate(this->stripe_size_);
             this->buffer_position_ = 0;
           }
         }
       }
       else {
+        CHECK_EXPECTED_ASYNC(co_await this->flush_async(0));
+
         binary_serializer s;
         if (0 != this->buffer_position_) {
-          CHECK_EXPECTED_ASYNC(this->generator_.write(s, this->buffer_.get(), this->buffer_position_));
+          CHECK_EXPECTED_ASYNC(this->generator_->write(s, this->buffer_.data(), this->buffer_position_));
         }
         else {
-          CHECK_EXPECTED_ASYNC(this->generator_.write_padding(s, this->size_));
+          CHECK_EXPECTED_ASYNC(this->generator_->write_padding(s, this->size_));
         }
         CHECK_EXPECTED_ASYNC(co_await this->target_->write_async(s.get_buffer(), s.size()));
         CHECK_EXPECTED_ASYNC(co_await this->target_->write_async(nullptr, 0));
@@ -167,12 +251,75 @@ namespace vds {
     }
 
     private:
-    chunk_generator<cell_type> & generator_;
+    const service_provider * sp_;
+    std::shared_ptr<const chunk_generator<cell_type>> generator_;
     std::shared_ptr<stream_output_async<uint8_t>> target_;
     uint64_t size_;
 
-    std::unique_ptr<uint8_t> buffer_;
+    size_t stripe_size_;
+    size_t max_in_flight_;
+    buffer_pool::buffer buffer_;
     size_t buffer_position_;
+
+    //Stripes being encoded, in the stream order
+    std::deque<async_task<expected<const_data_buffer>>> pending_;
+
+    //As many whole blocks as fit into the largest pooled buffer, so a stripe is worth a thread switch
+    static size_t stripe_size(cell_type k) {
+      const size_t block_size = 1024 * k * sizeof(cell_type);
+      return block_size * std::max<size_t>(1, buffer_pool::max_pooled_size / block_size);
+    }
+
+    async_task<expected<const_data_buffer>> encode_async(buffer_pool::buffer && stripe) {
+      async_result<expected<const_data_buffer>> result;
+      auto future = result.get_future();
+
+      imt_service::async(this->sp_, [generator = this->generator_, size = this->stripe_size_, stripe = std::move(stripe), result = std::move(result)]() mutable {
+        binary_serializer s;
+        auto error = generator->write(s, stripe.data(), size, false);
+        if (error.has_error()) {
+          result.set_value(unexpected(std::move(error.error())));
+        }
+        else {
+          result.set_value(s.move_data());
+        }
+      });
+
+      return future;
+    }
+
+    //Writes the encoded stripes that are ready and waits for the oldest ones until no more than max_pending are left
+    async_task<expected<void>> flush_async(size_t max_pending) {
+      while (!this->pending_.empty()
+        && (this->pending_.size() > max_pending || this->pending_.front().await_ready())) {
+        auto task = std::move(this->pending_.front());
+        this->pending_.pop_front();
+
+        auto encoded = co_await std::move(task);
+        if (encoded.has_error()) {
+          (void)co_await this->drain_async();
+          co_return unexpected(std::move(encoded.error()));
+        }
+
+        auto error = co_await this->target_->write_async(encoded.value().data(), encoded.value().size());
+        if (error.has_error()) {
+          (void)co_await this->drain_async();
+          co_return unexpected(std::move(error.error()));
+        }
+      }
+      co_return expected<void>();
+    }
+
+    //After an error the stripes still being encoded are waited for and dropped
+    async_task<expected<void>> drain_async() {
+      while (!this->pending_.empty()) {
+        auto task = std::move(this->pending_.front());
+        this->pending_.pop_front();
+
+        (void)co_await std::move(task);
+      }
+      co_return expected<void>();
+    }
   };
 
 }
@@ -243,11 +390,18 @@ inline vds::chunk_generator<cell_type>::~chunk_generator()
 }
 
 template<typename cell_type>
-inline vds::expected<void> vds::chunk_generator<cell_type>::write(binary_serializer & s, const void * data, size_t size, bool write_padding)
+inline vds::expected<void> vds::chunk_generator<cell_type>::write(binary_serializer & s, const void * data, size_t size, bool write_padding) const
 {
+  static auto & encoded_bytes = metrics::counter("erasure.encode.bytes");
+  static auto & encode_time = metrics::histogram("erasure.encode_us");
+  const auto start_time = std::chrono::steady_clock::now();
+
   const uint64_t expected_size = ((size + sizeof(cell_type) * this->k_ - 1)/ sizeof(cell_type) / this->k_) * sizeof(cell_type);
   const auto start = s.size();
+  CHECK_EXPECTED(s.reserve(start + safe_cast<size_t>(expected_size) + (write_padding ? sizeof(uint16_t) : 0)));
 
+  cell_type values[1024];
+  size_t count = 0;
   for (size_t i = 0; i < size; i += sizeof(cell_type) * this->k_) {
     cell_type value = 0;
     for (cell_type j = 0; j < this->k_; ++j) {
@@ -264,8 +418,13 @@ inline vds::expected<void> vds::chunk_generator<cell_type>::write(binary_seriali
         chunk<cell_type>::math_.mul(this->multipliers_[j], data_item));
     }
 
-    CHECK_EXPECTED(s << value);
+    values[count++] = value;
+    if (sizeof(values) / sizeof(values[0]) == count) {
+      CHECK_EXPECTED(s.put_array(values, count));
+      count = 0;
+    }
   }
+  CHECK_EXPECTED(s.put_array(values, count));
 
   auto final_size = s.size();
   assert(expected_size == final_size - start);
@@ -277,11 +436,13 @@ inline vds::expected<void> vds::chunk_generator<cell_type>::write(binary_seriali
     vds_assert(0 == size % (sizeof(cell_type) * this->k_));
   }
 
+  encoded_bytes.add(size);
+  encode_time.record(std::chrono::steady_clock::now() - start_time);
   return vds::expected<void>();
 }
 
 template<typename cell_type>
-inline vds::expected<void> vds::chunk_generator<cell_type>::write_padding(binary_serializer & s, uint64_t size)
+inline vds::expected<void> vds::chunk_generator<cell_type>::write_padding(binary_serializer & s, uint64_t size) const
 {
   return (s << safe_cast<uint16_t>(size % (sizeof(cell_type) * this->k_)));//Padding
 }
@@ -403,6 +564,10 @@ template<typename cell_type>
 inline vds::expected<vds::const_data_buffer> vds::chunk_restore<cell_type>::restore(
   const std::vector<const_data_buffer> & chunks)
 {
+  static auto & decoded_bytes = metrics::counter("erasure.decode.bytes");
+  static auto & decode_time = metrics::histogram("erasure.decode_us");
+  const auto start_time = std::chrono::steady_clock::now();
+
   binary_serializer s;
   auto size = chunks.begin()->size();
   auto padding = uint16_t(chunks.begin()->data()[size - 2] << 8) | chunks.begin()->data()[size - 1];
@@ -435,6 +600,8 @@ inline vds::expected<vds::const_data_buffer> vds::chunk_restore<cell_type>::rest
       }
       CHECK_EXPECTED(s << value);
       if(s.size() >= expected_size) {
+        decoded_bytes.add(expected_size);
+        decode_time.record(std::chrono::steady_clock::now() - start_time);
         return const_data_buffer(s.get_buffer(), expected_size);
       }
     }
@@ -0,0 +1,61 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include <algorithm>
+#include "chunk_decoder_cache.h"
+
+//A decoder of k = 32 takes about 130 KiB, so few shards keep the budget usable
+vds::chunk_decoder_cache::chunk_decoder_cache(
+  uint16_t k,
+  size_t max_bytes)
+: k_(k), decoders_(max_bytes, 4)
+{
+}
+
+vds::expected<vds::const_data_buffer> vds::chunk_decoder_cache::restore(
+  const std::vector<uint16_t> & replicas,
+  const std::vector<const_data_buffer> & chunks)
+{
+  if (replicas.size() < this->k_ || chunks.size() < this->k_) {
+    return vds::make_unexpected<std::runtime_error>("Not enough replicas to restore data");
+  }
+
+  //The decoder is built for the sorted set, so the chunks are reordered the same way
+  std::vector<size_t> order(this->k_);
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&replicas](size_t left, size_t right) {
+    return replicas[left] < replicas[right];
+  });
+
+  std::vector<uint16_t> key(this->k_);
+  std::vector<const const_data_buffer *> sources(this->k_);
+  for (size_t i = 0; i < order.size(); ++i) {
+    key[i] = replicas[order[i]];
+    sources[i] = &chunks[order[i]];
+  }
+
+  return this->get(key)->restore(sources);
+}
+
+std::shared_ptr<const vds::chunk_decoder> vds::chunk_decoder_cache::get(const std::vector<uint16_t> & replicas)
+{
+  static auto & hits = metrics::counter("erasure.decoder_cache.hits");
+  static auto & misses = metrics::counter("erasure.decoder_cache.misses");
+
+  std::shared_ptr<const chunk_decoder> result;
+  if (this->decoders_.find(replicas, result)) {
+    hits.add();
+    return result;
+  }
+
+  //Two threads may build the same decoder at once; the last one stays in the cache
+  misses.add();
+  result = std::make_shared<chunk_decoder>(this->k_, replicas.data());
+  this->decoders_.set(replicas, result);
+  return result;
+}
@@ -0,0 +1,55 @@
+#ifndef __VDS_DATA_CHUNK_DECODER_CACHE_H_
+#define __VDS_DATA_CHUNK_DECODER_CACHE_H_
+
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include <memory>
+#include <vector>
+
+#include "chunk.h"
+#include "erasure_codec.h"
+#include "lru_cache.h"
+
+namespace vds {
+
+  //Keeps the inverted matrices of recently used replica sets.
+  //Blocks are usually restored from the same replicas, so the O(k^3) inversion
+  //and the table setup are done once per set instead of once per block.
+  class chunk_decoder_cache : public erasure_decoder
+  {
+  public:
+    chunk_decoder_cache(
+      uint16_t k,
+      size_t max_bytes = 16 * 1024 * 1024);
+
+    uint16_t k() const {
+      return this->k_;
+    }
+
+    erasure_codec_id codec() const override {
+      return erasure_codec_id::gf16_vandermonde;
+    }
+
+    expected<const_data_buffer> restore(
+      const std::vector<uint16_t> & replicas,
+      const std::vector<const_data_buffer> & chunks) override;
+
+    //replicas must be sorted
+    std::shared_ptr<const chunk_decoder> get(const std::vector<uint16_t> & replicas);
+
+  private:
+    struct decoder_size {
+      size_t operator()(const std::vector<uint16_t> & key, const std::shared_ptr<const chunk_decoder> & value) const {
+        return key.size() * sizeof(uint16_t) + value->memory_size();
+      }
+    };
+
+    uint16_t k_;
+    lru_cache<std::vector<uint16_t>, std::shared_ptr<const chunk_decoder>, replica_set_hash, decoder_size> decoders_;
+  };
+}
+
+#endif//__VDS_DATA_CHUNK_DECODER_CACHE_H_
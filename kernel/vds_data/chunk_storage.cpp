@@ -34,7 +34,8 @@ vds::expected<vds::const_data_buffer> vds::chunk_storage::restore_data(
 /////////////////////////////////////////////////////////////////////////////////////
 vds::_chunk_storage::_chunk_storage(
   uint16_t min_horcrux)
-: min_horcrux_(min_horcrux)
+: min_horcrux_(min_horcrux),
+  decoders_(min_horcrux)
 {
 }
 
@@ -80,8 +81,6 @@ vds::expected<vds::const_data_buffer> vds::_chunk_storage::restore_data(
     datas.push_back(p.second);
   }
   
-  chunk_restore<uint16_t> restore(this->min_horcrux_, replicas.data());
-  
-  return restore.restore(datas);
+  return this->decoders_.restore(replicas, datas);
 }
 
@@ -0,0 +1,48 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include "erasure_codec.h"
+#include "chunk.h"
+#include "chunk_decoder_cache.h"
+#include "cauchy_codec.h"
+
+vds::expected<std::unique_ptr<vds::erasure_encoder>> vds::erasure_codec::create_encoder(
+  erasure_codec_id codec,
+  uint16_t k,
+  const std::vector<uint16_t> & replicas)
+{
+  switch (codec) {
+  case erasure_codec_id::gf16_vandermonde:
+    return std::unique_ptr<erasure_encoder>(new chunk_replica_generator(k, replicas));
+
+  case erasure_codec_id::gf8_cauchy:
+    for (auto replica : replicas) {
+      if (replica >= 0x100) {
+        return vds::make_unexpected<std::runtime_error>("GF(2^8) codec supports up to 256 replicas");
+      }
+    }
+    return std::unique_ptr<erasure_encoder>(new cauchy_encoder(k, replicas));
+
+  default:
+    return vds::make_unexpected<std::runtime_error>("Unknown erasure codec " + std::to_string(static_cast<int>(codec)));
+  }
+}
+
+vds::expected<std::unique_ptr<vds::erasure_decoder>> vds::erasure_codec::create_decoder(
+  erasure_codec_id codec,
+  uint16_t k)
+{
+  switch (codec) {
+  case erasure_codec_id::gf16_vandermonde:
+    return std::unique_ptr<erasure_decoder>(new chunk_decoder_cache(k));
+
+  case erasure_codec_id::gf8_cauchy:
+    return std::unique_ptr<erasure_decoder>(new cauchy_decoder(k));
+
+  default:
+    return vds::make_unexpected<std::runtime_error>("Unknown erasure codec " + std::to_string(static_cast<int>(codec)));
+  }
+}
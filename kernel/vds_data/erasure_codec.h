@@ -0,0 +1,75 @@
+#ifndef __VDS_DATA_ERASURE_CODEC_H_
+#define __VDS_DATA_ERASURE_CODEC_H_
+
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include <memory>
+#include <vector>
+
+#include "const_data_buffer.h"
+#include "expected.h"
+
+namespace vds {
+
+  //Stored with every block, so replicas of both formats can coexist
+  enum class erasure_codec_id : uint8_t {
+    //chunk_generator<uint16_t>: 16-bit cells, every replica is a linear combination
+    gf16_vandermonde = 0,
+
+    //cauchy_encoder: bytes, replicas 0..k-1 are the data itself
+    gf8_cauchy = 1
+  };
+
+  class erasure_encoder {
+  public:
+    virtual ~erasure_encoder() {}
+
+    virtual erasure_codec_id codec() const = 0;
+
+    //Returns the chunks in the order of the replicas given at creation
+    virtual expected<std::vector<const_data_buffer>> write(const void * data, size_t size) const = 0;
+  };
+
+  class erasure_decoder {
+  public:
+    virtual ~erasure_decoder() {}
+
+    virtual erasure_codec_id codec() const = 0;
+
+    //The first k replicas and their chunks are used, in any order
+    virtual expected<const_data_buffer> restore(
+      const std::vector<uint16_t> & replicas,
+      const std::vector<const_data_buffer> & chunks) = 0;
+  };
+
+  class erasure_codec {
+  public:
+    static expected<std::unique_ptr<erasure_encoder>> create_encoder(
+      erasure_codec_id codec,
+      uint16_t k,
+      const std::vector<uint16_t> & replicas);
+
+    //Decoders keep the inverted matrices of recently used replica sets
+    static expected<std::unique_ptr<erasure_decoder>> create_decoder(
+      erasure_codec_id codec,
+      uint16_t k);
+  };
+
+  //Hash of a sorted replica set for the decoder caches
+  struct replica_set_hash {
+    size_t operator()(const std::vector<uint16_t> & key) const {
+      //FNV-1a
+      uint64_t result = 14695981039346656037ULL;
+      for (auto value : key) {
+        result ^= value;
+        result *= 1099511628211ULL;
+      }
+      return static_cast<size_t>(result);
+    }
+  };
+}
+
+#endif//__VDS_DATA_ERASURE_CODEC_H_
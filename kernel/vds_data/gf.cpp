@@ -5,4 +5,245 @@ All rights reserved
 
 #include "stdafx.h"
 #include "gf.h"
+#include "cpu_features.h"
 
+#ifdef VDS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace {
+  typedef vds::gf_math<uint16_t>::region_table region_table;
+
+  static void mul_add_region_scalar(uint16_t * dst, const uint16_t * src, const region_table & table, size_t count) {
+    uint16_t t[4][16];
+    for (int i = 0; i < 4; ++i) {
+      for (int n = 0; n < 16; ++n) {
+        t[i][n] = static_cast<uint16_t>(table.lo[i][n] | (table.hi[i][n] << 8));
+      }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+      const auto x = src[i];
+      dst[i] ^= t[0][x & 0xF] ^ t[1][(x >> 4) & 0xF] ^ t[2][(x >> 8) & 0xF] ^ t[3][x >> 12];
+    }
+  }
+
+  typedef vds::gf_math<uint8_t>::region_table byte_region_table;
+
+  static void mul_add_region_scalar(uint8_t * dst, const uint8_t * src, const byte_region_table & table, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      const auto x = src[i];
+      dst[i] ^= table.lo[x & 0xF] ^ table.hi[x >> 4];
+    }
+  }
+
+#ifdef VDS_X86_SIMD
+  //16 cells per step: the low and high bytes are split into two vectors,
+  //every nibble selects its partial products with pshufb
+  VDS_TARGET("ssse3")
+  static size_t mul_add_region_ssse3(uint16_t * dst, const uint16_t * src, const region_table & table, size_t count) {
+    __m128i lo[4];
+    __m128i hi[4];
+    for (int i = 0; i < 4; ++i) {
+      lo[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(table.lo[i]));
+      hi[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(table.hi[i]));
+    }
+
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    const __m128i byte_mask = _mm_set1_epi16(0x00FF);
+
+    size_t processed = 0;
+    for (; processed + 16 <= count; processed += 16) {
+      const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + processed));
+      const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + processed + 8));
+
+      const __m128i low_bytes = _mm_packus_epi16(_mm_and_si128(a, byte_mask), _mm_and_si128(b, byte_mask));
+      const __m128i high_bytes = _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));
+
+      const __m128i n0 = _mm_and_si128(low_bytes, mask);
+      const __m128i n1 = _mm_and_si128(_mm_srli_epi16(low_bytes, 4), mask);
+      const __m128i n2 = _mm_and_si128(high_bytes, mask);
+      const __m128i n3 = _mm_and_si128(_mm_srli_epi16(high_bytes, 4), mask);
+
+      const __m128i result_lo = _mm_xor_si128(
+        _mm_xor_si128(_mm_shuffle_epi8(lo[0], n0), _mm_shuffle_epi8(lo[1], n1)),
+        _mm_xor_si128(_mm_shuffle_epi8(lo[2], n2), _mm_shuffle_epi8(lo[3], n3)));
+      const __m128i result_hi = _mm_xor_si128(
+        _mm_xor_si128(_mm_shuffle_epi8(hi[0], n0), _mm_shuffle_epi8(hi[1], n1)),
+        _mm_xor_si128(_mm_shuffle_epi8(hi[2], n2), _mm_shuffle_epi8(hi[3], n3)));
+
+      __m128i * out = reinterpret_cast<__m128i *>(dst + processed);
+      _mm_storeu_si128(out, _mm_xor_si128(_mm_loadu_si128(out), _mm_unpacklo_epi8(result_lo, result_hi)));
+      _mm_storeu_si128(out + 1, _mm_xor_si128(_mm_loadu_si128(out + 1), _mm_unpackhi_epi8(result_lo, result_hi)));
+    }
+    return processed;
+  }
+
+  //Same as the SSSE3 kernel with 32 cells per step. Pack and unpack work inside
+  //128-bit lanes, so the cells come back in their original order.
+  VDS_TARGET("avx2")
+  static size_t mul_add_region_avx2(uint16_t * dst, const uint16_t * src, const region_table & table, size_t count) {
+    __m256i lo[4];
+    __m256i hi[4];
+    for (int i = 0; i < 4; ++i) {
+      lo[i] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(table.lo[i])));
+      hi[i] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(table.hi[i])));
+    }
+
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+    const __m256i byte_mask = _mm256_set1_epi16(0x00FF);
+
+    size_t processed = 0;
+    for (; processed + 32 <= count; processed += 32) {
+      const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + processed));
+      const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + processed + 16));
+
+      const __m256i low_bytes = _mm256_packus_epi16(_mm256_and_si256(a, byte_mask), _mm256_and_si256(b, byte_mask));
+      const __m256i high_bytes = _mm256_packus_epi16(_mm256_srli_epi16(a, 8), _mm256_srli_epi16(b, 8));
+
+      const __m256i n0 = _mm256_and_si256(low_bytes, mask);
+      const __m256i n1 = _mm256_and_si256(_mm256_srli_epi16(low_bytes, 4), mask);
+      const __m256i n2 = _mm256_and_si256(high_bytes, mask);
+      const __m256i n3 = _mm256_and_si256(_mm256_srli_epi16(high_bytes, 4), mask);
+
+      const __m256i result_lo = _mm256_xor_si256(
+        _mm256_xor_si256(_mm256_shuffle_epi8(lo[0], n0), _mm256_shuffle_epi8(lo[1], n1)),
+        _mm256_xor_si256(_mm256_shuffle_epi8(lo[2], n2), _mm256_shuffle_epi8(lo[3], n3)));
+      const __m256i result_hi = _mm256_xor_si256(
+        _mm256_xor_si256(_mm256_shuffle_epi8(hi[0], n0), _mm256_shuffle_epi8(hi[1], n1)),
+        _mm256_xor_si256(_mm256_shuffle_epi8(hi[2], n2), _mm256_shuffle_epi8(hi[3], n3)));
+
+      __m256i * out = reinterpret_cast<__m256i *>(dst + processed);
+      _mm256_storeu_si256(out, _mm256_xor_si256(_mm256_loadu_si256(out), _mm256_unpacklo_epi8(result_lo, result_hi)));
+      _mm256_storeu_si256(out + 1, _mm256_xor_si256(_mm256_loadu_si256(out + 1), _mm256_unpackhi_epi8(result_lo, result_hi)));
+    }
+    return processed;
+  }
+
+  //Bytes need no splitting: one pshufb per nibble
+  VDS_TARGET("ssse3")
+  static size_t mul_add_region_ssse3(uint8_t * dst, const uint8_t * src, const byte_region_table & table, size_t count) {
+    const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(table.lo));
+    const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(table.hi));
+    const __m128i mask = _mm_set1_epi8(0x0F);
+
+    size_t processed = 0;
+    for (; processed + 16 <= count; processed += 16) {
+      const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + processed));
+      const __m128i product = _mm_xor_si128(
+        _mm_shuffle_epi8(lo, _mm_and_si128(x, mask)),
+        _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi16(x, 4), mask)));
+
+      __m128i * out = reinterpret_cast<__m128i *>(dst + processed);
+      _mm_storeu_si128(out, _mm_xor_si128(_mm_loadu_si128(out), product));
+    }
+    return processed;
+  }
+
+  VDS_TARGET("avx2")
+  static size_t mul_add_region_avx2(uint8_t * dst, const uint8_t * src, const byte_region_table & table, size_t count) {
+    const __m256i lo = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(table.lo)));
+    const __m256i hi = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(table.hi)));
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+
+    size_t processed = 0;
+    for (; processed + 32 <= count; processed += 32) {
+      const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + processed));
+      const __m256i product = _mm256_xor_si256(
+        _mm256_shuffle_epi8(lo, _mm256_and_si256(x, mask)),
+        _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi16(x, 4), mask)));
+
+      __m256i * out = reinterpret_cast<__m256i *>(dst + processed);
+      _mm256_storeu_si256(out, _mm256_xor_si256(_mm256_loadu_si256(out), product));
+    }
+    return processed;
+  }
+#endif//VDS_X86_SIMD
+}
+
+void vds::gf_math<uint8_t>::prepare_region_table(uint8_t coeff, region_table & table) const {
+  table.coeff = coeff;
+  for (int n = 0; n < 16; ++n) {
+    table.lo[n] = this->mul(coeff, static_cast<uint8_t>(n));
+    table.hi[n] = this->mul(coeff, static_cast<uint8_t>(n << 4));
+  }
+}
+
+void vds::gf_math<uint8_t>::mul_add_region(uint8_t * dst, const uint8_t * src, const region_table & table, size_t count) const {
+  if (0 == table.coeff) {
+    return;
+  }
+
+  if (1 == table.coeff) {
+    for (size_t i = 0; i < count; ++i) {
+      dst[i] ^= src[i];
+    }
+    return;
+  }
+
+#ifdef VDS_X86_SIMD
+  size_t processed = 0;
+  if (cpu_features::has_avx2()) {
+    processed = mul_add_region_avx2(dst, src, table, count);
+  }
+  else if (cpu_features::has_ssse3()) {
+    processed = mul_add_region_ssse3(dst, src, table, count);
+  }
+  dst += processed;
+  src += processed;
+  count -= processed;
+#endif
+
+  mul_add_region_scalar(dst, src, table, count);
+}
+
+void vds::gf_math<uint16_t>::prepare_region_table(uint16_t coeff, region_table & table) const {
+  table.coeff = coeff;
+
+  //Multiplication is linear over XOR, so every entry is a sum of coeff * (1 << bit)
+  uint16_t bit_products[16];
+  for (int bit = 0; bit < 16; ++bit) {
+    bit_products[bit] = this->mul(coeff, static_cast<uint16_t>(1 << bit));
+  }
+
+  for (int i = 0; i < 4; ++i) {
+    for (int n = 0; n < 16; ++n) {
+      uint16_t value = 0;
+      for (int bit = 0; bit < 4; ++bit) {
+        if (0 != (n & (1 << bit))) {
+          value ^= bit_products[4 * i + bit];
+        }
+      }
+      table.lo[i][n] = static_cast<uint8_t>(value);
+      table.hi[i][n] = static_cast<uint8_t>(value >> 8);
+    }
+  }
+}
+
+void vds::gf_math<uint16_t>::mul_add_region(uint16_t * dst, const uint16_t * src, const region_table & table, size_t count) const {
+  if (0 == table.coeff) {
+    return;
+  }
+
+  if (1 == table.coeff) {
+    for (size_t i = 0; i < count; ++i) {
+      dst[i] ^= src[i];
+    }
+    return;
+  }
+
+#ifdef VDS_X86_SIMD
+  size_t processed = 0;
+  if (cpu_features::has_avx2()) {
+    processed = mul_add_region_avx2(dst, src, table, count);
+  }
+  else if (cpu_features::has_ssse3()) {
+    processed = mul_add_region_ssse3(dst, src, table, count);
+  }
+  dst += processed;
+  src += processed;
+  count -= processed;
+#endif
+
+  mul_add_region_scalar(dst, src, table, count);
+}
@@ -185,6 +185,20 @@ namespace vds {
     uint8_t sub(uint8_t left, uint8_t right) const {
       return left ^ right;
     }
+
+    //Products of one coefficient with both 4-bit nibbles of a byte:
+    //coeff * x == lo[x & 0xF] ^ hi[x >> 4]
+    struct region_table {
+      uint8_t coeff;
+      uint8_t lo[16];
+      uint8_t hi[16];
+    };
+
+    void prepare_region_table(uint8_t coeff, region_table & table) const;
+
+    //dst[i] ^= coeff * src[i]
+    void mul_add_region(uint8_t * dst, const uint8_t * src, const region_table & table, size_t count) const;
+
   private:
     uint8_t value2log_[0x100];
     uint8_t log2value_[0x100];
@@ -247,6 +261,27 @@ namespace vds {
     uint16_t sub(uint16_t left, uint16_t right) const {
       return left ^ right;
     }
+
+    //Products of one coefficient with every 4-bit nibble of a cell.
+    //coeff * x == nibble(0, x & 0xF) ^ nibble(1, (x >> 4) & 0xF) ^ ...,
+    //the low and high bytes are kept apart for the pshufb kernels.
+    struct region_table {
+      uint16_t coeff;
+      uint8_t lo[4][16];
+      uint8_t hi[4][16];
+    };
+
+    void prepare_region_table(uint16_t coeff, region_table & table) const;
+
+    //dst[i] ^= coeff * src[i] for count cells in the host byte order
+    void mul_add_region(uint16_t * dst, const uint16_t * src, const region_table & table, size_t count) const;
+
+    void mul_add_region(uint16_t * dst, const uint16_t * src, uint16_t coeff, size_t count) const {
+      region_table table;
+      this->prepare_region_table(coeff, table);
+      this->mul_add_region(dst, src, table, count);
+    }
+
   private:
     uint16_t value2log_[0x10000];
     uint16_t log2value_[0x10000];
@@ -8,6 +8,7 @@ All rights reserved
 
 #include "chunk.h"
 #include "chunk_storage.h"
+#include "chunk_decoder_cache.h"
 
 namespace vds {
   class _chunk_storage
@@ -28,6 +29,7 @@ namespace vds {
     uint16_t min_horcrux_;
 
     std::unordered_map<uint16_t, std::unique_ptr<chunk_generator<uint16_t>>> generators_;
+    chunk_decoder_cache decoders_;
   };
 
 }
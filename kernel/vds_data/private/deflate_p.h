@@ -22,6 +22,7 @@ namespace vds {
       int compression_level) {
 
       this->target_ = target;
+      this->buffer_ = buffer_pool::allocate(buffer_pool::default_size);
       memset(&this->strm_, 0, sizeof(z_stream));
       if (Z_OK != deflateInit(&this->strm_, compression_level)) {
         return make_unexpected<std::runtime_error>("deflateInit failed");
@@ -39,18 +40,17 @@ namespace vds {
         this->strm_.next_in = (Bytef *)input_data;
         this->strm_.avail_in = (uInt)input_size;
 
-        uint8_t buffer[1024];
         do {
-          this->strm_.next_out = (Bytef *)buffer;
-          this->strm_.avail_out = sizeof(buffer);
+          this->strm_.next_out = (Bytef *)this->buffer_.data();
+          this->strm_.avail_out = (uInt)this->buffer_.size();
           auto error = ::deflate(&this->strm_, Z_FINISH);
 
           if (Z_STREAM_ERROR == error) {
             co_return make_unexpected<std::runtime_error>("deflate failed");
           }
 
-          auto written = sizeof(buffer) - this->strm_.avail_out;
-          CHECK_EXPECTED_ASYNC(co_await this->target_->write_async(buffer, written));
+          auto written = this->buffer_.size() - this->strm_.avail_out;
+          CHECK_EXPECTED_ASYNC(co_await this->target_->write_async(this->buffer_.data(), written));
         } while (0 == this->strm_.avail_out);
 
 				deflateEnd(&this->strm_);
@@ -61,19 +61,18 @@ namespace vds {
 			this->strm_.next_in = (Bytef *)input_data;
 			this->strm_.avail_in = (uInt)input_size;
 
-			uint8_t buffer[1024];
 			do {
-				this->strm_.next_out = (Bytef *)buffer;
-				this->strm_.avail_out = sizeof(buffer);
+				this->strm_.next_out = (Bytef *)this->buffer_.data();
+				this->strm_.avail_out = (uInt)this->buffer_.size();
 				auto error = ::deflate(&this->strm_, Z_NO_FLUSH);
 
 				if (Z_STREAM_ERROR == error) {
           co_return make_unexpected<std::runtime_error>("deflate failed");
 				}
 
-				auto written = sizeof(buffer) - this->strm_.avail_out;
+				auto written = this->buffer_.size() - this->strm_.avail_out;
         if (0 != written) {
-          CHECK_EXPECTED_ASYNC(co_await this->target_->write_async(buffer, written));
+          CHECK_EXPECTED_ASYNC(co_await this->target_->write_async(this->buffer_.data(), written));
         }
 			} while (0 == this->strm_.avail_out);
 
@@ -82,6 +81,7 @@ namespace vds {
 
 	private:
     std::shared_ptr<stream_output_async<uint8_t>> target_;
+    buffer_pool::buffer buffer_;
 		z_stream strm_;
 	};
 }
@@ -19,6 +19,7 @@ namespace vds {
       const std::shared_ptr<stream_output_async<uint8_t>> & target)
     {
       this->target_ = target;
+      this->buffer_ = buffer_pool::allocate(buffer_pool::default_size);
 
       memset(&this->strm_, 0, sizeof(z_stream));
       if (Z_OK != inflateInit(&this->strm_)) {
@@ -39,19 +40,18 @@ namespace vds {
       this->strm_.next_in = (Bytef *)input_data;
       this->strm_.avail_in = (uInt)input_size;
 
-      uint8_t buffer[1024];
       do{
-        this->strm_.next_out = (Bytef *)buffer;
-        this->strm_.avail_out = sizeof(buffer);
+        this->strm_.next_out = (Bytef *)this->buffer_.data();
+        this->strm_.avail_out = (uInt)this->buffer_.size();
         auto error = ::inflate(&this->strm_, Z_NO_FLUSH);
 
         if (Z_STREAM_ERROR == error || Z_NEED_DICT == error || Z_DATA_ERROR == error || Z_MEM_ERROR == error) {
           co_return make_unexpected<std::runtime_error>("inflate failed");
         }
 
-        auto written = sizeof(buffer) - this->strm_.avail_out;
+        auto written = this->buffer_.size() - this->strm_.avail_out;
         if (0 != written) {
-          CHECK_EXPECTED_ASYNC(co_await this->target_->write_async(buffer, written));
+          CHECK_EXPECTED_ASYNC(co_await this->target_->write_async(this->buffer_.data(), written));
         }
       } while(0 == this->strm_.avail_out);
 
@@ -60,6 +60,7 @@ namespace vds {
 
   private:
     std::shared_ptr<stream_output_async<uint8_t>> target_;
+    buffer_pool::buffer buffer_;
     z_stream strm_;
   };
 }
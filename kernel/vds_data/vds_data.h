@@ -10,6 +10,9 @@ All rights reserved
 
 #include "gf.h"
 #include "chunk.h"
+#include "chunk_decoder_cache.h"
+#include "erasure_codec.h"
+#include "cauchy_codec.h"
 #include "chunk_storage.h"
 #include "inflate.h"
 #include "deflate.h"
@@ -203,7 +203,7 @@ namespace vds {
     _database(const service_provider * sp)
     : sp_(sp),
       db_(nullptr),
-      execute_queue_(std::make_shared<thread_apartment>(sp))
+      execute_queue_(std::make_shared<thread_apartment>(sp, "db"))
     {
     }
 
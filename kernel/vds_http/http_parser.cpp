@@ -22,7 +22,7 @@ vds::async_task<vds::expected<void>> vds::http_parser::write_async(
 
   vds_assert(!this->eof_);
   if (0 == len) {
-    this->sp_->get<logger>()->trace("HTTPParser", "HTTP %p end", this);
+    VDS_LOG_TRACE(this->sp_, "HTTPParser", "HTTP %p end", this);
     this->eof_ = true;
 
     switch(this->state_){
@@ -41,7 +41,8 @@ vds::async_task<vds::expected<void>> vds::http_parser::write_async(
 
     co_return co_await this->before_close();
   }
-  this->sp_->get<logger>()->trace(
+  VDS_LOG_TRACE(
+    this->sp_,
     "HTTPParser",
     "HTTP %p[%s],state=%d,content_length:%d,type:%s",
     this,
@@ -18,7 +18,7 @@ vds::http_async_serializer::start_message(std::list<std::string> headers) {
 
   auto data = stream.str();
 
-  this->sp_->get<logger>()->trace("TCPout", "HTTP[%s]", data.c_str());
+  VDS_LOG_TRACE(this->sp_, "TCPout", "HTTP[%s]", data.c_str());
 
   CHECK_EXPECTED_ASYNC(co_await this->target_->write_async(reinterpret_cast<const uint8_t *>(data.c_str()), data.length()));
 
@@ -35,11 +35,11 @@ vds::async_task<vds::expected<void>> vds::http_async_serializer::out_stream::wri
   const uint8_t* data, size_t len) {
 
   if (0 != len) {
-    this->target_->sp_->get<logger>()->trace("TCPout", "HTTP[%s]", std::string((const char *)data, len).c_str());
+    VDS_LOG_TRACE(this->target_->sp_, "TCPout", "HTTP[%s]", std::string((const char *)data, len).c_str());
     CHECK_EXPECTED_ASYNC(co_await this->target_->target_->write_async(data, len));
   }
   else {
-    this->target_->sp_->get<logger>()->trace("TCPout", "HTTP end");
+    VDS_LOG_TRACE(this->target_->sp_, "TCPout", "HTTP end");
     this->target_->write_body_ = false;
   }
 
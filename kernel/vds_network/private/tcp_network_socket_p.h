@@ -481,7 +481,8 @@ namespace vds {
         std::shared_ptr<stream_output_async<uint8_t>> target)
         : sp_(sp),
           owner_(owner),
-          target_(target) {
+          target_(target),
+          buffer_(buffer_pool::allocate(buffer_pool::default_size)) {
     }
 
     ~_read_socket_task() {
@@ -498,8 +499,8 @@ namespace vds {
 
       auto len = read(
           handle,
-          this->buffer_,
-          sizeof(this->buffer_) / sizeof(this->buffer_[0]));
+          this->buffer_.data(),
+          this->buffer_.size());
 
       if (len < 0) {
         int error = errno;
@@ -517,7 +518,7 @@ namespace vds {
       }
       else {
         CHECK_EXPECTED((*this->owner())->change_mask(this->owner_, 0, EPOLLIN));
-        this->target_->write_async(this->buffer_, len).then(
+        this->target_->write_async(this->buffer_.data(), len).then(
           [len, pthis = this->shared_from_this()](expected<void> result){
           if(0 < len && !result.has_error()) {
               (void)static_cast<_read_socket_task *>(pthis.get())->process();
@@ -540,7 +541,7 @@ namespace vds {
     std::shared_ptr<socket_base> owner_;
     std::shared_ptr<stream_output_async<uint8_t>> target_;
 
-    uint8_t buffer_[1024];
+    buffer_pool::buffer buffer_;
 
     tcp_network_socket * owner() const {
       return static_cast<tcp_network_socket *>(this->owner_.get());
@@ -41,6 +41,14 @@ namespace vds {
     {
     }
 
+    _udp_datagram(
+      const network_address & address,
+      const_data_buffer && data)
+      : address_(address),
+      data_(std::move(data))
+    {
+    }
+
     const network_address & address() const { return this->address_; }
 
     const uint8_t * data() const { return this->data_.data(); }
@@ -186,7 +194,7 @@ namespace vds {
       auto r = std::make_shared<vds::async_result<vds::expected<udp_datagram>>>();
       this->result_ = r;
 
-      this->sp_->get<logger>()->trace("UDP", "WSARecvFrom %d", (*this->s_)->handle());
+      VDS_LOG_TRACE(this->sp_, "UDP", "WSARecvFrom %d", (*this->s_)->handle());
 
       DWORD flags = 0;
       DWORD numberOfBytesRecvd;
@@ -210,12 +218,12 @@ namespace vds {
                 "WSARecvFrom failed"));
         }
         else {
-          this->sp_->get<logger>()->trace("UDP", "Read scheduled");
+          VDS_LOG_TRACE(this->sp_, "UDP", "Read scheduled");
         }
       }
       else {
         auto errorCode = WSAGetLastError();
-        this->sp_->get<logger>()->trace("UDP", "Direct readed %d, code %d", numberOfBytesRecvd, errorCode);
+        VDS_LOG_TRACE(this->sp_, "UDP", "Direct readed %d, code %d", numberOfBytesRecvd, errorCode);
         //this_->process(numberOfBytesRecvd);
       }
 
@@ -236,7 +244,7 @@ namespace vds {
 
     void process(DWORD dwBytesTransfered) override
     {
-      this->sp_->get<logger>()->trace("UDP", "Got %d bytes UDP package from %s", dwBytesTransfered, this->addr_.to_string().c_str());
+      VDS_LOG_TRACE(this->sp_, "UDP", "Got %d bytes UDP package from %s", dwBytesTransfered, this->addr_.to_string().c_str());
 
       vds_assert(this->result_);
       auto pthis = this->shared_from_this();
@@ -246,7 +254,7 @@ namespace vds {
 
     void error(DWORD error_code) override
     {
-      this->sp_->get<logger>()->trace("UDP", "Error %d at get recive UDP package", error_code);
+      VDS_LOG_TRACE(this->sp_, "UDP", "Error %d at get recive UDP package", error_code);
 
       auto r = std::move(this->result_);
       r->set_value(make_unexpected<std::system_error>(error_code, std::system_category(), "WSARecvFrom failed"));
@@ -269,7 +277,8 @@ namespace vds {
       this->buffer_ = data;
       this->wsa_buf_.len = this->buffer_.data_size();
       this->wsa_buf_.buf = (CHAR *)this->buffer_.data();
-      this->sp_->get<logger>()->trace(
+      VDS_LOG_TRACE(
+        this->sp_,
         "UDP",
         "write_async %s %d bytes",
         this->buffer_->address().to_string().c_str(),
@@ -279,7 +288,8 @@ namespace vds {
       this->result_ = r;
 
 
-      this->sp_->get<logger>()->trace(
+      VDS_LOG_TRACE(
+        this->sp_,
         "UDP",
         "WSASendTo %s %d bytes (%s)",
         this->buffer_->address().to_string().c_str(),
@@ -298,7 +308,8 @@ namespace vds {
         NULL)) {
         auto errorCode = WSAGetLastError();
         if (WSA_IO_PENDING != errorCode) {
-          this->sp_->get<logger>()->trace(
+          VDS_LOG_TRACE(
+            this->sp_,
             "UDP",
             "Error %d at schedule sending UDP to %s",
             errorCode,
@@ -326,7 +337,8 @@ namespace vds {
 
     void process(DWORD dwBytesTransfered) override
     {
-      this->sp_->get<logger>()->trace(
+      VDS_LOG_TRACE(
+        this->sp_,
         "UDP",
         "Sent %d bytes UDP package to %s",
         dwBytesTransfered,
@@ -345,7 +357,8 @@ namespace vds {
 
     void error(DWORD error_code) override
     {
-      this->sp_->get<logger>()->trace(
+      VDS_LOG_TRACE(
+        this->sp_,
         "UDP",
         "Error %d at sending UDP to %s",
         error_code,
@@ -392,12 +405,12 @@ namespace vds {
           CHECK_EXPECTED((*this->owner())->change_mask(this->owner_, EPOLLIN));
         }
         else {
-          this->sp_->get<logger>()->trace("UDP", "Error %d at get recive UDP package", error);
+          VDS_LOG_TRACE(this->sp_, "UDP", "Error %d at get recive UDP package", error);
           r->set_value(make_unexpected<std::system_error>(error, std::system_category(), "recvfrom"));
         }
       }
       else {
-        this->sp_->get<logger>()->trace("UDP", "Got %d bytes UDP package from %s", len, this->addr_.to_string().c_str());
+        VDS_LOG_TRACE(this->sp_, "UDP", "Got %d bytes UDP package from %s", len, this->addr_.to_string().c_str());
         r->set_value(_udp_datagram::create(this->addr_, this->read_buffer_, len));
       }
 
@@ -422,12 +435,13 @@ namespace vds {
         }
 
         CHECK_EXPECTED((*this->owner())->change_mask(this->owner_, 0, EPOLLIN));
-        this->sp_->get<logger>()->trace("UDP", "Error %d at get recive UDP package", error);
+        VDS_LOG_TRACE(this->sp_, "UDP", "Error %d at get recive UDP package", error);
         r->set_value(
           make_unexpected<std::system_error>(error, std::system_category(), "recvfrom"));
       }
       else {
-        this->sp_->get<logger>()->trace(
+        VDS_LOG_TRACE(
+            this->sp_,
             "UDP",
             "Got %d bytes UDP package from %s",
             len,
@@ -484,7 +498,8 @@ namespace vds {
         else {
           auto address = message.address().to_string();
 
-          this->sp_->get<logger>()->trace(
+          VDS_LOG_TRACE(
+            this->sp_,
             "UDP",
             "Error %d at sending UDP to %s",
             error,
@@ -502,7 +517,8 @@ namespace vds {
           r->set_value(make_unexpected<std::runtime_error>("Invalid send UDP"));
         }
         else {
-          this->sp_->get<logger>()->trace(
+          VDS_LOG_TRACE(
+            this->sp_,
             "UDP",
             "Sent %d bytes UDP package to %s",
             message.data_size(),
@@ -533,7 +549,8 @@ namespace vds {
         }
 
         CHECK_EXPECTED((*this->owner())->change_mask(this->owner_, 0, EPOLLOUT));
-        this->sp_->get<logger>()->trace(
+        VDS_LOG_TRACE(
+          this->sp_,
           "UDP",
           "Error %d at sending UDP to %s",
           error,
@@ -550,7 +567,8 @@ namespace vds {
       else {
           CHECK_EXPECTED((*this->owner())->change_mask(this->owner_, 0, EPOLLOUT));
 
-        this->sp_->get<logger>()->trace(
+        VDS_LOG_TRACE(
+          this->sp_,
           "UDP",
           "Sent %d bytes UDP package to %s",
           this->write_message_.data_size(),
@@ -40,6 +40,13 @@ vds::udp_datagram::udp_datagram(
 {
 }
 
+vds::udp_datagram::udp_datagram(
+  const network_address & address,
+  const_data_buffer && data)
+  : impl_(new _udp_datagram(address, std::move(data)))
+{
+}
+
 vds::udp_datagram::~udp_datagram() {
   delete this->impl_;
 }
@@ -34,6 +34,10 @@ namespace vds {
     udp_datagram(
       const network_address & address,
       const const_data_buffer & data);
+
+    udp_datagram(
+      const network_address & address,
+      const_data_buffer && data);
     
     ~udp_datagram();
 
@@ -54,7 +54,7 @@ vds::async_task<vds::expected<void>> vds::_upload_stream_task::write_async(const
     co_return expected<void>();
   }
   else {
-    this->sp_->get<logger>()->trace("HASH", "[%s]", std::string((const char *)data, len).c_str());
+    VDS_LOG_TRACE(this->sp_, "HASH", "[%s]", std::string((const char *)data, len).c_str());
     CHECK_EXPECTED_ASYNC(this->total_hash_.update(data, len));
     this->total_size_ += len;
   }
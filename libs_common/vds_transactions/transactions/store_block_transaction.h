@@ -11,17 +11,19 @@ All rights reserved
 #include "const_data_buffer.h"
 #include "binary_serialize.h"
 #include "transaction_id.h"
+#include "erasure_codec.h"
 
 namespace vds {
   namespace transactions {
     class store_block_transaction {
     public:
-      static const transaction_id message_id = transaction_id::store_block_transaction;
+      static const transaction_id message_id = transaction_id::store_coded_block_transaction;
 
       const_data_buffer owner_id;
       const_data_buffer object_id;
       uint64_t object_size;
       uint32_t replica_size;
+      uint8_t codec;//erasure_codec_id
       std::vector<const_data_buffer> replicas;
       const_data_buffer owner_sig;
 
@@ -32,6 +34,7 @@ namespace vds {
           object_id,
           object_size,
           replica_size,
+          codec,
           replicas,
           owner_sig
         );
@@ -42,6 +45,7 @@ namespace vds {
         const const_data_buffer& object_id,
         uint64_t object_size,
         uint32_t replica_size,
+        erasure_codec_id codec,
         const std::vector<const_data_buffer>& replicas,
         const asymmetric_private_key& private_key) {
 
@@ -50,6 +54,7 @@ namespace vds {
         CHECK_EXPECTED(s << object_id);
         CHECK_EXPECTED(s << object_size);
         CHECK_EXPECTED(s << replica_size);
+        CHECK_EXPECTED(s << static_cast<uint8_t>(codec));
         CHECK_EXPECTED(s << replicas);
 
         GET_EXPECTED(owner_sig, asymmetric_sign::signature(hash::sha256(), private_key, s.move_data()));
@@ -58,10 +63,49 @@ namespace vds {
           object_id,
           object_size,
           replica_size,
+          static_cast<uint8_t>(codec),
           replicas,
           owner_sig);
       }
     };
+
+    //The format of the records written before the codec was stored with the block.
+    //They are read from the old logs only and always use GF(2^16).
+    class store_block_legacy_transaction {
+    public:
+      static const transaction_id message_id = transaction_id::store_block_transaction;
+
+      const_data_buffer owner_id;
+      const_data_buffer object_id;
+      uint64_t object_size;
+      uint32_t replica_size;
+      std::vector<const_data_buffer> replicas;
+      const_data_buffer owner_sig;
+
+      template <typename  visitor_type>
+      void visit(visitor_type & v) {
+        v(
+          owner_id,
+          object_id,
+          object_size,
+          replica_size,
+          replicas,
+          owner_sig
+        );
+      }
+
+      store_block_transaction upgrade() const {
+        store_block_transaction result;
+        result.owner_id = this->owner_id;
+        result.object_id = this->object_id;
+        result.object_size = this->object_size;
+        result.replica_size = this->replica_size;
+        result.codec = static_cast<uint8_t>(erasure_codec_id::gf16_vandermonde);
+        result.replicas = this->replicas;
+        result.owner_sig = this->owner_sig;
+        return result;
+      }
+    };
   }
 }
 
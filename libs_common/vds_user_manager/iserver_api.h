@@ -5,6 +5,7 @@
 #include "async_task.h"
 #include "const_data_buffer.h"
 #include "transaction_block_builder.h"
+#include "erasure_codec.h"
 
 /*
 Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
@@ -18,6 +19,7 @@ namespace vds {
     struct data_info_t {
       const_data_buffer data_hash;
       uint32_t replica_size;
+      erasure_codec_id codec;
       std::vector<const_data_buffer> replicas;
     };
 
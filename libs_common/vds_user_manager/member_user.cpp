@@ -121,6 +121,7 @@ vds::async_task<vds::expected<vds::member_user>> vds::_member_user::create_user(
       profile_info.data_hash,
       profile_block.size(),
       profile_info.replica_size,
+      profile_info.codec,
       profile_info.replicas,
       *private_key)));
 
@@ -18,6 +18,7 @@ namespace vds {
 				replica(this, "replica"),
         replica_hash(this, "replica_hash"),
         replica_size(this, "replica_size"),
+        codec(this, "codec"),
 				distance(this, "distance") {
 			}
 
@@ -26,6 +27,7 @@ namespace vds {
 			database_column<int16_t, int> replica;
       database_column<const_data_buffer, std::string> replica_hash;
       database_column<uint32_t, int> replica_size;
+      database_column<uint8_t, int> codec;//erasure_codec_id
 			database_column<uint32_t, int> distance;
 
 			static constexpr const char* create_table =
@@ -38,6 +40,10 @@ namespace vds {
 				distance INTEGER NOT NULL,\
 				CONSTRAINT pk_chunk_replica_data PRIMARY KEY(owner_id, object_hash,replica),\
 				CONSTRAINT idx_chunk_replica_data_replica_hash UNIQUE(replica_hash))";
+
+			//Database version 2: blocks stored before it use GF(2^16)
+			static constexpr const char* add_codec_column =
+				"ALTER TABLE chunk_replica_data ADD COLUMN codec INTEGER NOT NULL DEFAULT 0";
 		};
 	}
 }
@@ -262,6 +262,17 @@ vds::expected<void> vds::db_model::migrate(
     }
 	}
 
+  if (2 > db_version) {
+    static const char * commands[] = {
+      orm::chunk_replica_data_dbo::add_codec_column,
+      "UPDATE module SET version=2 WHERE id='kernel'"
+    };
+
+    for(size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); ++i) {
+      CHECK_EXPECTED(t.execute(commands[i]));
+    }
+  }
+
   return expected<void>();
 }
 
@@ -34,6 +34,10 @@ namespace vds {
 
   };
 
+  template <>
+  struct service_slot<db_model> {
+    static constexpr service_slot_t value = service_slot_t::reserved_0;
+  };
 }
 
 #endif //__VDS_DB_MODEL_DB_MODEL_H_
@@ -5,8 +5,9 @@ All rights reserved
 #include "stdafx.h"
 #include "dht_datagram_protocol.h"
 #include "iudp_transport.h"
+#include "metrics.h"
 
-vds::dht::network::dht_datagram_protocol::dht_datagram_protocol(const service_provider* sp, const network_address& address, const const_data_buffer& this_node_id, asymmetric_public_key partner_node_key, const const_data_buffer& partner_node_id, const const_data_buffer& session_key) noexcept
+vds::dht::network::dht_datagram_protocol::dht_datagram_protocol(const service_provider* sp, const network_address& address, const hash256& this_node_id, asymmetric_public_key partner_node_key, const hash256& partner_node_id, const const_data_buffer& session_key) noexcept
   : sp_(sp),
   failed_state_(false),
   check_mtu_(0),
@@ -59,8 +60,8 @@ vds::async_task<vds::expected<void>> vds::dht::network::dht_datagram_protocol::s
     base64::from_bytes(target_node).c_str());
 
   std::unique_lock<std::mutex> lock(this->metrics_mutex_);
-  this->traffic_[this->this_node_id_][target_node][message_type].sent_count_++;
-  this->traffic_[this->this_node_id_][target_node][message_type].sent_ += message.size();
+  this->traffic_[this->this_node_id_][hash256(target_node)][message_type].sent_count_++;
+  this->traffic_[this->this_node_id_][hash256(target_node)][message_type].sent_ += message.size();
 
   lock.unlock();
 
@@ -93,8 +94,8 @@ vds::async_task<vds::expected<void>> vds::dht::network::dht_datagram_protocol::p
     base64::from_bytes(target_node).c_str());
 
   std::unique_lock<std::mutex> lock(this->traffic_mutex_);
-  this->traffic_[hops[0]][target_node][message_type].sent_count_++;
-  this->traffic_[hops[0]][target_node][message_type].sent_ += message.size();
+  this->traffic_[hash256(hops[0])][hash256(target_node)][message_type].sent_count_++;
+  this->traffic_[hash256(hops[0])][hash256(target_node)][message_type].sent_ += message.size();
   lock.unlock();
 
   return this->send_message_async(
@@ -392,7 +393,7 @@ vds::expected<std::tuple<uint32_t, uint32_t>> vds::dht::network::dht_datagram_pr
       buffer.size()));
     CHECK_EXPECTED(buffer.add(sig));
 
-    const_data_buffer datagram = buffer.move_data();
+    const const_data_buffer datagram = buffer.move_data().share();
     vds_assert(datagram.size() <= this->mtu_);
 
     this->output_messages_.emplace(this->last_output_index_, output_message { std::chrono::high_resolution_clock::now(), datagram });
@@ -472,7 +473,7 @@ vds::expected<std::tuple<uint32_t, uint32_t>> vds::dht::network::dht_datagram_pr
       buffer.size()));
 
     CHECK_EXPECTED(buffer.add(sig));
-    const_data_buffer datagram = buffer.move_data();
+    const const_data_buffer datagram = buffer.move_data().share();
     vds_assert(datagram.size() <= this->mtu_);
 
     this->output_messages_.emplace(this->last_output_index_, output_message { std::chrono::high_resolution_clock::now(), datagram });
@@ -508,7 +509,7 @@ vds::expected<std::tuple<uint32_t, uint32_t>> vds::dht::network::dht_datagram_pr
         buffer.size()));
       CHECK_EXPECTED(buffer.add(sig));
 
-      const_data_buffer datagram = buffer.move_data();
+      const const_data_buffer datagram = buffer.move_data().share();
 
       vds_assert(datagram.size() <= this->mtu_);
 
@@ -621,15 +622,15 @@ vds::async_task<vds::expected<void>> vds::dht::network::dht_datagram_protocol::c
         message_type,
         target_node,
         hops,
-        message).then([pthis = this->shared_from_this(), message_type, target_node, source_node = hops.back(), message_size](expected<bool> is_good) {
+        message).then([pthis = this->shared_from_this(), message_type, target = hash256(target_node), source_node = hash256(hops.back()), message_size](expected<bool> is_good) {
         std::unique_lock<std::mutex> traffic_lock(pthis->traffic_mutex_);
         if (is_good.has_value() && is_good.value()) {
-          pthis->traffic_[source_node][target_node][message_type].good_count_++;
-          pthis->traffic_[source_node][target_node][message_type].good_traffic_ += message_size;
+          pthis->traffic_[source_node][target][message_type].good_count_++;
+          pthis->traffic_[source_node][target][message_type].good_traffic_ += message_size;
         }
         else {
-          pthis->traffic_[source_node][target_node][message_type].bad_count_++;
-          pthis->traffic_[source_node][target_node][message_type].bad_traffic_ += message_size;
+          pthis->traffic_[source_node][target][message_type].bad_count_++;
+          pthis->traffic_[source_node][target][message_type].bad_traffic_ += message_size;
         }
         traffic_lock.unlock();
       });
@@ -736,15 +737,15 @@ vds::async_task<vds::expected<void>> vds::dht::network::dht_datagram_protocol::c
             message_type,
             target_node,
             hops,
-            message.move_data()).then([pthis = this->shared_from_this(), message_type, target_node, hops, message_size](expected<bool> is_good) {
+            message.move_data()).then([pthis = this->shared_from_this(), message_type, target = hash256(target_node), source_node = hash256(hops.back()), message_size](expected<bool> is_good) {
             std::unique_lock<std::mutex> traffic_lock(pthis->traffic_mutex_);
             if (is_good.has_value() && is_good.value()) {
-              pthis->traffic_[hops[hops.size() - 1]][target_node][message_type].good_count_++;
-              pthis->traffic_[hops[hops.size() - 1]][target_node][message_type].good_traffic_ += message_size;
+              pthis->traffic_[source_node][target][message_type].good_count_++;
+              pthis->traffic_[source_node][target][message_type].good_traffic_ += message_size;
             }
             else {
-              pthis->traffic_[hops[hops.size() - 1]][target_node][message_type].bad_count_++;
-              pthis->traffic_[hops[hops.size() - 1]][target_node][message_type].bad_traffic_ += message_size;
+              pthis->traffic_[source_node][target][message_type].bad_count_++;
+              pthis->traffic_[source_node][target][message_type].bad_traffic_ += message_size;
             }
             traffic_lock.unlock();
           });
@@ -769,6 +770,7 @@ vds::async_task<vds::expected<void>> vds::dht::network::dht_datagram_protocol::c
 }
 
 vds::async_task<vds::expected<void>> vds::dht::network::dht_datagram_protocol::process_acknowledgment(const std::shared_ptr<iudp_transport>& s, const const_data_buffer& datagram) {
+  static auto & retransmitted = metrics::counter("dht.datagram.retransmitted");
 
   this->output_mutex_.lock();
 
@@ -816,6 +818,7 @@ vds::async_task<vds::expected<void>> vds::dht::network::dht_datagram_protocol::p
       last_index);
 
     this->service_traffic_ += datagram.data_size();
+    retransmitted.add();
     CHECK_EXPECTED_ASYNC(co_await s->write_async(datagram));
 
     this->output_mutex_.lock();
@@ -841,6 +844,7 @@ vds::async_task<vds::expected<void>> vds::dht::network::dht_datagram_protocol::p
           base64::from_bytes(this->partner_node_id_).c_str(),
           last_index + i + 1);
 
+        retransmitted.add();
         CHECK_EXPECTED_ASYNC(co_await s->write_async(datagram));
         this->service_traffic_ += datagram.data_size();
 
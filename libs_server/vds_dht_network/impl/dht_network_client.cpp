@@ -28,6 +28,20 @@ All rights reserved
 #include "chunk_tmp_data_dbo.h"
 #include "node_storage_dbo.h"
 #include "keys_control.h"
+#include "metrics.h"
+#include "async_file.h"
+#include "parallel_tasks.h"
+
+//Final tasks are independent sends, so a slow peer must not hold up the others
+static vds::async_task<vds::expected<void>> run_final_tasks(
+  std::list<std::function<vds::async_task<vds::expected<void>>()>> && final_tasks) {
+  return vds::parallel_for_each(
+    std::move(final_tasks),
+    vds::dht::network::_client::MAX_FINAL_TASKS,
+    [](const std::function<vds::async_task<vds::expected<void>>()> & task) {
+    return task();
+  });
+}
 
 vds::dht::network::client::client()
 : is_new_node_(true), port_(0) {
@@ -48,14 +62,28 @@ vds::dht::network::_client::_client(
   const std::shared_ptr<iudp_transport> & udp_transport,
   const const_data_buffer & this_node_id)
   : sp_(sp),
-  route_(sp, this_node_id),
+  route_(sp, hash256(this_node_id)),
   update_timer_("DHT Network"),
   update_route_table_counter_(0),
   udp_transport_(udp_transport),
+  codec_(service::ERASURE_CODEC),
   sync_process_(sp),
-  update_wellknown_connection_enabled_(true) {
+  update_wellknown_connection_enabled_(true),
+  restore_semaphore_(MAX_RESTORE_TASKS) {
+  std::vector<uint16_t> replicas;
   for (uint16_t replica = 0; replica < service::GENERATE_HORCRUX; ++replica) {
-    this->generators_[replica].reset(new chunk_generator<uint16_t>(service::MIN_HORCRUX, replica));
+    replicas.push_back(replica);
+  }
+
+  //Blocks stored with any codec can be replicated and restored
+  for (auto codec : { erasure_codec_id::gf16_vandermonde, erasure_codec_id::gf8_cauchy }) {
+    auto encoder = erasure_codec::create_encoder(codec, service::MIN_HORCRUX, replicas);
+    vds_assert(encoder.has_value());
+    this->encoders_[codec] = std::move(encoder.value());
+
+    auto decoder = erasure_codec::create_decoder(codec, service::MIN_HORCRUX);
+    vds_assert(decoder.has_value());
+    this->decoders_[codec] = std::move(decoder.value());
   }
 }
 
@@ -63,19 +91,24 @@ vds::expected<std::vector<vds::const_data_buffer>> vds::dht::network::_client::s
   database_transaction& t,
   const const_data_buffer& value_id,
   const const_data_buffer& value,
-  uint32_t* replica_size) {
+  uint32_t* replica_size,
+  erasure_codec_id* codec) {
 
   GET_EXPECTED(root_folder, persistence::current_user(this->sp_));
 
   foldername tmp_folder(root_folder, "tmp");
   CHECK_EXPECTED(tmp_folder.create());
 
+  const erasure_codec_id block_codec = this->codec_;
+  if (nullptr != codec) {
+    *codec = block_codec;
+  }
+
+  GET_EXPECTED(replicas, this->encoders_[block_codec]->write(value.data(), value.size()));
 
   std::vector<const_data_buffer> result(service::GENERATE_HORCRUX);
   for (uint16_t replica = 0; replica < service::GENERATE_HORCRUX; ++replica) {
-    binary_serializer s;
-    CHECK_EXPECTED(this->generators_.find(replica)->second->write(s, value.data(), value.size()));
-    const auto replica_data = s.move_data();
+    const auto & replica_data = replicas[replica];
     GET_EXPECTED(replica_hash, hash::signature(hash::sha256(), replica_data));
 
     if (0 == replica && nullptr != replica_size) {
@@ -115,8 +148,8 @@ vds::expected<std::vector<vds::const_data_buffer>> vds::dht::network::_client::s
 vds::async_task<vds::expected<bool>> vds::dht::network::_client::apply_message(
   const messages::dht_find_node& message,
   const imessage_map::message_info_t& message_info) {
-  std::map<const_data_buffer /*distance*/,
-  std::map<const_data_buffer, std::shared_ptr<dht_route::node>>> result_nodes;
+  std::map<hash256 /*distance*/,
+  std::map<hash256, std::shared_ptr<dht_route::node>>> result_nodes;
 
   CHECK_EXPECTED_ASYNC(this->route_.search_nodes(
     message.target_id,
@@ -186,8 +219,9 @@ vds::async_task<vds::expected<bool>> vds::dht::network::_client::apply_message(
   const imessage_map::message_info_t& message_info) {
   const auto now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
   message_info.session()->process_pong(message_info.source_node(), now - message.ping_time_);
+  GET_EXPECTED_ASYNC(source_node, hash256::create(message_info.source_node()));
   this->route_.mark_pinged(
-    message_info.source_node(),
+    source_node,
     message_info.session()->address());
   co_return true;
 }
@@ -198,7 +232,8 @@ vds::async_task<vds::expected<void>> vds::dht::network::_client::for_near(
   const std::function<expected<bool>(const dht_route::node & node)>& filter,
   lambda_holder_t<vds::async_task<vds::expected<bool>>, const std::shared_ptr<dht_route::node>&> callback)
 {
-  return this->route_.for_near(target_node_id, max_count, filter, std::move(callback));
+  GET_EXPECTED(target, hash256::create(target_node_id));
+  return this->route_.for_near(target, max_count, filter, std::move(callback));
 }
 
 vds::expected<void> vds::dht::network::_client::for_near_sync(
@@ -207,7 +242,8 @@ vds::expected<void> vds::dht::network::_client::for_near_sync(
   const std::function<expected<bool>(const dht_route::node & node)>& filter,
   lambda_holder_t<vds::expected<bool>, const std::shared_ptr<dht_route::node>&> callback)
 {
-  return this->route_.for_near_sync(target_node_id, max_count, filter, std::move(callback));
+  GET_EXPECTED(target, hash256::create(target_node_id));
+  return this->route_.for_near_sync(target, max_count, filter, std::move(callback));
 }
 
 vds::async_task<vds::expected<void>> vds::dht::network::_client::add_session(
@@ -247,9 +283,10 @@ vds::async_task<vds::expected<void>> vds::dht::network::_client::send(
   const message_type_t message_id,
   expected<const_data_buffer> && message) {
   CHECK_EXPECTED_ERROR(message);
+  GET_EXPECTED(target, hash256::create(target_node_id));
 
   return this->route_.for_near(
-    target_node_id,
+    target,
     1,
     [](const dht_route::node& node) -> expected<bool> {
       return true;
@@ -272,9 +309,10 @@ vds::async_task<vds::expected<void>> vds::dht::network::_client::send_near(
   expected<const_data_buffer>&& message,
   const std::function<expected<bool>(const dht_route::node & node)>& filter) {
   CHECK_EXPECTED_ERROR(message);
+  GET_EXPECTED(target, hash256::create(target_node_id));
 
   return this->route_.for_near(
-    target_node_id,
+    target,
     max_count,
     filter,
     [target_node_id, message_id, msg = std::move(message.value()), pthis = this->shared_from_this()](
@@ -295,10 +333,12 @@ vds::async_task<vds::expected<void>> vds::dht::network::_client::proxy_message(
     const const_data_buffer &message,
     const std::vector<const_data_buffer>& hops) {
 
+  GET_EXPECTED(target, hash256::create(target_node_id));
   if (hops.size() > 10) {
     auto best = this->current_node_id();
-    for (const auto& item : hops) {
-      if (dht_object_id::distance(target_node_id, item) < dht_object_id::distance(target_node_id, best)) {
+    for (const auto & hop : hops) {
+      GET_EXPECTED(item, hash256::create(hop));
+      if (dht_object_id::distance(target, item) < dht_object_id::distance(target, best)) {
         best = item;
       }
     }
@@ -312,7 +352,7 @@ vds::async_task<vds::expected<void>> vds::dht::network::_client::proxy_message(
   }
   else {
     return this->route_.for_near(
-      target_node_id,
+      target,
       1,
       [&hops](const dht_route::node& node) -> expected<bool> {
         return hops.end() == std::find(hops.begin(), hops.end(), node.proxy_session_->partner_node_id());
@@ -322,7 +362,7 @@ vds::async_task<vds::expected<void>> vds::dht::network::_client::proxy_message(
         message_id,
         message,
         pthis = this->shared_from_this(),
-        distance = dht_object_id::distance(this->current_node_id(), target_node_id),
+        distance = dht_object_id::distance(this->current_node_id(), target),
         hops](
           const std::shared_ptr<dht_route::node>& candidate)->vds::async_task<vds::expected<bool>> {
         pthis->sp_->get<logger>()->trace(
@@ -386,10 +426,7 @@ vds::expected<void> vds::dht::network::_client::start() {
       }));
 
     pthis->sp_->get<logger>()->trace(ThisModule, "Start Final tasks");
-    while(!final_tasks.empty()) {
-      CHECK_EXPECTED_ASYNC(co_await final_tasks.front()());
-      final_tasks.pop_front();
-    }
+    CHECK_EXPECTED_ASYNC(co_await run_final_tasks(std::move(final_tasks)));
 
      co_return !pthis->sp_->get_shutdown_event().is_shuting_down();
   });
@@ -422,23 +459,21 @@ void vds::dht::network::_client::remove_session(
   this->route_.remove_session(session);
 }
 
-vds::expected<vds::filename> vds::dht::network::_client::save_data(
-  const service_provider * sp,
+vds::expected<bool> vds::dht::network::_client::prepare_save_data(
   database_transaction& t,
   const const_data_buffer& data_hash,
-  const const_data_buffer& data,
+  size_t data_size,
   const const_data_buffer& owner,
-  const const_data_buffer& value_id,
-  uint16_t replica) {
-
-  auto client = sp->get<network::client>();
+  filename & fn,
+  std::string & storage_path,
+  const_data_buffer & storage_id) {
 
   orm::chunk_replica_data_dbo t4;
   GET_EXPECTED(st, t.get_reader(t4.select(t4.replica_size).where(t4.replica_hash == data_hash)));
   GET_EXPECTED(st_execute, st.execute());
   if (st_execute) {
-    vds_assert(data.size() == t4.replica_size.get(st));
-    if (data.size() != t4.replica_size.get(st)) {
+    vds_assert(data_size == t4.replica_size.get(st));
+    if (data_size != t4.replica_size.get(st)) {
       return make_unexpected<std::runtime_error>("Data collusion " + base64::from_bytes(data_hash));
     }
   }
@@ -452,22 +487,22 @@ vds::expected<vds::filename> vds::dht::network::_client::save_data(
     .where(t1.replica_hash == data_hash)));
   GET_EXPECTED_VALUE(st_execute, st.execute());
   if (st_execute) {
-    return filename(foldername(t1.storage_path.get(st)), t2.local_path.get(st));
+    fn = filename(foldername(t1.storage_path.get(st)), t2.local_path.get(st));
+    return false;
   }
 
   uint64_t allowed_size = 0;
   std::string local_path;
-  const_data_buffer storage_id;
 
-  db_value<int64_t> data_size;
+  db_value<int64_t> total_size;
   GET_EXPECTED_VALUE(st, t.get_reader(
-    t2.select(t2.storage_id, t2.local_path, t2.reserved_size, db_sum(t1.replica_size).as(data_size))
+    t2.select(t2.storage_id, t2.local_path, t2.reserved_size, db_sum(t1.replica_size).as(total_size))
       .left_join(t1, t1.storage_id == t2.storage_id)
       .where((t2.usage_type == orm::node_storage_dbo::usage_type_t::share)
         || (t2.usage_type == orm::node_storage_dbo::usage_type_t::exclusive && t2.owner_id == owner))
       .group_by(t2.storage_id, t2.local_path, t2.reserved_size)));
   WHILE_EXPECTED (st.execute()) {
-    const int64_t size = data_size.is_null(st) ? 0 : data_size.get(st);
+    const int64_t size = total_size.is_null(st) ? 0 : total_size.get(st);
     if (t2.reserved_size.get(st) > size && allowed_size < (t2.reserved_size.get(st) - size)) {
       allowed_size = (t2.reserved_size.get(st) - size);
       local_path = t2.local_path.get(st);
@@ -476,7 +511,7 @@ vds::expected<vds::filename> vds::dht::network::_client::save_data(
   }
   WHILE_EXPECTED_END()
 
-  if (local_path.empty() || allowed_size < data.size()) {
+  if (local_path.empty() || allowed_size < data_size) {
     return vds::make_unexpected<std::runtime_error>("No disk space");
   }
 
@@ -493,18 +528,56 @@ vds::expected<vds::filename> vds::dht::network::_client::save_data(
   fl = foldername(fl, append_path.substr(10, 10));
   CHECK_EXPECTED(fl.create());
 
-  filename fn(fl, append_path.substr(20));
-  CHECK_EXPECTED(file::write_all(fn, data));
+  fn = filename(fl, append_path.substr(20));
+  storage_path = append_path.substr(0, 10) + "/" + append_path.substr(10, 10) + "/" + append_path.substr(20);
+  return true;
+}
 
-  CHECK_EXPECTED(t.execute(t1.insert(
-    t1.storage_id = storage_id,
-    t1.replica_hash = data_hash,
-    t1.replica_size = data.size(),
-    t1.owner = owner,
-    t1.storage_path = append_path.substr(0, 10) + "/" + append_path.substr(10, 10) + "/" + append_path.substr(20),
-    t1.last_access = std::chrono::system_clock::now())));
+vds::async_task<vds::expected<vds::filename>> vds::dht::network::_client::save_data_async(
+  const service_provider * sp,
+  const_data_buffer data_hash,
+  const_data_buffer data,
+  const_data_buffer owner) {
 
-  return fn;
+  const auto data_size = data.size();
+
+  bool is_new = false;
+  filename fn;
+  std::string storage_path;
+  const_data_buffer storage_id;
+  CHECK_EXPECTED_ASYNC(co_await sp->get<db_model>()->async_transaction(
+    [&](database_transaction& t) -> expected<void> {
+    GET_EXPECTED_VALUE(is_new, prepare_save_data(t, data_hash, data_size, owner, fn, storage_path, storage_id));
+    return expected<void>();
+  }));
+
+  if (!is_new) {
+    co_return fn;
+  }
+
+  //The disk write runs outside of the database transaction
+  CHECK_EXPECTED_ASYNC(co_await async_file::write_all(sp, fn, std::move(data)));
+
+  CHECK_EXPECTED_ASYNC(co_await sp->get<db_model>()->async_transaction(
+    [&](database_transaction& t) -> expected<void> {
+    //Another copy of the same replica could have been saved meanwhile
+    orm::local_data_dbo t1;
+    GET_EXPECTED(st, t.get_reader(t1.select(t1.replica_hash).where(t1.replica_hash == data_hash)));
+    GET_EXPECTED(st_execute, st.execute());
+    if (st_execute) {
+      return expected<void>();
+    }
+
+    return t.execute(t1.insert(
+      t1.storage_id = storage_id,
+      t1.replica_hash = data_hash,
+      t1.replica_size = data_size,
+      t1.owner = owner,
+      t1.storage_path = storage_path,
+      t1.last_access = std::chrono::system_clock::now()));
+  }));
+
+  co_return fn;
 }
 
 vds::expected<vds::filename> vds::dht::network::_client::save_data(
@@ -579,82 +652,24 @@ vds::expected<vds::filename> vds::dht::network::_client::save_data(
   return fn;
 }
 
-vds::expected<void> vds::dht::network::_client::save_data(
-  const service_provider* sp,
-  database_transaction& t,
-  const const_data_buffer& data,
-  const const_data_buffer& owner) {
-
-  std::vector<const_data_buffer> result(service::GENERATE_HORCRUX);
-  for (uint16_t replica = 0; replica < service::GENERATE_HORCRUX; ++replica) {
-    binary_serializer s;
-    CHECK_EXPECTED(this->generators_.find(replica)->second->write(s, data.data(), data.size()));
-    const auto replica_data = s.move_data();
-    GET_EXPECTED(replica_hash, hash::signature(hash::sha256(), replica_data));
-
-    orm::local_data_dbo t1;
-    orm::node_storage_dbo t2;
-    GET_EXPECTED(st, t.get_reader(
-      t1
-      .select(t1.storage_path, t2.local_path)
-      .inner_join(t2, t2.storage_id == t1.storage_id)
-      .where(t1.replica_hash == replica_hash)));
-    GET_EXPECTED(st_execute, st.execute());
-    if (st_execute) {
-      continue;//exist already
-    }
-
-    uint64_t allowed_size = 0;
-    std::string local_path;
-    const_data_buffer storage_id;
+vds::async_task<vds::expected<void>> vds::dht::network::_client::save_replicas_async(
+  erasure_codec_id codec,
+  const_data_buffer data,
+  const_data_buffer owner) {
 
-    db_value<int64_t> data_size;
-    GET_EXPECTED_VALUE(st, t.get_reader(
-      t2.select(t2.storage_id, t2.local_path, t2.reserved_size, db_sum(t1.replica_size).as(data_size))
-      .left_join(t1, t1.storage_id == t2.storage_id)
-      .where((t2.usage_type == orm::node_storage_dbo::usage_type_t::share)
-        || (t2.usage_type == orm::node_storage_dbo::usage_type_t::exclusive && t2.owner_id == owner))
-      .group_by(t2.storage_id, t2.local_path, t2.reserved_size)));
-    WHILE_EXPECTED(st.execute()) {
-      const int64_t size = data_size.is_null(st) ? 0 : data_size.get(st);
-      if (t2.reserved_size.get(st) > size && allowed_size < (t2.reserved_size.get(st) - size)) {
-        allowed_size = (t2.reserved_size.get(st) - size);
-        local_path = t2.local_path.get(st);
-        storage_id = t2.storage_id.get(st);
-      }
-    }
-    WHILE_EXPECTED_END()
-
-    if (local_path.empty() || allowed_size < replica_data.size()) {
-      return vds::make_unexpected<std::runtime_error>("No disk space");
-    }
-
-    auto append_path = base64::from_bytes(replica_hash);
-    str_replace(append_path, '+', '#');
-    str_replace(append_path, '/', '_');
-
-    foldername fl(local_path);
-    CHECK_EXPECTED(fl.create());
-
-    fl = foldername(fl, append_path.substr(0, 10));
-    CHECK_EXPECTED(fl.create());
-
-    fl = foldername(fl, append_path.substr(10, 10));
-    CHECK_EXPECTED(fl.create());
+  auto encoder = this->encoders_.find(codec);
+  if (this->encoders_.end() == encoder) {
+    co_return vds::make_unexpected<std::runtime_error>("Unknown erasure codec");
+  }
 
-    filename fn(fl, append_path.substr(20));
-    CHECK_EXPECTED(file::write_all(fn, replica_data));
+  GET_EXPECTED_ASYNC(replicas, encoder->second->write(data.data(), data.size()));
 
-    CHECK_EXPECTED(t.execute(t1.insert(
-      t1.storage_id = storage_id,
-      t1.replica_hash = replica_hash,
-      t1.replica_size = replica_data.size(),
-      t1.owner = owner,
-      t1.storage_path = append_path.substr(0, 10) + "/" + append_path.substr(10, 10) + "/" + append_path.substr(20),
-      t1.last_access = std::chrono::system_clock::now())));
+  for (uint16_t replica = 0; replica < service::GENERATE_HORCRUX; ++replica) {
+    GET_EXPECTED_ASYNC(replica_hash, hash::signature(hash::sha256(), replicas[replica]));
+    CHECK_EXPECTED_ASYNC(co_await save_data_async(this->sp_, replica_hash, std::move(replicas[replica]), owner));
   }
 
-  return expected<void>();
+  co_return expected<void>();
 }
 
 
@@ -795,7 +810,7 @@ vds::expected<bool> vds::dht::network::_client::apply_message( database_transact
 vds::expected<bool> vds::dht::network::_client::apply_message(
    database_transaction& t,
   std::list<std::function<async_task<expected<void>>()>> & final_tasks,
-  const messages::sync_replica_data& message,
+  const messages::sync_replica_data_view& message,
   const imessage_map::message_info_t& message_info) {
   return this->sync_process_.apply_message(t, final_tasks, message, message_info);
 }
@@ -822,14 +837,18 @@ vds::async_task<vds::expected<vds::const_data_buffer>> vds::dht::network::_clien
       result));
 
     if (result->size() > 0) {
+      static auto & restore_latency = metrics::histogram("dht.restore_us");
+      restore_latency.record(std::chrono::steady_clock::now() - start);
       co_return *result;
     }
 
     if (std::chrono::seconds(60) < (std::chrono::steady_clock::now() - start)) {
+      static auto & restore_failed = metrics::counter("dht.restore.not_found");
+      restore_failed.add();
       co_return vds::make_unexpected<vds_exceptions::not_found>();
     }
 
-    std::this_thread::sleep_for(std::chrono::seconds(5));
+    CHECK_EXPECTED_ASYNC(co_await sleep_for(this->sp_, std::chrono::seconds(5)));
   }
 }
 
@@ -848,20 +867,45 @@ vds::expected<vds::dht::network::client::block_info_t> vds::dht::network::_clien
   return result;
 }
 
-vds::expected<void> vds::dht::network::_client::restore_async(
+vds::expected<void> vds::dht::network::_client::find_replicas(
   database_transaction& t,
   std::list<std::function<async_task<expected<void>>()>> & final_tasks,
   const std::vector<const_data_buffer>& replicas_hashes,
-  const std::shared_ptr<const_data_buffer>& result,
+  erasure_codec_id & codec,
+  std::vector<uint16_t> & replicas,
+  std::vector<filename> & files,
   const std::shared_ptr<uint8_t> & result_progress) {
-  
-  std::vector<uint16_t> replicas;
-  std::vector<const_data_buffer> datas;
+
+  if (replicas_hashes.empty()) {
+    *result_progress = 0;
+    return expected<void>();
+  }
+
+  //The block is decoded with the codec it was stored with, whatever the default of this node is
+  bool is_codec_known = false;
+  {
+    orm::chunk_replica_data_dbo t1;
+    GET_EXPECTED(st, t.get_reader(
+      t1
+      .select(t1.codec)
+      .where(t1.replica_hash == replicas_hashes[0])));
+    GET_EXPECTED(st_execute, st.execute());
+    if (st_execute) {
+      codec = static_cast<erasure_codec_id>(t1.codec.get(st));
+      is_codec_known = true;
+    }
+  }
+
+  if (!is_codec_known) {
+    GET_EXPECTED_VALUE(is_codec_known, find_block_codec(t, replicas_hashes[0], codec));
+  }
+
   std::map<uint16_t, const_data_buffer> unknonw_replicas;
 
   orm::node_storage_dbo t1;
   orm::local_data_dbo t4;
-  for (uint16_t replica = 0; replica < service::GENERATE_HORCRUX; ++replica) {
+  const auto replica_count = std::min<size_t>(replicas_hashes.size(), service::GENERATE_HORCRUX);
+  for (uint16_t replica = 0; replica < replica_count; ++replica) {
     GET_EXPECTED(st, t.get_reader(
       t1
       .select(t1.local_path, t4.storage_path)
@@ -870,8 +914,7 @@ vds::expected<void> vds::dht::network::_client::restore_async(
     GET_EXPECTED(st_execute, st.execute());
     if (st_execute) {
       replicas.push_back(replica);
-      GET_EXPECTED(data, file::read_all(filename(foldername(t1.local_path.get(st)), t4.storage_path.get(st))));
-      datas.push_back(data);
+      files.push_back(filename(foldername(t1.local_path.get(st)), t4.storage_path.get(st)));
 
       if (replicas.size() >= service::MIN_HORCRUX) {
         break;
@@ -882,17 +925,20 @@ vds::expected<void> vds::dht::network::_client::restore_async(
     }
   }
 
-  if (replicas.size() >= service::MIN_HORCRUX) {
-    if (result) {
-      chunk_restore<uint16_t> restore(service::MIN_HORCRUX, replicas.data());
-      GET_EXPECTED(data, restore.restore(datas));
-      *result = data;
-    }
+  if (!is_codec_known) {
+    //Nothing is decoded before the store_block record arrives, the replicas are requested meanwhile
+    replicas.clear();
+    files.clear();
+    *result_progress = 0;
+  }
+  else if (replicas.size() >= service::MIN_HORCRUX) {
     *result_progress = 100;
     return expected<void>();
   }
+  else {
+    *result_progress = 99 * replicas.size() / service::MIN_HORCRUX;
+  }
 
-  *result_progress = 99 * replicas.size() / service::MIN_HORCRUX;
   for (const auto replica : unknonw_replicas) {
     CHECK_EXPECTED(this->sync_process_.restore_replica(t, final_tasks, replica.second));
   }
@@ -901,25 +947,83 @@ vds::expected<void> vds::dht::network::_client::restore_async(
 }
 
 vds::async_task<vds::expected<uint8_t>> vds::dht::network::_client::restore_async(
-  const std::vector<const_data_buffer>& replicas_hashes,
+  std::vector<const_data_buffer> replicas_hashes,
   std::shared_ptr<const_data_buffer> result) {
 
+  auto restore_guard = co_await this->restore_semaphore_.scoped_acquire();
+
   auto result_progress = std::make_shared<uint8_t>();
+  erasure_codec_id codec = this->codec_;
+  std::vector<uint16_t> replicas;
+  std::vector<filename> files;
   std::list<std::function<async_task<expected<void>>()>> final_tasks;
   CHECK_EXPECTED_ASYNC(co_await this->sp_->get<db_model>()->async_transaction(
-    [pthis = this->shared_from_this(), replicas_hashes, result, result_progress, &final_tasks](
+    [pthis = this->shared_from_this(), &replicas_hashes, &codec, &replicas, &files, result_progress, &final_tasks](
       database_transaction& t) -> expected<void> {
-    return pthis->restore_async(t, final_tasks, replicas_hashes, result, result_progress);
+    return pthis->find_replicas(t, final_tasks, replicas_hashes, codec, replicas, files, result_progress);
   }));
 
-  while(!final_tasks.empty()) {
-    CHECK_EXPECTED_ASYNC(co_await final_tasks.front()());
-    final_tasks.pop_front();
+  CHECK_EXPECTED_ASYNC(co_await run_final_tasks(std::move(final_tasks)));
+
+  //Replicas are read by the disk I/O threads instead of the database thread
+  if (replicas.size() >= service::MIN_HORCRUX && result) {
+    std::vector<const_data_buffer> datas;
+    for (const auto & fn : files) {
+      GET_EXPECTED_ASYNC(data, co_await async_file::read_all(this->sp_, fn));
+      datas.push_back(std::move(data));
+    }
+
+    GET_EXPECTED_ASYNC(decoder, this->get_decoder(codec));
+    GET_EXPECTED_ASYNC(data, decoder->restore(replicas, datas));
+    *result = std::move(data);
   }
 
   co_return *result_progress;
 }
 
+vds::expected<bool> vds::dht::network::_client::find_block_codec(
+  database_read_transaction & t,
+  const const_data_buffer & replica_hash,
+  erasure_codec_id & codec) {
+
+  //A block waiting for its ancestors is validated but its records are not applied yet
+  bool is_found = false;
+  orm::transaction_log_record_dbo t1;
+  GET_EXPECTED(st, t.get_reader(
+    t1
+    .select(t1.data)
+    .where(t1.state == orm::transaction_log_record_dbo::state_t::validated)));
+  WHILE_EXPECTED(st.execute()) {
+    GET_EXPECTED(block, transactions::transaction_block::create(t1.data.get(st)));
+    CHECK_EXPECTED(block.walk_messages(
+      [&replica_hash, &codec, &is_found](const transactions::store_block_transaction & message) -> expected<bool> {
+      if (message.replicas.end() == std::find(message.replicas.begin(), message.replicas.end(), replica_hash)) {
+        return true;
+      }
+
+      codec = static_cast<erasure_codec_id>(message.codec);
+      is_found = true;
+      return false;
+    }));
+
+    if (is_found) {
+      break;
+    }
+  }
+  WHILE_EXPECTED_END()
+
+  return is_found;
+}
+
+vds::expected<vds::erasure_decoder *> vds::dht::network::_client::get_decoder(erasure_codec_id codec) const {
+  auto p = this->decoders_.find(codec);
+  if (this->decoders_.end() == p) {
+    return vds::make_unexpected<std::runtime_error>("Unknown erasure codec");
+  }
+
+  return p->second.get();
+}
+
 vds::expected<void> vds::dht::network::_client::update_wellknown_connection(
   database_transaction& t,
   std::list<std::function<async_task<expected<void>>()>> & final_tasks) {
@@ -979,7 +1083,8 @@ void vds::dht::network::_client::add_route(
   const const_data_buffer& source_node,
   uint16_t hops,
   const std::shared_ptr<dht_session>& session) {
-  this->route_.add_node(source_node, session, hops, false);
+  //Hops are cut from the datagram header in node id sized fields
+  this->route_.add_node(hash256(source_node), session, hops, false);
 
 }
 
@@ -990,9 +1095,10 @@ vds::async_task<vds::expected<void>> vds::dht::network::_client::redirect(
   expected<const_data_buffer> message)
 {
   CHECK_EXPECTED_ERROR(message);
+  GET_EXPECTED(target, hash256::create(node_id));
 
   return this->route_.for_near(
-    node_id,
+    target,
     1,
     [last_node = hops[0]](const dht_route::node& node)->expected<bool> {
       return last_node != node.proxy_session_->partner_node_id();
@@ -1013,7 +1119,8 @@ vds::async_task<vds::expected<void>> vds::dht::network::_client::find_nodes(
     const vds::const_data_buffer &node_id,
     size_t radius) {
 
-  co_return co_await this->send_neighbors(message_create<messages::dht_find_node>(node_id));
+  GET_EXPECTED_ASYNC(target, hash256::create(node_id));
+  co_return co_await this->send_neighbors(message_create<messages::dht_find_node>(target));
 }
 
 vds::expected<void> vds::dht::network::client::start(
@@ -1335,7 +1442,7 @@ vds::expected<vds::dht::network::client::block_info_t> vds::dht::network::client
 }
 
 
-const vds::const_data_buffer& vds::dht::network::client::current_node_id() const {
+const vds::hash256& vds::dht::network::client::current_node_id() const {
   return this->impl_->current_node_id();
 }
 
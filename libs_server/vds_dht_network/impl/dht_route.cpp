@@ -5,12 +5,13 @@ All rights reserved
 #include "stdafx.h"
 #include "dht_route.h"
 #include "route_statistic.h"
+#include "parallel_tasks.h"
 
 vds::dht::dht_route::node::node()
   : pinged_(0) {
 }
 
-vds::dht::dht_route::node::node(const const_data_buffer& id, const session_type& proxy_session, uint8_t hops)
+vds::dht::dht_route::node::node(const hash256& id, const session_type& proxy_session, uint8_t hops)
   : node_id_(id),
   proxy_session_(proxy_session),
   hops_(hops),
@@ -28,14 +29,14 @@ bool vds::dht::dht_route::node::is_good() const {
   return this->pinged_ < 10;
 }
 
-void vds::dht::dht_route::node::reset(const const_data_buffer& id, const session_type& proxy_session, uint8_t hops) {
+void vds::dht::dht_route::node::reset(const hash256& id, const session_type& proxy_session, uint8_t hops) {
   this->node_id_ = id;
   this->proxy_session_ = proxy_session;
   this->hops_ = hops;
   this->pinged_ = 0;
 }
 
-bool vds::dht::dht_route::bucket::add_node(const const_data_buffer& id, const session_type& proxy_session, uint8_t hops, bool allow_skip) {
+bool vds::dht::dht_route::bucket::add_node(const hash256& id, const session_type& proxy_session, uint8_t hops, bool allow_skip) {
 
   std::unique_lock<std::shared_mutex> ulock(this->nodes_mutex_);
   for (const auto& p : this->nodes_) {
@@ -75,7 +76,7 @@ vds::async_task<vds::expected<void>> vds::dht::dht_route::bucket::on_timer(
   const service_provider* sp,
   const dht_route* owner,
   const std::shared_ptr<network::iudp_transport> & transport) {
-  std::list<std::tuple<const_data_buffer, session_type>> sessions;
+  std::list<std::tuple<hash256, session_type>> sessions;
 
   this->nodes_mutex_.lock();
   for (auto p : this->nodes_) {
@@ -90,15 +91,18 @@ vds::async_task<vds::expected<void>> vds::dht::dht_route::bucket::on_timer(
   }
   this->nodes_mutex_.unlock();
 
+  std::vector<async_task<expected<void>>> tasks;
   for (const auto& s : sessions) {
-    CHECK_EXPECTED_ASYNC(co_await std::get<1>(s)->ping_node(
+    tasks.push_back(std::get<1>(s)->ping_node(
       std::get<0>(s),
       transport));
   }
+
+  CHECK_EXPECTED_ASYNC(co_await when_all(std::move(tasks)));
   co_return expected<void>();
 }
 
-bool vds::dht::dht_route::bucket::contains(const const_data_buffer& node_id) const {
+bool vds::dht::dht_route::bucket::contains(const hash256& node_id) const {
   std::shared_lock<std::shared_mutex> lock(this->nodes_mutex_);
   for (auto& p : this->nodes_) {
     if (p->node_id_ == node_id) {
@@ -109,7 +113,7 @@ bool vds::dht::dht_route::bucket::contains(const const_data_buffer& node_id) con
   return false;
 }
 
-void vds::dht::dht_route::bucket::mark_pinged(const const_data_buffer& target_node, const network_address& address) {
+void vds::dht::dht_route::bucket::mark_pinged(const hash256& target_node, const network_address& address) {
   std::shared_lock<std::shared_mutex> lock(this->nodes_mutex_);
   for (auto& p : this->nodes_) {
     if (p->node_id_ == target_node && p->proxy_session_->address() == address) {
@@ -142,7 +146,7 @@ void vds::dht::dht_route::bucket::get_neighbors(std::list<std::shared_ptr<node>>
   }
 }
 
-vds::expected<size_t> vds::dht::dht_route::looking_nodes(const const_data_buffer& target_id, const lambda_holder_t<expected<bool>, const node&>& filter, std::map<const_data_buffer, std::map<const_data_buffer, std::shared_ptr<node>>>& result_nodes, size_t index) const {
+vds::expected<size_t> vds::dht::dht_route::looking_nodes(const hash256& target_id, const lambda_holder_t<expected<bool>, const node&>& filter, std::map<hash256, std::map<hash256, std::shared_ptr<node>>>& result_nodes, size_t index) const {
   size_t result = 0;
   auto p = this->buckets_.find(index);
   if (this->buckets_.end() == p) {
@@ -178,11 +182,16 @@ vds::expected<size_t> vds::dht::dht_route::looking_nodes(const const_data_buffer
 }
 
 vds::async_task<vds::expected<void>> vds::dht::dht_route::ping_buckets(std::shared_ptr<network::iudp_transport> transport) {
-  std::shared_lock<std::shared_mutex> lock(this->buckets_mutex_);
+  std::vector<async_task<expected<void>>> tasks;
+
+  this->buckets_mutex_.lock_shared();
   for (auto& p : this->buckets_) {
     logger::get(this->sp_)->trace("DHT", "Bucket %d", p.first);
-    CHECK_EXPECTED_ASYNC(co_await p.second->on_timer(this->sp_, this, transport));
+    tasks.push_back(p.second->on_timer(this->sp_, this, transport));
   }
+  this->buckets_mutex_.unlock_shared();
+
+  CHECK_EXPECTED_ASYNC(co_await when_all(std::move(tasks)));
 
   co_return expected<void>();
 }
@@ -192,10 +201,10 @@ vds::async_task<vds::expected<void>> vds::dht::dht_route::on_timer(std::shared_p
 }
 
 vds::expected<void> vds::dht::dht_route::search_nodes(
-  const const_data_buffer& target_id,
+  const hash256& target_id,
   size_t max_count,
   const std::function<expected<bool>(const node & node)>& filter,
-  std::map<const_data_buffer, std::map<const_data_buffer, std::shared_ptr<node>>>& result_nodes) const
+  std::map<hash256, std::map<hash256, std::shared_ptr<node>>>& result_nodes) const
 {
   if (this->buckets_.empty()) {
     return expected<void>();
@@ -237,7 +246,7 @@ void vds::dht::dht_route::get_neighbors(std::list<std::shared_ptr<node>>& result
 }
 
 void vds::dht::dht_route::mark_pinged(
-  const const_data_buffer& target_node,
+  const hash256& target_node,
   const network_address& address)
 {
   auto index = dht_object_id::distance_exp(this->current_node_id_, target_node);
@@ -268,16 +277,16 @@ void vds::dht::dht_route::remove_session(const session_type& session)
 
 vds::dht::dht_route::dht_route(
   const service_provider* sp,
-  const const_data_buffer& this_node_id)
+  const hash256& this_node_id)
   : sp_(sp), current_node_id_(this_node_id) {
 }
 
-const vds::const_data_buffer& vds::dht::dht_route::current_node_id() const
+const vds::hash256& vds::dht::dht_route::current_node_id() const
 {
   return this->current_node_id_;
 }
 
-bool vds::dht::dht_route::add_node(const const_data_buffer& id, const session_type& proxy_session, uint8_t hops, bool allow_skip)
+bool vds::dht::dht_route::add_node(const hash256& id, const session_type& proxy_session, uint8_t hops, bool allow_skip)
 {
   if (id == this->current_node_id_ || proxy_session->partner_node_id() == this->current_node_id_) {
     return false;
@@ -13,9 +13,9 @@ All rights reserved
 vds::dht::network::dht_session::dht_session(
   const service_provider * sp,
   const network_address& address,
-  const const_data_buffer& this_node_id,
+  const hash256& this_node_id,
   asymmetric_public_key partner_node_key,
-  const const_data_buffer& partner_node_id,
+  const hash256& partner_node_id,
   const const_data_buffer& session_key) noexcept
   : base_class(
       sp,
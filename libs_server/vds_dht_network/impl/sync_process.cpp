@@ -26,6 +26,7 @@ All rights reserved
 #include <local_data_dbo.h>
 #include "node_storage_dbo.h"
 #include <transaction_block_builder.h>
+#include "async_file.h"
 
 vds::dht::network::sync_process::sync_process(const service_provider * sp)
   : sp_(sp), sync_replicas_timeout_(0) {
@@ -49,6 +50,7 @@ vds::expected<vds::const_data_buffer> vds::dht::network::sync_process::restore_r
   const const_data_buffer & replica_hash) {
 
   auto client = this->sp_->get<network::client>();
+  GET_EXPECTED(object_id, hash256::create(replica_hash));
 
   std::set<const_data_buffer> candidates;
   orm::sync_replica_map_dbo t5;
@@ -68,21 +70,21 @@ vds::expected<vds::const_data_buffer> vds::dht::network::sync_process::restore_r
         base64::from_bytes(replica_hash).c_str(),
         base64::from_bytes(candidate).c_str());
 
-      final_tasks.push_back([client, candidate, replica_hash]() {
+      final_tasks.push_back([client, candidate, object_id]() {
         return (*client)->send(
           candidate,
           message_create<messages::sync_replica_request>(
-            replica_hash));
+            object_id));
       });
     }
   }
   else {
-    final_tasks.push_back([client, replica_hash]() {
+    final_tasks.push_back([client, replica_hash, object_id]() {
       return (*client)->send_near(
         replica_hash,
         1,
         message_create<messages::sync_replica_request>(
-          replica_hash),
+          object_id),
         [](const dht::dht_route::node& node) -> bool {
           return node.hops_ == 0;
         });
@@ -109,6 +111,7 @@ vds::expected<bool> vds::dht::network::sync_process::prepare_restore_replica(
     return expected<bool>(true);
   }
 
+  GET_EXPECTED(object_id, hash256::create(replica_hash));
   std::set<const_data_buffer> candidates;
   orm::sync_replica_map_dbo t5;
   GET_EXPECTED_VALUE(st, t.get_reader(t5.select(t5.node).where(t5.replica_hash == replica_hash)));
@@ -125,11 +128,11 @@ vds::expected<bool> vds::dht::network::sync_process::prepare_restore_replica(
       "request %s from %s",
       base64::from_bytes(replica_hash).c_str(),
       base64::from_bytes(candidate).c_str());
-    final_tasks.push_back([client, candidate, replica_hash]() {
+    final_tasks.push_back([client, candidate, object_id]() {
       return (*client)->send(
         candidate,
         message_create<messages::sync_replica_request>(
-          replica_hash));
+          object_id));
     });
   }
 
@@ -171,24 +174,27 @@ vds::expected<bool> vds::dht::network::sync_process::apply_message(
     const auto owner = t3.owner.get(st);
     const auto object_hash = t5.object_hash.get(st);
     const auto replica = t5.replica.get(st);
-    GET_EXPECTED(data, file::read_all(filename(foldername(t4.local_path.get(st)), t3.storage_path.get(st))));
+    //The replica is read after the transaction is committed
     final_tasks.push_back([
+      sp = this->sp_,
       client,
-        data,
+        fn = filename(foldername(t4.local_path.get(st)), t3.storage_path.get(st)),
         target_node = message_info.source_node(),
         object_id = message.object_id,
         owner,
         object_hash,
         replica
-    ]() {
-        return (*client)->send(
+    ]() -> async_task<expected<void>> {
+        GET_EXPECTED_ASYNC(data, co_await async_file::read_all(sp, fn));
+        CHECK_EXPECTED_ASYNC(co_await (*client)->send(
           target_node,
           message_create<messages::sync_replica_data>(
             object_id,
             data,
             owner,
             object_hash,
-            replica));
+            replica)));
+        co_return expected<void>();
       });
   }
 
@@ -198,7 +204,7 @@ vds::expected<bool> vds::dht::network::sync_process::apply_message(
 vds::expected<bool> vds::dht::network::sync_process::apply_message(
   database_transaction& t,
   std::list<std::function<async_task<expected<void>>()>> & final_tasks,
-  const messages::sync_replica_data& message,
+  const messages::sync_replica_data_view& message,
   const imessage_map::message_info_t& message_info) {
 
   auto client = this->sp_->get<network::client>();
@@ -218,14 +224,25 @@ vds::expected<bool> vds::dht::network::sync_process::apply_message(
     return false;
   }
 
-    GET_EXPECTED(data_hash, hash::signature(hash::sha256(), message.data));
+    GET_EXPECTED(data_hash, hash::signature(hash::sha256(), message.data.data(), message.data.size()));
     vds_assert(data_hash == message.object_id);
-    GET_EXPECTED(fn, _client::save_data(this->sp_, t, data_hash, message.data, message.owner, message.value_id, message.replica));
-    this->sp_->get<logger>()->trace(
-      SyncModule,
-      "Got replica %s from %s",
-      base64::from_bytes(message.object_id).c_str(),
-      base64::from_bytes(message_info.source_node()).c_str());
+
+    //The message buffer is released with the transaction, so the replica is copied once for the disk write
+    final_tasks.push_back([
+      sp = this->sp_,
+      data_hash,
+      data = message.data.to_buffer(),
+      owner = message.owner.to_buffer(),
+      source_node = message_info.source_node()
+    ]() mutable -> async_task<expected<void>> {
+      GET_EXPECTED_ASYNC(fn, co_await _client::save_data_async(sp, data_hash, std::move(data), owner));
+      sp->get<logger>()->trace(
+        SyncModule,
+        "Got replica %s from %s",
+        base64::from_bytes(data_hash).c_str(),
+        base64::from_bytes(source_node).c_str());
+      co_return expected<void>();
+    });
 
   return true;
 }
@@ -294,27 +311,29 @@ vds::expected<void> vds::dht::network::sync_process::sync_replicas(
             CHECK_EXPECTED(pclient->save(this->sp_, playload, t, false));
           }
           else if (!stored.empty()) {
+            GET_EXPECTED(object_id, hash256::create(replica_hash));
             for (const auto& candidate : stored) {
               this->sp_->get<logger>()->trace(
                 SyncModule,
                 "request %s from %s",
                 base64::from_bytes(replica_hash).c_str(),
                 base64::from_bytes(candidate).c_str());
-              final_tasks.push_back([pclient, candidate, replica_hash]() {
+              final_tasks.push_back([pclient, candidate, object_id]() {
                 return (*pclient)->send(
                   candidate,
                   message_create<messages::sync_replica_request>(
-                    replica_hash));
+                    object_id));
                 });
             }
           } else if(requested_objects.end() == requested_objects.find(object_hash)) {
             requested_objects.emplace(object_hash);
 
             std::vector<const_data_buffer> replicas;
+            auto codec = erasure_codec_id::gf16_vandermonde;
             orm::chunk_replica_data_dbo t1;
             GET_EXPECTED(st, t.get_reader(
               t1
-              .select(t1.replica, t1.replica_hash)
+              .select(t1.replica, t1.replica_hash, t1.codec)
               .where(t1.object_hash == object_hash)
               .order_by(t1.replica)));
             WHILE_EXPECTED(st.execute()) {
@@ -324,14 +343,23 @@ vds::expected<void> vds::dht::network::sync_process::sync_replicas(
                 break;
               }
               replicas.push_back(replica_hash);
+              codec = static_cast<erasure_codec_id>(t1.codec.get(st));
             }
             WHILE_EXPECTED_END()
 
-            auto result = std::make_shared<const_data_buffer>();
-            CHECK_EXPECTED((*pclient)->restore_async(t, final_tasks, replicas, result, std::make_shared<uint8_t>()));
-            
-            if (0 < result->size()) {
-              CHECK_EXPECTED((*pclient)->save_data(this->sp_, t, *result, owner));
+            //No replica of the block is known yet
+            if (!replicas.empty()) {
+              //The replica files are read and written after the transaction is committed
+              final_tasks.push_back([pclient, replicas, codec, owner]() -> async_task<expected<void>> {
+                auto result = std::make_shared<const_data_buffer>();
+                CHECK_EXPECTED_ASYNC(co_await (*pclient)->restore_async(replicas, result));
+
+                if (0 < result->size()) {
+                  CHECK_EXPECTED_ASYNC(co_await (*pclient)->save_replicas_async(codec, std::move(*result), owner));
+                }
+
+                co_return expected<void>();
+              });
             }
           }
         }
@@ -11,6 +11,8 @@ All rights reserved
 #include "logger.h"
 #include "dht_network_client.h"
 #include "dht_network_client_p.h"
+#include "parallel_tasks.h"
+#include "metrics.h"
 
 vds::dht::network::udp_transport::udp_transport(){
 }
@@ -26,7 +28,7 @@ vds::async_task<vds::expected<void>> vds::dht::network::udp_transport::start(
 
   this->MAGIC_LABEL = dev_network ? 0x54445331 : 0x56445331;
 
-  this->send_thread_ = std::make_shared<thread_apartment>(sp);
+  this->send_thread_ = std::make_shared<thread_apartment>(sp, "dht.send_thread");
   this->sp_ = sp;
   GET_EXPECTED_VALUE(this->this_node_id_, node_public_key->fingerprint());
   this->node_public_key_ = node_public_key;
@@ -60,6 +62,11 @@ vds::async_task<vds::expected<void>>
 vds::dht::network::udp_transport::write_async( const udp_datagram& datagram) {
   auto result = std::make_shared<vds::async_result<vds::expected<void>>>();
   this->send_thread_->schedule([result, this, datagram]() ->expected<void> {
+    static auto & sent = metrics::counter("dht.datagram.sent");
+    static auto & sent_bytes = metrics::counter("dht.datagram.sent_bytes");
+    sent.add();
+    sent_bytes.add(datagram.data_size());
+
     auto res = std::make_shared<expected<void>>(this->writer_->write_async(datagram).get());
     mt_service::async(this->sp_, [res, result]() {
       result->set_value(std::move(*res));
@@ -162,9 +169,12 @@ vds::async_task<vds::expected<void>> vds::dht::network::udp_transport::on_timer(
   }
   this->sessions_mutex_.unlock_shared();
 
-  for(auto & s : sessions) {
-    CHECK_EXPECTED_ASYNC(co_await s->on_timer(this->shared_from_this()));
-  }
+  CHECK_EXPECTED_ASYNC(co_await parallel_for_each(
+    std::move(sessions),
+    MAX_TIMER_SESSIONS,
+    [pthis = this->shared_from_this()](const std::shared_ptr<dht_session> & s) {
+    return s->on_timer(pthis);
+  }));
 
   co_return expected<void>();
 }
@@ -194,6 +204,11 @@ vds::async_task<vds::expected<void>> vds::dht::network::udp_transport::continue_
 
     udp_datagram datagram = std::move(datagram_result.value());
 
+    static auto & received = metrics::counter("dht.datagram.received");
+    static auto & received_bytes = metrics::counter("dht.datagram.received_bytes");
+    received.add();
+    received_bytes.add(datagram.data_size());
+
     if (this->sp_->get_shutdown_event().is_shuting_down()) {
       co_return expected<void>();
     }
@@ -209,7 +224,7 @@ vds::async_task<vds::expected<void>> vds::dht::network::udp_transport::continue_
         || *datagram.data() == (uint8_t)protocol_message_type_t::HandshakeBroadcast
         || *datagram.data() == (uint8_t)protocol_message_type_t::Welcome
         || *datagram.data() == (uint8_t)protocol_message_type_t::Failed)) {
-        logger::get(this->sp_)->trace(ThisModule, "Unblock session %s", datagram.address().to_string().c_str());
+        VDS_LOG_TRACE(this->sp_, ThisModule, "Unblock session %s", datagram.address().to_string().c_str());
         session_info.blocked_ = false;
       }
       else {
@@ -280,9 +295,9 @@ vds::async_task<vds::expected<void>> vds::dht::network::udp_transport::continue_
         session_info.session_ = std::make_shared<dht_session>(
           this->sp_,
           datagram.address(),
-          this->this_node_id_,
+          hash256(this->this_node_id_),
           std::move(partner_node_public_key),
-          partner_node_id,
+          hash256(partner_node_id),
           session_info.session_key_);
 
         resizable_data_buffer out_message;
@@ -298,7 +313,7 @@ vds::async_task<vds::expected<void>> vds::dht::network::udp_transport::continue_
 
         session_info.session_mutex_.unlock();
 
-        this->sp_->get<logger>()->debug(ThisModule, "Add session %s", datagram.address().to_string().c_str());
+        VDS_LOG_DEBUG(this->sp_, ThisModule, "Add session %s", datagram.address().to_string().c_str());
         CHECK_EXPECTED_ASYNC(co_await (*this->sp_->get<client>())->add_session(session_info.session_, 0));
 
         CHECK_EXPECTED_ASYNC(out_message.add(bs.move_data()));
@@ -332,16 +347,16 @@ vds::async_task<vds::expected<void>> vds::dht::network::udp_transport::continue_
         auto session = std::make_shared<dht_session>(
           this->sp_,
           datagram.address(),
-          this->this_node_id_,
+          hash256(this->this_node_id_),
           std::move(public_key),
-          partner_id,
+          hash256(partner_id),
           key);
 
         session_info.session_ = session;
         session_info.session_mutex_.unlock();
 
         const auto from_address = datagram.address().to_string();
-        this->sp_->get<logger>()->debug(ThisModule, "Add session %s", from_address.c_str());
+        VDS_LOG_DEBUG(this->sp_, ThisModule, "Add session %s", from_address.c_str());
         CHECK_EXPECTED_ASYNC(co_await (*this->sp_->get<client>())->add_session(session, 0));
         CHECK_EXPECTED_ASYNC(co_await this->sp_->get<imessage_map>()->on_new_session(partner_id));
       }
@@ -353,7 +368,7 @@ vds::async_task<vds::expected<void>> vds::dht::network::udp_transport::continue_
       break;
     }
     case protocol_message_type_t::Failed: {
-      logger::get(this->sp_)->trace(ThisModule, "Block session %s", datagram.address().to_string().c_str());
+      VDS_LOG_TRACE(this->sp_, ThisModule, "Block session %s", datagram.address().to_string().c_str());
       if (session_info.session_) {
         (*this->sp_->get<client>())->remove_session(session_info.session_);
         session_info.session_.reset();
@@ -373,7 +388,7 @@ vds::async_task<vds::expected<void>> vds::dht::network::udp_transport::continue_
           this->shared_from_this(),
           const_data_buffer(datagram.data(), datagram.data_size()));
         if (result.has_error()) {
-          logger::get(this->sp_)->debug(ThisModule, "%s at process message from %s",
+          VDS_LOG_DEBUG(this->sp_, ThisModule, "%s at process message from %s",
             result.error()->what(),
             datagram.address().to_string().c_str());
           failed = true;
@@ -381,7 +396,7 @@ vds::async_task<vds::expected<void>> vds::dht::network::udp_transport::continue_
 
         if (failed) {
           session_info.session_mutex_.lock();
-          logger::get(this->sp_)->trace(ThisModule, "Block session %s", datagram.address().to_string().c_str());
+          VDS_LOG_TRACE(this->sp_, ThisModule, "Block session %s", datagram.address().to_string().c_str());
           (*this->sp_->get<client>())->remove_session(session_info.session_);
           session_info.blocked_ = true;
           session_info.session_.reset();
@@ -394,7 +409,7 @@ vds::async_task<vds::expected<void>> vds::dht::network::udp_transport::continue_
         }
       }
       else {
-        logger::get(this->sp_)->trace(ThisModule, "Block session %s", datagram.address().to_string().c_str());
+        VDS_LOG_TRACE(this->sp_, ThisModule, "Block session %s", datagram.address().to_string().c_str());
         if (session_info.session_) {
           (*this->sp_->get<client>())->remove_session(session_info.session_);
         }
@@ -11,6 +11,7 @@ All rights reserved
 
 #include "udp_socket.h"
 #include "const_data_buffer.h"
+#include "hash256.h"
 #include "udp_datagram_size_exception.h"
 #include "vds_debug.h"
 #include "messages/dht_route_messages.h"
@@ -34,9 +35,9 @@ namespace vds {
         dht_datagram_protocol(
           const service_provider * sp,
           const network_address& address,
-          const const_data_buffer& this_node_id,
+          const hash256& this_node_id,
           asymmetric_public_key partner_node_key,
-          const const_data_buffer& partner_node_id,
+          const hash256& partner_node_id,
           const const_data_buffer& session_key) noexcept;
 
         virtual ~dht_datagram_protocol();
@@ -70,11 +71,11 @@ namespace vds {
           return this->address_;
         }
 
-        const const_data_buffer& this_node_id() const {
+        const hash256& this_node_id() const {
           return this->this_node_id_;
         }
 
-        const const_data_buffer& partner_node_id() const {
+        const hash256& partner_node_id() const {
           return this->partner_node_id_;
         }
 
@@ -97,7 +98,7 @@ namespace vds {
         std::list<session_statistic::time_metric> metrics_;
 
         std::mutex traffic_mutex_;
-        std::map<const_data_buffer /*from*/, std::map<const_data_buffer /*to*/, std::map<uint8_t /*message_type*/, session_statistic::traffic_info /*size*/>>> traffic_;
+        std::map<hash256 /*from*/, std::map<hash256 /*to*/, std::map<uint8_t /*message_type*/, session_statistic::traffic_info /*size*/>>> traffic_;
 
         async_task<vds::expected<void>> send_acknowledgment(
           const std::shared_ptr<iudp_transport>& s);
@@ -128,10 +129,10 @@ namespace vds {
         int check_mtu_;
         int last_sent_;
         network_address address_;
-        const_data_buffer this_node_id_;
+        hash256 this_node_id_;
 
         asymmetric_public_key partner_node_key_;
-        const_data_buffer partner_node_id_;
+        hash256 partner_node_id_;
         const_data_buffer session_key_;
 
         uint16_t mtu_;
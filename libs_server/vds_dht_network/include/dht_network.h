@@ -9,6 +9,7 @@ All rights reserved
 #include "const_data_buffer.h"
 #include "dht_network_client.h"
 #include "asymmetriccrypto.h"
+#include "erasure_codec.h"
 
 namespace vds {
   class server;
@@ -24,6 +25,9 @@ namespace vds {
 
         static constexpr uint64_t BLOCK_SIZE = 32ULL * 1024ULL * MIN_HORCRUX;//32K 
 
+        //Codec of the new blocks. Stored blocks are restored with the codec recorded for them.
+        static constexpr erasure_codec_id ERASURE_CODEC = erasure_codec_id::gf16_vandermonde;
+
         expected<void> register_services(service_registrator& registrator);
         expected<void> start(
           const service_provider * sp,
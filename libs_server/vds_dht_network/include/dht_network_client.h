@@ -8,6 +8,7 @@ All rights reserved
 
 #include "service_provider.h"
 #include "const_data_buffer.h"
+#include "hash256.h"
 #include "route_statistic.h"
 #include "session_statistic.h"
 #include "stream.h"
@@ -88,7 +89,7 @@ namespace vds {
           std::list<std::function<async_task<expected<void>>()>> & final_tasks,
           const chunk_info& block_id);
 
-        const const_data_buffer& current_node_id() const;
+        const hash256& current_node_id() const;
 
         void get_route_statistics(route_statistic& result);
         void get_session_statistics(session_statistic& session_statistic);
@@ -110,6 +111,11 @@ namespace vds {
       };
     }
   }
+
+  template <>
+  struct service_slot<dht::network::client> {
+    static constexpr service_slot_t value = service_slot_t::reserved_1;
+  };
 }
 
 #endif //__VDS_DHT_NETWORK_DTH_NETWORK_CLIENT_H_
@@ -7,6 +7,7 @@ All rights reserved
 */
 
 #include "hash.h"
+#include "hash256.h"
 #include "vds_debug.h"
 #include "binary_serialize.h"
 #include "resizable_data_buffer.h"
@@ -52,6 +53,22 @@ namespace vds {
         return const_data_buffer(p, max_size);
       }
 
+      static hash256 distance(const hash256 &left, const hash256 &right) {
+        return left ^ right;
+      }
+
+      static size_t distance_exp(const hash256 &left, const hash256 &right) {
+        return left.distance_exp(right);
+      }
+
+      static size_t distance_exp(const hash256 &left, const const_data_buffer &right) {
+        return distance_exp(const_data_buffer(left), right);
+      }
+
+      static size_t distance_exp(const const_data_buffer &left, const hash256 &right) {
+        return distance_exp(left, const_data_buffer(right));
+      }
+
       static size_t distance_exp(const const_data_buffer &left, const const_data_buffer &right) {
         const auto min_size = (left.size() < right.size()) ? left.size() : right.size();
 
@@ -106,6 +123,21 @@ namespace vds {
         return const_data_buffer(result.data(), result.size());
       }
 
+      static hash256 generate_random_id(const hash256 &original, size_t exp_index) {
+        hash256 result = original;
+
+        result[exp_index / 8] ^= (0x80 >> (exp_index % 8));
+        result[exp_index / 8] ^= ((0x80 >> (exp_index % 8)) - 1) & static_cast<uint8_t>(std::rand());
+
+        for (size_t i = exp_index / 8 + 1; i < hash256::hash_size; ++i) {
+          result[i] = static_cast<uint8_t>(std::rand());
+        }
+
+        vds_assert(exp_index == distance_exp(original, result));
+
+        return result;
+      }
+
       static expected<const_data_buffer> from_user_email(const std::string & user_email){
         return from_string("email:" + user_email);
       }
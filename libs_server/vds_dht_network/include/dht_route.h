@@ -1,7 +1,7 @@
 #ifndef __VDS_DHT_NETWORK_P2P_ROUTE_H_
 #define __VDS_DHT_NETWORK_P2P_ROUTE_H_
 
-#include "const_data_buffer.h"
+#include "hash256.h"
 #include "logger.h"
 #include "dht_object_id.h"
 #include "legacy.h"
@@ -23,7 +23,7 @@ namespace vds {
       typedef std::shared_ptr<network::dht_session> session_type;
     public:
       struct node : public std::enable_shared_from_this<node>{
-        const_data_buffer node_id_;
+        hash256 node_id_;
         session_type proxy_session_;
         uint8_t pinged_;
         uint8_t hops_;
@@ -31,7 +31,7 @@ namespace vds {
         node();
 
         node(
-            const const_data_buffer &id,
+            const hash256 &id,
             const session_type &proxy_session,
           uint8_t hops);
         node(node&& origin);
@@ -45,19 +45,19 @@ namespace vds {
         bool is_good() const;
 
         void reset(
-            const const_data_buffer &id,
+            const hash256 &id,
             const session_type &proxy_session,
           uint8_t hops);
       };
 
       dht_route(
         const service_provider * sp,
-        const const_data_buffer& this_node_id);
+        const hash256& this_node_id);
 
-      const const_data_buffer& current_node_id() const;
+      const hash256& current_node_id() const;
 
       bool add_node(
-          const const_data_buffer &id,
+          const hash256 &id,
           const session_type &proxy_session,
           uint8_t hops,
         bool allow_skip);
@@ -65,20 +65,20 @@ namespace vds {
       vds::async_task<vds::expected<void>> on_timer(std::shared_ptr<network::iudp_transport> transport);
 
       expected<void>  search_nodes(        
-        const const_data_buffer &target_id,
+        const hash256 &target_id,
         size_t max_count,
         const std::function<expected<bool>(const node & node)>& filter,
-        std::map<const_data_buffer /*distance*/, std::map<const_data_buffer, std::shared_ptr<node>>>& result_nodes) const;
+        std::map<hash256 /*distance*/, std::map<hash256, std::shared_ptr<node>>>& result_nodes) const;
 
       vds::async_task<vds::expected<void>> for_near(
-        const const_data_buffer &target_node_id,
+        const hash256 &target_node_id,
         size_t max_count,
         const std::function<expected<bool>(const node & node)>& filter,
         lambda_holder_t<vds::async_task<vds::expected<bool>>, const std::shared_ptr<node> &> callback) {
 
         std::map<
-            const_data_buffer /*distance*/,
-            std::map<const_data_buffer, std::shared_ptr<node>>> result_nodes;
+            hash256 /*distance*/,
+            std::map<hash256, std::shared_ptr<node>>> result_nodes;
         CHECK_EXPECTED_ASYNC(this->search_nodes(target_node_id, max_count, filter, result_nodes));
 
         for (auto &presult : result_nodes) {
@@ -95,14 +95,14 @@ namespace vds {
       }
       
       vds::expected<void> for_near_sync(
-        const const_data_buffer& target_node_id,
+        const hash256& target_node_id,
         size_t max_count,
         const std::function<expected<bool>(const node & node)>& filter,
         lambda_holder_t<vds::expected<bool>, const std::shared_ptr<node>&> callback) {
 
         std::map<
-          const_data_buffer /*distance*/,
-          std::map<const_data_buffer, std::shared_ptr<node>>> result_nodes;
+          hash256 /*distance*/,
+          std::map<hash256, std::shared_ptr<node>>> result_nodes;
         CHECK_EXPECTED(this->search_nodes(target_node_id, max_count, filter, result_nodes));
 
         for (auto& presult : result_nodes) {
@@ -139,7 +139,7 @@ namespace vds {
         co_return expected<void>();
       }
 
-      void mark_pinged(const const_data_buffer& target_node, const network_address& address);
+      void mark_pinged(const hash256& target_node, const network_address& address);
 
       void get_statistics(route_statistic& result);
       void remove_session(
@@ -148,7 +148,7 @@ namespace vds {
 
     private:
       const service_provider * sp_;
-      const_data_buffer current_node_id_;
+      hash256 current_node_id_;
 
       struct bucket : public std::enable_shared_from_this<bucket> {
         static constexpr size_t MAX_NODES = 8;
@@ -158,7 +158,7 @@ namespace vds {
 
         bool add_node(
             
-            const const_data_buffer &id,
+            const hash256 &id,
             const session_type &proxy_session,
             uint8_t hops,
           bool allow_skip);
@@ -171,9 +171,9 @@ namespace vds {
             const dht_route* owner,
             const std::shared_ptr<network::iudp_transport> & transport);
 
-        bool contains(const const_data_buffer& node_id) const;
+        bool contains(const hash256& node_id) const;
 
-        void mark_pinged(const const_data_buffer& target_node, const network_address& address);
+        void mark_pinged(const hash256& target_node, const network_address& address);
 
         void get_statistics(route_statistic& result);
 
@@ -184,15 +184,15 @@ namespace vds {
       std::map<size_t, std::shared_ptr<bucket>> buckets_;
 
       expected<void> _search_nodes(        
-        const const_data_buffer &target_id,
+        const hash256 &target_id,
         size_t max_count,
         const std::function<expected<bool>(const node & node)>& filter,
-        std::map<const_data_buffer /*distance*/, std::map<const_data_buffer, std::shared_ptr<node>>>& result_nodes) const;
+        std::map<hash256 /*distance*/, std::map<hash256, std::shared_ptr<node>>>& result_nodes) const;
 
       expected<size_t> looking_nodes(
-          const const_data_buffer &target_id,
+          const hash256 &target_id,
           const lambda_holder_t<expected<bool>, const node &> & filter,
-          std::map<const_data_buffer, std::map<const_data_buffer, std::shared_ptr<node>>> &result_nodes,
+          std::map<hash256, std::map<hash256, std::shared_ptr<node>>> &result_nodes,
         size_t index) const;
 
       vds::async_task<vds::expected<void>> ping_buckets(std::shared_ptr<network::iudp_transport> transport);
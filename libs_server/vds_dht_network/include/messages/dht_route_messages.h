@@ -6,6 +6,8 @@ Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
 All rights reserved
 */
 
+#include "hash256.h"
+
 namespace vds {
   namespace dht {
     namespace network {
@@ -105,7 +107,7 @@ namespace vds {
       public:
         static const network::message_type_t message_id = network::message_type_t::dht_find_node;
 
-        const_data_buffer target_id;
+        hash256 target_id;
 
         template <typename visitor_type>
         void visit(visitor_type & v) {
@@ -119,7 +121,7 @@ namespace vds {
         static const network::message_type_t message_id = network::message_type_t::dht_find_node_response;
 
         struct target_node {
-          const_data_buffer target_id_;
+          hash256 target_id_;
           std::string address_;
           uint8_t hops_;
 
@@ -132,7 +134,7 @@ namespace vds {
           }
 
           target_node(
-            const const_data_buffer& target_id,
+            const hash256& target_id,
             const std::string& address,
             uint8_t hops)
             : target_id_(target_id), address_(address), hops_(hops) {
@@ -6,6 +6,8 @@ Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
 All rights reserved
 */
 
+#include "hash256.h"
+
 namespace vds {
   namespace dht {
     namespace messages {
@@ -17,7 +19,7 @@ namespace vds {
       public:
         static const network::message_type_t message_id = network::message_type_t::sync_replica_request;
 
-        const_data_buffer object_id;
+        hash256 object_id;
 
         template <typename visitor_type>
         auto & visit(visitor_type & v) {
@@ -312,7 +314,7 @@ namespace vds {
       public:
         static const network::message_type_t message_id = network::message_type_t::sync_replica_data;
 
-        const_data_buffer object_id;
+        hash256 object_id;
         const_data_buffer data;
         const_data_buffer owner;
         const_data_buffer value_id;
@@ -328,6 +330,28 @@ namespace vds {
             replica);
         }
       };
+
+      //Same wire format as sync_replica_data; the fields point into the received datagram
+      class sync_replica_data_view {
+      public:
+        static const network::message_type_t message_id = network::message_type_t::sync_replica_data;
+
+        hash256 object_id;
+        const_data_view data;
+        const_data_view owner;
+        const_data_view value_id;
+        uint16_t replica;
+
+        template <typename visitor_type>
+        auto & visit(visitor_type & v) {
+          return v(
+            object_id,
+            data,
+            owner,
+            value_id,
+            replica);
+        }
+      };
       ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     }
   }
@@ -49,7 +49,7 @@ namespace vds {
       size_t idle_;
       size_t delay_;
       size_t service_traffic_;
-      std::map<const_data_buffer /*from*/, std::map<const_data_buffer /*to*/, std::map<uint8_t /*message_type*/, traffic_info /*size*/>>> traffic_;
+      std::map<hash256 /*from*/, std::map<hash256 /*to*/, std::map<uint8_t /*message_type*/, traffic_info /*size*/>>> traffic_;
 
       void serialize(std::shared_ptr<json_array>& items) const {
         auto result = std::make_shared<json_object>();
@@ -23,6 +23,7 @@ namespace vds {
       class udp_transport : public iudp_transport {
       public:
         static constexpr uint8_t PROTOCOL_VERSION = 0;
+        static constexpr size_t MAX_TIMER_SESSIONS = 16;
 
         udp_transport();
         udp_transport(const udp_transport&) = delete;
@@ -10,9 +10,11 @@ All rights reserved
 #include "dht_session.h"
 #include "dht_route.h"
 #include "chunk.h"
+#include "erasure_codec.h"
 #include "sync_process.h"
 #include "udp_transport.h"
 #include "imessage_map.h"
+#include "async_semaphore.h"
 
 class mock_server;
 
@@ -25,6 +27,7 @@ namespace vds {
       //class sync_leader_broadcast_request;
       //class sync_add_message_request;
       class sync_replica_data;
+      class sync_replica_data_view;
       class sync_replica_request;
       class dht_pong;
       class dht_ping;
@@ -43,6 +46,8 @@ namespace vds {
 
       class _client : public std::enable_shared_from_this<_client> {
       public:
+        static constexpr size_t MAX_FINAL_TASKS = 16;
+        static constexpr size_t MAX_RESTORE_TASKS = 8;
 
         _client(
           const service_provider * sp,
@@ -65,20 +70,18 @@ namespace vds {
           std::list<std::function<async_task<expected<void>>()>> & final_tasks,
           const const_data_buffer& partner_id);
 
-        static expected<filename> save_data(
+        //Writes the replica file on the disk I/O threads between two short transactions
+        static async_task<expected<filename>> save_data_async(
           const service_provider * sp,
-          database_transaction& t,
-          const const_data_buffer& data_hash,
-          const const_data_buffer& data,
-          const const_data_buffer& owner,
-          const const_data_buffer& value_id,
-          uint16_t replica);
+          const_data_buffer data_hash,
+          const_data_buffer data,
+          const_data_buffer owner);
 
-        expected<void> save_data(
-          const service_provider* sp,
-          database_transaction & t,
-          const const_data_buffer& data,
-          const const_data_buffer& owner);
+        //Encodes the block and stores every replica through save_data_async
+        async_task<expected<void>> save_replicas_async(
+          erasure_codec_id codec,
+          const_data_buffer data,
+          const_data_buffer owner);
 
         static expected<filename> save_data(
           const service_provider * sp,
@@ -91,11 +94,21 @@ namespace vds {
           database_transaction& t,
           const const_data_buffer& value_id,
           const const_data_buffer& value,
-          uint32_t * replica_size);
+          uint32_t * replica_size,
+          erasure_codec_id * codec);
+
+        //Codec of the new blocks; stored blocks are restored with the codec recorded for them
+        erasure_codec_id erasure_codec() const {
+          return this->codec_;
+        }
+
+        void set_erasure_codec(erasure_codec_id codec) {
+          this->codec_ = codec;
+        }
 
         //expected<std::shared_ptr<client_save_stream>> create_save_stream();
 
-        const const_data_buffer& current_node_id() const {
+        const hash256& current_node_id() const {
           return this->route_.current_node_id();
         }
 
@@ -206,7 +219,7 @@ namespace vds {
         expected<bool> apply_message(
           database_transaction& t,
           std::list<std::function<async_task<expected<void>>()>> & final_tasks,
-          const messages::sync_replica_data& message,
+          const messages::sync_replica_data_view& message,
           const imessage_map::message_info_t& message_info);
 
         //expected<bool> apply_message(
@@ -297,7 +310,7 @@ namespace vds {
           const std::vector<const_data_buffer>& replicas_hashes);
 
         async_task<vds::expected<uint8_t>> restore_async(
-          const std::vector<const_data_buffer>& replicas_hashes,
+          std::vector<const_data_buffer> replicas_hashes,
           std::shared_ptr<const_data_buffer> result = std::shared_ptr<const_data_buffer>());
 
         void get_route_statistics(route_statistic& result);
@@ -337,13 +350,18 @@ namespace vds {
         const service_provider * sp_;
         std::shared_ptr<iudp_transport> udp_transport_;
         dht_route route_;
-        std::map<uint16_t, std::unique_ptr<chunk_generator<uint16_t>>> generators_;
+        std::atomic<erasure_codec_id> codec_;
+        std::map<erasure_codec_id, std::unique_ptr<erasure_encoder>> encoders_;
+        std::map<erasure_codec_id, std::unique_ptr<erasure_decoder>> decoders_;
         sync_process sync_process_;
 
         timer update_timer_;
         uint32_t update_route_table_counter_;
         bool update_wellknown_connection_enabled_;
 
+        //Bounds concurrent restore_async calls
+        async_semaphore restore_semaphore_;
+
         vds::async_task<vds::expected<void>> update_route_table();
         vds::expected<void> process_update(
           database_transaction& t,
@@ -383,12 +401,31 @@ namespace vds {
           const const_data_buffer& replica_hash,
           const filename& filename);
 
-        expected<void> restore_async(
+        expected<void> find_replicas(
           database_transaction& t,
           std::list<std::function<async_task<expected<void>>()>> & final_tasks,
-          const std::vector<const_data_buffer>& object_ids,
-          const std::shared_ptr<const_data_buffer>& result,
+          const std::vector<const_data_buffer>& replicas_hashes,
+          erasure_codec_id & codec,
+          std::vector<uint16_t> & replicas,
+          std::vector<filename> & files,
           const std::shared_ptr<uint8_t> & result_progress);
+
+        //Looks for the codec in the store_block records that are not applied yet
+        static expected<bool> find_block_codec(
+          database_read_transaction & t,
+          const const_data_buffer & replica_hash,
+          erasure_codec_id & codec);
+
+        expected<erasure_decoder *> get_decoder(erasure_codec_id codec) const;
+
+        static expected<bool> prepare_save_data(
+          database_transaction& t,
+          const const_data_buffer& data_hash,
+          size_t data_size,
+          const const_data_buffer& owner,
+          filename & fn,
+          std::string & storage_path,
+          const_data_buffer & storage_id);
       };
     }
   }
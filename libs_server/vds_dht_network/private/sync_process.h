@@ -19,6 +19,7 @@ namespace vds {
       //class sync_replica_query_operations_request;
       //class sync_offer_remove_replica_operation_request;
       class sync_replica_data;
+      class sync_replica_data_view;
       class sync_replica_request;
       //class sync_replica_operations_response;
       //class sync_replica_operations_request;
@@ -166,7 +167,7 @@ namespace vds {
         expected<bool> apply_message(
           database_transaction& t,
           std::list<std::function<async_task<expected<void>>()>> & final_tasks,
-          const messages::sync_replica_data& message,
+          const messages::sync_replica_data_view& message,
           const imessage_map::message_info_t& message_info);
         //
         //expected<bool> apply_message(
@@ -247,7 +247,7 @@ vds::expected<bool> vds::transaction_log::sync_process::apply_message(
     "Save log record %s",
     base64::from_bytes(message.record_id).c_str());
 
-  GET_EXPECTED(block, transactions::transaction_block::create(message.data));
+  GET_EXPECTED(block, transactions::transaction_block_view::create(message.data));
   GET_EXPECTED(block_exists, block.exists(t));
   if (block_exists) {
     return false;
@@ -256,19 +256,19 @@ vds::expected<bool> vds::transaction_log::sync_process::apply_message(
   orm::transaction_log_record_dbo t1;
   std::shared_ptr<asymmetric_public_key> write_public_key;
   orm::node_info_dbo t2;
-  GET_EXPECTED(st, t.get_reader(t2.select(t2.public_key, t2.last_activity).where(t2.node_id == block.write_public_key_id())));
+  GET_EXPECTED(st, t.get_reader(t2.select(t2.public_key, t2.last_activity).where(t2.node_id == block.write_public_key_id().to_buffer())));
   GET_EXPECTED(st_execute, st.execute());
   if (st_execute) {
     GET_EXPECTED(write_public_key_data, asymmetric_public_key::parse_der(t2.public_key.get(st)));
     write_public_key = std::make_shared<asymmetric_public_key>(std::move(write_public_key_data));
 
     if (t2.last_activity.get(st) < block.time_point()) {
-      CHECK_EXPECTED(t.execute(t2.update(t2.last_activity = block.time_point()).where(t2.node_id == block.write_public_key_id())));
+      CHECK_EXPECTED(t.execute(t2.update(t2.last_activity = block.time_point()).where(t2.node_id == block.write_public_key_id().to_buffer())));
     }
   }
 
   if (!write_public_key) {
-    GET_EXPECTED(block, transactions::transaction_block::create(message.data));
+    GET_EXPECTED(block, transactions::transaction_block_view::create(message.data));
     CHECK_EXPECTED(block.walk_messages([&block, &write_public_key](const transactions::node_add_transaction & message)->expected<bool> {
       GET_EXPECTED(node_id, message.node_public_key->fingerprint());
       if (block.write_public_key_id() == node_id) {
@@ -29,7 +29,7 @@ vds::expected<vds::transactions::transaction_block> vds::transactions::transacti
   const_data_buffer write_public_key_id;
   CHECK_EXPECTED(s >> write_public_key_id);
 
-  std::set<const_data_buffer> ancestors;
+  std::set<hash256> ancestors;
   CHECK_EXPECTED(s >> ancestors);
 
   const_data_buffer block_messages;
@@ -41,7 +41,7 @@ vds::expected<vds::transactions::transaction_block> vds::transactions::transacti
   return transaction_block(
     version,
     std::chrono::system_clock::from_time_t(time_point),
-    std::move(id),
+    hash256(id),
     order_no,
     std::move(write_public_key_id),
     std::move(ancestors),
@@ -49,6 +49,53 @@ vds::expected<vds::transactions::transaction_block> vds::transactions::transacti
     std::move(signature));
 }
 
+vds::expected<vds::transactions::transaction_block_view> vds::transactions::transaction_block_view::create(const const_data_buffer& data) {
+
+  transaction_block_view result;
+  GET_EXPECTED(id, hash::signature(hash::sha256(), data));
+  result.id_ = hash256(id);
+
+  binary_deserializer s(data);
+  CHECK_EXPECTED(s >> result.version_);
+
+  if (result.version_ != transaction_block::CURRENT_VERSION) {
+    return vds::make_unexpected<std::runtime_error>("Invalid block version");
+  }
+
+  uint64_t time_point;
+  CHECK_EXPECTED(s >> time_point);
+  result.time_point_ = std::chrono::system_clock::from_time_t(time_point);
+
+  CHECK_EXPECTED(s >> result.order_no_);
+  CHECK_EXPECTED(s >> result.write_public_key_id_);
+  CHECK_EXPECTED(s >> result.ancestors_);
+  CHECK_EXPECTED(s >> result.block_messages_);
+
+  result.signed_data_ = const_data_view(data.data(), data.size() - s.size());
+  CHECK_EXPECTED(s >> result.signature_);
+
+  return result;
+}
+
+vds::expected<bool> vds::transactions::transaction_block_view::validate(const asymmetric_public_key& write_public_key) const {
+  return asymmetric_sign_verify::verify(
+    hash::sha256(),
+    write_public_key,
+    this->signature_.to_buffer(),
+    this->signed_data_.data(),
+    this->signed_data_.size());
+}
+
+vds::expected<bool> vds::transactions::transaction_block_view::exists(database_transaction& t) const {
+  orm::transaction_log_record_dbo t1;
+  GET_EXPECTED(st, t.get_reader(
+    t1
+    .select(t1.state)
+    .where(t1.id == this->id())));
+
+  return st.execute();
+}
+
 vds::expected<vds::const_data_buffer> vds::transactions::transaction_block::build(
   database_transaction& t,
   const const_data_buffer& messages,
@@ -62,7 +109,7 @@ vds::expected<vds::const_data_buffer> vds::transactions::transaction_block::buil
   GET_EXPECTED(st, t.get_reader(
     t1.select(t1.id, t1.order_no)
     .where(t1.state == orm::transaction_log_record_dbo::state_t::leaf)));
-  std::set<const_data_buffer> ancestors;
+  std::set<hash256> ancestors;
   uint64_t order_no = 0;
   WHILE_EXPECTED(st.execute())
     ancestors.emplace(t1.id.get(st));
@@ -80,13 +80,13 @@ vds::expected<vds::const_data_buffer> vds::transactions::transaction_log::save(
 vds::expected<void> vds::transactions::transaction_log::process_block_with_followers(
   const service_provider * sp,
   database_transaction & t,
-  const const_data_buffer & block_id,
+  const hash256 & block_id,
   const const_data_buffer & block_data,
   orm::transaction_log_record_dbo::state_t state,
   bool in_consensus)
 {
-  std::map<const_data_buffer, std::tuple<const_data_buffer, orm::transaction_log_record_dbo::state_t, bool>> not_processed;
-  std::set<const_data_buffer> processed;
+  std::map<hash256, std::tuple<const_data_buffer, orm::transaction_log_record_dbo::state_t, bool>> not_processed;
+  std::set<hash256> processed;
 
   not_processed[block_id] = std::make_tuple(block_data, state, in_consensus);
 
@@ -109,11 +109,11 @@ vds::expected<void> vds::transactions::transaction_log::process_block_with_follo
     }
 
     //process followers
-    std::set<const_data_buffer> followers;
+    std::set<hash256> followers;
     orm::transaction_log_hierarchy_dbo t4;
     GET_EXPECTED(st, t.get_reader(t4.select(t4.follower_id).where(t4.id == current_block.id())));
     WHILE_EXPECTED(st.execute()) {
-      const auto follower_id = t4.follower_id.get(st);
+      GET_EXPECTED(follower_id, hash256::create(t4.follower_id.get(st)));
       if (follower_id) {
         followers.emplace(follower_id);
       }
@@ -154,7 +154,7 @@ vds::expected<vds::orm::transaction_log_record_dbo::state_t> vds::transactions::
   orm::transaction_log_vote_request_dbo t2;
 
   //Check ancestors
-  std::set<const_data_buffer> remove_leaf;
+  std::set<hash256> remove_leaf;
   auto state = orm::transaction_log_record_dbo::state_t::leaf;
   std::set<const_data_buffer> vote_requests;
   for (const auto & ancestor : block.ancestors()) {
@@ -252,13 +252,14 @@ vds::expected<vds::orm::transaction_log_record_dbo::state_t> vds::transactions::
 
 vds::expected<void> vds::transactions::transaction_log::process_followers(const service_provider * sp, database_transaction & t)
 {
-  std::map<const_data_buffer, std::tuple<const_data_buffer, orm::transaction_log_record_dbo::state_t, bool>> not_processed;
-  std::set<const_data_buffer> processed;
+  std::map<hash256, std::tuple<const_data_buffer, orm::transaction_log_record_dbo::state_t, bool>> not_processed;
+  std::set<hash256> processed;
 
   orm::transaction_log_record_dbo t1;
   GET_EXPECTED(st, t.get_reader(t1.select(t1.id, t1.data, t1.consensus).where(t1.state == orm::transaction_log_record_dbo::state_t::leaf)));
   WHILE_EXPECTED(st.execute()) {
-    not_processed[t1.id.get(st)] = std::make_tuple(t1.data.get(st), orm::transaction_log_record_dbo::state_t::leaf, t1.consensus.get(st));
+    GET_EXPECTED(id, hash256::create(t1.id.get(st)));
+    not_processed[id] = std::make_tuple(t1.data.get(st), orm::transaction_log_record_dbo::state_t::leaf, t1.consensus.get(st));
   }
   WHILE_EXPECTED_END()
 
@@ -279,11 +280,11 @@ vds::expected<void> vds::transactions::transaction_log::process_followers(const
     }
 
     //process followers
-    std::set<const_data_buffer> followers;
+    std::set<hash256> followers;
     orm::transaction_log_hierarchy_dbo t4;
     GET_EXPECTED(st, t.get_reader(t4.select(t4.follower_id).where(t4.id == current_block.id())));
     WHILE_EXPECTED(st.execute()) {
-      const auto follower_id = t4.follower_id.get(st);
+      GET_EXPECTED(follower_id, hash256::create(t4.follower_id.get(st)));
       if (follower_id) {
         followers.emplace(follower_id);
       }
@@ -322,8 +323,8 @@ vds::expected<bool> vds::transactions::transaction_log::update_consensus(
   orm::transaction_log_record_dbo::state_t state,
   bool in_consensus) {
 
-  std::map<const_data_buffer, std::tuple<const_data_buffer, orm::transaction_log_record_dbo::state_t, bool>> not_processed;
-  std::set<const_data_buffer> processed;
+  std::map<hash256, std::tuple<const_data_buffer, orm::transaction_log_record_dbo::state_t, bool>> not_processed;
+  std::set<hash256> processed;
   std::list<std::tuple<const_data_buffer, const_data_buffer, orm::transaction_log_record_dbo::state_t, bool>> consensus_candidate;
   bool have_invalid_consensus = false;
   uint64_t min_order;
@@ -438,7 +439,7 @@ vds::expected<bool> vds::transactions::transaction_log::update_consensus(
     }
   }
 
-  std::set<const_data_buffer> followers;
+  std::set<hash256> followers;
   orm::transaction_log_hierarchy_dbo t4;
   GET_EXPECTED(st, t.get_reader(
     t4
@@ -447,7 +448,7 @@ vds::expected<bool> vds::transactions::transaction_log::update_consensus(
     .where(
       t1.state == orm::transaction_log_record_dbo::state_t::leaf)));
   WHILE_EXPECTED(st.execute()) {
-    const auto follower_id = t4.follower_id.get(st);
+    GET_EXPECTED(follower_id, hash256::create(t4.follower_id.get(st)));
     if (follower_id && followers.end() == followers.find(follower_id)) {
       followers.emplace(follower_id);
     }
@@ -471,8 +472,8 @@ vds::expected<bool> vds::transactions::transaction_log::update_consensus(
 
 vds::expected<void> vds::transactions::transaction_log::rollback_all(const service_provider * sp, database_transaction & t, uint64_t min_order)
 {
-  std::map<const_data_buffer, const_data_buffer> not_processed;
-  std::set<const_data_buffer> processed;
+  std::map<hash256, const_data_buffer> not_processed;
+  std::set<hash256> processed;
 
   orm::transaction_log_record_dbo t1;
   GET_EXPECTED(st,
@@ -481,7 +482,8 @@ vds::expected<void> vds::transactions::transaction_log::rollback_all(const servi
       .where(t1.state == orm::transaction_log_record_dbo::state_t::leaf && t1.order_no >= safe_cast<int64_t>(min_order) && t1.consensus == false)));
 
   WHILE_EXPECTED(st.execute()) {
-    not_processed[t1.id.get(st)] = t1.data.get(st);
+    GET_EXPECTED(id, hash256::create(t1.id.get(st)));
+    not_processed[id] = t1.data.get(st);
   }
   WHILE_EXPECTED_END()
 
@@ -709,11 +711,11 @@ vds::expected<void> vds::transactions::transaction_log::invalid_block(
       .update(t1.state = (value ? orm::transaction_log_record_dbo::state_t::invalid : orm::transaction_log_record_dbo::state_t::validated))
       .where(t1.id == block_id)));
 
-  std::set<const_data_buffer> followers;
+  std::set<hash256> followers;
   orm::transaction_log_hierarchy_dbo t4;
   GET_EXPECTED(st, t.get_reader(t4.select(t4.follower_id).where(t4.id == block_id)));
   WHILE_EXPECTED (st.execute()) {
-    const auto follower_id = t4.follower_id.get(st);
+    GET_EXPECTED(follower_id, hash256::create(t4.follower_id.get(st)));
     if (follower_id) {
       followers.emplace(follower_id);
     }
@@ -1293,6 +1295,7 @@ vds::expected<bool> vds::transactions::transaction_log::apply_record(
         t1.replica = index,
         t1.replica_hash = message.replicas[index],
         t1.replica_size = message.replica_size,
+        t1.codec = message.codec,
         t1.distance = dht::dht_object_id::distance_exp(client->current_node_id(), message.replicas[index])
       )
     ));
@@ -7,6 +7,7 @@ All rights reserved
 */
 #include <set>
 #include "binary_serialize.h"
+#include "hash256.h"
 #include "database.h"
 #include "asymmetriccrypto.h"
 #include "channel_messages_walker.h"
@@ -23,15 +24,15 @@ namespace vds {
       transaction_block(
         uint32_t version,
         std::chrono::system_clock::time_point && time_point,
-        const_data_buffer && id,
+        const hash256 & id,
         uint64_t order_no,
         const_data_buffer && write_public_key_id,
-        std::set<const_data_buffer> && ancestors,
+        std::set<hash256> && ancestors,
         const_data_buffer && block_messages,
         const_data_buffer && signature)
       : version_(version),
         time_point_(std::move(time_point)),
-        id_(std::move(id)),
+        id_(id),
         order_no_(order_no),
         write_public_key_id_(std::move(write_public_key_id)),
         ancestors_(std::move(ancestors)),
@@ -64,7 +65,7 @@ namespace vds {
       }
 
 
-      const const_data_buffer & id() const {
+      const hash256 & id() const {
         return this->id_;
       }
 
@@ -76,7 +77,7 @@ namespace vds {
         return this->write_public_key_id_;
       }
 
-      const std::set<const_data_buffer> & ancestors() const {
+      const std::set<hash256> & ancestors() const {
         return this->ancestors_;
       }
 
@@ -138,13 +139,79 @@ namespace vds {
     private:
       uint32_t version_;
       std::chrono::system_clock::time_point time_point_;
-      const_data_buffer id_;
+      hash256 id_;
       uint64_t order_no_;
       const_data_buffer write_public_key_id_;
-      std::set<const_data_buffer> ancestors_;
+      std::set<hash256> ancestors_;
       const_data_buffer block_messages_;
       const_data_buffer signature_;
     };
+
+    //Parsed block that refers to the source buffer instead of copying the payload.
+    //The source buffer must outlive the view.
+    class transaction_block_view {
+    public:
+      transaction_block_view() = default;
+
+      static expected<transaction_block_view> create(const const_data_buffer& data);
+
+      const uint32_t & version() const {
+        return this->version_;
+      }
+
+      std::chrono::system_clock::time_point time_point() const {
+        return this->time_point_;
+      }
+
+      const hash256 & id() const {
+        return this->id_;
+      }
+
+      uint64_t order_no() const {
+        return this->order_no_;
+      }
+
+      const const_data_view & write_public_key_id() const {
+        return this->write_public_key_id_;
+      }
+
+      const std::set<hash256> & ancestors() const {
+        return this->ancestors_;
+      }
+
+      const const_data_view & block_messages() const {
+        return this->block_messages_;
+      }
+
+      const const_data_view & signature() const {
+        return this->signature_;
+      }
+
+      //Verifies the signed prefix of the source buffer as is
+      expected<bool> validate(const asymmetric_public_key & write_public_key) const;
+      expected<bool> exists(database_transaction& t) const;
+
+      template <typename... handler_types>
+      expected<bool> walk_messages(
+        handler_types && ... handlers) const {
+
+        transaction_messages_walker_lambdas<handler_types...> walker(
+          std::forward<handler_types>(handlers)...);
+
+        return walker.process(this->block_messages_);
+      }
+
+    private:
+      uint32_t version_;
+      std::chrono::system_clock::time_point time_point_;
+      hash256 id_;
+      uint64_t order_no_;
+      const_data_view write_public_key_id_;
+      std::set<hash256> ancestors_;
+      const_data_view block_messages_;
+      const_data_view signed_data_;
+      const_data_view signature_;
+    };
   }
 }
 #endif //__VDS_TRANSACTIONS_TRANSACTION_BLOCK_H_
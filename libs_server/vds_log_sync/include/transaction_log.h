@@ -7,6 +7,7 @@ All rights reserved
 */
 
 #include "const_data_buffer.h"
+#include "hash256.h"
 #include "transaction_log_record_dbo.h"
 
 namespace vds {
@@ -47,7 +48,7 @@ namespace vds {
       static expected<void> process_block_with_followers(
         const service_provider * sp,
         class database_transaction &t,
-        const const_data_buffer & block_id,
+        const hash256 & block_id,
         const const_data_buffer & block_data,
         orm::transaction_log_record_dbo::state_t state,
         bool in_consensus);
@@ -50,8 +50,8 @@ namespace vds {
         return true;
       }
 
-      expected<bool> process(const const_data_buffer & message_data) {
-        binary_deserializer s(message_data);
+      expected<bool> process(const const_data_view & message_data) {
+        binary_deserializer s(message_data.data(), message_data.size());
 
         while (0 < s.size()) {
           uint8_t message_id;
@@ -114,6 +114,14 @@ namespace vds {
               }
               break;
             }
+            case transactions::store_block_legacy_transaction::message_id: {
+              GET_EXPECTED(message, message_deserialize<store_block_legacy_transaction>(s));
+              GET_EXPECTED(result, this->visit(message.upgrade()));
+              if (!result) {
+                return false;
+              }
+              break;
+            }
             case transactions::host_block_transaction::message_id: {
               GET_EXPECTED(message, message_deserialize<host_block_transaction>(s));
               GET_EXPECTED(result, this->visit(message));
@@ -9,11 +9,14 @@
 #include "messages/sync_messages.h"
 #include "messages/transaction_log_messages.h"
 
-#define route_client(message_type)\
+#define route_client(message_type) route_client_as(message_type, message_type)
+
+//message_class is the type to deserialize into, e.g. a zero-copy view of message_type
+#define route_client_as(message_type, message_class)\
   case dht::network::message_type_t::message_type: {\
     CHECK_EXPECTED_ASYNC(co_await this->sp_->get<db_model>()->async_transaction([message_info, pthis = this->shared_from_this(), &final_tasks, &result](database_transaction & t) -> expected<void> {\
         binary_deserializer s(message_info.message_data());\
-        GET_EXPECTED(message, message_deserialize<dht::messages::message_type>(s));\
+        GET_EXPECTED(message, message_deserialize<dht::messages::message_class>(s));\
         GET_EXPECTED_VALUE(result, (*pthis->sp_->get<dht::network::client>())->apply_message(\
          t,\
          final_tasks,\
@@ -180,7 +183,7 @@ vds::async_task<vds::expected<bool>> vds::_server::process_message(
     //route_client(sync_offer_remove_replica_operation_request)
 
     route_client(sync_replica_request)
-    route_client(sync_replica_data)
+    route_client_as(sync_replica_data, sync_replica_data_view)
     //
     //route_client(sync_replica_query_operations_request)
 
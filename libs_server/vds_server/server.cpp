@@ -129,6 +129,7 @@ vds::async_task<vds::expected<vds::server_statistic>> vds::_server::get_statisti
   GET_EXPECTED_VALUE_ASYNC(result->local_machine_, persistence::local_machine(this->sp_));
   this->sp_->get<dht::network::client>()->get_route_statistics(result->route_statistic_);
   this->sp_->get<dht::network::client>()->get_session_statistics(result->session_statistic_);
+  result->metrics_ = metrics::get_statistic();
 
   co_return *result;
 }
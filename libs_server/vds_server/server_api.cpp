@@ -21,7 +21,7 @@ vds::async_task<vds::expected<vds::server_api::data_info_t>> vds::server_api::up
       &result
     ](database_transaction& t)->expected<void> {
       auto network_client = sp->get<dht::network::client>();
-      GET_EXPECTED_VALUE(result.replicas, (*network_client)->save_temp(t, result.data_hash, body, &result.replica_size));
+      GET_EXPECTED_VALUE(result.replicas, (*network_client)->save_temp(t, result.data_hash, body, &result.replica_size, &result.codec));
 
       return expected<void>();
     }));
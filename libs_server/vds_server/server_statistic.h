@@ -9,6 +9,7 @@ All rights reserved
 #include "route_statistic.h"
 #include "sync_statistic.h"
 #include "session_statistic.h"
+#include "metrics.h"
 
 namespace vds {
 
@@ -18,6 +19,8 @@ namespace vds {
     foldername local_machine_;
     route_statistic route_statistic_;
     session_statistic session_statistic_;
+    metrics_statistic metrics_;
+
     std::shared_ptr<vds::json_value> serialize() const {
       auto result = std::make_shared<vds::json_object>();
       result->add_property("db_queue_length", std::to_string(this->db_queue_length_));
@@ -25,6 +28,39 @@ namespace vds {
       result->add_property("local_machine_folder", this->local_machine_.full_name());
       result->add_property("route", this->route_statistic_.serialize());
       result->add_property("session", this->session_statistic_.serialize());
+      result->add_property("metrics", serialize_metrics(this->metrics_));
+      return result;
+    }
+
+    static std::shared_ptr<vds::json_value> serialize_metrics(const metrics_statistic & metrics) {
+      auto counters = std::make_shared<vds::json_object>();
+      for (const auto & p : metrics.counters_) {
+        counters->add_property(p.first, p.second);
+      }
+
+      auto gauges = std::make_shared<vds::json_object>();
+      for (const auto & p : metrics.gauges_) {
+        gauges->add_property(p.first, std::to_string(p.second));
+      }
+
+      auto histograms = std::make_shared<vds::json_object>();
+      for (const auto & p : metrics.histograms_) {
+        auto item = std::make_shared<vds::json_object>();
+        item->add_property("count", p.second.count);
+        item->add_property("sum", p.second.sum);
+        item->add_property("min", p.second.min);
+        item->add_property("max", p.second.max);
+        item->add_property("p50", p.second.p50);
+        item->add_property("p90", p.second.p90);
+        item->add_property("p99", p.second.p99);
+        item->add_property("p999", p.second.p999);
+        histograms->add_property(p.first, item);
+      }
+
+      auto result = std::make_shared<vds::json_object>();
+      result->add_property("counters", counters);
+      result->add_property("gauges", gauges);
+      result->add_property("histograms", histograms);
       return result;
     }
   };
@@ -478,6 +478,7 @@ vds::websocket_api::upload(const vds::service_provider * sp, std::shared_ptr<jso
   res->add_property("replicas", replicas);
   res->add_property("hash", base64::from_bytes(info.data_hash));
   res->add_property("replica_size", info.replica_size);
+  res->add_property("codec", static_cast<uint32_t>(info.codec));
 
   result->add_property("result", res);
 
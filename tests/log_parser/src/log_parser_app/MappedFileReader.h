@@ -9,6 +9,8 @@ public:
     hMapFile_(NULL),
     view_start_(0),
     data_(NULL),
+    readed_(0),
+    is_eof_(false),
     rest_size_(0)
   {
   }
@@ -89,6 +91,35 @@ public:
     return true;
   }
 
+  //Read up to size bytes, readed is less than size at the end of file
+  bool read(void * buffer, size_t size, size_t & readed) {
+    readed = 0;
+    auto p = reinterpret_cast<char *>(buffer);
+    while (readed < size) {
+      if (0 == rest_size_ && !is_eof_) {
+        if (!next_view()) {
+          return false;
+        }
+      }
+
+      if (is_eof_) {
+        return true;
+      }
+
+      auto n = size - readed;
+      if (n > rest_size_) {
+        n = rest_size_;
+      }
+
+      memcpy(p + readed, current_position_, n);
+      current_position_ += n;
+      rest_size_ -= n;
+      readed += n;
+    }
+
+    return true;
+  }
+
   //read to end of line
   bool skip_to_newline() {
     char ch;
@@ -0,0 +1,60 @@
+#include "stdafx.h"
+#include "VLogReader.h"
+#include "filter_parser.h"
+
+
+CVLogReader::CVLogReader()
+: decoder_(file_reader_)
+{
+}
+
+
+CVLogReader::~CVLogReader()
+{
+  Close();
+}
+
+bool CVLogReader::Open(const TCHAR * filename) {
+  if (!file_reader_.Open(filename)) {
+    return false;
+  }
+
+  return decoder_.read_header();
+}
+
+void CVLogReader::Close() {
+  file_reader_.Close();
+}
+
+bool CVLogReader::SetFilter(const char *filter) {
+  return filter_parser::parse_filter(filter, filter_);
+}
+
+bool CVLogReader::GetNextLine(char * buf, const int bufsize) {
+  if (nullptr == buf || 0 >= bufsize) {
+    return false;
+  }
+
+  for (;;) {
+    if (!decoder_.next_line(line_)) {
+      return false;
+    }
+
+    if (line_.empty()) {
+      *buf = '\0';
+      return true;
+    }
+
+    if (filter_.is_match(line_.c_str())) {
+      //Long lines are truncated to the buffer
+      auto len = line_.length();
+      if (len >= static_cast<size_t>(bufsize)) {
+        len = bufsize - 1;
+      }
+
+      memcpy(buf, line_.c_str(), len);
+      buf[len] = '\0';
+      return true;
+    }
+  }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include "MappedFileReader.h"
+#include "filter_statemachine.h"
+#include "vlog_decoder.h"
+
+//Reader of the binary vds.vlog with the same interface as CLogReader
+class CVLogReader
+{
+public:
+  CVLogReader();
+  ~CVLogReader();
+
+  bool    Open(const TCHAR * filename);   // open file, false - error
+  void    Close();                        // close file
+
+  bool    SetFilter(const char *filter);  // set line filter, false - error
+  bool    GetNextLine(char *buf,          // get next matched line,
+    const int bufsize);                   // empty line - end of file, false - error
+
+private:
+  CMappedFileReader file_reader_;
+  filter_statemachine filter_;
+  vlog_decoder<CMappedFileReader> decoder_;
+  std::string line_;
+};
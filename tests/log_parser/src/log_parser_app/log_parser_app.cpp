@@ -3,22 +3,18 @@
 
 #include "stdafx.h"
 #include "LogReader.h"
+#include "VLogReader.h"
 #include "StringUtils.h"
 
-int _tmain(int argc, TCHAR *argv[]) {
-  if(argc != 3) {
-    puts("Usage: log_parser file pattern");
-    return 1;
-  }
-
-  CLogReader reader;
-  if(!reader.Open(argv[1])) {
-    _tprintf(_T("Open file %s error\n"), argv[1]);
+template <typename reader_type>
+static int print_lines(reader_type & reader, const TCHAR * file, const TCHAR * filter) {
+  if(!reader.Open(file)) {
+    _tprintf(_T("Open file %s error\n"), file);
     return 1;
   }
 
 #ifdef _UNICODE
-  auto pattern = StringUtils::to_mb(argv[2]);
+  auto pattern = StringUtils::to_mb(filter);
   if (!reader.SetFilter(pattern)) {
     free(pattern);
     puts("Set pattern error");
@@ -27,7 +23,7 @@ int _tmain(int argc, TCHAR *argv[]) {
   free(pattern);
 
 #else
-  if (!reader.SetFilter(argv[2])) {
+  if (!reader.SetFilter(filter)) {
     puts("Set pattern error");
     return 1;
   }
@@ -45,3 +41,25 @@ int _tmain(int argc, TCHAR *argv[]) {
   return 1;
 }
 
+//Binary logs are decoded by the file extension
+static bool is_vlog(const TCHAR * file) {
+  static const TCHAR extension[] = _T(".vlog");
+  const auto len = _tcslen(file);
+  const auto ext_len = _tcslen(extension);
+  return len >= ext_len && 0 == _tcsicmp(file + len - ext_len, extension);
+}
+
+int _tmain(int argc, TCHAR *argv[]) {
+  if(argc != 3) {
+    puts("Usage: log_parser file pattern");
+    return 1;
+  }
+
+  if (is_vlog(argv[1])) {
+    CVLogReader reader;
+    return print_lines(reader, argv[1], argv[2]);
+  }
+
+  CLogReader reader;
+  return print_lines(reader, argv[1], argv[2]);
+}
@@ -0,0 +1,344 @@
+#ifndef __LOG_PARSER_VLOG_DECODER_H_
+#define __LOG_PARSER_VLOG_DECODER_H_
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <unordered_map>
+
+//Decoder of the binary log written by vds::binary_log (see kernel/vds_core/binary_log.h for the layout).
+//reader_type should provide bool read(void * buffer, size_t size, size_t & readed),
+//readed less than size means end of file.
+template <typename reader_type>
+class vlog_decoder {
+public:
+  vlog_decoder(reader_type & reader)
+  : reader_(reader) {
+  }
+
+  //Check the file signature
+  bool read_header() {
+    char signature[4];
+    uint32_t version;
+    return read_exact(signature, sizeof(signature))
+      && 0 == memcmp(signature, "VLOG", sizeof(signature))
+      && read_value(version)
+      && 1 == version;
+  }
+
+  //Render the next record in the vds.log text format; empty line at the end of file
+  bool next_line(std::string & line) {
+    line.clear();
+
+    for (;;) {
+      uint8_t block_type;
+      size_t readed;
+      if (!reader_.read(&block_type, sizeof(block_type), readed)) {
+        return false;
+      }
+
+      if (0 == readed) {
+        return true;
+      }
+
+      switch (block_type) {
+      case FORMAT_BLOCK: {
+        uint32_t id;
+        uint8_t level;
+        format_t format;
+        if (!read_value(id) || !read_value(level) || !read_string(format.module) || !read_string(format.format)) {
+          return end_of_data();
+        }
+
+        format.level = level;
+        formats_[id] = format;
+        break;
+      }
+
+      case RECORD_BLOCK: {
+        uint32_t thread_id;
+        uint64_t time;
+        uint32_t format_id;
+        uint16_t args_size;
+        if (!read_value(thread_id) || !read_value(time) || !read_value(format_id) || !read_value(args_size)) {
+          return end_of_data();
+        }
+
+        args_.resize(args_size);
+        if (0 < args_size && !read_exact(&args_[0], args_size)) {
+          return end_of_data();
+        }
+
+        auto p = formats_.find(format_id);
+        if (formats_.end() == p) {
+          render_line(line, time, thread_id, LL_ERROR, "vlog", "Unknown format " + std::to_string(format_id));
+        }
+        else {
+          std::string message;
+          render_message(message, p->second.format.c_str(), args_.data(), args_.size());
+          render_line(line, time, thread_id, p->second.level, p->second.module, message);
+        }
+        return true;
+      }
+
+      case DROPPED_BLOCK: {
+        uint32_t thread_id;
+        uint64_t time;
+        uint64_t count;
+        if (!read_value(thread_id) || !read_value(time) || !read_value(count)) {
+          return end_of_data();
+        }
+
+        render_line(line, time, thread_id, LL_WARNING, "vlog", std::to_string(count) + " records dropped");
+        return true;
+      }
+
+      default:
+        return false;
+      }
+    }
+  }
+
+  //Render the message using printf format and raw arguments
+  static void render_message(std::string & result, const char * format, const char * args, size_t size) {
+    const char * args_end = args + size;
+
+    while ('\0' != *format) {
+      if ('%' != *format) {
+        result += *format++;
+        continue;
+      }
+
+      if ('%' == format[1]) {
+        result += '%';
+        format += 2;
+        continue;
+      }
+
+      std::string spec("%");
+      ++format;
+      while ('\0' != *format && nullptr != strchr("-+ #0", *format)) {
+        spec += *format++;
+      }
+
+      if (!copy_number(spec, format, args, args_end)) {
+        return;
+      }
+
+      if ('.' == *format) {
+        spec += *format++;
+        if (!copy_number(spec, format, args, args_end)) {
+          return;
+        }
+      }
+
+      //Length modifiers are replaced by the stored argument size
+      while ('\0' != *format && nullptr != strchr("hlLqjztI0123456789", *format)) {
+        ++format;
+      }
+
+      if ('\0' == *format) {
+        return;
+      }
+
+      const char conversion = *format++;
+
+      char tag;
+      uint64_t value;
+      std::string str;
+      if (!read_arg(args, args_end, tag, value, str)) {
+        result += "<?>";
+        continue;
+      }
+
+      switch (tag) {
+      case 'i':
+        if ('c' == conversion) {
+          append_format(result, spec + "c", static_cast<int>(value));
+        }
+        else if (nullptr != strchr("ouxX", conversion)) {
+          append_format(result, spec + "ll" + conversion, static_cast<unsigned long long>(value));
+        }
+        else {
+          append_format(result, spec + "lld", static_cast<long long>(value));
+        }
+        break;
+
+      case 'u':
+        if ('c' == conversion) {
+          append_format(result, spec + "c", static_cast<int>(value));
+        }
+        else if (nullptr != strchr("ouxX", conversion)) {
+          append_format(result, spec + "ll" + conversion, static_cast<unsigned long long>(value));
+        }
+        else {
+          append_format(result, spec + "llu", static_cast<unsigned long long>(value));
+        }
+        break;
+
+      case 'd': {
+        double v;
+        memcpy(&v, &value, sizeof(v));
+        append_format(result, spec + ((nullptr != strchr("fFeEgGaA", conversion)) ? conversion : 'g'), v);
+        break;
+      }
+
+      case 'p':
+        result += "0x";
+        append_format(result, spec + "llx", static_cast<unsigned long long>(value));
+        break;
+
+      case 's':
+        append_format(result, spec + "s", str.c_str());
+        break;
+      }
+    }
+  }
+
+private:
+  static constexpr uint8_t FORMAT_BLOCK = 1;
+  static constexpr uint8_t RECORD_BLOCK = 2;
+  static constexpr uint8_t DROPPED_BLOCK = 3;
+
+  static constexpr int LL_WARNING = 3;
+  static constexpr int LL_ERROR = 4;
+
+  struct format_t {
+    int level;
+    std::string module;
+    std::string format;
+  };
+
+  reader_type & reader_;
+  std::unordered_map<uint32_t, format_t> formats_;
+  std::string args_;
+
+  bool read_exact(void * buffer, size_t size) {
+    size_t readed;
+    return reader_.read(buffer, size, readed) && readed == size;
+  }
+
+  //A truncated last block is left by a crash while writing
+  static bool end_of_data() {
+    return true;
+  }
+
+  template <typename value_type>
+  bool read_value(value_type & value) {
+    uint8_t buffer[sizeof(value_type)];
+    if (!read_exact(buffer, sizeof(buffer))) {
+      return false;
+    }
+
+    uint64_t result = 0;
+    for (size_t i = 0; i < sizeof(value_type); ++i) {
+      result |= static_cast<uint64_t>(buffer[i]) << (8 * i);
+    }
+    value = static_cast<value_type>(result);
+    return true;
+  }
+
+  bool read_string(std::string & value) {
+    uint16_t len;
+    if (!read_value(len)) {
+      return false;
+    }
+
+    value.resize(len);
+    return 0 == len || read_exact(&value[0], len);
+  }
+
+  static bool read_arg(const char *& args, const char * args_end, char & tag, uint64_t & value, std::string & str) {
+    if (args == args_end) {
+      return false;
+    }
+
+    tag = *args++;
+    if ('s' == tag) {
+      if (args_end - args < 2) {
+        return false;
+      }
+
+      const size_t len = static_cast<uint8_t>(args[0]) | (static_cast<size_t>(static_cast<uint8_t>(args[1])) << 8);
+      args += 2;
+      if (static_cast<size_t>(args_end - args) < len) {
+        return false;
+      }
+
+      str.assign(args, len);
+      args += len;
+      return true;
+    }
+
+    if (args_end - args < 8) {
+      return false;
+    }
+
+    value = 0;
+    for (int i = 0; i < 8; ++i) {
+      value |= static_cast<uint64_t>(static_cast<uint8_t>(args[i])) << (8 * i);
+    }
+    args += 8;
+    return (nullptr != strchr("iudp", tag));
+  }
+
+  //Width or precision, '*' takes the next argument
+  static bool copy_number(std::string & spec, const char *& format, const char *& args, const char * args_end) {
+    if ('*' == *format) {
+      ++format;
+
+      char tag;
+      uint64_t value;
+      std::string str;
+      if (!read_arg(args, args_end, tag, value, str)) {
+        return false;
+      }
+
+      spec += std::to_string(static_cast<long long>(value));
+      return true;
+    }
+
+    while ('0' <= *format && *format <= '9') {
+      spec += *format++;
+    }
+    return true;
+  }
+
+  template <typename value_type>
+  static void append_format(std::string & result, const std::string & spec, value_type value) {
+    char buffer[256];
+    auto len = snprintf(buffer, sizeof(buffer), spec.c_str(), value);
+    if (0 > len) {
+      return;
+    }
+
+    if (static_cast<size_t>(len) < sizeof(buffer)) {
+      result.append(buffer, len);
+    }
+    else {
+      std::string big(len + 1, '\0');
+      snprintf(&big[0], big.size(), spec.c_str(), value);
+      result.append(big.c_str(), len);
+    }
+  }
+
+  //Same layout as vds::file_logger
+  static void render_line(std::string & line, uint64_t time, uint32_t thread_id, int level, const std::string & module, const std::string & message) {
+    static const char * levels[] = { "TRACE", "DEBUG", "INFO", "WARNING", "ERROR" };
+
+    auto t = static_cast<time_t>(time / 1000000000);
+    auto tm = localtime(&t);
+
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "%04d/%02d/%0d %02d:%02d.%02d %-6u %-6s [%-10s] ",
+      tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday, tm->tm_hour, tm->tm_min, tm->tm_sec,
+      thread_id, (0 <= level && level <= LL_ERROR) ? levels[level] : "?", module.c_str());
+
+    line = buffer;
+    line += message;
+  }
+};
+
+#endif//__LOG_PARSER_VLOG_DECODER_H_
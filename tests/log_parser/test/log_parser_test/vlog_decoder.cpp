@@ -0,0 +1,131 @@
+#include "stdafx.h"
+#include <vector>
+#include "vlog_decoder.h"
+
+class memory_reader {
+public:
+  memory_reader(const std::vector<uint8_t> & data)
+  : data_(data), position_(0) {
+  }
+
+  bool read(void * buffer, size_t size, size_t & readed) {
+    readed = data_.size() - position_;
+    if (readed > size) {
+      readed = size;
+    }
+
+    memcpy(buffer, data_.data() + position_, readed);
+    position_ += readed;
+    return true;
+  }
+
+private:
+  const std::vector<uint8_t> & data_;
+  size_t position_;
+};
+
+class vlog_builder {
+public:
+  vlog_builder() {
+    data.insert(data.end(), { 'V', 'L', 'O', 'G' });
+    put(4, 1);
+  }
+
+  void format(uint32_t id, uint8_t level, const std::string & module, const std::string & format) {
+    put(1, 1);
+    put(4, id);
+    put(1, level);
+    put_string(module);
+    put_string(format);
+  }
+
+  void record(uint32_t thread_id, uint32_t format_id, const std::vector<uint8_t> & args) {
+    put(1, 2);
+    put(4, thread_id);
+    put(8, 0);
+    put(4, format_id);
+    put(2, args.size());
+    data.insert(data.end(), args.begin(), args.end());
+  }
+
+  static void arg(std::vector<uint8_t> & args, char tag, uint64_t value) {
+    args.push_back(tag);
+    for (int i = 0; i < 8; ++i) {
+      args.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+  }
+
+  static void arg(std::vector<uint8_t> & args, const std::string & value) {
+    args.push_back('s');
+    args.push_back(static_cast<uint8_t>(value.length()));
+    args.push_back(static_cast<uint8_t>(value.length() >> 8));
+    args.insert(args.end(), value.begin(), value.end());
+  }
+
+  std::vector<uint8_t> data;
+
+private:
+  void put(size_t size, uint64_t value) {
+    for (size_t i = 0; i < size; ++i) {
+      data.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+  }
+
+  void put_string(const std::string & value) {
+    put(2, value.length());
+    data.insert(data.end(), value.begin(), value.end());
+  }
+};
+
+static std::string message(const std::string & line) {
+  auto p = line.find('[');
+  return (std::string::npos == p) ? std::string() : line.substr(p);
+}
+
+TEST(test_vlog, test_render)
+{
+  std::vector<uint8_t> args;
+  vlog_builder::arg(args, 'i', static_cast<uint64_t>(-42));
+  vlog_builder::arg(args, 'u', 255);
+  vlog_builder::arg(args, "text");
+  vlog_builder::arg(args, 'u', 7);
+
+  std::string result;
+  vlog_decoder<memory_reader>::render_message(result, "%d %02x [%5s] %zu%% %d", reinterpret_cast<const char *>(args.data()), args.size());
+  ASSERT_EQ("-42 ff [ text] 7% <?>", result);
+}
+
+TEST(test_vlog, test_decode)
+{
+  vlog_builder builder;
+  builder.format(1, 2, "UserMng", "Create user %s");
+  builder.format(2, 4, "DHT", "Ping %d failed");
+
+  std::vector<uint8_t> args;
+  vlog_builder::arg(args, "root");
+  builder.record(10, 1, args);
+
+  args.clear();
+  vlog_builder::arg(args, 'i', 3);
+  builder.record(11, 2, args);
+
+  memory_reader reader(builder.data);
+  vlog_decoder<memory_reader> decoder(reader);
+  ASSERT_TRUE(decoder.read_header());
+
+  std::string line;
+  ASSERT_TRUE(decoder.next_line(line));
+  ASSERT_EQ("[UserMng   ] Create user root", message(line));
+  ASSERT_NE(std::string::npos, line.find(" INFO   "));
+
+  filter_statemachine statemachine;
+  ASSERT_TRUE(filter_parser::parse_filter("*ERROR*DHT*failed", statemachine));
+  ASSERT_FALSE(statemachine.is_match(line.c_str()));
+
+  ASSERT_TRUE(decoder.next_line(line));
+  ASSERT_EQ("[DHT       ] Ping 3 failed", message(line));
+  ASSERT_TRUE(statemachine.is_match(line.c_str()));
+
+  ASSERT_TRUE(decoder.next_line(line));
+  ASSERT_TRUE(line.empty());
+}
@@ -0,0 +1,69 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include <atomic>
+#include "async_task.h"
+#include "test_config.h"
+
+static constexpr int await_iterations = 10000;
+
+static vds::async_task<vds::expected<int>> ready_value(int v) {
+  co_return v;
+}
+
+static vds::async_task<vds::expected<int>> await_ready_value(int v) {
+  GET_EXPECTED_ASYNC(result, co_await ready_value(v));
+  co_return result + 1;
+}
+
+static vds::async_task<vds::expected<int>> await_result(vds::async_task<vds::expected<int>> && f) {
+  GET_EXPECTED_ASYNC(result, co_await std::move(f));
+  co_return result + 1;
+}
+
+struct await_frames {
+  uint64_t allocations;
+  uint64_t heap_allocations;
+};
+
+//Coroutine frames are counted by async_frame_pool; frames which missed the pool came from the heap.
+//The timing of the same loops is in vds_bench.
+template <typename body_type>
+static await_frames count_frames(body_type && body) {
+  const auto frames = vds::async_frame_pool::get_statistic();
+  for (int i = 0; i < await_iterations; ++i) {
+    body(i);
+  }
+  const auto frames_after = vds::async_frame_pool::get_statistic();
+
+  await_frames result;
+  result.allocations = frames_after.allocations - frames.allocations;
+  result.heap_allocations = (frames_after.allocations - frames_after.pool_hits) - (frames.allocations - frames.pool_hits);
+  return result;
+}
+
+TEST(code_tests, test_await_frame_pool) {
+  //co_await of a task which is already complete
+  const auto ready = count_frames([](int i) {
+    auto r = await_ready_value(i).get();
+    ASSERT_EQ(r.value(), i + 1);
+  });
+
+  //co_await suspends and the producer completes the task later
+  const auto suspended = count_frames([](int i) {
+    vds::async_result<vds::expected<int>> p;
+    auto f = await_result(p.get_future());
+    p.set_value(i);
+    auto r = f.get();
+    ASSERT_EQ(r.value(), i + 1);
+  });
+
+  //Frames are freed on the same thread, so the next iteration takes them from the pool
+  ASSERT_LE(uint64_t(await_iterations), ready.allocations);
+  ASSERT_GT(ready.allocations, 100 * ready.heap_allocations);
+  ASSERT_LE(uint64_t(await_iterations), suspended.allocations);
+  ASSERT_GT(suspended.allocations, 100 * suspended.heap_allocations);
+}
@@ -0,0 +1,75 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include "async_file.h"
+#include "file.h"
+#include "foldername.h"
+#include "mt_service.h"
+#include "test_config.h"
+
+TEST(core_tests, test_async_file) {
+  vds::service_registrator registrator;
+  vds::mt_service mt_service;
+  vds::async_file_service async_file_service;
+  registrator.add(mt_service);
+  registrator.add(async_file_service);
+
+  GET_EXPECTED_GTEST(sp, registrator.build());
+  CHECK_EXPECTED_GTEST(registrator.start());
+
+  std::vector<uint8_t> data(300 * 1024);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<uint8_t>(i * 7);
+  }
+
+  const vds::foldername folder("test_async_file");
+  if (folder.exist()) {
+    CHECK_EXPECTED_GTEST(folder.delete_folder(true));
+  }
+
+  const vds::filename fn(folder, "test_async_file.bin");
+  CHECK_EXPECTED_GTEST(vds::async_file::write_all(sp, fn, vds::const_data_buffer(data.data(), data.size())).get());
+
+  GET_EXPECTED_GTEST(result, vds::async_file::read_all(sp, fn).get());
+  ASSERT_EQ(vds::const_data_buffer(data.data(), data.size()), result);
+
+  //Concurrent writes of the same file all succeed and leave no temporary files
+  const vds::filename shared_fn(folder, "test_async_file.shared");
+  std::vector<vds::async_task<vds::expected<void>>> writes;
+  for (int i = 0; i < 8; ++i) {
+    writes.push_back(vds::async_file::write_all(sp, shared_fn, vds::const_data_buffer(data.data(), data.size())));
+  }
+  for (auto & write : writes) {
+    CHECK_EXPECTED_GTEST(write.get());
+  }
+
+  size_t file_count = 0;
+  CHECK_EXPECTED_GTEST(folder.files([&file_count](const vds::filename &) -> vds::expected<bool> {
+    ++file_count;
+    return true;
+  }));
+  ASSERT_EQ(2, file_count);
+
+  GET_EXPECTED_GTEST(shared, vds::async_file::read_all(sp, shared_fn).get());
+  ASSERT_EQ(vds::const_data_buffer(data.data(), data.size()), shared);
+
+  const vds::filename empty_fn(folder, "test_async_file.empty");
+  CHECK_EXPECTED_GTEST(vds::async_file::write_all(sp, empty_fn, vds::const_data_buffer()).get());
+  GET_EXPECTED_GTEST(empty, vds::async_file::read_all(sp, empty_fn).get());
+  ASSERT_EQ(0, empty.size());
+
+  ASSERT_TRUE(vds::async_file::read_all(sp, vds::filename("test_async_file.missing")).get().has_error());
+
+  const vds::filename moved(folder, "test_async_file.moved");
+  CHECK_EXPECTED_GTEST(vds::async_file::move(sp, fn, moved).get());
+  ASSERT_FALSE(vds::file::exists(fn));
+
+  CHECK_EXPECTED_GTEST(vds::async_file::delete_file(sp, moved).get());
+  ASSERT_FALSE(vds::file::exists(moved));
+  CHECK_EXPECTED_GTEST(folder.delete_folder(true));
+
+  CHECK_EXPECTED_GTEST(registrator.shutdown());
+}
@@ -0,0 +1,105 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include <atomic>
+#include <thread>
+#include "async_semaphore.h"
+#include "async_shared_mutex.h"
+#include "parallel_tasks.h"
+#include "test_config.h"
+
+static vds::async_task<vds::expected<void>> delay_async(int delay_ms) {
+  auto r = std::make_shared<vds::async_result<vds::expected<void>>>();
+  std::thread([r, delay_ms]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+    r->set_value(vds::expected<void>());
+  }).detach();
+  return r->get_future();
+}
+
+static void update_max(std::atomic<int> & max_value, int value) {
+  auto current = max_value.load();
+  while (current < value && !max_value.compare_exchange_weak(current, value)) {
+  }
+}
+
+TEST(code_tests, test_async_semaphore) {
+  vds::async_semaphore semaphore(3);
+  std::atomic<int> in_flight(0);
+  std::atomic<int> max_in_flight(0);
+  std::atomic<int> done(0);
+
+  std::vector<vds::async_task<vds::expected<void>>> tasks;
+  for (int i = 0; i < 20; ++i) {
+    tasks.push_back([](vds::async_semaphore & semaphore, std::atomic<int> & in_flight, std::atomic<int> & max_in_flight, std::atomic<int> & done, int i)
+      -> vds::async_task<vds::expected<void>> {
+      auto guard = co_await semaphore.scoped_acquire();
+      update_max(max_in_flight, ++in_flight);
+      CHECK_EXPECTED_ASYNC(co_await delay_async(1 + i % 4));
+      --in_flight;
+      ++done;
+      co_return vds::expected<void>();
+    }(semaphore, in_flight, max_in_flight, done, i));
+  }
+
+  CHECK_EXPECTED_GTEST(vds::when_all(std::move(tasks)).get());
+  ASSERT_EQ(20, done);
+  ASSERT_EQ(3, max_in_flight);
+  ASSERT_EQ(3, semaphore.available());
+
+  ASSERT_TRUE(semaphore.try_acquire());
+  semaphore.release();
+}
+
+TEST(code_tests, test_async_shared_mutex) {
+  vds::async_shared_mutex mutex;
+  std::atomic<int> readers(0);
+  std::atomic<int> max_readers(0);
+  std::atomic<int> writers(0);
+  std::atomic<bool> is_overlapped(false);
+
+  std::vector<vds::async_task<vds::expected<void>>> tasks;
+  for (int i = 0; i < 30; ++i) {
+    if (0 == i % 5) {
+      tasks.push_back([](vds::async_shared_mutex & mutex, std::atomic<int> & readers, std::atomic<int> & writers, std::atomic<bool> & is_overlapped)
+        -> vds::async_task<vds::expected<void>> {
+        co_await mutex.lock();
+        if (0 != readers || 0 != writers++) {
+          is_overlapped = true;
+        }
+        auto result = co_await delay_async(2);
+        --writers;
+        mutex.unlock();
+        co_return result;
+      }(mutex, readers, writers, is_overlapped));
+    }
+    else {
+      tasks.push_back([](vds::async_shared_mutex & mutex, std::atomic<int> & readers, std::atomic<int> & max_readers, std::atomic<int> & writers, std::atomic<bool> & is_overlapped)
+        -> vds::async_task<vds::expected<void>> {
+        co_await mutex.lock_shared();
+        update_max(max_readers, ++readers);
+        if (0 != writers) {
+          is_overlapped = true;
+        }
+        auto result = co_await delay_async(2);
+        --readers;
+        mutex.unlock_shared();
+        co_return result;
+      }(mutex, readers, max_readers, writers, is_overlapped));
+    }
+  }
+
+  CHECK_EXPECTED_GTEST(vds::when_all(std::move(tasks)).get());
+  ASSERT_FALSE(is_overlapped);
+  ASSERT_LT(1, max_readers);
+
+  ASSERT_TRUE(mutex.try_lock());
+  ASSERT_FALSE(mutex.try_lock_shared());
+  mutex.unlock();
+  ASSERT_TRUE(mutex.try_lock_shared());
+  ASSERT_FALSE(mutex.try_lock());
+  mutex.unlock_shared();
+}
@@ -60,3 +60,17 @@ TEST(code_tests, async_future1) {
   GET_EXPECTED_GTEST(tr, test_result.get());
   ASSERT_EQ(tr, "10");
 }
+
+TEST(code_tests, async_then_outlives_task) {
+  auto r = std::make_shared<vds::async_result<vds::expected<std::string>>>();
+  bool called = false;
+  {
+    auto f = r->get_future();
+    f.then([&called]() { called = true; });
+  }
+
+  //The task is gone, the continuation still holds the state
+  r->set_value(std::string("done"));
+  r.reset();
+  ASSERT_TRUE(called);
+}
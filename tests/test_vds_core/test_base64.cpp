@@ -0,0 +1,145 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include <random>
+#include "encoding.h"
+#include "test_config.h"
+
+//The byte-at-a-time encoder which base64 used before the vector codecs.
+//Kept here as the reference for the results; vds_bench times both.
+static std::string legacy_from_bytes(const uint8_t * data, size_t len) {
+  static const char lookup[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string result;
+  result.reserve(((len / 3) + ((len % 3 > 0) ? 1 : 0)) * 4);
+  uint32_t temp;
+
+  for (; 2 < len; len -= 3) {
+    temp = (*data++) << 16;
+    temp += (*data++) << 8;
+    temp += (*data++);
+    result.append(1, lookup[(temp & 0x00FC0000) >> 18]);
+    result.append(1, lookup[(temp & 0x0003F000) >> 12]);
+    result.append(1, lookup[(temp & 0x00000FC0) >> 6]);
+    result.append(1, lookup[(temp & 0x0000003F)]);
+  }
+
+  switch (len) {
+  case 1:
+    temp = *data << 16;
+    result.append(1, lookup[(temp & 0x00FC0000) >> 18]);
+    result.append(1, lookup[(temp & 0x0003F000) >> 12]);
+    result.append(2, '=');
+    break;
+  case 2:
+    temp = (*data++) << 16;
+    temp += *data << 8;
+    result.append(1, lookup[(temp & 0x00FC0000) >> 18]);
+    result.append(1, lookup[(temp & 0x0003F000) >> 12]);
+    result.append(1, lookup[(temp & 0x00000FC0) >> 6]);
+    result.append(1, '=');
+    break;
+  }
+
+  return result;
+}
+
+static bool legacy_to_bytes(const std::string & data, std::vector<uint8_t> & result) {
+  uint32_t temp = 0;
+  size_t quantum = 0;
+  for (auto ch : data) {
+    temp <<= 6;
+    if (ch >= 'A' && ch <= 'Z') {
+      temp |= ch - 'A';
+    }
+    else if (ch >= 'a' && ch <= 'z') {
+      temp |= ch - 'a' + 26;
+    }
+    else if (ch >= '0' && ch <= '9') {
+      temp |= ch - '0' + 52;
+    }
+    else if (ch == '+') {
+      temp |= 62;
+    }
+    else if (ch == '/') {
+      temp |= 63;
+    }
+    else if (ch == '=') {
+      break;
+    }
+    else {
+      return false;
+    }
+
+    if (4 == ++quantum) {
+      result.push_back(static_cast<uint8_t>(temp >> 16));
+      result.push_back(static_cast<uint8_t>(temp >> 8));
+      result.push_back(static_cast<uint8_t>(temp));
+      quantum = 0;
+    }
+  }
+
+  if (2 == quantum) {
+    result.push_back(static_cast<uint8_t>(temp >> 4));
+  }
+  else if (3 == quantum) {
+    result.push_back(static_cast<uint8_t>(temp >> 10));
+    result.push_back(static_cast<uint8_t>(temp >> 2));
+  }
+
+  return true;
+}
+
+TEST(core_tests, test_base64) {
+  std::mt19937 random(1234);
+  std::vector<uint8_t> data(300);
+  for (auto & b : data) {
+    b = static_cast<uint8_t>(random());
+  }
+
+  //Every length covers the vector blocks together with all scalar tails
+  for (size_t len = 0; len <= data.size(); ++len) {
+    const auto encoded = vds::base64::from_bytes(data.data(), len);
+    ASSERT_EQ(legacy_from_bytes(data.data(), len), encoded);
+
+    GET_EXPECTED_GTEST(decoded, vds::base64::to_bytes(encoded));
+    ASSERT_EQ(vds::const_data_buffer(data.data(), len), decoded);
+
+    auto url = vds::base64::url_from_bytes(data.data(), len);
+    ASSERT_EQ(std::string::npos, url.find_first_of("+/="));
+    GET_EXPECTED_GTEST(url_decoded, vds::base64::url_to_bytes(url));
+    ASSERT_EQ(vds::const_data_buffer(data.data(), len), url_decoded);
+
+    std::replace(url.begin(), url.end(), '-', '+');
+    std::replace(url.begin(), url.end(), '_', '/');
+    ASSERT_EQ(encoded.substr(0, url.length()), url);
+
+    GET_EXPECTED_GTEST(padded_decoded, vds::base64::url_to_bytes(url_decoded.size() ? vds::base64::url_from_bytes(url_decoded) + std::string((4 - url.length() % 4) % 4, '=') : std::string()));
+    ASSERT_EQ(url_decoded, padded_decoded);
+  }
+
+  //Invalid characters are found inside the vector blocks as well
+  const auto encoded = vds::base64::from_bytes(data.data(), data.size());
+  for (size_t i = 0; i < encoded.length(); ++i) {
+    for (auto ch : { '-', '_', '@', '[', '`', '{', ' ', '\x7F', '\x80', '\xFF' }) {
+      auto invalid = encoded;
+      invalid[i] = ch;
+      ASSERT_TRUE(vds::base64::to_bytes(invalid).has_error());
+    }
+
+    auto url = encoded;
+    std::replace(url.begin(), url.end(), '+', '-');
+    std::replace(url.begin(), url.end(), '/', '_');
+    for (auto ch : { '+', '/', '@', '[', '`', '{', '^', '\x7F', '\x80', '\xFF' }) {
+      auto invalid = url;
+      invalid[i] = ch;
+      ASSERT_TRUE(vds::base64::url_to_bytes(invalid).has_error());
+    }
+  }
+
+  ASSERT_TRUE(vds::base64::to_bytes("QUJD=").has_error());
+  ASSERT_TRUE(vds::base64::to_bytes("QUJDR").has_error());
+  ASSERT_TRUE(vds::base64::url_to_bytes("QUJDR").has_error());
+}
@@ -0,0 +1,124 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include <thread>
+#include "logger.h"
+#include "binary_log.h"
+#include "file.h"
+#include "test_config.h"
+
+class binary_test_logger : public vds::iservice_factory, public vds::log_writer, public vds::logger {
+public:
+  binary_test_logger()
+  : log_writer(vds::log_level::ll_trace), logger(*this, vds::log_level::ll_trace, { "*" }) {
+    this->binary_log_ = &this->log_;
+  }
+
+  vds::expected<void> register_services(vds::service_registrator & registrator) override {
+    registrator.add_service<vds::logger>(this);
+    return vds::expected<void>();
+  }
+
+  vds::expected<void> start(const vds::service_provider *) override {
+    return this->log_.start(vds::filename("test_binary_log.vlog"));
+  }
+
+  vds::expected<void> stop() override {
+    this->log_.stop();
+    return vds::expected<void>();
+  }
+
+  void write(const vds::log_record & record) override {
+    this->log_.write(record);
+  }
+
+  void flush() override {
+    this->log_.flush();
+  }
+
+private:
+  vds::binary_log log_;
+};
+
+static uint64_t read_le(const uint8_t *& p, size_t size) {
+  uint64_t result = 0;
+  for (size_t i = 0; i < size; ++i) {
+    result |= static_cast<uint64_t>(*p++) << (8 * i);
+  }
+  return result;
+}
+
+TEST(core_tests, test_binary_log) {
+  const vds::filename fn("test_binary_log.vlog");
+  if (vds::file::exists(fn)) {
+    CHECK_EXPECTED_GTEST(vds::file::delete_file(fn));
+  }
+
+  vds::service_registrator registrator;
+  binary_test_logger logger;
+  registrator.add(logger);
+  GET_EXPECTED_GTEST(sp, registrator.build());
+  CHECK_EXPECTED_GTEST(registrator.start());
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.push_back(std::thread([sp, t]() {
+      for (int i = 0; i < 1000; ++i) {
+        VDS_LOG_DEBUG(sp, "Binary", "record %d from %s %p %f", i, "thread", sp, 0.5 * t);
+      }
+    }));
+  }
+  for (auto & t : threads) {
+    t.join();
+  }
+
+  //Preformatted messages share one "%s" format per module and level
+  logger.debug("Binary", "text %d", 1);
+  logger.debug("Binary", "text %d", 2);
+
+  CHECK_EXPECTED_GTEST(registrator.shutdown());
+
+  GET_EXPECTED_GTEST(data, vds::file::read_all(fn));
+  CHECK_EXPECTED_GTEST(vds::file::delete_file(fn));
+
+  ASSERT_LE(8, data.size());
+  ASSERT_EQ(0, memcmp(data.data(), "VLOG", 4));
+
+  std::map<uint32_t, std::string> formats;
+  std::map<uint32_t, int> records;
+  const uint8_t * p = data.data() + 8;
+  const uint8_t * end = data.data() + data.size();
+  while (p < end) {
+    switch (*p++) {
+    case vds::binary_log::format_block: {
+      const auto id = static_cast<uint32_t>(read_le(p, 4));
+      ++p;
+      p += read_le(p, 2);
+      const auto len = read_le(p, 2);
+      formats[id] = std::string(reinterpret_cast<const char *>(p), len);
+      p += len;
+      break;
+    }
+    case vds::binary_log::record_block: {
+      p += 4 + 8;
+      const auto id = static_cast<uint32_t>(read_le(p, 4));
+      ASSERT_NE(formats.end(), formats.find(id));
+      ++records[id];
+      p += read_le(p, 2);
+      break;
+    }
+    default:
+      FAIL() << "Unexpected block";
+    }
+  }
+
+  ASSERT_EQ(end, p);
+  ASSERT_EQ(2, formats.size());
+  ASSERT_EQ("record %d from %s %p %f", formats.begin()->second);
+  ASSERT_EQ(4000, records[formats.begin()->first]);
+  ASSERT_EQ("%s", formats.rbegin()->second);
+  ASSERT_EQ(2, records[formats.rbegin()->first]);
+}
@@ -0,0 +1,48 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include "stream.h"
+#include "test_config.h"
+
+TEST(core_tests, test_buffer_pool) {
+  uint8_t * first;
+  {
+    auto buffer = vds::buffer_pool::allocate(100 * 1024);
+    ASSERT_EQ(128 * 1024, buffer.size());
+    first = buffer.data();
+  }
+
+  const auto before = vds::buffer_pool::get_statistic();
+  {
+    auto buffer = vds::buffer_pool::allocate(65 * 1024);
+    ASSERT_EQ(first, buffer.data());
+
+    auto moved = std::move(buffer);
+    ASSERT_FALSE(buffer);
+    ASSERT_EQ(first, moved.data());
+  }
+  ASSERT_EQ(before.pool_hits + 1, vds::buffer_pool::get_statistic().pool_hits);
+
+  auto big = vds::buffer_pool::allocate(3 * vds::buffer_pool::max_pooled_size);
+  ASSERT_EQ(3 * vds::buffer_pool::max_pooled_size, big.size());
+}
+
+TEST(core_tests, test_stream_pipeline) {
+  std::vector<uint8_t> data(3 * 1024 * 1024 + 17);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<uint8_t>(i * 31);
+  }
+  const vds::const_data_buffer source(data.data(), data.size());
+
+  auto input = std::make_shared<vds::buffer_stream_input_async>(source);
+  GET_EXPECTED_GTEST(all, input->read_all().get());
+  ASSERT_EQ(source, all);
+
+  auto target = std::make_shared<vds::collect_data>();
+  auto copy_input = std::make_shared<vds::buffer_stream_input_async>(source);
+  CHECK_EXPECTED_GTEST(copy_input->copy_to(target).get());
+  ASSERT_EQ(source, target->move_data());
+}
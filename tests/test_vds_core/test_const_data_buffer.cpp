@@ -0,0 +1,110 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include <map>
+#include "const_data_buffer.h"
+#include "test_config.h"
+
+TEST(core_tests, test_shared_buffer) {
+  uint8_t data[256];
+  for (size_t i = 0; i < sizeof(data); ++i) {
+    data[i] = static_cast<uint8_t>(i);
+  }
+
+  vds::const_data_buffer original(data, sizeof(data));
+  ASSERT_FALSE(original.is_shared());
+
+  const auto owned_copy = original;
+  ASSERT_NE(original.data(), owned_copy.data());
+
+  const uint8_t * p = original.data();
+  original.share();
+  ASSERT_TRUE(original.is_shared());
+  ASSERT_EQ(p, static_cast<const vds::const_data_buffer &>(original).data());
+
+  //O(1) copy and slice
+  const auto copy = original;
+  ASSERT_EQ(p, copy.data());
+
+  const auto slice = copy.slice(16, 32);
+  ASSERT_TRUE(slice.is_shared());
+  ASSERT_EQ(p + 16, slice.data());
+  ASSERT_EQ(vds::const_data_buffer(data + 16, 32), slice);
+
+  //Writes detach a private copy
+  auto writable = slice;
+  writable[0] = 0xFF;
+  ASSERT_FALSE(writable.is_shared());
+  ASSERT_EQ(0xFF, writable[0]);
+  ASSERT_EQ(16, slice[0]);
+  ASSERT_EQ(16, copy[16]);
+
+  vds::const_data_buffer assigned;
+  assigned = slice;
+  ASSERT_TRUE(assigned.is_shared());
+  ASSERT_EQ(slice, assigned);
+  assigned = owned_copy;
+  ASSERT_FALSE(assigned.is_shared());
+  ASSERT_EQ(owned_copy, assigned);
+
+  //Slices outlive the original buffer
+  vds::const_data_buffer tail;
+  {
+    vds::const_data_buffer temp(data, sizeof(data));
+    tail = temp.share().slice(200, 56);
+  }
+  ASSERT_EQ(vds::const_data_buffer(data + 200, 56), tail);
+  ASSERT_EQ(vds::const_data_buffer(data + 8, 8), owned_copy.slice(8, 8));
+}
+
+//Retransmission queue of dht_datagram_protocol: each datagram is stored in the output queue,
+//copied into the udp_datagram, captured by the send thread and resent on lost acknowledgments.
+//The timing of the same path is in vds_bench.
+static size_t datagram_path_bytes_copied(bool shared) {
+  constexpr size_t datagram_count = 10000;
+  constexpr size_t mtu = 1400;
+  constexpr int retransmits = 2;
+
+  size_t bytes_copied = 0;
+
+  std::map<uint32_t, vds::const_data_buffer> output_messages;
+  for (uint32_t index = 0; index < datagram_count; ++index) {
+    const std::vector<uint8_t> payload(mtu, static_cast<uint8_t>(index));
+    vds::const_data_buffer datagram(payload.data(), payload.size());
+    if (shared) {
+      datagram.share();
+    }
+
+    const auto & stored = output_messages.emplace(index, datagram).first->second;
+    if (stored.data() != static_cast<const vds::const_data_buffer &>(datagram).data()) {
+      bytes_copied += stored.size();
+    }
+  }
+
+  for (int i = 0; i <= retransmits; ++i) {
+    for (const auto & p : output_messages) {
+      const vds::const_data_buffer udp_datagram(p.second);
+      const auto send_task = [udp_datagram]() { return udp_datagram.data(); };
+
+      if (udp_datagram.data() != p.second.data()) {
+        bytes_copied += udp_datagram.size();
+      }
+      if (send_task() != udp_datagram.data()) {
+        bytes_copied += udp_datagram.size();
+      }
+    }
+  }
+
+  return bytes_copied;
+}
+
+TEST(core_tests, test_shared_buffer_copies) {
+  const auto owned = datagram_path_bytes_copied(false);
+  const auto shared = datagram_path_bytes_copied(true);
+
+  ASSERT_EQ(0, shared);
+  ASSERT_LT(0, owned);
+}
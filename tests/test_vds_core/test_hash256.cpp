@@ -0,0 +1,77 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include <unordered_set>
+#include "hash256.h"
+#include "test_config.h"
+
+static vds::const_data_buffer random_buffer(size_t size) {
+  std::vector<uint8_t> data(size);
+  for (auto & b : data) {
+    b = static_cast<uint8_t>(std::rand());
+  }
+  data[0] |= 1;
+  return vds::const_data_buffer(data.data(), data.size());
+}
+
+TEST(core_tests, test_hash256) {
+  const auto left_data = random_buffer(vds::hash256::hash_size);
+  const auto right_data = random_buffer(vds::hash256::hash_size);
+
+  //Same wire format as const_data_buffer
+  vds::binary_serializer s;
+  CHECK_EXPECTED_GTEST(s << vds::hash256(left_data));
+  CHECK_EXPECTED_GTEST(s << vds::hash256());
+  CHECK_EXPECTED_GTEST(s << right_data);
+
+  vds::binary_serializer s1;
+  CHECK_EXPECTED_GTEST(s1 << left_data);
+  CHECK_EXPECTED_GTEST(s1 << vds::const_data_buffer());
+  CHECK_EXPECTED_GTEST(s1 << right_data);
+  ASSERT_EQ(s1.move_data(), s.move_data());
+
+  vds::binary_serializer s2;
+  CHECK_EXPECTED_GTEST(s2 << left_data);
+  CHECK_EXPECTED_GTEST(s2 << vds::const_data_buffer());
+  CHECK_EXPECTED_GTEST(s2 << right_data);
+  CHECK_EXPECTED_GTEST(s2 << random_buffer(16));
+
+  const auto buffer = s2.move_data();
+  vds::binary_deserializer ds(buffer.data(), buffer.size());
+  vds::hash256 left, empty, right, invalid;
+  CHECK_EXPECTED_GTEST(ds >> left);
+  CHECK_EXPECTED_GTEST(ds >> empty);
+  CHECK_EXPECTED_GTEST(ds >> right);
+  ASSERT_TRUE((ds >> invalid).has_error());
+
+  ASSERT_EQ(left_data, left);
+  ASSERT_FALSE(empty);
+  ASSERT_EQ(vds::const_data_buffer(), empty);
+  ASSERT_EQ(0, vds::const_data_buffer(empty).size());
+  ASSERT_EQ(left_data < right_data, left < right);
+  ASSERT_TRUE(vds::hash256::create(random_buffer(16)).has_error());
+
+  //Only buffers of a known size are converted, and only explicitly
+  static_assert(!std::is_convertible<vds::const_data_buffer, vds::hash256>::value, "hash256 from a buffer must be explicit");
+
+  //XOR distance
+  ASSERT_FALSE(left ^ left);
+  ASSERT_EQ(0, left.distance_exp(left));
+  ASSERT_EQ(left, (left ^ right) ^ right);
+
+  for (size_t bit = 0; bit < 8 * vds::hash256::hash_size; ++bit) {
+    auto other = left;
+    other[bit / 8] ^= static_cast<uint8_t>(0x80 >> (bit % 8));
+    ASSERT_EQ(bit, left.distance_exp(other));
+    ASSERT_EQ(bit, other.distance_exp(left));
+  }
+
+  std::unordered_set<vds::hash256> ids;
+  ids.emplace(left);
+  ids.emplace(right);
+  ids.emplace(left_data);
+  ASSERT_EQ(2, ids.size());
+}
@@ -0,0 +1,83 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include <list>
+#include "logger.h"
+#include "test_config.h"
+
+class test_logger : public vds::iservice_factory, public vds::log_writer, public vds::logger {
+public:
+  test_logger(vds::log_level level, const std::unordered_set<std::string> & modules)
+  : log_writer(level), logger(*this, level, modules) {
+  }
+
+  vds::expected<void> register_services(vds::service_registrator & registrator) override {
+    registrator.add_service<vds::logger>(this);
+    return vds::expected<void>();
+  }
+
+  vds::expected<void> start(const vds::service_provider *) override {
+    return vds::expected<void>();
+  }
+
+  vds::expected<void> stop() override {
+    return vds::expected<void>();
+  }
+
+  void write(const vds::log_record & record) override {
+    this->records_.push_back(record);
+  }
+
+  void flush() override {
+  }
+
+  std::list<vds::log_record> records_;
+};
+
+static int log_argument_count = 0;
+
+static std::string log_argument(const char * value) {
+  ++log_argument_count;
+  return value;
+}
+
+TEST(core_tests, test_lazy_logging) {
+  vds::service_registrator registrator;
+  test_logger logger(vds::log_level::ll_debug, { "Enabled", "-Disabled" });
+
+  registrator.add(logger);
+  GET_EXPECTED_GTEST(sp, registrator.build());
+
+  for (int i = 0; i < 3; ++i) {
+    VDS_LOG_DEBUG(sp, "Enabled", "debug %s", log_argument("enabled").c_str());
+    VDS_LOG_DEBUG(sp, "Disabled", "debug %s", log_argument("disabled").c_str());
+    VDS_LOG_DEBUG(sp, "Unknown", "debug %s", log_argument("unknown").c_str());
+    VDS_LOG_TRACE(sp, "Enabled", "trace %s", log_argument("trace").c_str());
+  }
+
+  //Only the enabled module at an enabled level evaluates its arguments
+  ASSERT_EQ(3, log_argument_count);
+  ASSERT_EQ(3, logger.records_.size());
+  ASSERT_EQ("Enabled", logger.records_.front().module);
+  ASSERT_EQ("debug enabled", logger.records_.front().message);
+
+  //Errors ignore the filter
+  VDS_LOG_ERROR(sp, "Disabled", "error %s", log_argument("error").c_str());
+  ASSERT_EQ(4, log_argument_count);
+
+  //The cached filter follows runtime changes
+  logger.set_log_module("*");
+  VDS_LOG_DEBUG(sp, "Unknown", "debug %s", log_argument("unknown").c_str());
+  ASSERT_EQ(5, log_argument_count);
+  ASSERT_FALSE(logger.check("Disabled", vds::log_level::ll_debug));
+  ASSERT_TRUE(logger.check("Other", vds::log_level::ll_debug));
+
+  ASSERT_EQ(vds::log_module::get_id("Enabled"), vds::log_module::get_id(std::string("Enabled")));
+  ASSERT_NE(vds::log_module::get_id("Enabled"), vds::log_module::get_id("Disabled"));
+  ASSERT_EQ("other", vds::log_module::name(vds::log_module::overflow_id));
+
+  CHECK_EXPECTED_GTEST(registrator.shutdown());
+}
@@ -0,0 +1,101 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include <thread>
+#include "lru_cache.h"
+#include "test_config.h"
+
+struct unit_size {
+  size_t operator()(int, int) const {
+    return 1;
+  }
+};
+
+TEST(core_tests, test_lru_cache) {
+  vds::lru_cache<int, int, std::hash<int>, unit_size> cache(3, 1);
+
+  cache.set(1, 10);
+  cache.set(2, 20);
+  cache.set(3, 30);
+
+  int value;
+  ASSERT_TRUE(cache.find(1, value));
+  ASSERT_EQ(10, value);
+
+  //2 is the least recently used now
+  cache.set(4, 40);
+  ASSERT_FALSE(cache.find(2, value));
+  ASSERT_TRUE(cache.find(3, value));
+  ASSERT_TRUE(cache.find(4, value));
+
+  cache.set(1, 11);
+  ASSERT_TRUE(cache.find(1, value));
+  ASSERT_EQ(11, value);
+
+  cache.remove(1);
+  ASSERT_FALSE(cache.contains(1));
+
+  const auto stat = cache.get_statistics();
+  ASSERT_EQ(4, stat.hits);
+  ASSERT_EQ(1, stat.misses);
+  ASSERT_EQ(1, stat.evictions);
+  ASSERT_EQ(2, stat.count);
+  ASSERT_EQ(2, stat.bytes);
+}
+
+TEST(core_tests, test_lru_cache_budget) {
+  vds::lru_cache<int, vds::const_data_buffer> cache(4 * 1024, 1, std::chrono::milliseconds(50));
+
+  const std::vector<uint8_t> data(1000, 1);
+  for (int i = 0; i < 10; ++i) {
+    cache.set(i, vds::const_data_buffer(data.data(), data.size()));
+  }
+
+  //Oversized items are not cached at all
+  cache.set(100, vds::const_data_buffer(std::vector<uint8_t>(8 * 1024).data(), 8 * 1024));
+
+  auto stat = cache.get_statistics();
+  ASSERT_GE(4 * 1024, stat.bytes);
+  ASSERT_EQ(10 - stat.evictions, stat.count);
+  ASSERT_TRUE(cache.contains(9));
+  ASSERT_FALSE(cache.contains(0));
+  ASSERT_FALSE(cache.contains(100));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  vds::const_data_buffer value;
+  ASSERT_FALSE(cache.find(9, value));
+  stat = cache.get_statistics();
+  ASSERT_EQ(1, stat.expirations);
+}
+
+TEST(core_tests, test_lru_cache_threads) {
+  vds::lru_cache<int, int, std::hash<int>, unit_size> cache(10000);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&cache, t]() {
+      for (int i = 0; i < 100000; ++i) {
+        const int key = (i * 7 + t) % 20000;
+        int value;
+        if (!cache.find(key, value)) {
+          cache.set(key, key);
+        }
+        else if (value != key) {
+          throw std::runtime_error("invalid cache value");
+        }
+      }
+    });
+  }
+
+  for (auto & t : threads) {
+    t.join();
+  }
+
+  const auto stat = cache.get_statistics();
+  ASSERT_GE(10000, stat.count);
+  ASSERT_EQ(400000, stat.hits + stat.misses);
+}
@@ -0,0 +1,64 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include <thread>
+#include "metrics.h"
+#include "test_config.h"
+
+TEST(core_tests, test_metrics_counter) {
+  auto & counter = vds::metrics::counter("test.counter");
+  ASSERT_EQ(&counter, &vds::metrics::counter("test.counter"));
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&counter]() {
+      for (int j = 0; j < 10000; ++j) {
+        counter.add();
+      }
+    });
+  }
+  for (auto & t : threads) {
+    t.join();
+  }
+
+  ASSERT_EQ(80000, counter.value());
+
+  auto & gauge = vds::metrics::gauge("test.gauge");
+  gauge.set(10);
+  gauge.add(-3);
+
+  const auto stat = vds::metrics::get_statistic();
+  ASSERT_EQ(80000, stat.counters_.at("test.counter"));
+  ASSERT_EQ(7, stat.gauges_.at("test.gauge"));
+}
+
+TEST(core_tests, test_metrics_histogram) {
+  for (uint64_t value : { 0ULL, 1ULL, 15ULL, 16ULL, 17ULL, 1000ULL, 123456789ULL, ~0ULL }) {
+    const auto index = vds::metric_histogram::bucket_index(value);
+    ASSERT_LT(index, vds::metric_histogram::bucket_count);
+    ASSERT_LE(vds::metric_histogram::bucket_lower_bound(index), value);
+    if (index + 1 < vds::metric_histogram::bucket_count) {
+      ASSERT_GT(vds::metric_histogram::bucket_lower_bound(index + 1), value);
+    }
+  }
+
+  auto & histogram = vds::metrics::histogram("test.histogram");
+  for (uint64_t i = 1; i <= 1000; ++i) {
+    histogram.record(i);
+  }
+
+  const auto snapshot = histogram.get_snapshot();
+  ASSERT_EQ(1000, snapshot.count);
+  ASSERT_EQ(500500, snapshot.sum);
+  ASSERT_EQ(1, snapshot.min);
+  ASSERT_EQ(1000, snapshot.max);
+
+  //Buckets keep the relative error below 1/16
+  ASSERT_NEAR(500.0, double(snapshot.p50), 500.0 / 16);
+  ASSERT_NEAR(900.0, double(snapshot.p90), 900.0 / 16);
+  ASSERT_NEAR(990.0, double(snapshot.p99), 990.0 / 16);
+  ASSERT_LE(snapshot.p999, snapshot.max);
+}
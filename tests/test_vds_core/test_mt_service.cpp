@@ -0,0 +1,127 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "mt_service.h"
+#include "test_config.h"
+
+static constexpr size_t chain_producers = 8;
+static constexpr size_t chains_per_producer = 16;
+static constexpr size_t chain_length = 256;
+
+//Every producer starts several chains; each task schedules the next one from the worker thread,
+//the same way a resumed coroutine schedules its continuation.
+//The timing of the same load is in vds_bench.
+class scheduler_chains {
+public:
+  scheduler_chains(vds::imt_service & scheduler)
+  : scheduler_(scheduler),
+    done_(chain_producers * chains_per_producer),
+    executed_(0) {
+  }
+
+  size_t run() {
+    std::vector<std::thread> producers;
+    for (size_t i = 0; i < chain_producers; ++i) {
+      producers.emplace_back([this]() {
+        for (size_t j = 0; j < chains_per_producer; ++j) {
+          this->schedule(0);
+        }
+      });
+    }
+    for (auto & t : producers) {
+      t.join();
+    }
+
+    this->done_.wait();
+    return this->executed_;
+  }
+
+private:
+  vds::imt_service & scheduler_;
+  vds::barrier done_;
+  std::atomic<size_t> executed_;
+
+  void schedule(size_t step) {
+    this->scheduler_.do_async([this, step]() {
+      ++this->executed_;
+
+      if (step + 1 < chain_length) {
+        this->schedule(step + 1);
+      }
+      else {
+        --this->done_;
+      }
+    });
+  }
+};
+
+TEST(mt_tests, test_scheduler_chains) {
+  vds::service_registrator registrator;
+  vds::mt_service mt_service;
+  registrator.add(mt_service);
+
+  GET_EXPECTED_GTEST(sp, registrator.build());
+  CHECK_EXPECTED_GTEST(registrator.start());
+
+  const auto executed = scheduler_chains(*sp->get<vds::imt_service>()).run();
+
+  CHECK_EXPECTED_GTEST(registrator.shutdown());
+
+  ASSERT_EQ(chain_producers * chains_per_producer * chain_length, executed);
+}
+
+TEST(mt_tests, test_shutdown_drains_queues) {
+  vds::service_registrator registrator;
+  vds::mt_service mt_service;
+  registrator.add(mt_service);
+
+  GET_EXPECTED_GTEST(sp, registrator.build());
+  CHECK_EXPECTED_GTEST(registrator.start());
+
+  //Tasks scheduled from a worker go to its LIFO slot and deque
+  static constexpr size_t count = 10000;
+  std::atomic<size_t> executed(0);
+  vds::barrier scheduled(1);
+  vds::imt_service::async(sp, [sp, &executed, &scheduled]() {
+    for (size_t i = 0; i < count; ++i) {
+      vds::imt_service::async(sp, [&executed]() {
+        ++executed;
+      });
+    }
+    --scheduled;
+  });
+
+  scheduled.wait();
+  CHECK_EXPECTED_GTEST(registrator.shutdown());
+
+  ASSERT_EQ(count, executed);
+}
+
+TEST(mt_tests, test_blocked_owner_lifo_slot) {
+  vds::service_registrator registrator;
+  vds::mt_service mt_service;
+  registrator.add(mt_service);
+
+  GET_EXPECTED_GTEST(sp, registrator.build());
+  CHECK_EXPECTED_GTEST(registrator.start());
+
+  //The continuation waits in the LIFO slot of a worker that blocks on it
+  vds::barrier done(1);
+  vds::imt_service::async(sp, [sp, &done]() {
+    vds::barrier continued(1);
+    vds::imt_service::async(sp, [&continued]() {
+      --continued;
+    });
+    continued.wait();
+    --done;
+  });
+
+  done.wait();
+  CHECK_EXPECTED_GTEST(registrator.shutdown());
+}
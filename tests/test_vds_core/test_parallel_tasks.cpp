@@ -0,0 +1,106 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include <atomic>
+#include <list>
+#include <thread>
+#include "parallel_tasks.h"
+#include "test_config.h"
+
+static vds::async_task<vds::expected<int>> delayed_value(int value, int delay_ms) {
+  auto r = std::make_shared<vds::async_result<vds::expected<int>>>();
+  std::thread([r, value, delay_ms]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+    if (value < 0) {
+      r->set_value(vds::make_unexpected<std::runtime_error>("negative value"));
+    }
+    else {
+      r->set_value(value);
+    }
+  }).detach();
+  return r->get_future();
+}
+
+TEST(code_tests, test_when_all) {
+  std::vector<vds::async_task<vds::expected<int>>> tasks;
+  tasks.push_back(delayed_value(1, 60));
+  tasks.push_back(delayed_value(2, 10));
+  tasks.push_back(delayed_value(3, 30));
+
+  //Tasks run concurrently, so the slowest one sets the pace
+  const auto start = std::chrono::steady_clock::now();
+  GET_EXPECTED_GTEST(values, vds::when_all(std::move(tasks)).get());
+  ASSERT_GT(std::chrono::milliseconds(100), std::chrono::steady_clock::now() - start);
+  ASSERT_EQ(std::vector<int>({ 1, 2, 3 }), values);
+
+  std::vector<vds::async_task<vds::expected<int>>> failed_tasks;
+  failed_tasks.push_back(delayed_value(1, 10));
+  failed_tasks.push_back(delayed_value(-1, 20));
+  failed_tasks.push_back(delayed_value(3, 30));
+  auto failed_result = vds::when_all(std::move(failed_tasks)).get();
+  ASSERT_TRUE(failed_result.has_error());
+  ASSERT_STREQ("negative value", failed_result.error()->what());
+
+  GET_EXPECTED_GTEST(empty, vds::when_all(std::vector<vds::async_task<vds::expected<int>>>()).get());
+  ASSERT_TRUE(empty.empty());
+}
+
+TEST(code_tests, test_when_any) {
+  std::vector<vds::async_task<vds::expected<int>>> tasks;
+  tasks.push_back(delayed_value(1, 200));
+  tasks.push_back(delayed_value(2, 10));
+  tasks.push_back(delayed_value(3, 100));
+
+  GET_EXPECTED_GTEST(first, vds::when_any(std::move(tasks)).get());
+  ASSERT_EQ(1, first.first);
+  ASSERT_EQ(2, first.second);
+
+  //Let the remaining tasks finish before the test exits
+  std::this_thread::sleep_for(std::chrono::milliseconds(250));
+}
+
+TEST(code_tests, test_parallel_for_each) {
+  std::list<int> items;
+  for (int i = 0; i < 40; ++i) {
+    items.push_back(i);
+  }
+
+  std::atomic<int> in_flight(0);
+  std::atomic<int> max_in_flight(0);
+  std::atomic<int> sum(0);
+  CHECK_EXPECTED_GTEST(vds::parallel_for_each(items, 4, [&](int item) -> vds::async_task<vds::expected<void>> {
+    const auto current = ++in_flight;
+    auto max_value = max_in_flight.load();
+    while (max_value < current && !max_in_flight.compare_exchange_weak(max_value, current)) {
+    }
+
+    GET_EXPECTED_ASYNC(value, co_await delayed_value(item, 1 + item % 5));
+    sum += value;
+    --in_flight;
+    co_return vds::expected<void>();
+  }).get());
+  ASSERT_EQ(40 * 39 / 2, sum);
+  ASSERT_GE(4, max_in_flight);
+
+  //Completed tasks must not grow the stack
+  std::vector<int> ready_items(100000, 1);
+  int ready_sum = 0;
+  CHECK_EXPECTED_GTEST(vds::parallel_for_each(std::move(ready_items), 8, [&ready_sum](int item) -> vds::async_task<vds::expected<void>> {
+    ready_sum += item;
+    co_return vds::expected<void>();
+  }).get());
+  ASSERT_EQ(100000, ready_sum);
+
+  //No new calls start after the first error
+  std::atomic<int> started(0);
+  auto result = vds::parallel_for_each(items, 2, [&started](int item) -> vds::async_task<vds::expected<void>> {
+    ++started;
+    CHECK_EXPECTED_ASYNC(co_await delayed_value((5 == item) ? -1 : item, 1));
+    co_return vds::expected<void>();
+  }).get();
+  ASSERT_TRUE(result.has_error());
+  ASSERT_GT(40, started);
+}
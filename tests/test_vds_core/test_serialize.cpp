@@ -78,3 +78,164 @@ TEST(core_tests, test_message_serialize) {
   GTEST_ASSERT_EQ(m1.field1, 10u);
   GTEST_ASSERT_EQ(m1.field2, "test");
 }
+
+class sized_message {
+public:
+
+  uint8_t field1;
+  uint64_t field2;
+  std::string field3;
+  vds::const_data_buffer field4;
+  std::list<uint16_t> field5;
+  std::map<uint32_t, std::string> field6;
+
+  template <typename visitor_t>
+  void visit(visitor_t & v) {
+    v(field1, field2, field3, field4, field5, field6);
+  }
+};
+
+TEST(core_tests, test_message_size) {
+  sized_message m;
+  m.field1 = 1;
+  m.field2 = 2;
+  m.field3 = std::string(300, 'a');
+  m.field4 = vds::const_data_buffer(m.field3.c_str(), 127);
+  m.field5 = { 1, 2, 3 };
+  m.field6[1] = "one";
+  m.field6[100000] = std::string(70000, 'b');
+
+  GET_EXPECTED_GTEST(data, vds::message_serialize(m));
+  GET_EXPECTED_GTEST(size, vds::message_size(m));
+  GTEST_ASSERT_EQ(size, data.size());
+
+  for (uint64_t value : { 0ULL, 127ULL, 128ULL, 383ULL, 384ULL, 65663ULL, 65664ULL, 0xFFFFFFFFFFFFFFFFULL }) {
+    vds::binary_serializer s;
+    CHECK_EXPECTED_GTEST(s.write_number(value));
+    GTEST_ASSERT_EQ(vds::binary_sizer::number_size(value), s.size());
+
+    vds::binary_deserializer d(s.get_buffer(), s.size());
+    GET_EXPECTED_GTEST(result, d.read_number());
+    GTEST_ASSERT_EQ(value, result);
+  }
+}
+
+class nested_message {
+public:
+  uint16_t field1;
+  std::list<sized_message> field2;
+
+  template <typename visitor_t>
+  void visit(visitor_t & v) {
+    v(field1, field2);
+  }
+};
+
+//A leaf type that can only be measured by serializing it
+struct broken_field {
+};
+
+static vds::expected<void> operator <<(vds::binary_serializer &, const broken_field &) {
+  return vds::make_unexpected<std::runtime_error>("Broken field");
+}
+
+class broken_message {
+public:
+  uint32_t field1;
+  broken_field field2;
+
+  template <typename visitor_t>
+  void visit(visitor_t & v) {
+    v(field1, field2);
+  }
+};
+
+TEST(core_tests, test_nested_message_size) {
+  nested_message m;
+  m.field1 = 7;
+  m.field2.resize(2);
+  for (auto & item : m.field2) {
+    item.field1 = 1;
+    item.field2 = 2;
+    item.field3 = "item";
+    item.field5 = { 1, 2 };
+  }
+
+  vds::binary_sizer s;
+  s << m;
+  ASSERT_FALSE(s.error());
+  GTEST_ASSERT_EQ(2 + 1 + 2 * (1 + 8 + 5 + 1 + 1 + 2 * 2 + 1), s.size());
+
+  broken_message b;
+  b.field1 = 1;
+  ASSERT_TRUE(vds::message_size(b).has_error());
+  ASSERT_TRUE(vds::message_serialize(b).has_error());
+}
+
+TEST(core_tests, test_put_array) {
+  const uint16_t values[] = { 0, 1, 0x1234, 0xFFFF };
+
+  vds::binary_serializer s;
+  CHECK_EXPECTED_GTEST(s.put_array(values, sizeof(values) / sizeof(values[0])));
+
+  vds::binary_serializer s1;
+  for (auto value : values) {
+    CHECK_EXPECTED_GTEST(s1 << value);
+  }
+
+  GTEST_ASSERT_EQ(s1.move_data(), s.move_data());
+}
+
+class payload_message {
+public:
+  uint32_t id;
+  vds::const_data_buffer data;
+  vds::const_data_buffer owner;
+
+  template <typename visitor_t>
+  void visit(visitor_t & v) {
+    v(id, data, owner);
+  }
+};
+
+class payload_message_view {
+public:
+  uint32_t id;
+  vds::const_data_view data;
+  vds::const_data_view owner;
+
+  template <typename visitor_t>
+  void visit(visitor_t & v) {
+    v(id, data, owner);
+  }
+};
+
+TEST(core_tests, test_deserialize_view) {
+  const std::string payload(100000, 'x');
+
+  payload_message m;
+  m.id = 42;
+  m.data = vds::const_data_buffer(payload.c_str(), payload.length());
+  m.owner = vds::const_data_buffer("owner", 5);
+  GET_EXPECTED_GTEST(data, vds::message_serialize(m));
+
+  vds::binary_deserializer d(data);
+  GET_EXPECTED_GTEST(view, vds::message_deserialize<payload_message_view>(d));
+  GTEST_ASSERT_EQ(0, d.size());
+
+  //Fields point into the source buffer
+  GTEST_ASSERT_EQ(42, view.id);
+  GTEST_ASSERT_EQ(m.data, view.data);
+  GTEST_ASSERT_EQ(m.owner, view.owner);
+  ASSERT_TRUE(view.data.data() > data.data() && view.data.data() + view.data.size() <= data.data() + data.size());
+  ASSERT_TRUE(view.owner.data() > data.data() && view.owner.data() + view.owner.size() <= data.data() + data.size());
+
+  //Same wire format as the owning message
+  GET_EXPECTED_GTEST(view_data, vds::message_serialize(view));
+  GTEST_ASSERT_EQ(data, view_data);
+  GET_EXPECTED_GTEST(view_size, vds::message_size(view));
+  GTEST_ASSERT_EQ(data.size(), view_size);
+
+  vds::binary_deserializer truncated(data.data(), data.size() - 1);
+  ASSERT_TRUE(vds::message_deserialize<payload_message_view>(truncated).has_error());
+}
@@ -0,0 +1,53 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include "logger.h"
+#include "test_config.h"
+
+class slot_test_logger : public vds::iservice_factory, public vds::log_writer, public vds::logger {
+public:
+  slot_test_logger()
+  : log_writer(vds::log_level::ll_error), logger(*this, vds::log_level::ll_error, std::unordered_set<std::string>()) {
+  }
+
+  vds::expected<void> register_services(vds::service_registrator & registrator) override {
+    registrator.add_service<vds::logger>(this);
+    registrator.add_service<dynamic_service>(&this->service_);
+    return vds::expected<void>();
+  }
+
+  vds::expected<void> start(const vds::service_provider *) override {
+    return vds::expected<void>();
+  }
+
+  vds::expected<void> stop() override {
+    return vds::expected<void>();
+  }
+
+  void write(const vds::log_record & /*record*/) override {
+  }
+
+  void flush() override {
+  }
+
+  class dynamic_service {
+  public:
+    size_t counter = 0;
+  };
+
+  dynamic_service service_;
+};
+
+TEST(core_tests, test_service_slots) {
+  vds::service_registrator registrator;
+  slot_test_logger logger;
+
+  registrator.add(logger);
+  GET_EXPECTED_GTEST(sp, registrator.build());
+
+  ASSERT_EQ(static_cast<vds::logger *>(&logger), sp->get<vds::logger>());
+  ASSERT_EQ(&logger.service_, sp->get<slot_test_logger::dynamic_service>());
+}
@@ -0,0 +1,85 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "thread_apartment.h"
+#include "task_manager.h"
+#include "mt_service.h"
+#include "test_config.h"
+
+static constexpr int producer_count = 32;
+static constexpr int items_per_producer = 10000;
+
+//The timing of the same load is in vds_bench
+static void schedule_from_producers(const std::shared_ptr<vds::thread_apartment> & apartment) {
+  std::atomic<int> processed(0);
+  std::vector<int> last_seen(producer_count, -1);
+  std::atomic<bool> order_ok(true);
+
+  std::vector<std::thread> producers;
+  for (int producer = 0; producer < producer_count; ++producer) {
+    producers.emplace_back([&, producer]() {
+      for (int i = 0; i < items_per_producer; ++i) {
+        apartment->schedule([&, producer, i]() -> vds::expected<void> {
+          //Callbacks run one at a time, so last_seen needs no lock
+          if (last_seen[producer] + 1 != i) {
+            order_ok = false;
+          }
+          last_seen[producer] = i;
+          ++processed;
+          return vds::expected<void>();
+        });
+      }
+    });
+  }
+
+  for (auto & p : producers) {
+    p.join();
+  }
+
+  while (producer_count * items_per_producer != processed) {
+    std::this_thread::yield();
+  }
+
+  EXPECT_TRUE(order_ok);
+}
+
+TEST(core_tests, test_thread_apartment) {
+  vds::service_registrator registrator;
+  vds::mt_service mt_service;
+  vds::task_manager task_manager;
+  vds::console_logger console_logger(
+    test_config::instance().log_level(),
+    test_config::instance().modules());
+
+  registrator.add(mt_service);
+  registrator.add(task_manager);
+  registrator.add(console_logger);
+
+  GET_EXPECTED_GTEST(sp, registrator.build());
+  CHECK_EXPECTED_GTEST(registrator.start());
+
+  auto apartment = std::make_shared<vds::thread_apartment>(sp);
+  schedule_from_producers(apartment);
+
+  CHECK_EXPECTED_GTEST(apartment->prepare_to_stop().get());
+  ASSERT_TRUE(apartment->is_ready_to_stop());
+
+  const auto stat = apartment->get_statistic();
+  ASSERT_EQ(producer_count * items_per_producer, stat.processed);
+  ASSERT_EQ(0, stat.queue_size);
+
+  //The queue never holds more than was scheduled, and every batch runs at least one callback
+  ASSERT_LE(1, stat.max_queue_size);
+  ASSERT_GE(size_t(producer_count * items_per_producer), stat.max_queue_size);
+  ASSERT_LE(1, stat.batches);
+  ASSERT_GE(stat.processed, stat.batches);
+  ASSERT_LE(stat.max_wait.count(), stat.total_wait.count());
+
+  CHECK_EXPECTED_GTEST(registrator.shutdown());
+}
@@ -0,0 +1,137 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include <vector>
+#include "timer_wheel.h"
+#include "task_manager.h"
+#include "mt_service.h"
+#include "test_config.h"
+
+class test_wheel_entry : public vds::timer_wheel::entry {
+public:
+  test_wheel_entry()
+  : fired_tick_(0), fire_count_(0), wheel_(nullptr) {
+  }
+
+  void on_expired() override {
+    this->fired_tick_ = this->wheel_->current_tick();
+    ++this->fire_count_;
+  }
+
+  uint64_t fired_tick_;
+  int fire_count_;
+  vds::timer_wheel * wheel_;
+};
+
+TEST(core_tests, test_timer_wheel) {
+  vds::timer_wheel wheel;
+
+  std::vector<test_wheel_entry> entries(2000);
+  for (auto & e : entries) {
+    e.wheel_ = &wheel;
+
+    //Spread deadlines over every level of the wheel
+    uint64_t delay;
+    switch (std::rand() % 4) {
+    case 0:
+      delay = 1 + std::rand() % 64;
+      break;
+    case 1:
+      delay = 1 + std::rand() % 4096;
+      break;
+    case 2:
+      delay = 1 + std::rand() % (4096 * 64);
+      break;
+    default:
+      delay = 1 + (uint64_t(std::rand()) * 64) % (uint64_t(1) << 26);
+      break;
+    }
+    wheel.schedule(&e, delay);
+  }
+
+  for (size_t i = 0; i < entries.size(); i += 10) {
+    wheel.cancel(&entries[i]);
+  }
+
+  uint64_t now = 0;
+  while (!wheel.empty()) {
+    const auto next = wheel.next_tick();
+    ASSERT_LT(now, next);
+
+    now = next + std::rand() % 3;
+    wheel.advance(now);
+  }
+
+  for (size_t i = 0; i < entries.size(); ++i) {
+    auto & e = entries[i];
+    if (0 == i % 10) {
+      ASSERT_EQ(0, e.fire_count_);
+    }
+    else {
+      ASSERT_EQ(1, e.fire_count_);
+      ASSERT_EQ(e.expire_tick(), e.fired_tick_);
+    }
+  }
+}
+
+static vds::async_task<vds::expected<void>> sleep_twice(const vds::service_provider * sp) {
+  CHECK_EXPECTED_ASYNC(co_await vds::sleep_for(sp, std::chrono::milliseconds(30)));
+  CHECK_EXPECTED_ASYNC(co_await vds::sleep_for(sp, std::chrono::milliseconds(30)));
+  co_return vds::expected<void>();
+}
+
+TEST(core_tests, test_sleep_for) {
+  vds::service_registrator registrator;
+  vds::mt_service mt_service;
+  vds::task_manager task_manager;
+  vds::console_logger console_logger(
+    test_config::instance().log_level(),
+    test_config::instance().modules());
+
+  registrator.add(mt_service);
+  registrator.add(task_manager);
+  registrator.add(console_logger);
+
+  GET_EXPECTED_GTEST(sp, registrator.build());
+  CHECK_EXPECTED_GTEST(registrator.start());
+
+  const auto start = std::chrono::steady_clock::now();
+  CHECK_EXPECTED_GTEST(sleep_twice(sp).get());
+  ASSERT_LE(std::chrono::milliseconds(60), std::chrono::steady_clock::now() - start);
+
+  CHECK_EXPECTED_GTEST(registrator.shutdown());
+}
+
+static vds::async_task<vds::expected<void>> sleep_after_shutdown(const vds::service_provider * sp) {
+  auto result = co_await vds::sleep_for(sp, std::chrono::hours(1));
+  if (!result.has_error()) {
+    co_return vds::make_unexpected<std::runtime_error>("The sleep is not interrupted");
+  }
+
+  //The waiter must not be resumed under the task manager lock
+  co_return co_await vds::sleep_for(sp, std::chrono::milliseconds(30));
+}
+
+TEST(core_tests, test_sleep_for_shutdown) {
+  vds::service_registrator registrator;
+  vds::mt_service mt_service;
+  vds::task_manager task_manager;
+  vds::console_logger console_logger(
+    test_config::instance().log_level(),
+    test_config::instance().modules());
+
+  registrator.add(mt_service);
+  registrator.add(task_manager);
+  registrator.add(console_logger);
+
+  GET_EXPECTED_GTEST(sp, registrator.build());
+  CHECK_EXPECTED_GTEST(registrator.start());
+
+  auto task = sleep_after_shutdown(sp);
+
+  CHECK_EXPECTED_GTEST(registrator.shutdown());
+  ASSERT_TRUE(task.get().has_error());
+}
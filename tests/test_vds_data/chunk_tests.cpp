@@ -5,6 +5,8 @@ All rights reserved
 
 #include "stdafx.h"
 #include "chunk_tests.h"
+#include "compare_data.h"
+#include "random_stream.h"
 #include "test_config.h"
 
 TEST(chunk_tests, test_chunks) {
@@ -160,3 +162,247 @@ TEST(chunk_tests, test_chunks_storage) {
         }
     }
 }
+
+//The per-cell log table encoder and decoder which chunk_generator and chunk_restore used
+//before the region kernels. Kept here as the reference for the output and the speed.
+static vds::expected<vds::const_data_buffer> legacy_encode(
+  const vds::chunk_generator<uint16_t> & generator,
+  const uint8_t * data,
+  size_t size) {
+  const auto & math = vds::chunk<uint16_t>::math();
+  const size_t k = generator.k();
+
+  vds::binary_serializer s;
+  for (size_t i = 0; i < size; i += sizeof(uint16_t) * k) {
+    uint16_t value = 0;
+    for (size_t j = 0; j < k; ++j) {
+      uint16_t data_item = 0;
+      for (size_t offset = 0; offset < sizeof(uint16_t); ++offset) {
+        data_item <<= 8;
+        if (i + sizeof(uint16_t) * j + offset < size) {
+          data_item |= data[i + sizeof(uint16_t) * j + offset];
+        }
+      }
+      value = math.add(value, math.mul(generator.multipliers()[j], data_item));
+    }
+    CHECK_EXPECTED(s << value);
+  }
+  CHECK_EXPECTED(s << uint16_t(size % (sizeof(uint16_t) * k)));
+  return s.move_data();
+}
+
+static vds::const_data_buffer legacy_decode(
+  const vds::chunk_restore<uint16_t> & restore,
+  size_t k,
+  const std::vector<vds::const_data_buffer> & chunks,
+  size_t expected_size) {
+  const auto & math = vds::chunk<uint16_t>::math();
+  const auto size = chunks[0].size() - sizeof(uint16_t);
+
+  std::vector<uint8_t> result;
+  result.reserve(size * k);
+  for (size_t index = 0; index < size; index += sizeof(uint16_t)) {
+    auto m = restore.multipliers();
+    for (size_t i = 0; i < k; ++i) {
+      uint16_t value = 0;
+      for (size_t j = 0; j < k; ++j) {
+        const uint16_t cell = uint16_t(chunks[j][index] << 8) | chunks[j][index + 1];
+        value = math.add(value, math.mul(*m++, cell));
+      }
+      result.push_back(uint8_t(value >> 8));
+      result.push_back(uint8_t(value));
+    }
+  }
+  return vds::const_data_buffer(result.data(), expected_size);
+}
+
+TEST(chunk_tests, test_chunk_codec_bench) {
+  const uint16_t k = 32;
+  const size_t size = 1024 * 1024 + 7;
+
+  std::vector<uint8_t> data(size);
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = uint8_t(std::rand());
+  }
+
+  std::vector<uint16_t> replicas;
+  std::vector<vds::const_data_buffer> chunks;
+  double legacy_encode_time = 0;
+  double encode_time = 0;
+  for (uint16_t replica = 0; replica < k; ++replica) {
+    const uint16_t n = 2 * replica + 1;
+    vds::chunk_generator<uint16_t> generator(k, n);
+
+    auto start = std::chrono::steady_clock::now();
+    GET_EXPECTED_GTEST(expected, legacy_encode(generator, data.data(), size));
+    legacy_encode_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    vds::binary_serializer s;
+    CHECK_EXPECTED_GTEST(generator.write(s, data.data(), size));
+    encode_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    auto chunk = s.move_data();
+    ASSERT_EQ(expected, chunk);
+
+    replicas.push_back(n);
+    chunks.push_back(chunk);
+  }
+
+  vds::chunk_restore<uint16_t> restore(k, replicas.data());
+
+  auto start = std::chrono::steady_clock::now();
+  const auto expected = legacy_decode(restore, k, chunks, size);
+  const auto legacy_decode_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  start = std::chrono::steady_clock::now();
+  GET_EXPECTED_GTEST(result, restore.restore(chunks));
+  const auto decode_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  ASSERT_EQ(vds::const_data_buffer(data.data(), data.size()), expected);
+  ASSERT_EQ(expected, result);
+
+  const double total = double(size) * k / 1e9;
+  std::cout
+    << "encode: log tables " << (total / legacy_encode_time) << " GB/s"
+    << ", region kernels " << (total / encode_time) << " GB/s" << std::endl
+    << "decode: log tables " << (double(size) / 1e9 / legacy_decode_time) << " GB/s"
+    << ", region kernels " << (double(size) / 1e9 / decode_time) << " GB/s" << std::endl;
+}
+
+TEST(chunk_tests, test_chunk_replica_generator) {
+  const uint16_t k = 32;
+  const uint16_t replica_count = 64;
+  const size_t size = 1024 * 1024 + 7;
+
+  std::vector<uint8_t> data(size);
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = uint8_t(std::rand());
+  }
+
+  std::vector<uint16_t> replicas;
+  for (uint16_t replica = 0; replica < replica_count; ++replica) {
+    replicas.push_back(replica);
+  }
+
+  std::vector<vds::const_data_buffer> expected;
+  for (auto replica : replicas) {
+    vds::chunk_generator<uint16_t> generator(k, replica);
+    vds::binary_serializer s;
+    CHECK_EXPECTED_GTEST(generator.write(s, data.data(), size));
+    expected.push_back(s.move_data());
+  }
+
+  vds::chunk_replica_generator generator(k, replicas);
+  GET_EXPECTED_GTEST(result, generator.write(data.data(), size));
+
+  ASSERT_EQ(expected.size(), result.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_EQ(expected[i], result[i]);
+  }
+}
+
+TEST(chunk_tests, test_chunk_decoder_cache) {
+  const uint16_t k = 32;
+  const size_t size = 256 * 1024 + 3;
+  const int block_count = 16;
+
+  std::vector<uint16_t> all_replicas;
+  for (uint16_t replica = 0; replica < 2 * k; ++replica) {
+    all_replicas.push_back(replica);
+  }
+  vds::chunk_replica_generator generator(k, all_replicas);
+
+  //The same replica set in a different order for every block
+  std::vector<uint16_t> replicas(all_replicas.begin() + k / 2, all_replicas.begin() + k / 2 + k);
+
+  vds::chunk_decoder_cache cache(k);
+  for (int block = 0; block < block_count; ++block) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; ++i) {
+      data[i] = uint8_t(std::rand());
+    }
+    GET_EXPECTED_GTEST(encoded, generator.write(data.data(), size));
+
+    for (size_t i = replicas.size() - 1; i > 0; --i) {
+      std::swap(replicas[i], replicas[std::rand() % (i + 1)]);
+    }
+    std::vector<vds::const_data_buffer> chunks;
+    for (auto replica : replicas) {
+      chunks.push_back(encoded[replica]);
+    }
+
+    vds::chunk_restore<uint16_t> restore(k, replicas.data());
+    GET_EXPECTED_GTEST(expected, restore.restore(chunks));
+    GET_EXPECTED_GTEST(result, cache.restore(replicas, chunks));
+
+    ASSERT_EQ(vds::const_data_buffer(data.data(), data.size()), expected);
+    ASSERT_EQ(expected, result);
+  }
+
+  std::vector<uint16_t> key(replicas);
+  std::sort(key.begin(), key.end());
+  ASSERT_EQ(cache.get(key), cache.get(key));
+}
+
+TEST(chunk_tests, test_chunk_output_async) {
+  vds::service_registrator registrator;
+  vds::mt_service mt_service;
+
+  vds::console_logger console_logger(
+      test_config::instance().log_level(),
+      test_config::instance().modules());
+
+  registrator.add(mt_service);
+  registrator.add(console_logger);
+  {
+    GET_EXPECTED_GTEST(sp, registrator.build());
+    CHECK_EXPECTED_GTEST(registrator.start());
+
+    const uint16_t k = 32;
+    const size_t block_size = 1024 * k * sizeof(uint16_t);
+    //The same stripe as chunk_output_async takes from the largest pooled buffer
+    const size_t stripe_size = block_size * std::max<size_t>(1, vds::buffer_pool::max_pooled_size / block_size);
+    auto generator = std::make_shared<vds::chunk_generator<uint16_t>>(k, 5);
+
+    //Less than a block, one whole stripe and more stripes than fit into the budget
+    for (size_t size : { size_t(100), stripe_size, 10 * stripe_size + 12345 }) {
+      std::vector<uint8_t> data(size);
+      for (size_t i = 0; i < size; ++i) {
+        data[i] = uint8_t(std::rand());
+      }
+
+      vds::binary_serializer s;
+      CHECK_EXPECTED_GTEST(generator->write(s, data.data(), size));
+
+      //The stream must produce exactly what the serial encoder does
+      auto cd = std::make_shared<compare_data_async<uint8_t>>(s.get_buffer(), s.size());
+      auto output = std::make_shared<vds::chunk_output_async<uint16_t>>(sp, generator, cd, 4 * stripe_size);
+      CHECK_EXPECTED_GTEST(output->write_async(data.data(), size).get());
+      CHECK_EXPECTED_GTEST(output->write_async(nullptr, 0).get());
+
+      //Writes of random length split the blocks at any position
+      auto random_cd = std::make_shared<compare_data_async<uint8_t>>(s.get_buffer(), s.size());
+      auto rs = std::make_shared<random_stream<uint8_t>>(
+        std::make_shared<vds::chunk_output_async<uint16_t>>(sp, generator, random_cd, 0));
+      CHECK_EXPECTED_GTEST(rs->write_async(data.data(), size).get());
+      CHECK_EXPECTED_GTEST(rs->write_async(nullptr, 0).get());
+    }
+
+    //A target error is returned after the stripes being encoded are dropped,
+    //so the stream and the generator can be released right away
+    {
+      std::vector<uint8_t> data(10 * stripe_size);
+      auto mismatch = std::make_shared<compare_data_async<uint8_t>>(data.data(), 1);
+      auto output = std::make_shared<vds::chunk_output_async<uint16_t>>(
+        sp,
+        std::make_shared<vds::chunk_generator<uint16_t>>(k, 7),
+        mismatch,
+        4 * stripe_size);
+      ASSERT_TRUE(output->write_async(data.data(), data.size()).get().has_error());
+      output.reset();
+    }
+
+    CHECK_EXPECTED_GTEST(registrator.shutdown());
+  }
+}
@@ -0,0 +1,172 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include "test_config.h"
+
+static std::vector<uint8_t> random_data(size_t size) {
+  std::vector<uint8_t> result(size);
+  for (size_t i = 0; i < size; ++i) {
+    result[i] = uint8_t(std::rand());
+  }
+  return result;
+}
+
+static std::vector<uint16_t> random_replicas(uint16_t k, uint16_t n) {
+  std::vector<uint16_t> result;
+  for (uint16_t replica = 0; replica < n; ++replica) {
+    result.push_back(replica);
+  }
+  for (size_t i = result.size() - 1; i > 0; --i) {
+    std::swap(result[i], result[std::rand() % (i + 1)]);
+  }
+  result.resize(k);
+  return result;
+}
+
+TEST(erasure_codec_tests, test_gf8_mul_add_region) {
+  static const vds::gf_math<uint8_t> math;
+
+  for (uint8_t coeff : { 0, 1, 2, 0x1D, 0x80, 0xFF }) {
+    vds::gf_math<uint8_t>::region_table table;
+    math.prepare_region_table(coeff, table);
+
+    //Odd count to cover the scalar tail after the vector kernels
+    const size_t count = 1000 + 37;
+    const auto src = random_data(count);
+    auto dst = random_data(count);
+    auto expected = dst;
+    for (size_t i = 0; i < count; ++i) {
+      expected[i] ^= math.mul(coeff, src[i]);
+    }
+
+    math.mul_add_region(dst.data(), src.data(), table, count);
+    ASSERT_EQ(expected, dst);
+  }
+}
+
+TEST(erasure_codec_tests, test_codecs) {
+  const uint16_t k = 32;
+  const uint16_t n = 64;
+
+  std::vector<uint16_t> all_replicas;
+  for (uint16_t replica = 0; replica < n; ++replica) {
+    all_replicas.push_back(replica);
+  }
+
+  for (auto codec : { vds::erasure_codec_id::gf16_vandermonde, vds::erasure_codec_id::gf8_cauchy }) {
+    GET_EXPECTED_GTEST(encoder, vds::erasure_codec::create_encoder(codec, k, all_replicas));
+    GET_EXPECTED_GTEST(decoder, vds::erasure_codec::create_decoder(codec, k));
+    ASSERT_EQ(codec, encoder->codec());
+    ASSERT_EQ(codec, decoder->codec());
+
+    for (size_t size : { size_t(0), size_t(1), size_t(k - 1), size_t(2 * k), size_t(100000 + 13) }) {
+      const auto data = random_data(size);
+      GET_EXPECTED_GTEST(chunks, encoder->write(data.data(), size));
+      ASSERT_EQ(all_replicas.size(), chunks.size());
+
+      //Data replicas only, parity replicas only and a random mix
+      std::vector<std::vector<uint16_t>> sets;
+      sets.push_back(std::vector<uint16_t>(all_replicas.begin(), all_replicas.begin() + k));
+      sets.push_back(std::vector<uint16_t>(all_replicas.end() - k, all_replicas.end()));
+      sets.push_back(random_replicas(k, n));
+
+      for (const auto & replicas : sets) {
+        std::vector<vds::const_data_buffer> selected;
+        for (auto replica : replicas) {
+          selected.push_back(chunks[replica]);
+        }
+
+        GET_EXPECTED_GTEST(result, decoder->restore(replicas, selected));
+        ASSERT_EQ(vds::const_data_buffer(data.data(), data.size()), result);
+      }
+    }
+  }
+}
+
+TEST(erasure_codec_tests, test_cauchy_systematic) {
+  const uint16_t k = 4;
+  const uint8_t data[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+
+  vds::cauchy_encoder encoder(k, { 0, 1, 2, 3, 4 });
+  GET_EXPECTED_GTEST(chunks, encoder.write(data, sizeof(data)));
+
+  //Segments of 3 bytes, 2 zero bytes of padding
+  ASSERT_EQ(vds::const_data_buffer("\x01\x02\x03\x00\x02", 5), chunks[0]);
+  ASSERT_EQ(vds::const_data_buffer("\x0A\x00\x00\x00\x02", 5), chunks[3]);
+  ASSERT_EQ(5, chunks[4].size());
+}
+
+TEST(erasure_codec_tests, test_codec_repair) {
+  const uint16_t k = 32;
+  const uint16_t n = 64;
+  const size_t size = 256 * 1024 + 5;
+  const auto data = random_data(size);
+
+  std::vector<uint16_t> all_replicas;
+  for (uint16_t replica = 0; replica < n; ++replica) {
+    all_replicas.push_back(replica);
+  }
+  const auto replicas = random_replicas(k, n);
+
+  for (auto codec : { vds::erasure_codec_id::gf16_vandermonde, vds::erasure_codec_id::gf8_cauchy }) {
+    GET_EXPECTED_GTEST(encoder, vds::erasure_codec::create_encoder(codec, k, all_replicas));
+    GET_EXPECTED_GTEST(decoder, vds::erasure_codec::create_decoder(codec, k));
+    GET_EXPECTED_GTEST(chunks, encoder->write(data.data(), size));
+
+    std::vector<vds::const_data_buffer> selected;
+    for (auto replica : replicas) {
+      selected.push_back(chunks[replica]);
+    }
+
+    //A lost replica is rebuilt from k others and matches the original one
+    for (auto lost : { uint16_t(0), uint16_t(k), uint16_t(n - 1) }) {
+      GET_EXPECTED_GTEST(repair_encoder, vds::erasure_codec::create_encoder(codec, k, { lost }));
+      GET_EXPECTED_GTEST(restored, decoder->restore(replicas, selected));
+      GET_EXPECTED_GTEST(repaired, repair_encoder->write(restored.data(), restored.size()));
+      ASSERT_EQ(chunks[lost], repaired[0]);
+    }
+  }
+}
+
+TEST(erasure_codec_tests, test_codec_coexistence) {
+  const uint16_t k = 16;
+  const uint16_t n = 32;
+  const size_t size = 64 * 1024 + 17;
+  const auto data = random_data(size);
+
+  std::vector<uint16_t> all_replicas;
+  for (uint16_t replica = 0; replica < n; ++replica) {
+    all_replicas.push_back(replica);
+  }
+  const auto replicas = random_replicas(k, n);
+
+  //A node keeps a decoder per codec and picks it by the codec recorded with the block
+  std::map<vds::erasure_codec_id, std::unique_ptr<vds::erasure_decoder>> decoders;
+  for (auto codec : { vds::erasure_codec_id::gf16_vandermonde, vds::erasure_codec_id::gf8_cauchy }) {
+    GET_EXPECTED_GTEST(decoder, vds::erasure_codec::create_decoder(codec, k));
+    decoders[codec] = std::move(decoder);
+  }
+
+  for (auto codec : { vds::erasure_codec_id::gf16_vandermonde, vds::erasure_codec_id::gf8_cauchy }) {
+    GET_EXPECTED_GTEST(encoder, vds::erasure_codec::create_encoder(codec, k, all_replicas));
+    GET_EXPECTED_GTEST(chunks, encoder->write(data.data(), size));
+
+    std::vector<vds::const_data_buffer> selected;
+    for (auto replica : replicas) {
+      selected.push_back(chunks[replica]);
+    }
+
+    GET_EXPECTED_GTEST(result, decoders[codec]->restore(replicas, selected));
+    ASSERT_EQ(vds::const_data_buffer(data.data(), data.size()), result);
+
+    //The default codec of the node does not give the block back
+    const auto other = (vds::erasure_codec_id::gf16_vandermonde == codec)
+      ? vds::erasure_codec_id::gf8_cauchy
+      : vds::erasure_codec_id::gf16_vandermonde;
+    auto wrong = decoders[other]->restore(replicas, selected);
+    ASSERT_TRUE(wrong.has_error() || vds::const_data_buffer(data.data(), data.size()) != wrong.value());
+  }
+}
@@ -62,4 +62,29 @@ TEST(gf_tests, test_math) {
         ASSERT_EQ(math.sub(p, x), y);
         ASSERT_EQ(math.sub(p, y), x);
     }
-}
\ No newline at end of file
+}
+TEST(gf_tests, test_mul_add_region) {
+    static const vds::gf_math<uint16_t> math;
+
+    //Lengths around the vector widths check the scalar tails
+    for (size_t count : { 0, 1, 7, 8, 15, 16, 17, 31, 32, 33, 63, 100, 1000 }) {
+        for (int round = 0; round < 10; ++round) {
+            const uint16_t coeff = (round < 2) ? uint16_t(round) : uint16_t(std::rand() & 0xFFFF);
+
+            std::vector<uint16_t> src(count);
+            std::vector<uint16_t> dst(count);
+            for (size_t i = 0; i < count; ++i) {
+                src[i] = uint16_t(std::rand() & 0xFFFF);
+                dst[i] = uint16_t(std::rand() & 0xFFFF);
+            }
+
+            std::vector<uint16_t> expected(dst);
+            for (size_t i = 0; i < count; ++i) {
+                expected[i] = math.add(expected[i], math.mul(coeff, src[i]));
+            }
+
+            math.mul_add_region(dst.data(), src.data(), coeff, count);
+            ASSERT_EQ(expected, dst) << "count " << count << ", coeff " << coeff;
+        }
+    }
+}
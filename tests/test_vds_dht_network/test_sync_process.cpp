@@ -271,6 +271,7 @@ vds::expected<void> test_server::start(const std::shared_ptr<transport_hab> & ha
 
   registrator_.add(logger_);
   registrator_.add(mt_service_);
+  registrator_.add(async_file_service_);
   registrator_.add(task_manager_);
   registrator_.add(server_);
 
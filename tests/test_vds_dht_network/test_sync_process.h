@@ -168,6 +168,7 @@ private:
   vds::service_registrator registrator_;
   vds::file_logger logger_;
   vds::mt_service mt_service_;
+  vds::async_file_service async_file_service_;
   vds::task_manager task_manager_;
   mock_sync_server server_;
 
@@ -725,6 +725,7 @@ vds::expected<void> mock_server::start()
   }
  
   this->registrator_.add(this->mt_service_);
+  this->registrator_.add(this->async_file_service_);
   this->registrator_.add(this->logger_);
   this->registrator_.add(this->task_manager_);
   if (this->allow_network_) {
@@ -761,6 +762,7 @@ vds::expected<void> mock_server::init(
   vds::service_registrator registrator;
 
   vds::mt_service mt_service;
+  vds::async_file_service async_file_service;
   vds::network_service network_service;
   vds::file_logger logger(
     test_config::instance().log_level(),
@@ -777,6 +779,7 @@ vds::expected<void> mock_server::init(
   CHECK_EXPECTED(folder.create());
 
   registrator.add(mt_service);
+  registrator.add(async_file_service);
   registrator.add(logger);
   registrator.add(task_manager);
   registrator.add(crypto_service);
@@ -59,6 +59,7 @@ private:
 
   vds::service_registrator registrator_;
   vds::mt_service mt_service_;
+  vds::async_file_service async_file_service_;
   vds::network_service network_service_;
   vds::file_logger logger_;
   vds::task_manager task_manager_;
@@ -0,0 +1,61 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include "store_block_transaction.h"
+#include "test_config.h"
+
+TEST(test_store_block_transaction, test_legacy_record)
+{
+  const vds::const_data_buffer owner_id("owner", 5);
+  const vds::const_data_buffer object_id("object", 6);
+  const std::vector<vds::const_data_buffer> replicas = {
+    vds::const_data_buffer("replica0", 8),
+    vds::const_data_buffer("replica1", 8) };
+  const vds::const_data_buffer owner_sig("signature", 9);
+
+  //The layout of the records written before the codec was stored with the block
+  vds::binary_serializer s;
+  CHECK_EXPECTED_GTEST(s << owner_id);
+  CHECK_EXPECTED_GTEST(s << object_id);
+  CHECK_EXPECTED_GTEST(s << uint64_t(100000));
+  CHECK_EXPECTED_GTEST(s << uint32_t(4096));
+  CHECK_EXPECTED_GTEST(s << replicas);
+  CHECK_EXPECTED_GTEST(s << owner_sig);
+  const auto data = s.move_data();
+
+  ASSERT_NE(
+    vds::transactions::store_block_legacy_transaction::message_id,
+    vds::transactions::store_block_transaction::message_id);
+
+  vds::binary_deserializer d(data);
+  GET_EXPECTED_GTEST(legacy, vds::message_deserialize<vds::transactions::store_block_legacy_transaction>(d));
+  ASSERT_EQ(0, d.size());
+
+  const auto message = legacy.upgrade();
+  ASSERT_EQ(static_cast<uint8_t>(vds::erasure_codec_id::gf16_vandermonde), message.codec);
+  ASSERT_EQ(owner_id, message.owner_id);
+  ASSERT_EQ(object_id, message.object_id);
+  ASSERT_EQ(100000, message.object_size);
+  ASSERT_EQ(4096, message.replica_size);
+  ASSERT_EQ(replicas, message.replicas);
+  ASSERT_EQ(owner_sig, message.owner_sig);
+
+  //The current record keeps the codec of the block
+  GET_EXPECTED_GTEST(coded, vds::message_create<vds::transactions::store_block_transaction>(
+    owner_id,
+    object_id,
+    uint64_t(100000),
+    uint32_t(4096),
+    static_cast<uint8_t>(vds::erasure_codec_id::gf8_cauchy),
+    replicas,
+    owner_sig));
+  GET_EXPECTED_GTEST(coded_data, vds::message_serialize(coded));
+
+  vds::binary_deserializer coded_d(coded_data);
+  GET_EXPECTED_GTEST(restored, vds::message_deserialize<vds::transactions::store_block_transaction>(coded_d));
+  ASSERT_EQ(static_cast<uint8_t>(vds::erasure_codec_id::gf8_cauchy), restored.codec);
+  ASSERT_EQ(replicas, restored.replicas);
+}
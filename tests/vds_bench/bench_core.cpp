@@ -0,0 +1,601 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include "bench_runner.h"
+#include "async_task.h"
+#include "async_frame_pool.h"
+#include "mt_service.h"
+#include "task_manager.h"
+#include "binary_serialize.h"
+#include "const_data_buffer.h"
+#include "encoding.h"
+#include "thread_apartment.h"
+
+static vds::async_task<vds::expected<int>> ready_value(int v) {
+  co_return v;
+}
+
+static vds::async_task<vds::expected<int>> await_ready_value(int v) {
+  GET_EXPECTED_ASYNC(result, co_await ready_value(v));
+  co_return result + 1;
+}
+
+static vds::async_task<vds::expected<int>> await_result(vds::async_task<vds::expected<int>> && f) {
+  GET_EXPECTED_ASYNC(result, co_await std::move(f));
+  co_return result + 1;
+}
+
+//Coroutine frames are counted by async_frame_pool; frames which missed the pool came from the heap
+static vds::expected<void> print_frames(const bench_runner & runner, const std::string & name, const bench_runner::body_t & body) {
+  static constexpr size_t count = 10000;
+
+  if (!runner.is_selected(name)) {
+    return vds::expected<void>();
+  }
+
+  const auto before = vds::async_frame_pool::get_statistic();
+  CHECK_EXPECTED(body(count));
+  const auto after = vds::async_frame_pool::get_statistic();
+
+  std::cout
+    << name << ": " << double(after.allocations - before.allocations) / count << " frames per operation, "
+    << double((after.allocations - after.pool_hits) - (before.allocations - before.pool_hits)) / count
+    << " from the heap" << std::endl;
+  return vds::expected<void>();
+}
+
+//The mutex-guarded on-demand pool which mt_service used before the work-stealing scheduler.
+//Kept as the reference point for the mt_service numbers.
+class legacy_mt_pool {
+public:
+  legacy_mt_pool()
+  : free_threads_(0), is_shuting_down_(false) {
+  }
+
+  ~legacy_mt_pool() {
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    this->is_shuting_down_ = true;
+    this->cond_.notify_all();
+    lock.unlock();
+
+    for (auto & t : this->work_threads_) {
+      t.join();
+    }
+  }
+
+  void do_async(vds::lambda_holder_t<void> handler) {
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    this->queue_.push(std::move(handler));
+    if (0 == this->free_threads_) {
+      auto count = std::thread::hardware_concurrency();
+      if (count < 1) {
+        count = 1;
+      }
+      if (this->work_threads_.size() < 16 * count) {
+        this->work_threads_.emplace_back([this]() { this->work_thread(); });
+        return;
+      }
+    }
+
+    this->cond_.notify_one();
+  }
+
+private:
+  std::list<std::thread> work_threads_;
+  unsigned int free_threads_;
+  bool is_shuting_down_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::queue<vds::lambda_holder_t<void>> queue_;
+
+  void work_thread() {
+    for (;;) {
+      std::unique_lock<std::mutex> lock(this->mutex_);
+      if (this->queue_.empty()) {
+        if (8 < ++this->free_threads_ || this->is_shuting_down_) {
+          --this->free_threads_;
+          break;
+        }
+        do {
+          this->cond_.wait(lock);
+        } while (this->queue_.empty() && !this->is_shuting_down_);
+        --this->free_threads_;
+
+        if (this->is_shuting_down_) {
+          continue;
+        }
+      }
+
+      auto handler = std::move(this->queue_.front());
+      this->queue_.pop();
+
+      lock.unlock();
+
+      handler();
+    }
+  }
+};
+
+//Every task schedules the next one of its chain from the worker thread,
+//the same way a resumed coroutine schedules its continuation
+template <typename scheduler_type>
+class scheduler_chains {
+public:
+  static constexpr size_t max_chains = 128;
+
+  scheduler_chains(scheduler_type & scheduler, size_t task_count)
+  : scheduler_(scheduler),
+    chain_count_(std::min(task_count, max_chains)),
+    chain_length_((task_count + chain_count_ - 1) / chain_count_),
+    done_(chain_count_) {
+  }
+
+  void run() {
+    for (size_t i = 0; i < this->chain_count_; ++i) {
+      this->schedule(0);
+    }
+    this->done_.wait();
+  }
+
+private:
+  scheduler_type & scheduler_;
+  size_t chain_count_;
+  size_t chain_length_;
+  vds::barrier done_;
+
+  void schedule(size_t step) {
+    this->scheduler_.do_async([this, step]() {
+      if (step + 1 < this->chain_length_) {
+        this->schedule(step + 1);
+      }
+      else {
+        --this->done_;
+      }
+    });
+  }
+};
+
+//Previous mutex based thread_apartment, kept as the reference point for the lock-free one
+class legacy_thread_apartment : public std::enable_shared_from_this<legacy_thread_apartment> {
+public:
+  legacy_thread_apartment(const vds::service_provider * sp)
+    : sp_(sp) {
+  }
+
+  void schedule(vds::lambda_holder_t<vds::expected<void>> callback) {
+    std::unique_lock<std::mutex> lock(this->task_queue_mutex_);
+    const auto need_start = this->task_queue_.empty();
+    this->task_queue_.push(std::move(callback));
+    lock.unlock();
+
+    if (need_start) {
+      vds::mt_service::async(this->sp_, [pthis = this->shared_from_this()]() {
+        for (;;) {
+          std::unique_lock<std::mutex> lock(pthis->task_queue_mutex_);
+          auto & f = pthis->task_queue_.front();
+          lock.unlock();
+
+          (void)f();
+
+          lock.lock();
+          pthis->task_queue_.pop();
+          if (pthis->task_queue_.empty()) {
+            break;
+          }
+          lock.unlock();
+        }
+      });
+    }
+  }
+
+private:
+  const vds::service_provider * sp_;
+  std::mutex task_queue_mutex_;
+  std::queue<vds::lambda_holder_t<vds::expected<void>>> task_queue_;
+};
+
+//Several pool threads schedule into one apartment at once
+template <typename apartment_type>
+static void apartment_producers(const vds::service_provider * sp, const std::shared_ptr<apartment_type> & apartment, size_t count) {
+  static constexpr size_t max_producers = 8;
+
+  const auto producer_count = std::min(count, max_producers);
+  vds::barrier b;
+  size_t left = count;
+
+  for (size_t producer = 0; producer < producer_count; ++producer) {
+    const auto items = count / producer_count + ((producer < count % producer_count) ? 1 : 0);
+    vds::imt_service::async(sp, [apartment, items, &b, &left]() {
+      for (size_t i = 0; i < items; ++i) {
+        apartment->schedule([&b, &left]() -> vds::expected<void> {
+          //Callbacks run one at a time
+          if (0 == --left) {
+            b.set();
+          }
+          return vds::expected<void>();
+        });
+      }
+    });
+  }
+
+  b.wait();
+}
+
+//The byte-at-a-time base64 codec used before the vector codecs
+static std::string legacy_from_bytes(const uint8_t * data, size_t len) {
+  static const char lookup[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string result;
+  result.reserve(((len / 3) + ((len % 3 > 0) ? 1 : 0)) * 4);
+  uint32_t temp;
+
+  for (; 2 < len; len -= 3) {
+    temp = (*data++) << 16;
+    temp += (*data++) << 8;
+    temp += (*data++);
+    result.append(1, lookup[(temp & 0x00FC0000) >> 18]);
+    result.append(1, lookup[(temp & 0x0003F000) >> 12]);
+    result.append(1, lookup[(temp & 0x00000FC0) >> 6]);
+    result.append(1, lookup[(temp & 0x0000003F)]);
+  }
+
+  switch (len) {
+  case 1:
+    temp = *data << 16;
+    result.append(1, lookup[(temp & 0x00FC0000) >> 18]);
+    result.append(1, lookup[(temp & 0x0003F000) >> 12]);
+    result.append(2, '=');
+    break;
+  case 2:
+    temp = (*data++) << 16;
+    temp += *data << 8;
+    result.append(1, lookup[(temp & 0x00FC0000) >> 18]);
+    result.append(1, lookup[(temp & 0x0003F000) >> 12]);
+    result.append(1, lookup[(temp & 0x00000FC0) >> 6]);
+    result.append(1, '=');
+    break;
+  }
+
+  return result;
+}
+
+static bool legacy_to_bytes(const std::string & data, std::vector<uint8_t> & result) {
+  uint32_t temp = 0;
+  size_t quantum = 0;
+  for (auto ch : data) {
+    temp <<= 6;
+    if (ch >= 'A' && ch <= 'Z') {
+      temp |= ch - 'A';
+    }
+    else if (ch >= 'a' && ch <= 'z') {
+      temp |= ch - 'a' + 26;
+    }
+    else if (ch >= '0' && ch <= '9') {
+      temp |= ch - '0' + 52;
+    }
+    else if (ch == '+') {
+      temp |= 62;
+    }
+    else if (ch == '/') {
+      temp |= 63;
+    }
+    else if (ch == '=') {
+      break;
+    }
+    else {
+      return false;
+    }
+
+    if (4 == ++quantum) {
+      result.push_back(static_cast<uint8_t>(temp >> 16));
+      result.push_back(static_cast<uint8_t>(temp >> 8));
+      result.push_back(static_cast<uint8_t>(temp));
+      quantum = 0;
+    }
+  }
+
+  if (2 == quantum) {
+    result.push_back(static_cast<uint8_t>(temp >> 4));
+  }
+  else if (3 == quantum) {
+    result.push_back(static_cast<uint8_t>(temp >> 10));
+    result.push_back(static_cast<uint8_t>(temp >> 2));
+  }
+
+  return true;
+}
+
+static vds::const_data_buffer make_buffer(size_t size) {
+  std::vector<uint8_t> data(size);
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = static_cast<uint8_t>(i * 31 + 7);
+  }
+  return vds::const_data_buffer(data.data(), data.size());
+}
+
+//Retransmission queue of dht_datagram_protocol: each datagram is stored in the output queue,
+//copied into the udp_datagram and captured by the send task on every transmission
+static vds::expected<void> datagram_path(const vds::const_data_buffer & payload, bool shared, size_t count) {
+  constexpr int retransmits = 2;
+
+  std::map<uint32_t, vds::const_data_buffer> output_messages;
+  for (uint32_t index = 0; index < count; ++index) {
+    vds::const_data_buffer datagram(payload.data(), payload.size());
+    if (shared) {
+      datagram.share();
+    }
+    output_messages.emplace(index, datagram);
+  }
+
+  for (int i = 0; i <= retransmits; ++i) {
+    for (const auto & p : output_messages) {
+      const vds::const_data_buffer udp_datagram(p.second);
+      const auto send_task = [udp_datagram]() { return udp_datagram.size(); };
+      if (send_task() != payload.size()) {
+        return vds::make_unexpected<std::runtime_error>("Invalid size");
+      }
+    }
+  }
+
+  return vds::expected<void>();
+}
+
+static vds::expected<void> serialize_message(
+  vds::binary_serializer & s,
+  uint32_t version,
+  const vds::const_data_buffer & id,
+  const vds::const_data_buffer & payload) {
+  CHECK_EXPECTED(s << version);
+  CHECK_EXPECTED(s << uint64_t(0x123456789));
+  CHECK_EXPECTED(s << std::string("replica"));
+  CHECK_EXPECTED(s << id);
+  CHECK_EXPECTED(s << payload);
+  return vds::expected<void>();
+}
+
+vds::expected<void> core_benchmarks(bench_runner & runner, const vds::service_provider * sp) {
+  //co_await of a task which is already complete
+  const bench_runner::body_t await_ready = [](size_t count) -> vds::expected<void> {
+    for (size_t i = 0; i < count; ++i) {
+      GET_EXPECTED(result, await_ready_value(static_cast<int>(i)).get());
+      if (result != static_cast<int>(i) + 1) {
+        return vds::make_unexpected<std::runtime_error>("Invalid result");
+      }
+    }
+    return vds::expected<void>();
+  };
+  CHECK_EXPECTED(runner.run("async_task.await_ready", await_ready));
+  CHECK_EXPECTED(print_frames(runner, "async_task.await_ready", await_ready));
+
+  //co_await suspends and the producer completes the task later
+  const bench_runner::body_t await_suspended = [](size_t count) -> vds::expected<void> {
+    for (size_t i = 0; i < count; ++i) {
+      vds::async_result<vds::expected<int>> p;
+      auto f = await_result(p.get_future());
+      p.set_value(static_cast<int>(i));
+      GET_EXPECTED(result, f.get());
+      if (result != static_cast<int>(i) + 1) {
+        return vds::make_unexpected<std::runtime_error>("Invalid result");
+      }
+    }
+    return vds::expected<void>();
+  };
+  CHECK_EXPECTED(runner.run("async_task.await_suspended", await_suspended));
+  CHECK_EXPECTED(print_frames(runner, "async_task.await_suspended", await_suspended));
+
+  //Dispatch a batch of tasks from this thread and wait until the pool has run all of them
+  CHECK_EXPECTED(runner.run("mt_service.dispatch", [sp](size_t count) -> vds::expected<void> {
+    vds::barrier b;
+    std::atomic<size_t> left(count);
+    for (size_t i = 0; i < count; ++i) {
+      vds::imt_service::async(sp, [&b, &left]() {
+        if (1 == left.fetch_sub(1)) {
+          b.set();
+        }
+      });
+    }
+    b.wait();
+    return vds::expected<void>();
+  }));
+
+  auto scheduler = sp->get<vds::imt_service>();
+  CHECK_EXPECTED(runner.run("mt_service.chain", [scheduler](size_t count) -> vds::expected<void> {
+    scheduler_chains<vds::imt_service>(*scheduler, count).run();
+    return vds::expected<void>();
+  }));
+
+  legacy_mt_pool legacy_pool;
+  CHECK_EXPECTED(runner.run("mt_service.chain_legacy", [&legacy_pool](size_t count) -> vds::expected<void> {
+    scheduler_chains<legacy_mt_pool>(legacy_pool, count).run();
+    return vds::expected<void>();
+  }));
+
+  auto apartment = std::make_shared<vds::thread_apartment>(sp);
+  CHECK_EXPECTED(runner.run("thread_apartment.schedule", [apartment](size_t count) -> vds::expected<void> {
+    vds::barrier b;
+    size_t left = count;
+    for (size_t i = 0; i < count; ++i) {
+      apartment->schedule([&b, &left]() -> vds::expected<void> {
+        if (0 == --left) {
+          b.set();
+        }
+        return vds::expected<void>();
+      });
+    }
+    b.wait();
+    return vds::expected<void>();
+  }));
+
+  CHECK_EXPECTED(runner.run("thread_apartment.producers", [sp, apartment](size_t count) -> vds::expected<void> {
+    apartment_producers(sp, apartment, count);
+    return vds::expected<void>();
+  }));
+
+  auto legacy_apartment = std::make_shared<legacy_thread_apartment>(sp);
+  CHECK_EXPECTED(runner.run("thread_apartment.producers_legacy", [sp, legacy_apartment](size_t count) -> vds::expected<void> {
+    apartment_producers(sp, legacy_apartment, count);
+    return vds::expected<void>();
+  }));
+
+  CHECK_EXPECTED(apartment->prepare_to_stop().get());
+
+  const auto stat = apartment->get_statistic();
+  if (0 < stat.processed) {
+    std::cout
+      << "thread_apartment: max depth " << stat.max_queue_size
+      << ", batches " << stat.batches
+      << ", avg wait " << (stat.total_wait.count() / stat.processed) << " ns"
+      << ", max wait " << stat.max_wait.count() << " ns"
+      << ", avg execute " << (stat.total_execute.count() / stat.processed) << " ns"
+      << std::endl;
+  }
+
+  //A message shaped like the DHT ones: a few numbers, an id and a payload
+  const auto id = make_buffer(32);
+  const auto payload = make_buffer(1024);
+  vds::binary_serializer message;
+  CHECK_EXPECTED(serialize_message(message, 1, id, payload));
+  const auto message_data = message.move_data();
+
+  CHECK_EXPECTED(runner.run("binary_serializer.message", message_data.size(), [&id, &payload](size_t count) -> vds::expected<void> {
+    vds::binary_serializer s;
+    for (size_t i = 0; i < count; ++i) {
+      s.clear();
+      CHECK_EXPECTED(serialize_message(s, static_cast<uint32_t>(i), id, payload));
+    }
+    return vds::expected<void>();
+  }));
+
+  CHECK_EXPECTED(runner.run("binary_deserializer.message", message_data.size(), [&message_data](size_t count) -> vds::expected<void> {
+    for (size_t i = 0; i < count; ++i) {
+      vds::binary_deserializer s(message_data);
+      uint32_t version;
+      uint64_t number;
+      std::string name;
+      vds::const_data_buffer id;
+      vds::const_data_buffer payload;
+      CHECK_EXPECTED(s >> version);
+      CHECK_EXPECTED(s >> number);
+      CHECK_EXPECTED(s >> name);
+      CHECK_EXPECTED(s >> id);
+      CHECK_EXPECTED(s >> payload);
+    }
+    return vds::expected<void>();
+  }));
+
+  const auto block = make_buffer(64 * 1024);
+  CHECK_EXPECTED(runner.run("const_data_buffer.copy_64k", block.size(), [&block](size_t count) -> vds::expected<void> {
+    for (size_t i = 0; i < count; ++i) {
+      vds::const_data_buffer copy(block);
+      if (copy.size() != block.size()) {
+        return vds::make_unexpected<std::runtime_error>("Invalid size");
+      }
+    }
+    return vds::expected<void>();
+  }));
+
+  auto shared_block = make_buffer(64 * 1024);
+  shared_block.share();
+  CHECK_EXPECTED(runner.run("const_data_buffer.copy_64k_shared", shared_block.size(), [&shared_block](size_t count) -> vds::expected<void> {
+    for (size_t i = 0; i < count; ++i) {
+      vds::const_data_buffer copy(shared_block);
+      if (copy.size() != shared_block.size()) {
+        return vds::make_unexpected<std::runtime_error>("Invalid size");
+      }
+    }
+    return vds::expected<void>();
+  }));
+
+  //Four lookups per datagram: logger, db_model, network client and imt_service
+  CHECK_EXPECTED(runner.run("service_provider.get_slot", [sp](size_t count) -> vds::expected<void> {
+    for (size_t i = 0; i < count; ++i) {
+      if (nullptr == sp->get<vds::logger>()) {
+        return vds::make_unexpected<std::runtime_error>("Invalid result");
+      }
+    }
+    return vds::expected<void>();
+  }));
+
+  CHECK_EXPECTED(runner.run("service_provider.get_dynamic", [sp](size_t count) -> vds::expected<void> {
+    for (size_t i = 0; i < count; ++i) {
+      if (nullptr == sp->get<vds::task_manager>()) {
+        return vds::make_unexpected<std::runtime_error>("Invalid result");
+      }
+    }
+    return vds::expected<void>();
+  }));
+
+  const auto datagram = make_buffer(1400);
+  CHECK_EXPECTED(runner.run("const_data_buffer.datagram_path", datagram.size(), [&datagram](size_t count) -> vds::expected<void> {
+    return datagram_path(datagram, false, count);
+  }));
+
+  CHECK_EXPECTED(runner.run("const_data_buffer.datagram_path_shared", datagram.size(), [&datagram](size_t count) -> vds::expected<void> {
+    return datagram_path(datagram, true, count);
+  }));
+
+  const auto id_text = vds::base64::from_bytes(id);
+  CHECK_EXPECTED(runner.run("base64.encode_32", id.size(), [&id](size_t count) -> vds::expected<void> {
+    for (size_t i = 0; i < count; ++i) {
+      if (vds::base64::from_bytes(id).empty()) {
+        return vds::make_unexpected<std::runtime_error>("Invalid result");
+      }
+    }
+    return vds::expected<void>();
+  }));
+
+  CHECK_EXPECTED(runner.run("base64.decode_32", id.size(), [&id_text](size_t count) -> vds::expected<void> {
+    for (size_t i = 0; i < count; ++i) {
+      CHECK_EXPECTED(vds::base64::to_bytes(id_text));
+    }
+    return vds::expected<void>();
+  }));
+
+  const auto block_text = vds::base64::from_bytes(block);
+  CHECK_EXPECTED(runner.run("base64.encode_64k", block.size(), [&block](size_t count) -> vds::expected<void> {
+    for (size_t i = 0; i < count; ++i) {
+      if (vds::base64::from_bytes(block).empty()) {
+        return vds::make_unexpected<std::runtime_error>("Invalid result");
+      }
+    }
+    return vds::expected<void>();
+  }));
+
+  CHECK_EXPECTED(runner.run("base64.decode_64k", block.size(), [&block_text](size_t count) -> vds::expected<void> {
+    for (size_t i = 0; i < count; ++i) {
+      CHECK_EXPECTED(vds::base64::to_bytes(block_text));
+    }
+    return vds::expected<void>();
+  }));
+
+  CHECK_EXPECTED(runner.run("base64.encode_64k_legacy", block.size(), [&block](size_t count) -> vds::expected<void> {
+    for (size_t i = 0; i < count; ++i) {
+      if (legacy_from_bytes(block.data(), block.size()).empty()) {
+        return vds::make_unexpected<std::runtime_error>("Invalid result");
+      }
+    }
+    return vds::expected<void>();
+  }));
+
+  CHECK_EXPECTED(runner.run("base64.decode_64k_legacy", block.size(), [&block_text](size_t count) -> vds::expected<void> {
+    for (size_t i = 0; i < count; ++i) {
+      std::vector<uint8_t> result;
+      if (!legacy_to_bytes(block_text, result)) {
+        return vds::make_unexpected<std::runtime_error>("Invalid result");
+      }
+    }
+    return vds::expected<void>();
+  }));
+
+  return vds::expected<void>();
+}
@@ -0,0 +1,39 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include "bench_runner.h"
+#include "hash.h"
+
+vds::expected<void> crypto_benchmarks(bench_runner & runner, const vds::service_provider * /*sp*/) {
+  std::vector<uint8_t> data(64 * 1024);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<uint8_t>(i * 31 + 7);
+  }
+
+  CHECK_EXPECTED(runner.run("sha256.32", 32, [&data](size_t count) -> vds::expected<void> {
+    for (size_t i = 0; i < count; ++i) {
+      CHECK_EXPECTED(vds::hash::signature(vds::hash::sha256(), data.data(), 32));
+    }
+    return vds::expected<void>();
+  }));
+
+  CHECK_EXPECTED(runner.run("sha256.64k", data.size(), [&data](size_t count) -> vds::expected<void> {
+    for (size_t i = 0; i < count; ++i) {
+      CHECK_EXPECTED(vds::hash::signature(vds::hash::sha256(), data.data(), data.size()));
+    }
+    return vds::expected<void>();
+  }));
+
+  const vds::const_data_buffer key(data.data(), 32);
+  CHECK_EXPECTED(runner.run("hmac_sha256.1k", 1024, [&data, &key](size_t count) -> vds::expected<void> {
+    for (size_t i = 0; i < count; ++i) {
+      CHECK_EXPECTED(vds::hmac::signature(key, vds::hash::sha256(), data.data(), 1024));
+    }
+    return vds::expected<void>();
+  }));
+
+  return vds::expected<void>();
+}
@@ -0,0 +1,167 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include <cstring>
+#include "bench_runner.h"
+#include "chunk.h"
+#include "chunk_decoder_cache.h"
+#include "erasure_codec.h"
+
+//Same geometry as the DHT replicas
+static constexpr uint16_t min_horcrux = 32;
+static constexpr uint16_t generate_horcrux = 64;
+static constexpr size_t block_size = 256 * 1024;
+
+//Drops the encoded stream
+class null_output_async : public vds::stream_output_async<uint8_t> {
+public:
+  vds::async_task<vds::expected<void>> write_async(const uint8_t * /*data*/, size_t /*len*/) override {
+    co_return vds::expected<void>();
+  }
+};
+
+vds::expected<void> data_benchmarks(bench_runner & runner, const vds::service_provider * sp) {
+  std::vector<uint16_t> left(4096);
+  std::vector<uint16_t> right(4096);
+  for (size_t i = 0; i < left.size(); ++i) {
+    left[i] = static_cast<uint16_t>(i * 40503 + 1);
+    right[i] = static_cast<uint16_t>(i * 2654435761u + 3);
+  }
+
+  const auto & math = vds::chunk<uint16_t>::math();
+  CHECK_EXPECTED(runner.run("gf16.mul_4096", left.size() * sizeof(uint16_t), [&left, &right, &math](size_t count) -> vds::expected<void> {
+    uint16_t result = 0;
+    for (size_t i = 0; i < count; ++i) {
+      for (size_t j = 0; j < left.size(); ++j) {
+        result = math.add(result, math.mul(left[j], right[j]));
+      }
+    }
+    //Keep the loop from being optimized away
+    volatile uint16_t sink = result;
+    (void)sink;
+    return vds::expected<void>();
+  }));
+
+  std::vector<uint8_t> data(block_size);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<uint8_t>(i * 31 + 7);
+  }
+
+  vds::chunk_generator<uint16_t> generator(min_horcrux, 1);
+  CHECK_EXPECTED(runner.run("chunk_generator.encode_256k", data.size(), [&generator, &data](size_t count) -> vds::expected<void> {
+    vds::binary_serializer s;
+    for (size_t i = 0; i < count; ++i) {
+      s.clear();
+      CHECK_EXPECTED(generator.write(s, data.data(), data.size()));
+    }
+    return vds::expected<void>();
+  }));
+
+  //16 stripes of 1 MiB through the parallel stream encoder
+  std::vector<uint8_t> stream_data(16 * 1024 * 1024);
+  for (size_t i = 0; i < stream_data.size(); ++i) {
+    stream_data[i] = static_cast<uint8_t>(i * 31 + 7);
+  }
+  auto stream_generator = std::make_shared<vds::chunk_generator<uint16_t>>(min_horcrux, 1);
+  CHECK_EXPECTED(runner.run("chunk_output_async.encode_16m", stream_data.size(), [sp, &stream_generator, &stream_data](size_t count) -> vds::expected<void> {
+    for (size_t i = 0; i < count; ++i) {
+      auto output = std::make_shared<vds::chunk_output_async<uint16_t>>(sp, stream_generator, std::make_shared<null_output_async>());
+      CHECK_EXPECTED(output->write_async(stream_data.data(), stream_data.size()).get());
+      CHECK_EXPECTED(output->write_async(nullptr, 0).get());
+    }
+    return vds::expected<void>();
+  }));
+
+  std::vector<uint16_t> all_replicas;
+  for (uint16_t replica = 0; replica < generate_horcrux; ++replica) {
+    all_replicas.push_back(replica);
+  }
+
+  vds::chunk_replica_generator replica_generator(min_horcrux, all_replicas);
+  CHECK_EXPECTED(runner.run("chunk_replica_generator.encode_256k_x64", data.size(), [&replica_generator, &data](size_t count) -> vds::expected<void> {
+    for (size_t i = 0; i < count; ++i) {
+      CHECK_EXPECTED(replica_generator.write(data.data(), data.size()));
+    }
+    return vds::expected<void>();
+  }));
+
+  std::vector<uint16_t> replicas;
+  std::vector<vds::const_data_buffer> chunks;
+  for (uint16_t replica = 1; replica <= min_horcrux; ++replica) {
+    vds::chunk_generator<uint16_t> replica_generator(min_horcrux, replica);
+    vds::binary_serializer s;
+    CHECK_EXPECTED(replica_generator.write(s, data.data(), data.size()));
+    replicas.push_back(replica);
+    chunks.push_back(s.move_data());
+  }
+
+  vds::chunk_restore<uint16_t> restore(min_horcrux, replicas.data());
+  GET_EXPECTED(restored, restore.restore(chunks));
+  if (restored.size() != data.size() || 0 != memcmp(restored.data(), data.data(), data.size())) {
+    return vds::make_unexpected<std::runtime_error>("chunk_restore returned invalid data");
+  }
+
+  CHECK_EXPECTED(runner.run("chunk_restore.decode_256k", data.size(), [&restore, &chunks](size_t count) -> vds::expected<void> {
+    for (size_t i = 0; i < count; ++i) {
+      CHECK_EXPECTED(restore.restore(chunks));
+    }
+    return vds::expected<void>();
+  }));
+
+  //The matrix inversion is included, as restore_async did before the decoder cache
+  CHECK_EXPECTED(runner.run("chunk_restore.invert_and_decode_256k", data.size(), [&replicas, &chunks](size_t count) -> vds::expected<void> {
+    for (size_t i = 0; i < count; ++i) {
+      vds::chunk_restore<uint16_t> restore(min_horcrux, replicas.data());
+      CHECK_EXPECTED(restore.restore(chunks));
+    }
+    return vds::expected<void>();
+  }));
+
+  vds::chunk_decoder_cache decoders(min_horcrux);
+  CHECK_EXPECTED(runner.run("chunk_decoder_cache.decode_256k", data.size(), [&decoders, &replicas, &chunks](size_t count) -> vds::expected<void> {
+    for (size_t i = 0; i < count; ++i) {
+      CHECK_EXPECTED(decoders.restore(replicas, chunks));
+    }
+    return vds::expected<void>();
+  }));
+
+  //Both codecs through the common interface: all replicas, k parity replicas and one lost replica
+  for (auto codec : { vds::erasure_codec_id::gf16_vandermonde, vds::erasure_codec_id::gf8_cauchy }) {
+    const std::string name = (vds::erasure_codec_id::gf8_cauchy == codec) ? "erasure.gf8_cauchy" : "erasure.gf16_vandermonde";
+
+    GET_EXPECTED(encoder, vds::erasure_codec::create_encoder(codec, min_horcrux, all_replicas));
+    GET_EXPECTED(decoder, vds::erasure_codec::create_decoder(codec, min_horcrux));
+    GET_EXPECTED(encoded, encoder->write(data.data(), data.size()));
+
+    std::vector<uint16_t> parity_replicas(all_replicas.end() - min_horcrux, all_replicas.end());
+    std::vector<vds::const_data_buffer> parity_chunks(encoded.end() - min_horcrux, encoded.end());
+
+    CHECK_EXPECTED(runner.run(name + ".encode_256k_x64", data.size(), [&encoder, &data](size_t count) -> vds::expected<void> {
+      for (size_t i = 0; i < count; ++i) {
+        CHECK_EXPECTED(encoder->write(data.data(), data.size()));
+      }
+      return vds::expected<void>();
+    }));
+
+    CHECK_EXPECTED(runner.run(name + ".decode_256k", data.size(), [&decoder, &parity_replicas, &parity_chunks](size_t count) -> vds::expected<void> {
+      for (size_t i = 0; i < count; ++i) {
+        CHECK_EXPECTED(decoder->restore(parity_replicas, parity_chunks));
+      }
+      return vds::expected<void>();
+    }));
+
+    GET_EXPECTED(repair_encoder, vds::erasure_codec::create_encoder(codec, min_horcrux, { 0 }));
+    CHECK_EXPECTED(runner.run(name + ".repair_256k", data.size(), [&decoder, &repair_encoder, &parity_replicas, &parity_chunks](size_t count) -> vds::expected<void> {
+      for (size_t i = 0; i < count; ++i) {
+        GET_EXPECTED(restored, decoder->restore(parity_replicas, parity_chunks));
+        CHECK_EXPECTED(repair_encoder->write(restored.data(), restored.size()));
+      }
+      return vds::expected<void>();
+    }));
+  }
+
+  return vds::expected<void>();
+}
@@ -0,0 +1,97 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include "bench_runner.h"
+#include "database.h"
+#include "database_orm.h"
+#include "file.h"
+
+namespace {
+  class bench_record_dbo : public vds::database_table {
+  public:
+    bench_record_dbo()
+    : database_table("bench_record"),
+      id(this, "id"),
+      name(this, "name"),
+      data(this, "data") {
+    }
+
+    vds::database_column<int64_t> id;
+    vds::database_column<std::string> name;
+    vds::database_column<vds::const_data_buffer> data;
+  };
+}
+
+static constexpr int64_t record_count = 10000;
+
+vds::expected<void> database_benchmarks(bench_runner & runner, const vds::service_provider * sp) {
+  const vds::filename db_file("vds_bench.db");
+  if (vds::file::exists(db_file)) {
+    CHECK_EXPECTED(vds::file::delete_file(db_file));
+  }
+
+  std::vector<uint8_t> payload(256);
+  for (size_t i = 0; i < payload.size(); ++i) {
+    payload[i] = static_cast<uint8_t>(i * 31 + 7);
+  }
+  const vds::const_data_buffer data(payload.data(), payload.size());
+
+  vds::database db;
+  CHECK_EXPECTED(db.open(sp, db_file));
+
+  CHECK_EXPECTED(db.async_transaction([&data](vds::database_transaction & t) -> vds::expected<bool> {
+    CHECK_EXPECTED(t.execute(
+      "CREATE TABLE bench_record(\
+      id INTEGER PRIMARY KEY NOT NULL,\
+      name VARCHAR(64) NOT NULL,\
+      data BLOB NOT NULL)"));
+
+    bench_record_dbo t1;
+    for (int64_t i = 0; i < record_count; ++i) {
+      CHECK_EXPECTED(t.execute(t1.insert(
+        t1.id = i,
+        t1.name = "record " + std::to_string(i),
+        t1.data = data)));
+    }
+    return true;
+  }).get());
+
+  //One transaction per batch, the statement is built and prepared for every row
+  int64_t next_id = record_count;
+  CHECK_EXPECTED(runner.run("database.orm_insert", [&db, &data, &next_id](size_t count) -> vds::expected<void> {
+    return db.async_transaction([&data, &next_id, count](vds::database_transaction & t) -> vds::expected<bool> {
+      bench_record_dbo t1;
+      for (size_t i = 0; i < count; ++i) {
+        const auto id = next_id++;
+        CHECK_EXPECTED(t.execute(t1.insert(
+          t1.id = id,
+          t1.name = "record " + std::to_string(id),
+          t1.data = data)));
+      }
+      return true;
+    }).get();
+  }));
+
+  CHECK_EXPECTED(runner.run("database.orm_select_by_id", [&db](size_t count) -> vds::expected<void> {
+    return db.async_read_transaction([count](vds::database_read_transaction & t) -> vds::expected<void> {
+      bench_record_dbo t1;
+      for (size_t i = 0; i < count; ++i) {
+        GET_EXPECTED(st, t.get_reader(
+          t1.select(t1.name, t1.data)
+          .where(t1.id == static_cast<int64_t>(i % record_count))));
+        GET_EXPECTED(found, st.execute());
+        if (!found || t1.data.get(st).size() != 256) {
+          return vds::make_unexpected<std::runtime_error>("Record not found");
+        }
+      }
+      return vds::expected<void>();
+    }).get();
+  }));
+
+  CHECK_EXPECTED(db.prepare_to_stop().get());
+  CHECK_EXPECTED(db.close());
+  return vds::file::delete_file(db_file);
+}
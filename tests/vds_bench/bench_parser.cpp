@@ -0,0 +1,55 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include "bench_runner.h"
+#include "encoding.h"
+#include "json_object.h"
+#include "json_parser.h"
+
+//A document shaped like the route statistics returned by the websocket API
+static std::shared_ptr<vds::json_object> make_document() {
+  auto items = std::make_shared<vds::json_array>();
+  for (int i = 0; i < 100; ++i) {
+    uint8_t node_id[32];
+    for (size_t j = 0; j < sizeof(node_id); ++j) {
+      node_id[j] = static_cast<uint8_t>(i * 32 + j);
+    }
+
+    auto item = std::make_shared<vds::json_object>();
+    item->add_property("node_id", vds::base64::from_bytes(node_id, sizeof(node_id)));
+    item->add_property("proxy", "udp://192.168.0." + std::to_string(i) + ":8050");
+    item->add_property("pinged", static_cast<uint64_t>(i % 10));
+    item->add_property("hops", static_cast<uint64_t>(i % 4));
+    items->add(item);
+  }
+
+  auto result = std::make_shared<vds::json_object>();
+  result->add_property("node_id", std::string("bench"));
+  result->add_property("items", items);
+  return result;
+}
+
+vds::expected<void> parser_benchmarks(bench_runner & runner, const vds::service_provider * /*sp*/) {
+  const auto document = make_document();
+  GET_EXPECTED(text, document->json_value::str());
+  const vds::const_data_buffer data(text.c_str(), text.length());
+
+  CHECK_EXPECTED(runner.run("json_writer.route_statistic", text.length(), [&document](size_t count) -> vds::expected<void> {
+    for (size_t i = 0; i < count; ++i) {
+      CHECK_EXPECTED(document->json_value::str());
+    }
+    return vds::expected<void>();
+  }));
+
+  CHECK_EXPECTED(runner.run("json_parser.route_statistic", data.size(), [&data](size_t count) -> vds::expected<void> {
+    for (size_t i = 0; i < count; ++i) {
+      CHECK_EXPECTED(vds::json_parser::parse("bench", data));
+    }
+    return vds::expected<void>();
+  }));
+
+  return vds::expected<void>();
+}
@@ -0,0 +1,164 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include "bench_runner.h"
+#include "file.h"
+#include "json_object.h"
+#include "json_parser.h"
+
+bench_runner::bench_runner(const options & opt)
+: options_(opt) {
+}
+
+vds::expected<void> bench_runner::run(const std::string & name, size_t bytes_per_op, const body_t & body) {
+  if (!this->is_selected(name)) {
+    return vds::expected<void>();
+  }
+
+  //Grow the batch until one sample takes long enough to be measured reliably
+  size_t batch_size = 1;
+  for (;;) {
+    const auto start = std::chrono::steady_clock::now();
+    CHECK_EXPECTED(body(batch_size));
+    if (this->options_.min_sample_time <= std::chrono::steady_clock::now() - start || batch_size >= (size_t(1) << 30)) {
+      break;
+    }
+    batch_size *= 2;
+  }
+
+  const auto warmup_start = std::chrono::steady_clock::now();
+  while (std::chrono::steady_clock::now() - warmup_start < this->options_.warmup_time) {
+    CHECK_EXPECTED(body(batch_size));
+  }
+
+  std::vector<double> samples;
+  samples.reserve(this->options_.samples);
+  for (size_t i = 0; i < this->options_.samples; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    CHECK_EXPECTED(body(batch_size));
+    const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    samples.push_back(elapsed / batch_size);
+  }
+  std::sort(samples.begin(), samples.end());
+
+  const auto percentile = [&samples](size_t p) -> double {
+    auto index = (samples.size() * p + 99) / 100;
+    return samples[(0 == index) ? 0 : index - 1];
+  };
+
+  result r;
+  r.name = name;
+  r.bytes_per_op = bytes_per_op;
+  r.batch_size = batch_size;
+  r.samples = samples.size();
+  r.mean_ns = 0;
+  for (auto value : samples) {
+    r.mean_ns += value;
+  }
+  r.mean_ns /= samples.size();
+  r.min_ns = samples.front();
+  r.p50_ns = percentile(50);
+  r.p90_ns = percentile(90);
+  r.p99_ns = percentile(99);
+  r.max_ns = samples.back();
+
+  print(r);
+  this->results_.push_back(r);
+  return vds::expected<void>();
+}
+
+void bench_runner::print(const result & r) {
+  std::cout
+    << std::left << std::setw(36) << r.name << std::right << std::fixed << std::setprecision(1)
+    << " p50 " << std::setw(12) << r.p50_ns << " ns"
+    << "  p90 " << std::setw(12) << r.p90_ns << " ns"
+    << "  p99 " << std::setw(12) << r.p99_ns << " ns";
+  if (0 != r.bytes_per_op) {
+    std::cout << "  " << std::setw(9) << (r.bytes_per_op * 1e9 / r.p50_ns / (1024 * 1024)) << " MiB/s";
+  }
+  std::cout << std::endl;
+}
+
+vds::expected<void> bench_runner::save(const vds::filename & fn) const {
+  auto items = std::make_shared<vds::json_array>();
+  for (const auto & r : this->results_) {
+    auto item = std::make_shared<vds::json_object>();
+    item->add_property("name", r.name);
+    item->add_property("bytes_per_op", r.bytes_per_op);
+    item->add_property("batch_size", r.batch_size);
+    item->add_property("samples", r.samples);
+    item->add_property("mean_ns", std::to_string(r.mean_ns));
+    item->add_property("min_ns", std::to_string(r.min_ns));
+    item->add_property("p50_ns", std::to_string(r.p50_ns));
+    item->add_property("p90_ns", std::to_string(r.p90_ns));
+    item->add_property("p99_ns", std::to_string(r.p99_ns));
+    item->add_property("max_ns", std::to_string(r.max_ns));
+    items->add(item);
+  }
+
+  auto root = std::make_shared<vds::json_object>();
+  root->add_property("benchmarks", items);
+
+  GET_EXPECTED(body, root->json_value::str());
+  return vds::file::write_all(fn, body.c_str(), body.length());
+}
+
+vds::expected<bool> bench_runner::compare(const vds::filename & baseline) const {
+  GET_EXPECTED(value, vds::json_parser::parse(baseline.full_name(), vds::file::read_all(baseline)));
+
+  auto root = std::dynamic_pointer_cast<vds::json_object>(value);
+  if (!root) {
+    return vds::make_unexpected<std::runtime_error>("Invalid baseline file " + baseline.full_name());
+  }
+
+  auto items = std::dynamic_pointer_cast<vds::json_array>(root->get_property("benchmarks"));
+  if (!items) {
+    return vds::make_unexpected<std::runtime_error>("Invalid baseline file " + baseline.full_name());
+  }
+
+  std::map<std::string, double> baseline_p50;
+  for (size_t i = 0; i < items->size(); ++i) {
+    auto item = std::dynamic_pointer_cast<vds::json_object>(items->get(i));
+    if (!item) {
+      continue;
+    }
+
+    std::string name;
+    std::string p50;
+    GET_EXPECTED(has_name, item->get_property("name", name));
+    GET_EXPECTED(has_p50, item->get_property("p50_ns", p50));
+    if (has_name && has_p50) {
+      baseline_p50[name] = std::stod(p50);
+    }
+  }
+
+  bool result = true;
+  std::cout << std::endl << "Compared to " << baseline.full_name() << ":" << std::endl;
+  for (const auto & r : this->results_) {
+    auto p = baseline_p50.find(r.name);
+    if (baseline_p50.end() == p || 0 == p->second) {
+      continue;
+    }
+
+    const auto change = (r.p50_ns - p->second) * 100 / p->second;
+    const bool is_regression = (change > this->options_.threshold);
+    if (is_regression) {
+      result = false;
+    }
+
+    std::cout
+      << std::left << std::setw(36) << r.name << std::right << std::fixed << std::setprecision(1)
+      << " " << std::setw(12) << p->second << " -> " << std::setw(12) << r.p50_ns << " ns"
+      << "  " << std::showpos << std::setw(7) << change << std::noshowpos << "%"
+      << (is_regression ? "  REGRESSION" : "")
+      << std::endl;
+  }
+
+  return result;
+}
@@ -0,0 +1,95 @@
+#ifndef __VDS_BENCH_BENCH_RUNNER_H_
+#define __VDS_BENCH_BENCH_RUNNER_H_
+
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include <chrono>
+#include <functional>
+#include <list>
+#include <string>
+#include "expected.h"
+#include "filename.h"
+
+namespace vds {
+  class service_provider;
+}
+
+//Runs the benchmark bodies and collects per-operation timings.
+//A body executes the measured operation the given number of times, so the
+//call overhead is spread over the whole batch.
+class bench_runner {
+public:
+  typedef std::function<vds::expected<void>(size_t count)> body_t;
+
+  struct options {
+    options()
+    : samples(100),
+      min_sample_time(std::chrono::microseconds(200)),
+      warmup_time(std::chrono::milliseconds(100)),
+      threshold(10.0) {
+    }
+
+    //Substring of the benchmark name, empty runs everything
+    std::string filter;
+    size_t samples;
+    std::chrono::nanoseconds min_sample_time;
+    std::chrono::nanoseconds warmup_time;
+    //Allowed p50 slowdown against the baseline, percent
+    double threshold;
+  };
+
+  struct result {
+    std::string name;
+    size_t bytes_per_op;
+    size_t batch_size;
+    size_t samples;
+    double mean_ns;
+    double min_ns;
+    double p50_ns;
+    double p90_ns;
+    double p99_ns;
+    double max_ns;
+  };
+
+  bench_runner(const options & opt);
+
+  //Matches the --filter option
+  bool is_selected(const std::string & name) const {
+    return this->options_.filter.empty() || std::string::npos != name.find(this->options_.filter);
+  }
+
+  vds::expected<void> run(const std::string & name, const body_t & body) {
+    return this->run(name, 0, body);
+  }
+
+  //With bytes_per_op the report also shows the throughput
+  vds::expected<void> run(const std::string & name, size_t bytes_per_op, const body_t & body);
+
+  const std::list<result> & results() const {
+    return this->results_;
+  }
+
+  vds::expected<void> save(const vds::filename & fn) const;
+
+  //Prints the p50 change of every benchmark found in the baseline.
+  //Returns false if any of them is slower than the threshold allows.
+  vds::expected<bool> compare(const vds::filename & baseline) const;
+
+private:
+  options options_;
+  std::list<result> results_;
+
+  static void print(const result & r);
+};
+
+//Benchmark suites, one per kernel library
+vds::expected<void> core_benchmarks(bench_runner & runner, const vds::service_provider * sp);
+vds::expected<void> data_benchmarks(bench_runner & runner, const vds::service_provider * sp);
+vds::expected<void> crypto_benchmarks(bench_runner & runner, const vds::service_provider * sp);
+vds::expected<void> parser_benchmarks(bench_runner & runner, const vds::service_provider * sp);
+vds::expected<void> database_benchmarks(bench_runner & runner, const vds::service_provider * sp);
+
+#endif //__VDS_BENCH_BENCH_RUNNER_H_
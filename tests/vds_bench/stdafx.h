@@ -0,0 +1,19 @@
+#ifndef __VDS_BENCH_STDAFX_H_
+#define __VDS_BENCH_STDAFX_H_
+
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "logger.h"
+#include "barrier.h"
+
+#endif//__VDS_BENCH_STDAFX_H_
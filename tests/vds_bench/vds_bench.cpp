@@ -0,0 +1,134 @@
+/*
+Copyright (c) 2017, Vadim Malyshev, lboss75@gmail.com
+All rights reserved
+*/
+
+#include "stdafx.h"
+#include <cstring>
+#include "bench_runner.h"
+#include "service_provider.h"
+#include "mt_service.h"
+#include "task_manager.h"
+#include "crypto_service.h"
+#include "async_frame_pool.h"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+static void print_usage() {
+  std::cout
+    << "Usage: vds_bench [options]" << std::endl
+    << "  --filter=<text>      run only benchmarks whose name contains the text" << std::endl
+    << "  --samples=<count>    samples per benchmark, 100 by default" << std::endl
+    << "  --json=<file>        save the results" << std::endl
+    << "  --baseline=<file>    compare the results with a saved run" << std::endl
+    << "  --threshold=<pct>    allowed p50 slowdown against the baseline, 10 by default" << std::endl;
+}
+
+//Memory use of the whole run, printed after the timings
+static void print_memory_statistic() {
+  const auto frames = vds::async_frame_pool::get_statistic();
+  std::cout
+    << "Coroutine frames: " << frames.allocations << " allocations, "
+    << frames.allocated_bytes << " bytes, pool hit rate " << frames.hit_rate()
+    << ", cached " << frames.cached_bytes << " bytes" << std::endl;
+
+#ifndef _WIN32
+  struct rusage usage;
+  if (0 == getrusage(RUSAGE_SELF, &usage)) {
+    std::cout
+      << "Max RSS: " << usage.ru_maxrss << " KB, context switches "
+      << usage.ru_nvcsw << " voluntary, " << usage.ru_nivcsw << " involuntary" << std::endl;
+  }
+#endif
+}
+
+static bool parse_arg(const char * arg, const char * prefix, std::string & value) {
+  const auto len = strlen(prefix);
+  if (0 != strncmp(arg, prefix, len)) {
+    return false;
+  }
+
+  value = arg + len;
+  return true;
+}
+
+static vds::expected<int> run_benchmarks(bench_runner & runner, const std::string & json_file, const std::string & baseline_file) {
+  vds::service_registrator registrator;
+  vds::mt_service mt_service;
+  vds::task_manager task_manager;
+  vds::crypto_service crypto_service;
+  vds::console_logger console_logger(vds::log_level::ll_error, std::unordered_set<std::string>());
+
+  registrator.add(mt_service);
+  registrator.add(task_manager);
+  registrator.add(crypto_service);
+  registrator.add(console_logger);
+
+  GET_EXPECTED(sp, registrator.build());
+  CHECK_EXPECTED(registrator.start());
+
+  CHECK_EXPECTED(core_benchmarks(runner, sp));
+  CHECK_EXPECTED(data_benchmarks(runner, sp));
+  CHECK_EXPECTED(crypto_benchmarks(runner, sp));
+  CHECK_EXPECTED(parser_benchmarks(runner, sp));
+  CHECK_EXPECTED(database_benchmarks(runner, sp));
+
+  CHECK_EXPECTED(registrator.shutdown());
+  print_memory_statistic();
+
+  if (!json_file.empty()) {
+    CHECK_EXPECTED(runner.save(vds::filename(json_file)));
+  }
+
+  if (!baseline_file.empty()) {
+    GET_EXPECTED(is_ok, runner.compare(vds::filename(baseline_file)));
+    if (!is_ok) {
+      return 2;
+    }
+  }
+
+  return 0;
+}
+
+int main(int argc, char ** argv) {
+  bench_runner::options options;
+  std::string json_file;
+  std::string baseline_file;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string value;
+    if (parse_arg(argv[i], "--filter=", value)) {
+      options.filter = value;
+    }
+    else if (parse_arg(argv[i], "--samples=", value)) {
+      options.samples = std::stoul(value);
+    }
+    else if (parse_arg(argv[i], "--json=", json_file)) {
+    }
+    else if (parse_arg(argv[i], "--baseline=", baseline_file)) {
+    }
+    else if (parse_arg(argv[i], "--threshold=", value)) {
+      options.threshold = std::stod(value);
+    }
+    else {
+      print_usage();
+      return 1;
+    }
+  }
+
+  if (0 == options.samples) {
+    print_usage();
+    return 1;
+  }
+
+  bench_runner runner(options);
+  auto result = run_benchmarks(runner, json_file, baseline_file);
+  if (result.has_error()) {
+    std::cerr << result.error()->what() << std::endl;
+    return 1;
+  }
+
+  return result.value();
+}